@@ -1,8 +1,12 @@
 #pragma once
 
+#include "imqttclient.hpp"
+#include "inflightwindow.hpp"
+#include "latencyhistogram.hpp"
+#include "metrics.hpp"
+#include "subscriptiontable.hpp"
 #include "types.hpp"
-#include <functional>
-#include <map>
+#include <array>
 #include <memory>
 #include <string>
 
@@ -14,25 +18,20 @@ namespace app {
  * This class provides functionality to connect, publish, subscribe, and manage
  * communication with AWS IoT Core using MQTT. It supports setting callbacks for
  * disconnect and subscription events.
+ *
+ * Messages published with publishAsync() don't wait for PUBACK. Up to the
+ * in-flight window of QoS1 messages is kept until acknowledged, so throughput
+ * is not limited to one message per round trip. Unacknowledged messages are
+ * sent again after reconnect. The window and the PUBLISH encoding are shared
+ * with the host socket client, only connect, read and keep alive go through
+ * the SDK.
+ *
+ * The TLS session and parsed credentials are kept over reconnects. A
+ * reconnect offers the cached session, so the server can resume it with an
+ * abbreviated handshake without certificate exchange and key agreement.
  */
-class AwsIotClient {
+class AwsIotClient final : public net::IMqttClient {
   public:
-    /**
-     * @brief Callback type for handling disconnect events.
-     */
-    using disconnectCallback = std::function<void(common::Argument)>;
-
-    /**
-     * @brief Callback type for handling subscription messages.
-     */
-    using subscribeCallback = std::function<void(const char*, uint16_t, void*,
-                                                 size_t, common::Argument)>;
-
-    /**
-     * @brief Quality of Service levels for MQTT messages.
-     */
-    enum class Qos : uint8_t { _0, _1 };
-
     /**
      * @brief Holds the TLS certificates required for secure communication.
      */
@@ -72,31 +71,37 @@ class AwsIotClient {
      * @param cb The disconnect callback function.
      * @param arg User-defined argument passed to the callback.
      */
-    void setDisconnectCallback(disconnectCallback cb, common::Argument arg);
+    void setDisconnectCallback(disconnectCallback cb,
+                               common::Argument arg) override;
 
     /**
-     * @brief Subscribes to a topic with a specified QoS level.
+     * @brief Subscribes to a topic with a specified QoS level. The topic is
+     * copied. Subscribing to a topic again only replaces its callback.
      *
-     * @param topic The topic to subscribe to.
+     * @param topic The topic filter to subscribe to, may contain '+' and '#'.
      * @param qos The Quality of Service level.
      * @param cb The callback function for handling received messages.
      * @param arg User-defined argument passed to the callback.
      *
      * @return
      *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Invalid or too long topic filter.
+     *   - common::Error::NO_MEM: Subscription table is full.
      *   - common::Error::FAIL: Fail.
      */
     common::Error subscribe(const std::string_view& topic, const Qos qos,
-                            subscribeCallback cb, common::Argument arg);
+                            subscribeCallback cb,
+                            common::Argument arg) override;
 
     /**
-     * @brief Establishes a connection to AWS IoT Core.
+     * @brief Establishes a connection to AWS IoT Core and subscribes to every
+     * topic in the table again.
      *
      * @return
      *   - common::Error::OK: Success.
      *   - common::Error::FAIL: Fail.
      */
-    common::Error connect();
+    common::Error connect() override;
 
     /**
      * @brief Disconnects from AWS IoT Core.
@@ -105,7 +110,7 @@ class AwsIotClient {
      *   - common::Error::OK: Success.
      *   - common::Error::FAIL: Fail.
      */
-    common::Error disconnect();
+    common::Error disconnect() override;
 
     /**
      * @brief Publishes a message to a specified topic.
@@ -113,32 +118,178 @@ class AwsIotClient {
      * @param topic The topic to publish to.
      * @param payload The message payload.
      * @param payloadSize The size of the payload.
+     * @param qos The Quality of Service level.
+     * @note QoS1 blocks until PUBACK and can't be used while asynchronous
+     * messages are in flight.
      *
      * @return
      *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Asynchronous messages in flight.
      *   - common::Error::FAIL: Fail.
      */
     common::Error publish(const std::string_view& topic, char* payload,
-                          size_t payloadSize);
+                          size_t payloadSize, const Qos qos) override;
+
+    /**
+     * @brief Publishes a message without waiting for the acknowledgment.
+     * @note Topic must stay valid until the message is completed.
+     *
+     * @param topic The topic to publish to.
+     * @param payload The message payload, it is copied.
+     * @param payloadSize The size of the payload.
+     * @param qos The Quality of Service level.
+     * @param cb The callback function called on completion, may be nullptr.
+     * @param arg User-defined argument passed to the callback.
+     * @param packetId Packet ID of the message, 0 for QoS0.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Invalid payload or topic.
+     *   - common::Error::INVALID_STATE: Not connected.
+     *   - common::Error::NO_MEM: In-flight window is full.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error publishAsync(const std::string_view& topic,
+                               const char* payload, size_t payloadSize,
+                               const Qos qos, publishCallback cb,
+                               common::Argument arg,
+                               uint16_t& packetId) override;
+
+    /**
+     * @brief Sets the number of QoS1 messages which may wait for PUBACK.
+     *
+     * @param window Window size, limited to 1..MAX_IN_FLIGHT.
+     */
+    void setInFlightWindow(const uint8_t window);
+
+    /**
+     * @brief Gets the number of messages which can be published without
+     * waiting.
+     *
+     * @return Free slots in the in-flight window.
+     */
+    uint8_t getFreeInFlightSlots() const override;
 
     /**
      * @brief Processes incoming messages and maintains the connection.
-     * This function should be called periodically to handle MQTT communication.
+     * This function should be called when the socket is readable and at least
+     * once per keep alive interval. While messages are in flight, PUBACKs are
+     * matched here and unacknowledged messages are sent again on timeout.
      */
-    void yield();
+    void yield() override;
+
+    /**
+     * @brief Gets the socket of the MQTT connection.
+     *
+     * @return Socket descriptor, -1 if not connected.
+     */
+    int getSocket() override;
+
+    /**
+     * @brief Checks if TLS holds decrypted data not yet processed.
+     * @note Such data does not make the socket readable again.
+     *
+     * @return True if yield() should be called without waiting.
+     */
+    bool hasPendingData() override;
+
+    /**
+     * @brief Gets TLS handshake statistics.
+     *
+     * @return Statistics since start.
+     */
+    TlsStats getTlsStats() const override;
+
+    /**
+     * @brief Gets PUBACK round-trip time statistics.
+     *
+     * @return Statistics since start or last reset.
+     */
+    RttStats getRttStats() const override;
+
+    /**
+     * @brief Resets PUBACK round-trip time statistics.
+     */
+    void resetRttStats() override;
+
+    /**
+     * @brief Gets latency of asynchronous messages from publishAsync() to
+     * PUBACK, including retries.
+     * @note Safe to call from another thread.
+     *
+     * @return Latency histogram since start.
+     */
+    sw::LatencyHistogram::Snapshot getPublishLatency() const override;
+
+    /**
+     * @brief Adds MQTT metrics: publish latency, retries and messages given
+     * up without PUBACK.
+     *
+     * @param registry Registry to add to.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NO_MEM: Registry is full.
+     */
+    common::Error
+    registerMetrics(sw::metrics::Registry& registry) const override;
+
+    /**
+     * @brief Forgets the cached TLS session, the next connect does a full
+     * handshake.
+     */
+    void clearTlsSession();
+
+    static constexpr size_t MAX_SUBSCRIPTIONS{8};
 
   private:
     using Handler = void;
     using HandlerDeleter =
         void (*)(Handler*); ///< Deleter for the MQTT client handler.
 
+    // Yield is called on socket data, it only needs to process what arrived
+    static constexpr uint32_t YIELD_TIMEOUT_MS{10};
+    static constexpr uint32_t MQTT_COMMAND_TIMEOUT_MS{20'000};
+    static constexpr uint32_t TLS_HANDSHAKE_TIMEOUT_MS{5000};
+    // Topic, packet ID and fixed header must fit next to the payload
+    static constexpr size_t PUBLISH_PACKET_SIZE{
+        net::InFlightWindow::PAYLOAD_SIZE + 128};
+
+    using Subscriptions =
+        SubscriptionTable<subscribeCallback, MAX_SUBSCRIPTIONS, MAX_TOPIC_SIZE>;
+
     /**
-     * @brief Stores callback data for a subscription.
+     * @brief Writes a QoS1 PUBLISH packet to the socket.
+     *
+     * @param message Message to send.
+     * @param isDuplicate True if the message was sent before.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NO_MEM: Packet does not fit the buffer.
+     *   - common::Error::FAIL: Fail.
      */
-    struct SubscribeCallbackData {
-        subscribeCallback cb;
-        common::Argument arg;
-    };
+    common::Error sendPublish_(const net::InFlightWindow::Message& message,
+                               const bool isDuplicate);
+
+    /**
+     * @brief Reads incoming packets and completes acknowledged messages.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Connection error.
+     */
+    common::Error readPackets_();
+
+    /**
+     * @brief Sends PINGREQ when the keep alive interval expired, like the SDK
+     * yield does.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Previous PINGREQ not answered or send fail.
+     */
+    common::Error keepAlive_();
 
     /**
      * @brief Deletes the MQTT client handler.
@@ -147,16 +298,12 @@ class AwsIotClient {
      */
     static void deleteHandler_(Handler* clientHandler);
 
-    static constexpr uint32_t YIELD_TIMEOUT_MS{100};
-    static constexpr uint32_t MQTT_COMMAND_TIMEOUT_MS{20'000};
-    static constexpr uint32_t TLS_HANDSHAKE_TIMEOUT_MS{5000};
-    static constexpr size_t PAYLOAD_SIZE{256};
-    static constexpr uint16_t MQTT_KEEP_ALIVE_INTERVAL_S{10};
-
-    std::map<std::string_view, SubscribeCallbackData> subscribeCallbacks_{};
+    Subscriptions subscriptions_{};
     std::string_view clientId_;
     std::unique_ptr<Handler, HandlerDeleter> clientHandler_;
     disconnectCallback disconnectCb_{nullptr};
     common::Argument disconnectArg_{nullptr};
+    std::array<uint8_t, PUBLISH_PACKET_SIZE> packetBuffer_{};
+    net::InFlightWindow inFlight_;
 };
 } // namespace app
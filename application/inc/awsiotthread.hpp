@@ -1,12 +1,21 @@
 #pragma once
 
-#include "awsiotclient.hpp"
+#include "awsshadowclient.hpp"
+#include "backoff.hpp"
 #include "defs.hpp"
 #include "eventgroup.hpp"
+#include "eventselector.hpp"
+#include "ilinkpower.hpp"
+#include "imqttclient.hpp"
+#include "irecordlog.hpp"
 #include "itimer.hpp"
+#include "metrics.hpp"
 #include "queue.hpp"
+#include "reportfilter.hpp"
+#include "telemetryaggregator.hpp"
 #include "threadbase.hpp"
 #include "utils.hpp"
+#include <atomic>
 
 namespace app {
 /**
@@ -14,7 +23,20 @@ namespace app {
  * @brief A thread class for managing AWS IoT communication.
  *
  * The `AwsIotThread` class is responsible for handling AWS IoT-related
- * operations in a dedicated thread.
+ * operations in a dedicated thread. Telemetry which cannot be published is
+ * stored in the telemetry log and sent after reconnect. In aggregated mode
+ * samples are published as one summary per controller and window, in raw
+ * mode samples without significant change are dropped by the report filter.
+ * Telemetry is published without waiting for PUBACK, the backlog uses the
+ * in-flight window except slots reserved for live data. Wi-Fi leaves power
+ * save while the backlog is sent.
+ *
+ * The thread sleeps in a single wait on the MQTT socket and an event
+ * selector, which is signaled by the telemetry queue and reconnect timer.
+ * The wait is also bounded by the next aggregation window to close.
+ *
+ * While connected, a snapshot of the metrics registry is published every
+ * METRICS_PERIOD_MS on the metrics topic.
  */
 class AwsIotThread : public sw::ThreadBase {
   public:
@@ -22,11 +44,17 @@ class AwsIotThread : public sw::ThreadBase {
      * @brief Configuration structure for initializing the `AwsIotThread`.
      */
     struct Config {
-        AwsIotClient& awsIotClient;
+        net::IMqttClient& mqttClient;
         sw::EventGroup& connectionEventGroup;
         sw::IQueueReceiver<common::Telemetry>& telemetryQueue;
         sw::IQueueSender<def::ui::LedEvent>& ledEventQueue;
         timer::ITimer& reconnectTimer;
+        storage::IRecordLog<common::TelemetrySummary>& telemetryLog;
+        ReportFilter& reportFilter;
+        TelemetryAggregator& aggregator;
+        AwsShadowClient& shadowClient;
+        net::ILinkPower& linkPower; // Wi-Fi on the hub
+        const sw::metrics::Registry& metrics;
     };
 
     /**
@@ -42,6 +70,17 @@ class AwsIotThread : public sw::ThreadBase {
      */
     ~AwsIotThread() = default;
 
+    /**
+     * @brief Adds cloud connection metrics: reconnect attempts.
+     *
+     * @param registry Registry to add to.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NO_MEM: Registry is full.
+     */
+    common::Error registerMetrics(sw::metrics::Registry& registry) const;
+
   private:
     /**
      * @brief The main thread execution function.
@@ -53,6 +92,23 @@ class AwsIotThread : public sw::ThreadBase {
      */
     void yield_();
 
+    /**
+     * @brief Checks if the MQTT connection is up.
+     */
+    bool isAwsConnected_() const;
+
+    /**
+     * @brief Waits for queue data, a reconnect trigger or MQTT socket data.
+     */
+    void waitForEvent_();
+
+    /**
+     * @brief Gets the time the thread may sleep while connected.
+     *
+     * @return Time in milliseconds until the next keep alive.
+     */
+    common::Time getConnectedWaitTimeMs_();
+
     /**
      *  @brief Handles the logic for managing disconnection events.
      */
@@ -64,7 +120,7 @@ class AwsIotThread : public sw::ThreadBase {
     void handleConnect_();
 
     /**
-     * @brief Handles the logic for managing reconnection attempts.
+     * @brief Schedules the next connection attempt with jittered backoff.
      */
     void handleReconnect_();
 
@@ -74,33 +130,110 @@ class AwsIotThread : public sw::ThreadBase {
     void setSubscriptions_();
 
     /**
-     * @brief Publishes telemetry data to the AWS IoT Core.
+     * @brief Telemetry waiting for PUBACK, stored again if it is given up.
+     */
+    struct PendingTelemetry {
+        bool isUsed;
+        uint16_t packetId;
+        common::TelemetrySummary summary;
+    };
+
+    /**
+     * @brief Publishes a raw sample or a window summary to the AWS IoT Core.
      *
-     * @param telemetry The telemetry data to be published.
+     * @param summary The telemetry to be published.
      *
      * @return
-     *   - common::Error::OK: Telemetry was successfully published.
+     *   - common::Error::OK: Telemetry was successfully sent.
+     *   - common::Error::NO_MEM: In-flight window is full.
      *   - common::Error::FAIL: Failed to publish telemetry.
      */
-    common::Error publishTelemetry_(common::Telemetry telemetry);
+    common::Error publishTelemetry_(common::TelemetrySummary summary);
+
+    /**
+     * @brief Handles the completion of a telemetry publish.
+     *
+     * @param packetId Packet ID of the message.
+     * @param result Publish result.
+     */
+    void handlePublishComplete_(const uint16_t packetId,
+                                const common::Error result);
+
+    /**
+     * @brief Adds telemetry to the aggregator, or filters it and passes it on
+     * as a raw sample.
+     *
+     * @param telemetry The telemetry data received from the radio.
+     */
+    void handleTelemetry_(common::Telemetry telemetry);
+
+    /**
+     * @brief Publishes telemetry or stores it in the log when offline.
+     *
+     * @param summary Raw sample or window summary.
+     */
+    void handleSummary_(const common::TelemetrySummary& summary);
+
+    /**
+     * @brief Passes on summaries of all closed aggregation windows.
+     */
+    void flushAggregator_();
+
+    /**
+     * @brief Publishes stored telemetry while the in-flight window has room.
+     */
+    void drainTelemetryLog_();
+
+    /**
+     * @brief Keeps Wi-Fi at full performance while a backlog is sent.
+     */
+    void updatePowerSave_();
+
+    /**
+     * @brief Publishes a metrics snapshot when the period has passed.
+     */
+    void publishMetrics_();
+
+    /**
+     * @brief Gets the time until the next metrics snapshot.
+     *
+     * @return Time in milliseconds, 0 if it is due.
+     */
+    common::Time getMetricsWaitTimeMs_() const;
 
     static constexpr std::string_view TELEMETRY_TOPIC{"controller/telemetry"};
-    static constexpr common::Time CONNECTED_WAIT_TIMEOUT_MS{
-        common::utils::sToMs<common::Time, common::Time>(60)};
-    static constexpr common::Time RECONNECT_TIME_US{
-        common::utils::msToUs<common::Time, common::Time>(
-            common::utils::sToMs<common::Time, common::Time>(10))};
-    static constexpr common::Time RECONNECT_AFTER_MAX_ATTEMPT_TIME_US{
-        common::utils::msToUs<common::Time, common::Time>(
-            common::utils::sToMs<common::Time, common::Time>(
-                common::utils::minToS<common::Time, common::Time>(10)))};
+    static constexpr std::string_view TELEMETRY_SUMMARY_TOPIC{
+        "controller/telemetry/summary"};
+    static constexpr std::string_view METRICS_TOPIC{"hub/metrics"};
+    static constexpr common::Time METRICS_PERIOD_MS{
+        common::utils::sToMs<common::Time, common::Time>(
+            common::utils::minToS<common::Time, common::Time>(5))};
+    static constexpr sw::Backoff::Settings RECONNECT_BACKOFF_SETTINGS{
+        common::utils::sToMs<common::Time, common::Time>(1),
+        common::utils::sToMs<common::Time, common::Time>(
+            common::utils::minToS<common::Time, common::Time>(10))};
+    // In-flight slots the backlog leaves for live data
+    static constexpr uint8_t LIVE_RESERVED_SLOTS{1};
+    // MQTT keep alive is handled in yield, call it twice per interval
+    static constexpr common::Time KEEP_ALIVE_YIELD_MS{
+        common::utils::sToMs<common::Time, common::Time>(
+            net::IMqttClient::MQTT_KEEP_ALIVE_INTERVAL_S) /
+        2};
+    // Wi-Fi connection is not signaled, check it with this period
+    static constexpr common::Time OFFLINE_WAIT_MS{1000};
     static constexpr uint32_t STACK_DEPTH{4096};
     static constexpr int PRIORITY{4};
     static constexpr sw::ThreadBase::CoreId CORE_ID{sw::ThreadBase::CoreId::_0};
-    static constexpr uint8_t MAX_CONNECT_ATTEMPTS{5};
     Config config_;
-    uint8_t connectCounter{0};
-    bool isConnectTriggered_{false};
+    sw::Backoff reconnectBackoff_{RECONNECT_BACKOFF_SETTINGS};
+    std::atomic<bool> isConnectTriggered_{false}; // Set by the timer task
+    common::Time lastClientYieldMs_{0};
+    net::EventSelector eventSelector_{};
+    bool isDraining_{false};
+    common::Time lastMetricsMs_{0};
+    sw::metrics::Counter reconnects_{};
+    std::array<PendingTelemetry, net::IMqttClient::MAX_IN_FLIGHT>
+        pendingTelemetry_{};
 };
 
 } // namespace app
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "imqttclient.hpp"
+#include "inplacefunction.hpp"
+#include "mutex.hpp"
+#include "types.hpp"
+#include <array>
+#include <string_view>
+
+namespace app {
+/**
+ * @class AwsShadowClient
+ * @brief AWS IoT Device Shadow client on top of an MQTT client.
+ *
+ * Reported state is kept as named numeric fields. Only fields changed since
+ * the last update are sent to the shadow update topic. Desired state from
+ * the delta topic is passed to the delta callback, deltas with an old
+ * version or an already applied value are skipped.
+ *
+ * @note setReported() is thread safe, use the rest from the thread which
+ * yields the MQTT client.
+ */
+class AwsShadowClient {
+  public:
+    /**
+     * @brief Callback type for handling a desired field change.
+     * Called with the field key and desired value.
+     */
+    using deltaCallback = common::InplaceFunction<void(
+        std::string_view, double, common::Argument)>;
+
+    /**
+     * @brief Configuration for the AwsShadowClient.
+     */
+    struct Config {
+        net::IMqttClient& mqttClient;
+        std::string_view thingName;
+    };
+
+    static constexpr size_t MAX_FIELDS{8};
+
+    /**
+     * @brief Construct a new AwsShadowClient object.
+     *
+     * @param config Configuration for the AwsShadowClient.
+     */
+    explicit AwsShadowClient(Config config);
+
+    /**
+     * @brief Sets the callback for handling desired state changes.
+     *
+     * @param cb The delta callback function.
+     * @param arg User-defined argument passed to the callback.
+     */
+    void setDeltaCallback(deltaCallback cb, common::Argument arg);
+
+    /**
+     * @brief Sets a reported field, it is sent on the next yield if changed.
+     * @note Key must stay valid for the lifetime of the client.
+     *
+     * @param key Field key.
+     * @param value Field value.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Empty key.
+     *   - common::Error::NO_MEM: No free field.
+     */
+    common::Error setReported(const std::string_view key, const double value);
+
+    /**
+     * @brief Subscribes to shadow topics and requests the current delta.
+     * Must be called after every connect, the MQTT session is not persistent.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error start();
+
+    /**
+     * @brief Sends changed reported fields.
+     *
+     * @return
+     *   - common::Error::OK: Success or nothing to send.
+     *   - common::Error::NO_MEM: In-flight window is full, retry later.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error yield();
+
+  private:
+    /**
+     * @brief Reported and desired value of a field.
+     */
+    struct Field {
+        std::string_view key;
+        double reportedValue;
+        double desiredValue;
+        bool hasDesired;
+        bool isDirty;
+        uint16_t packetId;
+    };
+
+    /**
+     * @brief Handles a message on the delta or get accepted topic.
+     *
+     * @param payload Message payload.
+     * @param payloadLength Payload length.
+     * @param isGetAccepted True if payload is a full shadow document.
+     */
+    void handleDelta_(const void* payload, const size_t payloadLength,
+                      const bool isGetAccepted);
+
+    /**
+     * @brief Handles completion of a reported state update.
+     *
+     * @param packetId Packet ID of the update.
+     * @param result Publish result.
+     */
+    void handleUpdateComplete_(const uint16_t packetId,
+                               const common::Error result);
+
+    /**
+     * @brief Finds the field with the given key.
+     *
+     * @param key Field key.
+     *
+     * @return Field or nullptr if not found.
+     */
+    Field* findField_(const std::string_view key);
+
+    static constexpr size_t BUFFER_SIZE{256};
+    using TopicBuffer = std::array<char, net::IMqttClient::MAX_TOPIC_SIZE>;
+    Config config_;
+    // Update topic is the start of the delta topic, get the start of get
+    // accepted, so one buffer holds both
+    TopicBuffer deltaTopicBuffer_{};
+    TopicBuffer getAcceptedTopicBuffer_{};
+    std::string_view updateTopic_;
+    std::string_view deltaTopic_;
+    std::string_view getTopic_;
+    std::string_view getAcceptedTopic_;
+    sw::Mutex fieldsMutex_{};
+    std::array<Field, MAX_FIELDS> fields_{};
+    deltaCallback deltaCb_{nullptr};
+    common::Argument deltaArg_{nullptr};
+    uint32_t desiredVersion_{0};
+};
+} // namespace app
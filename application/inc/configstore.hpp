@@ -0,0 +1,94 @@
+#pragma once
+
+#include "istorage.hpp"
+#include "mutex.hpp"
+#include "types.hpp"
+
+namespace app {
+/**
+ * @class ConfigStore
+ * @brief Persists the device configuration in storage.
+ *
+ * Radio threads apply a new configuration in their IRQ path, where a
+ * storage write would block and allocate. They queue it with saveLater()
+ * and the main task writes it in yield().
+ */
+class ConfigStore {
+  public:
+    /**
+     * @brief Configuration for the ConfigStore.
+     */
+    struct Config {
+        storage::IStorage& storage;
+    };
+
+    /**
+     * @brief Construct a new ConfigStore object.
+     *
+     * @param config Configuration for the ConfigStore.
+     */
+    explicit ConfigStore(Config config);
+
+    /**
+     * @brief Load the device configuration.
+     * @note Values which are missing or invalid keep their current value.
+     *
+     * @param deviceConfig Device configuration, holding defaults on input.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Stored configuration is invalid.
+     */
+    common::Error load(common::DeviceConfig& deviceConfig);
+
+    /**
+     * @brief Save the device configuration.
+     *
+     * @param deviceConfig Device configuration.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Invalid configuration.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error save(const common::DeviceConfig& deviceConfig);
+
+    /**
+     * @brief Queue the device configuration for saving in yield(). A newer
+     * configuration replaces a queued one.
+     * @note Does not touch storage, safe to call from any thread.
+     *
+     * @param deviceConfig Device configuration.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Invalid configuration.
+     */
+    common::Error saveLater(const common::DeviceConfig& deviceConfig);
+
+    /**
+     * @brief Save the configuration queued by saveLater(), if any.
+     */
+    void yield();
+
+    /**
+     * @brief Check if the device configuration is in supported ranges and
+     * its link settings are supported by the radio.
+     *
+     * @param deviceConfig Device configuration.
+     *
+     * @return True if valid.
+     */
+    static bool isValid(const common::DeviceConfig& deviceConfig);
+
+  private:
+    static constexpr uint32_t MIN_MEASUREMENT_PERIOD_S{1};
+    static constexpr uint32_t MIN_REQUEST_PERIOD_S{6};
+    // Timers take 32-bit microseconds, periods must stay below ~71 minutes
+    static constexpr uint32_t MAX_PERIOD_S{60 * 60};
+    Config config_;
+    sw::Mutex pendingMutex_{};
+    common::DeviceConfig pendingConfig_{};
+    bool hasPendingConfig_{false};
+};
+} // namespace app
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "eventgroup.hpp"
+#include "rfm95.hpp"
+#include "threadbase.hpp"
 #include <string_view>
 
 namespace def {
@@ -9,12 +11,21 @@ namespace key {
 namespace wifi {
 static constexpr std::string_view STA_SSID{"ssid"};
 static constexpr std::string_view STA_PASSWORD{"pass"};
+static constexpr std::string_view LAST_AP{"last_ap"};
 } // namespace wifi
 
 namespace aws {
 static constexpr std::string_view CLIENT_ID{"client_id"};
 static constexpr std::string_view HOST_URL{"host_url"};
 } // namespace aws
+
+namespace config {
+static constexpr std::string_view MEASUREMENT_PERIOD{"meas_period"};
+static constexpr std::string_view REQUEST_PERIOD{"req_period"};
+static constexpr std::string_view SPREADING_FACTOR{"sf"};
+static constexpr std::string_view BANDWIDTH{"bw"};
+static constexpr std::string_view TX_POWER{"tx_power"};
+} // namespace config
 } // namespace key
 
 namespace ui {
@@ -35,4 +46,23 @@ static constexpr sw::EventGroup::Bits WIFI_CONNECTED_BIT{1 << 0};
 static constexpr sw::EventGroup::Bits AWS_CONNECTED_BIT{1 << 1};
 } // namespace net
 
+namespace radio {
+static constexpr sw::ThreadBase::NotificationBits IRQ_BIT{1 << 0};
+static constexpr sw::ThreadBase::NotificationBits REQUEST_DUE_BIT{1 << 1};
+static constexpr sw::ThreadBase::NotificationBits TIMEOUT_BIT{1 << 2};
+static constexpr sw::ThreadBase::NotificationBits REQUEST_PERIOD_BIT{1 << 3};
+// Modem settings of the hub and the controllers, the link settings of the
+// device configuration are applied on top
+static constexpr ::radio::Rfm95::ModemSettings MODEM_SETTINGS{
+    868'000'000,
+    8,
+    ::radio::Rfm95::Gain::G1,
+    ::radio::Rfm95::Bandwidth::BW_125000,
+    ::radio::Rfm95::SF::SF_12,
+    18,
+    ::radio::Rfm95::PaPin::BOOST,
+    20,
+    true};
+} // namespace radio
+
 } // namespace def
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "configstore.hpp"
+#include "dutycyclelimiter.hpp"
+#include "isensors.hpp"
+#include "istorage.hpp"
+#include "itimer.hpp"
+#include "listenbeforetalk.hpp"
+#include "radiothreadcontroller.hpp"
+#include "rfm95.hpp"
+#include "timedmeter.hpp"
+#include "types.hpp"
+
+namespace app {
+/**
+ * @class GreenhouseController
+ * @brief Measurement and radio side of the controller, shared by the target
+ * and the host build.
+ *
+ * Owns the radio stack on top of the modem, the timed meter and the radio
+ * thread answering the hub. The platform provides the modem, the sensors,
+ * the measurement timer and storage.
+ */
+class GreenhouseController {
+  public:
+    /**
+     * @brief Configuration structure for GreenhouseController.
+     */
+    struct Config {
+        radio::Rfm95& rfm95;
+        sensor::ITemperatureSensor& temperatureSensor;
+        sensor::IHumiditySensor& humiditySensor;
+        timer::ITimer& measurementTimer;
+        storage::IStorage& storage;
+        uint8_t controllerId; // Unique, the hub keeps report state for each
+    };
+
+    /**
+     * @brief Construct a new GreenhouseController object.
+     *
+     * @param config Configuration for the GreenhouseController.
+     */
+    explicit GreenhouseController(Config config);
+
+    /**
+     * @brief Destroy the GreenhouseController object.
+     */
+    ~GreenhouseController() = default;
+
+    /**
+     * @brief Loads the device configuration and sets up the modem.
+     * @note Failed steps are logged and the rest is still set up.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: At least one step failed.
+     */
+    common::Error init();
+
+    /**
+     * @brief Starts measurements and the radio thread.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error start();
+
+    /**
+     * @brief Runs due measurements and saves configuration received from the
+     * hub, call it periodically from the main loop.
+     */
+    void yield();
+
+    const radio::ListenBeforeTalk& getListenBeforeTalk() const;
+
+    const radio::DutyCycleLimiter& getDutyCycleLimiter() const;
+
+    const RadioThreadController& getRadioThread() const;
+
+  private:
+    Config config_;
+    ConfigStore configStore_;
+    common::DeviceConfig deviceConfig_{};
+    common::Telemetry telemetry_{};
+    radio::ListenBeforeTalk lbtRadio_;
+    radio::DutyCycleLimiter dutyCycleRadio_;
+    TimedMeter timedMeter_;
+    RadioThreadController radioThread_;
+};
+} // namespace app
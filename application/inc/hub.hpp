@@ -0,0 +1,169 @@
+#pragma once
+
+#include "awsiotthread.hpp"
+#include "awsshadowclient.hpp"
+#include "configstore.hpp"
+#include "defs.hpp"
+#include "dutycyclelimiter.hpp"
+#include "eventgroup.hpp"
+#include "ilinkpower.hpp"
+#include "imqttclient.hpp"
+#include "irecordlog.hpp"
+#include "istorage.hpp"
+#include "listenbeforetalk.hpp"
+#include "metrics.hpp"
+#include "publishbenchmark.hpp"
+#include "queue.hpp"
+#include "radiothreadhub.hpp"
+#include "reportfilter.hpp"
+#include "rfm95.hpp"
+#include "ringbuffer.hpp"
+#include "telemetryaggregator.hpp"
+#include "timer.hpp"
+#include "types.hpp"
+#include <string_view>
+
+namespace app {
+/**
+ * @class Hub
+ * @brief Radio and cloud side of the hub, shared by the target and the host
+ * build.
+ *
+ * Owns the radio stack on top of the modem, the radio and cloud threads,
+ * the telemetry path between them, the device shadow and the metrics
+ * registry. The platform provides the modem, storage, LED events, the MQTT
+ * client with its network and the telemetry log.
+ *
+ * Desired configuration fields from the shadow are applied to the radio
+ * thread, which delivers them to the controllers, and reported back.
+ */
+class Hub {
+  public:
+    /**
+     * @brief Configuration structure for Hub.
+     */
+    struct Config {
+        radio::Rfm95& rfm95;
+        storage::IStorage& storage;
+        sw::IQueueSender<def::ui::LedEvent>& ledEventQueue;
+        sw::EventGroup& connectionEventGroup; // WIFI_CONNECTED_BIT is set
+                                              // by the platform
+        net::IMqttClient& mqttClient;
+        net::ILinkPower& linkPower;
+        storage::IRecordLog<common::TelemetrySummary>& telemetryLog;
+        std::string_view thingName; // Must stay valid
+    };
+
+    /**
+     * @brief Hub settings
+     */
+    struct Settings {
+        TelemetryAggregator::Settings aggregator;
+        // Runs in place of the radio thread if rateHz is not 0
+        PublishBenchmark::Settings benchmark;
+    };
+
+    using TelemetryQueue =
+        sw::RingBuffer<common::Telemetry, 8, sw::OverflowPolicy::DROP_OLDEST>;
+
+    /**
+     * @brief Construct a new Hub object.
+     *
+     * @param config Configuration for the Hub.
+     * @param settings Hub settings.
+     */
+    Hub(Config config, const Settings settings);
+
+    /**
+     * @brief Destroy the Hub object.
+     */
+    ~Hub() = default;
+
+    /**
+     * @brief Loads the device configuration, sets up the modem and adds the
+     * metrics of the shared parts.
+     * @note Failed steps are logged and the rest is still set up.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: At least one step failed.
+     */
+    common::Error init();
+
+    /**
+     * @brief Gets the metrics registry, platform metrics are added to it
+     * before start().
+     *
+     * @return Metrics registry.
+     */
+    sw::metrics::Registry& getMetrics();
+
+    /**
+     * @brief Starts the radio thread, or the publish benchmark, and the cloud
+     * thread.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: A thread failed to start.
+     */
+    common::Error start();
+
+    /**
+     * @brief Saves configuration changed by the threads and reports it to
+     * the shadow once applied, call it periodically from the main loop.
+     */
+    void yield();
+
+    const radio::ListenBeforeTalk& getListenBeforeTalk() const;
+
+    const radio::DutyCycleLimiter& getDutyCycleLimiter() const;
+
+    const RadioThreadHub& getRadioThread() const;
+
+    TelemetryQueue::Stats getTelemetryQueueStats() const;
+
+  private:
+    /**
+     * @brief Applies a desired shadow field to the device configuration.
+     *
+     * @param key Field key.
+     * @param value Desired value.
+     */
+    void handleDelta_(const std::string_view key, const double value);
+
+    /**
+     * @brief Reports all device configuration fields to the shadow.
+     *
+     * @param deviceConfig Configuration to report.
+     */
+    void reportDeviceConfig_(const common::DeviceConfig& deviceConfig);
+
+    /**
+     * @brief Adds the metrics of the shared parts.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NO_MEM: Registry is full.
+     */
+    common::Error registerMetrics_();
+
+    Config config_;
+    Settings settings_;
+    ConfigStore configStore_;
+    common::DeviceConfig deviceConfig_{};
+    common::DeviceConfig reportedConfig_{}; // Last one sent to the shadow
+    radio::ListenBeforeTalk lbtRadio_;
+    radio::DutyCycleLimiter dutyCycleRadio_;
+    timer::sw::Timer requestTimer_{};
+    timer::sw::Timer timeoutTimer_{};
+    timer::sw::Timer reconnectTimer_{};
+    TelemetryQueue telemetryQueue_{};
+    RadioThreadHub radioThread_;
+    ReportFilter reportFilter_;
+    TelemetryAggregator aggregator_;
+    AwsShadowClient shadowClient_;
+    sw::metrics::Registry metrics_{};
+    AwsIotThread awsThread_;
+    PublishBenchmark publishBenchmark_;
+};
+} // namespace app
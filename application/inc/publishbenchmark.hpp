@@ -0,0 +1,102 @@
+#pragma once
+
+#include "eventgroup.hpp"
+#include "imqttclient.hpp"
+#include "queue.hpp"
+#include "threadbase.hpp"
+#include "ticks.hpp"
+#include "types.hpp"
+
+namespace app {
+/**
+ * @class PublishBenchmark
+ * @brief Drives the publish path with synthetic telemetry and reports its
+ * throughput and latency.
+ *
+ * Once connected to the broker, telemetry is pushed to the telemetry queue at
+ * a fixed rate, so it takes the same path as radio telemetry. Values change
+ * with every sample to pass the report filter. The run ends when all sent
+ * telemetry is acknowledged or the drain timeout expires, the result is
+ * logged once.
+ */
+class PublishBenchmark final : public sw::ThreadBase {
+  public:
+    /**
+     * @brief Configuration structure for PublishBenchmark.
+     */
+    struct Config {
+        sw::IQueueSender<common::Telemetry>& telemetryQueue;
+        net::IMqttClient& mqttClient;
+        sw::EventGroup& connectionEventGroup;
+    };
+
+    /**
+     * @brief Benchmark settings
+     */
+    struct Settings {
+        uint32_t rateHz;         // Telemetry sent per second
+        common::Time durationMs; // Time telemetry is sent for
+    };
+
+    /**
+     * @brief Benchmark result
+     */
+    struct Result {
+        uint32_t sent;           // Telemetry accepted by the queue
+        uint32_t rejected;       // Telemetry the queue failed to take
+        uint32_t acknowledged;   // Messages acknowledged by the broker
+        common::Time elapsedMs;  // From the first sample to the last PUBACK
+        uint32_t p50Us;          // Median publish latency
+        uint32_t p99Us;          // 99th percentile publish latency
+        int32_t heapPerMessageB; // Heap not returned, per message
+        uint32_t peakHeapB;      // Heap used at most during the run
+    };
+
+    /**
+     * @brief Construct a new PublishBenchmark object.
+     *
+     * @param config Configuration for the PublishBenchmark.
+     * @param settings Benchmark settings.
+     */
+    PublishBenchmark(Config config, const Settings settings);
+
+    /**
+     * @brief Destroy the PublishBenchmark object.
+     */
+    ~PublishBenchmark() = default;
+
+  private:
+    /**
+     * @brief Main function to run the thread.
+     */
+    void run_() override;
+
+    /**
+     * @brief Sends telemetry at the set rate and waits for it to be
+     * acknowledged.
+     *
+     * @return Benchmark result.
+     */
+    Result measure_();
+
+    /**
+     * @brief Creates a synthetic sample.
+     *
+     * @param index Sample number.
+     *
+     * @return Telemetry differing from the previous sample of its controller.
+     */
+    static common::Telemetry createTelemetry_(const uint32_t index);
+
+    static constexpr uint8_t CONTROLLERS{4};
+    static constexpr common::Time DRAIN_TIMEOUT_MS{30'000};
+    // One tick, a shorter delay is zero ticks and spins without blocking
+    static constexpr common::Time POLL_PERIOD_MS{sw::TICK_PERIOD_MS};
+    static constexpr common::Time CONNECT_WAIT_MS{1000};
+    static constexpr uint32_t STACK_DEPTH{3072};
+    static constexpr int PRIORITY{3};
+    static constexpr sw::ThreadBase::CoreId CORE_ID{sw::ThreadBase::CoreId::_1};
+    Config config_;
+    Settings settings_;
+};
+} // namespace app
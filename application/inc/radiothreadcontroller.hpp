@@ -1,22 +1,46 @@
 #pragma once
 
+#include "configstore.hpp"
+#include "ichannel.hpp"
 #include "iradio.hpp"
+#include "latencymeter.hpp"
 #include "radiopacket.hpp"
 #include "threadbase.hpp"
+#include "timedmeter.hpp"
 
 namespace app {
 
+/**
+ * @class RadioThreadController
+ * @brief Answers hub requests and applies configuration sent by the hub.
+ *
+ * New configuration is acknowledged with the current link settings and
+ * applied after the acknowledgment was sent. If the hub is not heard within
+ * a few request periods after a link change, the previous link settings are
+ * restored, as the hub may have missed the acknowledgment.
+ */
 class RadioThreadController final : public sw::ThreadBase {
   public:
     struct Config {
         radio::IRadio& radio;
         common::Telemetry& telemetry;
+        radio::IChannel& channel;
+        TimedMeter& timedMeter;
+        ConfigStore& configStore; // Saved by ConfigStore::yield()
+        common::DeviceConfig& deviceConfig; // Applied configuration
     };
 
     explicit RadioThreadController(Config config);
 
     ~RadioThreadController() = default;
 
+    /**
+     * @brief Get latency between the radio interrupt and its handling.
+     *
+     * @return Latency statistics.
+     */
+    sw::LatencyMeter::Stats getIrqLatencyStats() const;
+
   private:
     void run_() override;
 
@@ -29,11 +53,65 @@ class RadioThreadController final : public sw::ThreadBase {
 
     void sendTelemetry_();
 
+    /**
+     * @brief Acknowledge received configuration, apply it after sending.
+     *
+     * @param buffer Pointer to the buffer containing the configuration.
+     * @param bufferLength Length of the buffer.
+     */
+    void receiveConfig_(const uint8_t* buffer, const size_t bufferLength);
+
+    /**
+     * @brief Send a response packet.
+     *
+     * @param type Packet type, OK or NOT_OK.
+     */
+    void sendResponse_(const packet::radio::Type type);
+
+    /**
+     * @brief Apply and save the configuration received from the hub.
+     */
+    void applyPendingConfig_();
+
+    /**
+     * @brief Restore previous link settings if the hub is not heard.
+     */
+    void revertLinkSettings_();
+
+    /**
+     * @brief Send the frame deferred by the radio once it is due.
+     */
+    void flushPendingFrame_();
+
+    /**
+     * @brief Get time to wait for the next notification.
+     *
+     * @return Time in milliseconds until the link check deadline or the
+     * deferred frame is due, whichever is first.
+     */
+    common::Time getWaitTimeMs_();
+
+    /**
+     * @brief Get time left until the link check deadline, safe across the
+     * uptime wrap.
+     *
+     * @return Time in milliseconds, zero or negative once it has passed.
+     */
+    int32_t getLinkCheckTimeLeftMs_() const;
+
     static constexpr size_t MAX_READ_BUFFER{256};
+    // Hub requests missed after a link change before it is reverted
+    static constexpr uint8_t LINK_CHECK_PERIODS{3};
     static constexpr uint32_t STACK_DEPTH{2880};
     static constexpr int PRIORITY{5};
     static constexpr sw::ThreadBase::CoreId CORE_ID{sw::ThreadBase::CoreId::_0};
     Config config_;
+    sw::LatencyMeter irqLatency_{};
+    common::DeviceConfig pendingConfig_{};
+    bool hasPendingConfig_{false};
+    common::radio::LinkSettings previousLink_{};
+    bool isLinkCheckArmed_{false};
+    common::Time linkCheckDeadlineMs_{0};
 };
 
 } // namespace app
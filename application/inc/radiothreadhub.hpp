@@ -1,12 +1,18 @@
 #pragma once
 
+#include "configstore.hpp"
 #include "defs.hpp"
+#include "ichannel.hpp"
 #include "iradio.hpp"
 #include "itimer.hpp"
+#include "latencymeter.hpp"
+#include "metrics.hpp"
+#include "mutex.hpp"
 #include "queue.hpp"
 #include "radiopacket.hpp"
 #include "threadbase.hpp"
 #include "utils.hpp"
+#include <array>
 
 namespace app {
 
@@ -18,17 +24,139 @@ class RadioThreadHub final : public sw::ThreadBase {
         timer::ITimer& timeoutTimer;
         sw::IQueueSender<def::ui::LedEvent>& ledEventQueue;
         sw::IQueueSender<common::Telemetry>& telemetryQueue;
+        radio::IChannel& channel;
+        ConfigStore& configStore; // Saved by ConfigStore::yield()
+        common::DeviceConfig& deviceConfig; // Applied configuration
     };
 
     explicit RadioThreadHub(Config config);
 
     ~RadioThreadHub() = default;
 
+    /**
+     * @brief Set a new device configuration.
+     *
+     * A change of the request period only is applied at once. Otherwise the
+     * configuration is sent to the controllers instead of the next telemetry
+     * requests, and applied and saved after every controller heard so far
+     * acknowledged it. It is dropped if one rejects it, or not all of them
+     * acknowledged it within the configuration attempts.
+     *
+     * @param deviceConfig New device configuration.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Invalid configuration.
+     */
+    common::Error setDeviceConfig(const common::DeviceConfig& deviceConfig);
+
+    /**
+     * @brief Get the applied device configuration.
+     *
+     * @return Device configuration.
+     */
+    common::DeviceConfig getDeviceConfig() const;
+
+    /**
+     * @brief Get latency between the radio interrupt and its handling.
+     *
+     * @return Latency statistics.
+     */
+    sw::LatencyMeter::Stats getIrqLatencyStats() const;
+
+    /**
+     * @brief Add radio metrics: TX and RX frames, CRC errors, response
+     * timeouts, RSSI and SNR of received frames.
+     *
+     * @param registry Registry to add to.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NO_MEM: Registry is full.
+     */
+    common::Error registerMetrics(sw::metrics::Registry& registry) const;
+
   private:
     void run_() override;
 
+    /**
+     * @brief Handle notification bits received by the thread.
+     *
+     * @param bits Notification bits.
+     */
+    void processNotification_(const NotificationBits bits);
+
     void processRadioIrqEvent_();
 
+    /**
+     * @brief Send the telemetry request, or the pending configuration.
+     */
+    void sendRequest_();
+
+    /**
+     * @brief Send the pending configuration.
+     *
+     * @return True if configuration was sent instead of a request.
+     */
+    bool sendConfig_();
+
+    /**
+     * @brief Handle a controller response to the sent configuration.
+     *
+     * @param buffer Pointer to the buffer containing the response.
+     * @param bufferLength Length of the buffer.
+     */
+    void handleConfigResponse_(const uint8_t* buffer,
+                               const size_t bufferLength);
+
+    /**
+     * @brief Apply and save a device configuration. Nothing is changed if
+     * the radio does not take its link settings.
+     *
+     * @param deviceConfig Device configuration.
+     */
+    void applyDeviceConfig_(const common::DeviceConfig& deviceConfig);
+
+    /**
+     * @brief Controller heard by the hub.
+     */
+    struct ControllerState {
+        bool isUsed;
+        uint8_t controllerId;
+        bool isConfirmed; // Acknowledged the pending configuration
+    };
+
+    /**
+     * @brief Get the state of a controller, add it if not known yet.
+     *
+     * @param controllerId Controller ID.
+     *
+     * @return Controller state, nullptr if the table is full.
+     */
+    ControllerState* addController_(const uint8_t controllerId);
+
+    /**
+     * @brief Remove controllers which did not acknowledge the configuration.
+     */
+    void forgetUnconfirmedControllers_();
+
+    /**
+     * @brief Send the frame deferred by the radio once it is due.
+     */
+    void flushPendingFrame_();
+
+    /**
+     * @brief Get time to wait for the next notification.
+     *
+     * @return Time in milliseconds until the deferred frame is due.
+     */
+    common::Time getWaitTimeMs_();
+
+    /**
+     * @brief Record RSSI and SNR of the last received frame.
+     */
+    void recordSignalQuality_();
+
     void processReceiveData_();
 
     void handlePacketData_(const packet::radio::Type& packetType,
@@ -51,16 +179,33 @@ class RadioThreadHub final : public sw::ThreadBase {
      */
     void setTimeoutTimer_();
 
-    static constexpr common::Time REQUEST_TIME_US{
-        common::utils::msToUs<common::Time, common::Time>(
-            common::utils::sToMs<common::Time, common::Time>(10))};
     static constexpr common::Time TIMEOUT_TIME_US{
         common::utils::msToUs<common::Time, common::Time>(
             common::utils::sToMs<common::Time, common::Time>(5))};
     static constexpr size_t MAX_READ_BUFFER{256};
+    static constexpr uint8_t MAX_CONFIG_ATTEMPTS{5};
+    static constexpr uint8_t MAX_CONTROLLERS{8};
+    // 4 dB buckets from -140 dBm, 1 dB buckets from -20 dB
+    static constexpr sw::metrics::LinearHistogram::Settings RSSI_SETTINGS{
+        -140, 4};
+    static constexpr sw::metrics::LinearHistogram::Settings SNR_SETTINGS{-20,
+                                                                         1};
     static constexpr uint32_t STACK_DEPTH{2880};
     static constexpr int PRIORITY{5};
     static constexpr sw::ThreadBase::CoreId CORE_ID{sw::ThreadBase::CoreId::_0};
     Config config_;
+    sw::LatencyMeter irqLatency_{};
+    sw::metrics::Counter txFrames_{};
+    sw::metrics::Counter rxFrames_{};
+    sw::metrics::Counter crcErrors_{};
+    sw::metrics::Counter timeouts_{};
+    sw::metrics::LinearHistogram rssi_{RSSI_SETTINGS};
+    sw::metrics::LinearHistogram snr_{SNR_SETTINGS};
+    mutable sw::Mutex configMutex_{};
+    common::DeviceConfig pendingConfig_{};
+    bool hasPendingConfig_{false};
+    bool isConfigSent_{false};
+    uint8_t configAttempts_{0};
+    std::array<ControllerState, MAX_CONTROLLERS> controllers_{};
 };
 } // namespace app
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "types.hpp"
+#include <array>
+
+namespace app {
+/**
+ * @class ReportFilter
+ * @brief Report-on-change filter for telemetry sent to the cloud.
+ *
+ * Telemetry is reported when any field moved out of its deadband since the
+ * last reported value of the same controller, or when nothing was reported
+ * for longer than the max silence time.
+ */
+class ReportFilter {
+  public:
+    /**
+     * @brief Deadband of a single field, the larger threshold is used.
+     * Zero disables the threshold.
+     */
+    struct Deadband {
+        float absolute; // Change in field units
+        float relative; // Change as a fraction of the last reported value
+    };
+
+    /**
+     * @brief Filter settings
+     */
+    struct Settings {
+        Deadband temperatureC;
+        Deadband humidityRh;
+        common::Time maxSilenceMs; // Heartbeat, report at least this often
+    };
+
+    /**
+     * @brief Filter statistics
+     */
+    struct Stats {
+        uint32_t reported;   // Telemetry passed to the cloud
+        uint32_t suppressed; // Telemetry within deadbands
+        uint32_t heartbeats; // Telemetry reported only due to max silence
+    };
+
+    static constexpr uint8_t MAX_CONTROLLERS{8};
+
+    /**
+     * @brief Construct a new ReportFilter object.
+     *
+     * @param settings Filter settings.
+     */
+    explicit ReportFilter(const Settings settings);
+
+    /**
+     * @brief Set filter settings.
+     *
+     * @param settings Filter settings.
+     */
+    void setSettings(const Settings settings);
+
+    /**
+     * @brief Check if telemetry should be reported and remember it if so.
+     *
+     * @param telemetry Telemetry received from a controller.
+     *
+     * @return True if telemetry should be published.
+     */
+    bool shouldReport(const common::Telemetry& telemetry);
+
+    /**
+     * @brief Forget the last reported values of all controllers.
+     */
+    void reset();
+
+    /**
+     * @brief Get filter statistics.
+     *
+     * @return Statistics since start or last reset.
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief Reset filter statistics.
+     */
+    void resetStats();
+
+  private:
+    /**
+     * @brief Last reported state of a controller.
+     */
+    struct ControllerState {
+        bool isUsed;
+        common::Telemetry telemetry;
+        common::Time reportedMs;
+    };
+
+    /**
+     * @brief Check if a field moved out of its deadband.
+     *
+     * @param value Current value.
+     * @param reportedValue Last reported value.
+     * @param deadband Deadband of the field.
+     *
+     * @return True if the change is larger than the deadband.
+     */
+    static bool isOutsideDeadband_(const float value, const float reportedValue,
+                                   const Deadband deadband);
+
+    /**
+     * @brief Get state of a controller, a new or least recently reported one
+     * is used for an unknown controller.
+     *
+     * @param controllerId Controller ID.
+     *
+     * @return Controller state.
+     */
+    ControllerState& getState_(const uint8_t controllerId);
+
+    Settings settings_;
+    Stats stats_{};
+    std::array<ControllerState, MAX_CONTROLLERS> states_{};
+};
+} // namespace app
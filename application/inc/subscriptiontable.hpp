@@ -0,0 +1,240 @@
+#pragma once
+
+#include "types.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <utility>
+
+namespace app {
+/**
+ * @class SubscriptionTable
+ * @brief Fixed-capacity table of MQTT topic filters and their callbacks.
+ *
+ * Topic filters are copied into the table, so the caller doesn't have to keep
+ * them alive. Entries never move, pointers to entries and their topics stay
+ * valid until removed. The table doesn't allocate and has no platform
+ * dependencies.
+ *
+ * @tparam Callback Callback type stored with each filter.
+ * @tparam MAX_ENTRIES Maximum number of filters.
+ * @tparam TOPIC_SIZE Maximum filter length including null terminator.
+ */
+template <typename Callback, size_t MAX_ENTRIES, size_t TOPIC_SIZE>
+class SubscriptionTable {
+  public:
+    /**
+     * @brief Topic filter with its callback.
+     */
+    struct Entry {
+        bool isUsed;
+        std::array<char, TOPIC_SIZE> topic; // Null terminated
+        size_t topicLength;
+        Callback cb;
+        common::Argument arg;
+
+        std::string_view getTopic() const {
+          return {topic.data(), topicLength};
+        }
+    };
+
+    /**
+     * @brief Adds a topic filter, replaces the callback if the filter is
+     * already in the table.
+     *
+     * @param filter Topic filter, may contain '+' and '#' wildcards.
+     * @param cb Callback.
+     * @param arg User-defined argument passed to the callback.
+     *
+     * @return Entry, nullptr if the filter is invalid, too long or the table
+     * is full.
+     */
+    Entry* add(const std::string_view filter, Callback cb,
+               common::Argument arg) {
+      if (filter.size() >= TOPIC_SIZE || not isValidFilter(filter)) {
+        return nullptr;
+      }
+
+      Entry* entry = find(filter);
+      if (entry == nullptr) {
+        auto freeEntry =
+            std::find_if(entries_.begin(), entries_.end(),
+                         [](const Entry& entry) { return not entry.isUsed; });
+        if (freeEntry == entries_.end()) {
+          return nullptr;
+        }
+
+        entry = &*freeEntry;
+        std::copy(filter.begin(), filter.end(), entry->topic.begin());
+        entry->topic[filter.size()] = '\0';
+        entry->topicLength = filter.size();
+        entry->isUsed = true;
+      }
+
+      entry->cb = std::move(cb);
+      entry->arg = arg;
+      return entry;
+    }
+
+    /**
+     * @brief Removes a topic filter.
+     *
+     * @param filter Topic filter.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NOT_FOUND: Filter is not in the table.
+     */
+    common::Error remove(const std::string_view filter) {
+      Entry* entry = find(filter);
+      if (entry == nullptr) {
+        return common::Error::NOT_FOUND;
+      }
+
+      *entry = {};
+      return common::Error::OK;
+    }
+
+    /**
+     * @brief Finds the entry of a topic filter, the filter is compared as is.
+     *
+     * @param filter Topic filter.
+     *
+     * @return Entry, nullptr if not found.
+     */
+    Entry* find(const std::string_view filter) {
+      auto entry = std::find_if(entries_.begin(), entries_.end(),
+                                [filter](const Entry& entry) {
+                                  return entry.isUsed &&
+                                         entry.getTopic() == filter;
+                                });
+      return entry != entries_.end() ? &*entry : nullptr;
+    }
+
+    /**
+     * @brief Calls a function for each entry whose filter matches a topic.
+     *
+     * @param topic Topic of a received message.
+     * @param function Function called with the matching entry.
+     *
+     * @return Number of matching entries.
+     */
+    template <typename Function>
+    size_t forEachMatch(const std::string_view topic, Function&& function) {
+      size_t count{0};
+      for (Entry& entry : entries_) {
+        if (entry.isUsed && isMatch(entry.getTopic(), topic)) {
+          function(entry);
+          ++count;
+        }
+      }
+      return count;
+    }
+
+    /**
+     * @brief Calls a function for each entry, e.g. to subscribe again after
+     * reconnect.
+     *
+     * @param function Function called with the entry.
+     */
+    template <typename Function> void forEach(Function&& function) {
+      for (Entry& entry : entries_) {
+        if (entry.isUsed) {
+          function(entry);
+        }
+      }
+    }
+
+    /**
+     * @brief Gets the number of filters in the table.
+     *
+     * @return Number of filters.
+     */
+    size_t size() const {
+      return std::count_if(entries_.begin(), entries_.end(),
+                           [](const Entry& entry) { return entry.isUsed; });
+    }
+
+    /**
+     * @brief Checks if a topic filter is valid. '+' must fill a whole level,
+     * '#' must fill the last level.
+     *
+     * @param filter Topic filter.
+     *
+     * @return True if valid.
+     */
+    static bool isValidFilter(const std::string_view filter) {
+      if (filter.empty()) {
+        return false;
+      }
+
+      for (size_t i = 0; i < filter.size(); ++i) {
+        const char c = filter[i];
+        if (c != '+' && c != '#') {
+          continue;
+        }
+
+        const bool isLevelStart = i == 0 || filter[i - 1] == '/';
+        const bool isLevelEnd = i + 1 == filter.size() || filter[i + 1] == '/';
+        if (not isLevelStart || not isLevelEnd) {
+          return false;
+        }
+        if (c == '#' && i + 1 != filter.size()) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    /**
+     * @brief Checks if a topic matches a topic filter. Wildcards don't match
+     * topics starting with '$'.
+     *
+     * @param filter Valid topic filter.
+     * @param topic Topic without wildcards.
+     *
+     * @return True if the topic matches.
+     */
+    static bool isMatch(const std::string_view filter,
+                        const std::string_view topic) {
+      if (not topic.empty() && topic.front() == '$' &&
+          (filter.empty() || filter.front() == '+' || filter.front() == '#')) {
+        return false;
+      }
+
+      size_t f{0};
+      size_t t{0};
+      while (f < filter.size()) {
+        if (filter[f] == '#') {
+          return true;
+        }
+
+        if (filter[f] == '+') {
+          while (t < topic.size() && topic[t] != '/') {
+            ++t;
+          }
+          ++f;
+          continue;
+        }
+
+        if (t == topic.size()) {
+          // "a/#" also matches the parent level "a"
+          return filter.substr(f) == "/#";
+        }
+
+        if (filter[f] != topic[t]) {
+          return false;
+        }
+        ++f;
+        ++t;
+      }
+
+      return t == topic.size();
+    }
+
+  private:
+    std::array<Entry, MAX_ENTRIES> entries_{};
+};
+} // namespace app
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "types.hpp"
+#include <array>
+
+namespace app {
+/**
+ * @class TelemetryAggregator
+ * @brief Windowed aggregation of telemetry per controller.
+ *
+ * In aggregated mode samples are accumulated with Welford's algorithm and one
+ * summary (min, max, mean, standard deviation) is produced per controller and
+ * window. The window of a controller starts with its first sample. In raw
+ * mode every sample is passed through as a single sample summary.
+ */
+class TelemetryAggregator {
+  public:
+    enum class Mode : uint8_t { RAW, AGGREGATED };
+
+    /**
+     * @brief Aggregator settings
+     */
+    struct Settings {
+        Mode mode;
+        common::Time windowMs;
+    };
+
+    static constexpr uint8_t MAX_CONTROLLERS{8};
+
+    /**
+     * @brief Construct a new TelemetryAggregator object.
+     *
+     * @param settings Aggregator settings.
+     */
+    explicit TelemetryAggregator(const Settings settings);
+
+    /**
+     * @brief Set aggregator settings. Open windows are closed at the next
+     * poll.
+     *
+     * @param settings Aggregator settings.
+     */
+    void setSettings(const Settings settings);
+
+    /**
+     * @brief Get aggregator mode.
+     *
+     * @return Aggregator mode.
+     */
+    Mode getMode() const;
+
+    /**
+     * @brief Add a sample to the window of its controller.
+     *
+     * @param telemetry Telemetry received from a controller.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Aggregator is in raw mode.
+     *   - common::Error::NO_MEM: No free window for the controller.
+     */
+    common::Error add(const common::Telemetry& telemetry);
+
+    /**
+     * @brief Take the summary of a closed window.
+     *
+     * @param summary Summary of the window.
+     *
+     * @return True if a window was closed, call again until false.
+     */
+    bool poll(common::TelemetrySummary& summary);
+
+    /**
+     * @brief Get time until the next window closes.
+     *
+     * @return Time in milliseconds, NO_WINDOW_MS if no window is open.
+     */
+    common::Time getWaitTimeMs() const;
+
+    /**
+     * @brief Convert a raw sample to a single sample summary.
+     *
+     * @param telemetry Telemetry received from a controller.
+     *
+     * @return Summary with window equal to 0.
+     */
+    static common::TelemetrySummary
+    toSummary(const common::Telemetry& telemetry);
+
+    static constexpr common::Time NO_WINDOW_MS{UINT32_MAX};
+
+  private:
+    /**
+     * @brief Streaming statistics of a single field.
+     */
+    struct Accumulator {
+        float mean;
+        float m2; // Sum of squared differences from the mean
+        float min;
+        float max;
+
+        void add(const float value, const uint16_t count);
+        common::FieldSummary getSummary(const uint16_t count) const;
+    };
+
+    /**
+     * @brief Open window of a controller.
+     */
+    struct Window {
+        bool isUsed;
+        uint8_t controllerId;
+        common::Time startMs;
+        uint16_t count;
+        Accumulator temperatureC;
+        Accumulator humidityRh;
+    };
+
+    /**
+     * @brief Get the window of a controller or a free one.
+     *
+     * @param controllerId Controller ID.
+     *
+     * @return Window, nullptr if all windows are used by other controllers.
+     */
+    Window* getWindow_(const uint8_t controllerId);
+
+    /**
+     * @brief Check if a window should be closed.
+     */
+    bool isWindowClosed_(const Window& window, const common::Time nowMs) const;
+
+    Settings settings_;
+    std::array<Window, MAX_CONTROLLERS> windows_{};
+};
+} // namespace app
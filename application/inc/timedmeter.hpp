@@ -4,6 +4,7 @@
 #include "interfaces/itimer.hpp"
 #include "types.hpp"
 #include "utils.hpp"
+#include <atomic>
 
 namespace app {
 class TimedMeter {
@@ -22,6 +23,17 @@ class TimedMeter {
      */
     explicit TimedMeter(Config config);
 
+    /**
+     * @brief Change the period of running measurements.
+     *
+     * @param timeUs Measurement period in microseconds.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error setPeriod(common::Time timeUs);
+
     /**
      * @brief Start periodic measurements.
      *
@@ -58,7 +70,7 @@ class TimedMeter {
     void takeMeasurement_();
 
     Config config_;
-    bool isReadyToMeasure_{false};
+    std::atomic<bool> isReadyToMeasure_{false};
 };
 
 } // namespace app
@@ -57,7 +57,7 @@ class UiThread final : public sw::ThreadBase {
     static constexpr common::Time DISCONNECTED_LED_TIME_US{
         common::utils::msToUs<common::Time, common::Time>(
             common::utils::sToMs<common::Time, common::Time>(2))};
-    static constexpr uint32_t STACK_DEPTH{2048};
+    static constexpr uint32_t STACK_DEPTH{3072}; // printf of the trace dump
     static constexpr int PRIORITY{5};
     static constexpr sw::ThreadBase::CoreId CORE_ID{sw::ThreadBase::CoreId::_0};
     Config config_;
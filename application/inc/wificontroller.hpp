@@ -1,8 +1,11 @@
 #pragma once
 
+#include "backoff.hpp"
 #include "defs.hpp"
+#include "ilinkpower.hpp"
 #include "istorage.hpp"
 #include "itimer.hpp"
+#include "metrics.hpp"
 #include "queue.hpp"
 #include "types.hpp"
 #include "utils.hpp"
@@ -16,8 +19,15 @@ namespace app {
  * @class WifiController
  * @brief Handles Wi-Fi operations such as initialization, connection
  * management, and event handling.
+ *
+ * BSSID and channel of the last access point are stored in NVS. Reconnects
+ * go directly to that access point without scanning all channels, the full
+ * scan is used again when the directed connect fails.
+ *
+ * The STA idles in modem power save and leaves it while the application
+ * reports it is busy, e.g. while a backlog is sent.
  */
-class WifiController {
+class WifiController final : public net::ILinkPower {
   public:
     struct Config {
         timer::ITimer& reconnectTimer;
@@ -62,6 +72,46 @@ class WifiController {
      */
     common::Error stop();
 
+    /**
+     * @brief Sets power save used while the application is idle.
+     *
+     * @param powerSave Power save mode.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error setIdlePowerSave(const net::Wifi::PowerSave powerSave);
+
+    /**
+     * @brief Switches between full performance and idle power save.
+     *
+     * @param isBusy True while the application needs full throughput.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error setBusy(const bool isBusy) override;
+
+    /**
+     * @brief Gets time spent in each power save mode.
+     *
+     * @return Power save statistics.
+     */
+    net::Wifi::PowerSaveStats getPowerSaveStats();
+
+    /**
+     * @brief Add Wi-Fi metrics: reconnect attempts.
+     *
+     * @param registry Registry to add to.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NO_MEM: Registry is full.
+     */
+    common::Error registerMetrics(sw::metrics::Registry& registry) const;
+
   private:
     /**
      * @brief Handles Wi-Fi events.
@@ -97,7 +147,18 @@ class WifiController {
     net::Wifi& getWifiInstance_();
 
     /**
-     * @brief Attempts to reconnect to the Wi-Fi network.
+     * @brief Handles a lost connection or a failed connection attempt.
+     */
+    void handleDisconnect_();
+
+    /**
+     * @brief Stores the access point of a new connection.
+     */
+    void storeApInfo_();
+
+    /**
+     * @brief Schedules a reconnect to the Wi-Fi network with jittered
+     * backoff.
      *
      * @return
      *   - common::Error::OK: Success.
@@ -147,15 +208,26 @@ class WifiController {
      */
     std::string_view toString_(net::Wifi::AuthenticateMode authenticateMode);
 
-    static constexpr common::Time RECONNECT_TIME_US{
-        common::utils::msToUs<common::Time, common::Time>(
-            common::utils::sToMs<common::Time, uint8_t>(60))};
+    static constexpr sw::Backoff::Settings RECONNECT_BACKOFF_SETTINGS{
+        200, common::utils::sToMs<common::Time, common::Time>(60)};
+    static constexpr net::Wifi::PowerSave IDLE_POWER_SAVE{
+        net::Wifi::PowerSave::MAX_MODEM};
+    // Beacon intervals (~102 ms) between wake-ups in MAX_MODEM
+    static constexpr uint16_t LISTEN_INTERVAL{3};
     static constexpr size_t AP_LIST_SIZE{5};
     static constexpr int NO_STA_IS_CONNECTED{0};
     static constexpr uint16_t NO_GET_AVAILABLE_AP{0};
+    // Failed attempts before the connection is reported as lost
     static constexpr uint8_t MAX_RECONNECT_ATTEMPTS{5};
     Config config_;
-    uint8_t reconnectAttempt_{0};
+    sw::Backoff reconnectBackoff_{RECONNECT_BACKOFF_SETTINGS};
+    net::Wifi::ApInfo apInfo_{};
+    bool isApInfoValid_{false};
+    bool isStaConnected_{false};
+    common::Time disconnectedMs_{0};
+    net::Wifi::PowerSave idlePowerSave_{IDLE_POWER_SAVE};
+    bool isBusy_{false};
+    sw::metrics::Counter reconnects_{};
 };
 
 } // namespace app
@@ -2,15 +2,344 @@
 
 #include "aws_iot_config.h"
 #include "aws_iot_mqtt_client.h"
+#include "aws_iot_mqtt_client_common_internal.h"
 #include "aws_iot_mqtt_client_interface.h"
 #include "aws_iot_version.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "mqttpacket.hpp"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/version.h"
+#include "mbedtls/x509_crt.h"
+#include "timer_interface.h"
+#include "trace.hpp"
+#include "uptime.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#ifndef MBEDTLS_PRIVATE
+#define MBEDTLS_PRIVATE(member) member
+#endif
+
+namespace {
+// Read timeout after the handshake, reads are bounded by the SDK timer
+constexpr uint32_t TLS_READ_TIMEOUT_MS{10};
+constexpr uint16_t ALPN_PORT{443};
+const char* ALPN_PROTOCOLS[]{"x-amzn-mqtt-ca", nullptr};
+constexpr std::string_view DRBG_PERSONALIZATION{"aws_iot_tls_wrapper"};
+
+/**
+ * @brief MQTT client with TLS state kept over reconnects. SDK network
+ * callbacks only get the network stack, the context is found from it.
+ */
+struct ClientContext {
+  AWS_IoT_Client client;
+  mbedtls_ssl_session session;
+  bool hasSession;
+  bool isTlsConfigured;    // Credentials parsed and TLS config set up
+  bool isTlsOpen;          // SSL context and socket must be freed
+  uint32_t lowestFreeHeap; // Free heap watermark during the handshake
+  app::AwsIotClient::TlsStats tlsStats;
+};
+
+// Context is only reached through these, client and network are members
+static_assert(std::is_standard_layout_v<ClientContext>);
+
+ClientContext& getContext(void* handler) {
+  return *static_cast<ClientContext*>(handler);
+}
+
+ClientContext& getContext(Network* network) {
+  return *reinterpret_cast<ClientContext*>(
+      reinterpret_cast<uint8_t*>(network) -
+      offsetof(ClientContext, client.networkStack));
+}
+
+AWS_IoT_Client* getClient(void* handler) {
+  return &getContext(handler).client;
+}
+
+void clearSession(ClientContext& context) {
+  if (context.hasSession) {
+    mbedtls_ssl_session_free(&context.session);
+    context.hasSession = false;
+  }
+}
+
+bool isSameSession(const mbedtls_ssl_session& a, const mbedtls_ssl_session& b) {
+  const size_t length = a.MBEDTLS_PRIVATE(id_len);
+  return length > 0 && length == b.MBEDTLS_PRIVATE(id_len) &&
+         std::memcmp(a.MBEDTLS_PRIVATE(id), b.MBEDTLS_PRIVATE(id), length) == 0;
+}
+
+void closeTls(ClientContext& context) {
+  if (not context.isTlsOpen) {
+    return;
+  }
+
+  TLSDataParams& tls = context.client.networkStack.tlsDataParams;
+  mbedtls_ssl_free(&tls.ssl);
+  mbedtls_net_free(&tls.server_fd);
+  context.isTlsOpen = false;
+}
+
+void freeTlsConfig(ClientContext& context) {
+  TLSDataParams& tls = context.client.networkStack.tlsDataParams;
+  mbedtls_ssl_config_free(&tls.conf);
+  mbedtls_pk_free(&tls.pkey);
+  mbedtls_x509_crt_free(&tls.clicert);
+  mbedtls_x509_crt_free(&tls.cacert);
+  mbedtls_ctr_drbg_free(&tls.ctr_drbg);
+  mbedtls_entropy_free(&tls.entropy);
+  context.isTlsConfigured = false;
+}
+
+/**
+ * @brief Parses credentials and sets up the TLS config, it is kept until the
+ * client is deleted.
+ */
+IoT_Error_t configureTls(ClientContext& context) {
+  Network& network = context.client.networkStack;
+  TLSDataParams& tls = network.tlsDataParams;
+  const TLSConnectParams& params = network.tlsConnectParams;
+
+  mbedtls_entropy_init(&tls.entropy);
+  mbedtls_ctr_drbg_init(&tls.ctr_drbg);
+  mbedtls_x509_crt_init(&tls.cacert);
+  mbedtls_x509_crt_init(&tls.clicert);
+  mbedtls_pk_init(&tls.pkey);
+  mbedtls_ssl_config_init(&tls.conf);
+  context.isTlsConfigured = true;
+
+  if (mbedtls_ctr_drbg_seed(&tls.ctr_drbg, mbedtls_entropy_func, &tls.entropy,
+                            reinterpret_cast<const unsigned char*>(
+                                DRBG_PERSONALIZATION.data()),
+                            DRBG_PERSONALIZATION.size()) != 0) {
+    freeTlsConfig(context);
+    return NETWORK_MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+  }
+
+  if (mbedtls_x509_crt_parse(
+          &tls.cacert,
+          reinterpret_cast<const unsigned char*>(params.pRootCALocation),
+          std::strlen(params.pRootCALocation) + 1) != 0) {
+    freeTlsConfig(context);
+    return NETWORK_X509_ROOT_CRT_PARSE_ERROR;
+  }
+
+  if (mbedtls_x509_crt_parse(
+          &tls.clicert,
+          reinterpret_cast<const unsigned char*>(params.pDeviceCertLocation),
+          std::strlen(params.pDeviceCertLocation) + 1) != 0) {
+    freeTlsConfig(context);
+    return NETWORK_X509_DEVICE_CRT_PARSE_ERROR;
+  }
+
+  const auto* privateKey =
+      reinterpret_cast<const unsigned char*>(params.pDevicePrivateKeyLocation);
+  const size_t privateKeyLength =
+      std::strlen(params.pDevicePrivateKeyLocation) + 1;
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+  int ret = mbedtls_pk_parse_key(&tls.pkey, privateKey, privateKeyLength,
+                                 nullptr, 0, mbedtls_ctr_drbg_random,
+                                 &tls.ctr_drbg);
+#else
+  int ret = mbedtls_pk_parse_key(&tls.pkey, privateKey, privateKeyLength,
+                                 nullptr, 0);
+#endif
+  if (ret != 0) {
+    freeTlsConfig(context);
+    return NETWORK_PK_PRIVATE_KEY_PARSE_ERROR;
+  }
+
+  if (mbedtls_ssl_config_defaults(&tls.conf, MBEDTLS_SSL_IS_CLIENT,
+                                  MBEDTLS_SSL_TRANSPORT_STREAM,
+                                  MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+    freeTlsConfig(context);
+    return SSL_CONNECTION_ERROR;
+  }
+
+  mbedtls_ssl_conf_authmode(&tls.conf, params.ServerVerificationFlag
+                                           ? MBEDTLS_SSL_VERIFY_REQUIRED
+                                           : MBEDTLS_SSL_VERIFY_OPTIONAL);
+  mbedtls_ssl_conf_rng(&tls.conf, mbedtls_ctr_drbg_random, &tls.ctr_drbg);
+  mbedtls_ssl_conf_ca_chain(&tls.conf, &tls.cacert, nullptr);
+  if (mbedtls_ssl_conf_own_cert(&tls.conf, &tls.clicert, &tls.pkey) != 0) {
+    freeTlsConfig(context);
+    return NETWORK_SSL_CERT_ERROR;
+  }
+
+  if (params.DestinationPort == ALPN_PORT &&
+      mbedtls_ssl_conf_alpn_protocols(&tls.conf, ALPN_PROTOCOLS) != 0) {
+    freeTlsConfig(context);
+    return SSL_CONNECTION_ERROR;
+  }
+
+  return SUCCESS;
+}
+
+/**
+ * @brief Handshake socket send, keeps the free heap watermark.
+ */
+int sendWithWatermark(void* arg, const unsigned char* buffer, size_t length) {
+  auto& context = *static_cast<ClientContext*>(arg);
+  context.lowestFreeHeap =
+      std::min(context.lowestFreeHeap, esp_get_free_heap_size());
+  return mbedtls_net_send(&context.client.networkStack.tlsDataParams.server_fd,
+                          buffer, length);
+}
+
+/**
+ * @brief Handshake socket receive, keeps the free heap watermark.
+ */
+int receiveWithWatermark(void* arg, unsigned char* buffer, size_t length,
+                         uint32_t timeoutMs) {
+  auto& context = *static_cast<ClientContext*>(arg);
+  context.lowestFreeHeap =
+      std::min(context.lowestFreeHeap, esp_get_free_heap_size());
+  return mbedtls_net_recv_timeout(
+      &context.client.networkStack.tlsDataParams.server_fd, buffer, length,
+      timeoutMs);
+}
+
+/**
+ * @brief Replaces the SDK TLS connect, which parses credentials and does a
+ * full handshake on every connect.
+ */
+IoT_Error_t tlsConnect(Network* network, TLSConnectParams* params) {
+  ClientContext& context = getContext(network);
+  if (params != nullptr) {
+    network->tlsConnectParams = *params;
+  }
+
+  // SDK does not destroy the network after every failed connect
+  closeTls(context);
+
+  if (not context.isTlsConfigured) {
+    IoT_Error_t iotErrorCode = configureTls(context);
+    if (iotErrorCode != SUCCESS) {
+      return iotErrorCode;
+    }
+  }
+
+  TLSDataParams& tls = network->tlsDataParams;
+  const TLSConnectParams& connectParams = network->tlsConnectParams;
+  mbedtls_net_init(&tls.server_fd);
+  mbedtls_ssl_init(&tls.ssl);
+  context.isTlsOpen = true;
+
+  std::array<char, 6> port{};
+  std::snprintf(port.data(), port.size(), "%u", connectParams.DestinationPort);
+  if (mbedtls_net_connect(&tls.server_fd, connectParams.pDestinationURL,
+                          port.data(), MBEDTLS_NET_PROTO_TCP) != 0 ||
+      mbedtls_net_set_block(&tls.server_fd) != 0) {
+    return NETWORK_ERR_NET_CONNECT_FAILED;
+  }
+
+  mbedtls_ssl_conf_read_timeout(&tls.conf, connectParams.timeout_ms);
+  if (mbedtls_ssl_setup(&tls.ssl, &tls.conf) != 0 ||
+      mbedtls_ssl_set_hostname(&tls.ssl, connectParams.pDestinationURL) !=
+          0) {
+    return SSL_CONNECTION_ERROR;
+  }
+  // Heap is sampled between handshake messages, allocations happen there
+  mbedtls_ssl_set_bio(&tls.ssl, &context, sendWithWatermark, nullptr,
+                      receiveWithWatermark);
+
+  if (context.hasSession &&
+      mbedtls_ssl_set_session(&tls.ssl, &context.session) != 0) {
+    // Full handshake still works without it
+    clearSession(context);
+  }
+
+  const uint32_t freeHeapBefore = esp_get_free_heap_size();
+  const size_t minimumFreeHeapBefore =
+      heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+  context.lowestFreeHeap = freeHeapBefore;
+  const common::Time startMs = sw::getUptimeMs();
+  int ret{0};
+  do {
+    ret = mbedtls_ssl_handshake(&tls.ssl);
+  } while (ret == MBEDTLS_ERR_SSL_WANT_READ ||
+           ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+  if (ret != 0) {
+    // Server may have rejected the session, don't offer it again
+    clearSession(context);
+    return SSL_CONNECTION_ERROR;
+  }
+
+  if (connectParams.ServerVerificationFlag &&
+      mbedtls_ssl_get_verify_result(&tls.ssl) != 0) {
+    clearSession(context);
+    return NETWORK_SSL_CERT_ERROR;
+  }
+
+  mbedtls_ssl_set_bio(&tls.ssl, &tls.server_fd, mbedtls_net_send, nullptr,
+                      mbedtls_net_recv_timeout);
+
+  app::AwsIotClient::TlsStats& stats = context.tlsStats;
+  stats.lastHandshakeMs = sw::getUptimeMs() - startMs;
+  uint32_t lowestFreeHeap =
+      std::min(context.lowestFreeHeap, esp_get_free_heap_size());
+  // A new low since boot can only be set by this handshake's allocations
+  const size_t minimumFreeHeap =
+      heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+  if (minimumFreeHeap < minimumFreeHeapBefore) {
+    lowestFreeHeap =
+        std::min(lowestFreeHeap, static_cast<uint32_t>(minimumFreeHeap));
+  }
+  stats.lastHandshakePeakHeap = freeHeapBefore - lowestFreeHeap;
+  ++stats.handshakes;
+
+  mbedtls_ssl_session session{};
+  mbedtls_ssl_session_init(&session);
+  if (mbedtls_ssl_get_session(&tls.ssl, &session) == 0) {
+    // Server echoes the offered session ID when it resumes the session
+    if (context.hasSession && isSameSession(context.session, session)) {
+      ++stats.resumedHandshakes;
+    }
+    clearSession(context);
+    context.session = session;
+    context.hasSession = true;
+  } else {
+    mbedtls_ssl_session_free(&session);
+    clearSession(context);
+  }
+
+  mbedtls_ssl_conf_read_timeout(&tls.conf, TLS_READ_TIMEOUT_MS);
+  return SUCCESS;
+}
+
+/**
+ * @brief Replaces the SDK TLS destroy, credentials and config are kept for
+ * the next connect.
+ */
+IoT_Error_t tlsDestroy(Network* network) {
+  closeTls(getContext(network));
+  return SUCCESS;
+}
+
+} // namespace
 
 namespace app {
 
 AwsIotClient::AwsIotClient(const std::string_view& clientId)
     : clientId_(clientId),
-      clientHandler_(static_cast<Handler*>(new AWS_IoT_Client{}),
-                     deleteHandler_) {}
+      clientHandler_(new ClientContext{}, deleteHandler_),
+      inFlight_{[this](const net::InFlightWindow::Message& message,
+                       const bool isDuplicate) {
+        return sendPublish_(message, isDuplicate);
+      }} {}
 
 common::Error AwsIotClient::init(char* hostUrl,
                                  const Certificates certificates) {
@@ -36,43 +365,59 @@ common::Error AwsIotClient::init(char* hostUrl,
   };
   mqttInitParams.disconnectHandlerData = this;
 
-  AWS_IoT_Client* client = static_cast<AWS_IoT_Client*>(clientHandler_.get());
+  AWS_IoT_Client* client = getClient(clientHandler_.get());
   IoT_Error_t iotErrorCode = aws_iot_mqtt_init(client, &mqttInitParams);
   if (iotErrorCode != SUCCESS) {
     return common::Error::FAIL;
   }
 
+  client->networkStack.connect = tlsConnect;
+  client->networkStack.destroy = tlsDestroy;
   return common::Error::OK;
 }
 
 void AwsIotClient::setDisconnectCallback(disconnectCallback cb,
                                          common::Argument arg) {
-  disconnectCb_ = cb;
+  disconnectCb_ = std::move(cb);
   disconnectArg_ = arg;
 }
 
 common::Error AwsIotClient::subscribe(const std::string_view& topic,
                                       const Qos qos, subscribeCallback cb,
                                       common::Argument arg) {
-  subscribeCallbacks_[topic] = {cb, arg};
-  SubscribeCallbackData* data = &subscribeCallbacks_[topic];
+  if (topic.size() >= MAX_TOPIC_SIZE ||
+      not Subscriptions::isValidFilter(topic)) {
+    return common::Error::INVALID_ARG;
+  }
+
+  const bool isSubscribed = subscriptions_.find(topic) != nullptr;
+  Subscriptions::Entry* entry = subscriptions_.add(topic, std::move(cb), arg);
+  if (entry == nullptr) {
+    return common::Error::NO_MEM;
+  }
 
+  if (isSubscribed) {
+    return common::Error::OK;
+  }
+
+  // SDK keeps the topic pointer and matches wildcards, so the owned topic and
+  // the entry are registered and a message goes straight to its entry
   IoT_Error_t iotErrorCode = aws_iot_mqtt_subscribe(
-      static_cast<AWS_IoT_Client*>(clientHandler_.get()), topic.data(),
-      topic.size(), static_cast<QoS>(qos),
+      getClient(clientHandler_.get()), entry->topic.data(),
+      entry->topicLength, static_cast<QoS>(qos),
       [](AWS_IoT_Client* client, char* topicName, uint16_t topicNameLen,
          IoT_Publish_Message_Params* params, void* arg) {
         assert(arg);
-        SubscribeCallbackData* data = static_cast<SubscribeCallbackData*>(arg);
-        if (data->cb) {
-          data->cb(topicName, topicNameLen, params->payload, params->payloadLen,
-                   data->arg);
+        auto* entry = static_cast<Subscriptions::Entry*>(arg);
+        if (entry->cb) {
+          entry->cb(topicName, topicNameLen, params->payload,
+                    params->payloadLen, entry->arg);
         }
       },
-      data);
+      entry);
 
   if (iotErrorCode != SUCCESS) {
-    subscribeCallbacks_.erase(topic);
+    subscriptions_.remove(topic);
     return common::Error::FAIL;
   }
 
@@ -90,17 +435,27 @@ common::Error AwsIotClient::connect() {
   connectParams.isWillMsgPresent = false;
 
   IoT_Error_t iotErrorCode = aws_iot_mqtt_connect(
-      static_cast<AWS_IoT_Client*>(clientHandler_.get()), &connectParams);
+      getClient(clientHandler_.get()), &connectParams);
+  if (iotErrorCode != SUCCESS) {
+    return common::Error::FAIL;
+  }
+
+  // A clean session drops the subscriptions on the broker, the SDK still
+  // holds every subscribed filter and sends them again
+  iotErrorCode = aws_iot_mqtt_resubscribe(getClient(clientHandler_.get()));
   if (iotErrorCode != SUCCESS) {
+    aws_iot_mqtt_disconnect(getClient(clientHandler_.get()));
     return common::Error::FAIL;
   }
 
+  // A failed resend is retried on the PUBACK timeout
+  inFlight_.resend();
   return common::Error::OK;
 }
 
 common::Error AwsIotClient::disconnect() {
   IoT_Error_t iotErrorCode = aws_iot_mqtt_disconnect(
-      static_cast<AWS_IoT_Client*>(clientHandler_.get()));
+      getClient(clientHandler_.get()));
   if (iotErrorCode != SUCCESS) {
     return common::Error::FAIL;
   }
@@ -109,19 +464,26 @@ common::Error AwsIotClient::disconnect() {
 }
 
 common::Error AwsIotClient::publish(const std::string_view& topic,
-                                    char* payload, size_t payloadSize) {
+                                    char* payload, size_t payloadSize,
+                                    const Qos qos) {
   if (payload == nullptr || payloadSize == 0) {
     return common::Error::INVALID_ARG;
   }
 
+  // The SDK takes any PUBACK as its own, it would complete a pipelined one
+  if (qos == Qos::_1 && inFlight_.getCount() > 0) {
+    return common::Error::INVALID_STATE;
+  }
+
+  sw::trace::Scope trace{"mqtt publish"};
   IoT_Publish_Message_Params publishMessageParams{};
-  publishMessageParams.qos = QOS1;
+  publishMessageParams.qos = static_cast<QoS>(qos);
   publishMessageParams.payloadLen = payloadSize;
   publishMessageParams.payload = payload;
   publishMessageParams.isRetained = 0;
 
   IoT_Error_t iotErrorCode =
-      aws_iot_mqtt_publish(static_cast<AWS_IoT_Client*>(clientHandler_.get()),
+      aws_iot_mqtt_publish(getClient(clientHandler_.get()),
                            topic.data(), topic.size(), &publishMessageParams);
   if (iotErrorCode != SUCCESS) {
     return common::Error::FAIL;
@@ -130,14 +492,213 @@ common::Error AwsIotClient::publish(const std::string_view& topic,
   return common::Error::OK;
 }
 
+common::Error AwsIotClient::publishAsync(const std::string_view& topic,
+                                         const char* payload,
+                                         size_t payloadSize, const Qos qos,
+                                         publishCallback cb,
+                                         common::Argument arg,
+                                         uint16_t& packetId) {
+  if (payload == nullptr || payloadSize == 0 ||
+      payloadSize > net::InFlightWindow::PAYLOAD_SIZE || topic.empty()) {
+    return common::Error::INVALID_ARG;
+  }
+
+  AWS_IoT_Client* client = getClient(clientHandler_.get());
+  if (not aws_iot_mqtt_is_client_connected(client)) {
+    return common::Error::INVALID_STATE;
+  }
+
+  if (qos == Qos::_0) {
+    // QoS0 is not acknowledged, the SDK only writes it to the socket
+    common::Error errorCode = publish(topic, const_cast<char*>(payload),
+                                      payloadSize, Qos::_0);
+    packetId = 0;
+    if (errorCode == common::Error::OK && cb) {
+      cb(packetId, common::Error::OK, arg);
+    }
+    return errorCode;
+  }
+
+  if (inFlight_.getFreeSlots() == 0) {
+    return common::Error::NO_MEM;
+  }
+
+  // Skip IDs still waiting for PUBACK after a counter wrap
+  do {
+    packetId = aws_iot_mqtt_get_next_packet_id(client);
+  } while (inFlight_.isInFlight(packetId));
+
+  return inFlight_.publish(topic, payload, payloadSize, packetId,
+                           std::move(cb), arg);
+}
+
+void AwsIotClient::setInFlightWindow(const uint8_t window) {
+  inFlight_.setWindow(window);
+}
+
+uint8_t AwsIotClient::getFreeInFlightSlots() const {
+  return inFlight_.getFreeSlots();
+}
+
 void AwsIotClient::yield() {
-  aws_iot_mqtt_yield(static_cast<AWS_IoT_Client*>(clientHandler_.get()),
-                     YIELD_TIMEOUT_MS);
+  AWS_IoT_Client* client = getClient(clientHandler_.get());
+  if (inFlight_.getCount() == 0) {
+    aws_iot_mqtt_yield(client, YIELD_TIMEOUT_MS);
+    return;
+  }
+
+  // SDK yield drops PUBACKs, read packets here until the window is empty.
+  // The SDK ping timer is not reset by publishes, so keep alive is sent here.
+  if (readPackets_() != common::Error::OK ||
+      keepAlive_() != common::Error::OK) {
+    // Let the SDK detect the broken connection and call disconnect handler
+    aws_iot_mqtt_yield(client, YIELD_TIMEOUT_MS);
+    return;
+  }
+
+  inFlight_.checkTimeouts();
+}
+
+int AwsIotClient::getSocket() {
+  AWS_IoT_Client* client = getClient(clientHandler_.get());
+  if (not aws_iot_mqtt_is_client_connected(client)) {
+    return -1;
+  }
+
+  return client->networkStack.tlsDataParams.server_fd.fd;
+}
+
+bool AwsIotClient::hasPendingData() {
+  AWS_IoT_Client* client = getClient(clientHandler_.get());
+  return mbedtls_ssl_get_bytes_avail(&client->networkStack.tlsDataParams.ssl) >
+         0;
+}
+
+AwsIotClient::RttStats AwsIotClient::getRttStats() const {
+  return inFlight_.getRttStats();
+}
+
+void AwsIotClient::resetRttStats() { inFlight_.resetRttStats(); }
+
+sw::LatencyHistogram::Snapshot AwsIotClient::getPublishLatency() const {
+  return inFlight_.getPublishLatency();
+}
+
+common::Error
+AwsIotClient::registerMetrics(sw::metrics::Registry& registry) const {
+  return inFlight_.registerMetrics(registry);
+}
+
+AwsIotClient::TlsStats AwsIotClient::getTlsStats() const {
+  return getContext(clientHandler_.get()).tlsStats;
+}
+
+void AwsIotClient::clearTlsSession() {
+  clearSession(getContext(clientHandler_.get()));
+}
+
+common::Error
+AwsIotClient::sendPublish_(const net::InFlightWindow::Message& message,
+                           const bool isDuplicate) {
+  sw::trace::Scope trace{"mqtt publish"};
+  uint8_t* buffer = packetBuffer_.data();
+  const size_t length = net::mqtt::serializePublish(
+      buffer, packetBuffer_.size(),
+      {message.topic, reinterpret_cast<const uint8_t*>(message.payload.data()),
+       message.payloadSize, message.packetId, 1, isDuplicate});
+  if (length == 0) {
+    return common::Error::NO_MEM;
+  }
+
+  AWS_IoT_Client* client = getClient(clientHandler_.get());
+  Timer timer{};
+  init_timer(&timer);
+  countdown_ms(&timer, MQTT_COMMAND_TIMEOUT_MS);
+
+  size_t writtenLength{0};
+  IoT_Error_t iotErrorCode = client->networkStack.write(
+      &client->networkStack, buffer, length, &timer, &writtenLength);
+  if (iotErrorCode != SUCCESS || writtenLength != length) {
+    return common::Error::FAIL;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error AwsIotClient::readPackets_() {
+  AWS_IoT_Client* client = getClient(clientHandler_.get());
+  Timer timer{};
+  init_timer(&timer);
+  countdown_ms(&timer, YIELD_TIMEOUT_MS);
+
+  while (not has_timer_expired(&timer)) {
+    uint8_t packetType{0};
+    // Also dispatches PUBLISH to subscriptions and handles PINGRESP
+    IoT_Error_t iotErrorCode =
+        aws_iot_mqtt_internal_cycle_read(client, &timer, &packetType);
+    if (iotErrorCode == MQTT_NOTHING_TO_READ ||
+        (iotErrorCode == SUCCESS && packetType == 0)) {
+      break;
+    }
+    if (iotErrorCode != SUCCESS) {
+      return common::Error::FAIL;
+    }
+
+    uint16_t packetId{0};
+    if (packetType == PUBACK &&
+        net::mqtt::deserializePuback(client->clientData.readBuf,
+                                     client->clientData.readBufSize,
+                                     packetId)) {
+      inFlight_.acknowledge(packetId);
+    }
+
+    if (inFlight_.getCount() == 0 && not hasPendingData()) {
+      break;
+    }
+  }
+
+  return common::Error::OK;
+}
+
+common::Error AwsIotClient::keepAlive_() {
+  AWS_IoT_Client* client = getClient(clientHandler_.get());
+  if (client->clientData.keepAliveInterval == 0 ||
+      not has_timer_expired(&client->pingTimer)) {
+    return common::Error::OK;
+  }
+
+  // No PINGRESP for a whole interval, the SDK yield disconnects
+  if (client->clientStatus.isPingOutstanding) {
+    return common::Error::FAIL;
+  }
+
+  Timer timer{};
+  init_timer(&timer);
+  countdown_ms(&timer, MQTT_COMMAND_TIMEOUT_MS);
+
+  size_t length{0};
+  if (aws_iot_mqtt_internal_serialize_zero(client->clientData.writeBuf,
+                                           client->clientData.writeBufSize,
+                                           PINGREQ, &length) != SUCCESS ||
+      aws_iot_mqtt_internal_send_packet(client, length, &timer) != SUCCESS) {
+    return common::Error::FAIL;
+  }
+
+  // PINGRESP is handled by the cycle read in readPackets_()
+  client->clientStatus.isPingOutstanding = true;
+  countdown_sec(&client->pingTimer, client->clientData.keepAliveInterval);
+  return common::Error::OK;
 }
 
 void AwsIotClient::deleteHandler_(Handler* clientHandler) {
   if (clientHandler) {
-    delete static_cast<AWS_IoT_Client*>(clientHandler);
+    ClientContext& context = getContext(clientHandler);
+    closeTls(context);
+    if (context.isTlsConfigured) {
+      freeTlsConfig(context);
+    }
+    clearSession(context);
+    delete &context;
   }
 }
 
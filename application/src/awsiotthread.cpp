@@ -1,7 +1,12 @@
 #include "awsiotthread.hpp"
+#include "allocationguard.hpp"
 #include "awspacket.hpp"
 #include "delay.hpp"
 #include "esp_log.h"
+#include "trace.hpp"
+#include "uptime.hpp"
+#include <algorithm>
+#include <cassert>
 #include <cstring>
 
 namespace {
@@ -13,16 +18,27 @@ AwsIotThread::AwsIotThread(Config config)
     : ThreadBase{{"AwsIotThread", STACK_DEPTH, PRIORITY, CORE_ID}},
       config_{config} {}
 
+common::Error
+AwsIotThread::registerMetrics(sw::metrics::Registry& registry) const {
+  return registry.add("mqtt.reconnects", reconnects_);
+}
+
 void AwsIotThread::run_() {
+  common::Error errorCode = eventSelector_.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init event selector");
+  }
+
   config_.reconnectTimer.setCallback(
       [](void* arg) {
         assert(arg);
         AwsIotThread* thread = static_cast<AwsIotThread*>(arg);
         thread->isConnectTriggered_ = true;
+        thread->eventSelector_.signal();
       },
       this);
 
-  config_.awsIotClient.setDisconnectCallback(
+  config_.mqttClient.setDisconnectCallback(
       [](common::Argument arg) {
         assert(arg);
         AwsIotThread* thread = static_cast<AwsIotThread*>(arg);
@@ -34,27 +50,78 @@ void AwsIotThread::run_() {
       [](common::Telemetry telemetry, common::Argument arg) {
         assert(arg);
         auto* thread = static_cast<AwsIotThread*>(arg);
-        common::Error errorCode = thread->publishTelemetry_(telemetry);
-        if (errorCode != common::Error::OK) {
-          ESP_LOGE(TAG.data(), "Failed to publish telemetry");
-        }
+        thread->handleTelemetry_(telemetry);
       },
       this);
 
-  while (config_.connectionEventGroup.wait(def::net::WIFI_CONNECTED_BIT,
-                                           CONNECTED_WAIT_TIMEOUT_MS) !=
-         common::Error::OK) {
-    ESP_LOGW(TAG.data(), "Waiting for wifi connected");
-  }
+  config_.telemetryQueue.setNotifyCallback(
+      [](common::Argument arg) {
+        assert(arg);
+        auto* thread = static_cast<AwsIotThread*>(arg);
+        thread->eventSelector_.signal();
+      },
+      this);
 
+  // Don't block on Wi-Fi, the queue must be drained into the log meanwhile
   isConnectTriggered_ = true;
 
   while (1) {
     yield_();
-    config_.telemetryQueue.yield();
-    config_.awsIotClient.yield();
-    sw::delayMs(10);
+    while (config_.telemetryQueue.yield()) {
+    }
+    flushAggregator_();
+    if (isAwsConnected_()) {
+      config_.shadowClient.yield();
+      drainTelemetryLog_();
+      publishMetrics_();
+    }
+    updatePowerSave_();
+    waitForEvent_();
+  }
+}
+
+bool AwsIotThread::isAwsConnected_() const {
+  return config_.connectionEventGroup.isBitsSet(def::net::AWS_CONNECTED_BIT);
+}
+
+void AwsIotThread::waitForEvent_() {
+  int socket{net::EventSelector::NO_SOCKET};
+  common::Time timeoutMs{OFFLINE_WAIT_MS};
+  if (isAwsConnected_()) {
+    socket = config_.mqttClient.getSocket();
+    timeoutMs = std::min(getConnectedWaitTimeMs_(), getMetricsWaitTimeMs_());
+  }
+  timeoutMs = std::min(timeoutMs, config_.aggregator.getWaitTimeMs());
+
+  net::EventSelector::Result result{};
+  common::Error errorCode = eventSelector_.wait(socket, timeoutMs, result);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to wait for events");
+    sw::delayMs(OFFLINE_WAIT_MS);
+    return;
+  }
+
+  if (not isAwsConnected_()) {
+    return;
+  }
+
+  const common::Time nowMs = sw::getUptimeMs();
+  if (result.isReadable || config_.mqttClient.hasPendingData() ||
+      nowMs - lastClientYieldMs_ >= KEEP_ALIVE_YIELD_MS) {
+    lastClientYieldMs_ = nowMs;
+    config_.mqttClient.yield();
+  }
+}
+
+common::Time AwsIotThread::getConnectedWaitTimeMs_() {
+  if (config_.mqttClient.hasPendingData()) {
+    return 0;
   }
+
+  // Backlog is sent again when PUBACK frees the window, socket wakes us
+  const common::Time sinceYieldMs = sw::getUptimeMs() - lastClientYieldMs_;
+  return sinceYieldMs < KEEP_ALIVE_YIELD_MS ? KEEP_ALIVE_YIELD_MS - sinceYieldMs
+                                            : 0;
 }
 
 void AwsIotThread::yield_() {
@@ -64,8 +131,7 @@ void AwsIotThread::yield_() {
   }
 
   if (not config_.connectionEventGroup.isBitsSet(def::net::AWS_CONNECTED_BIT)) {
-    if (isConnectTriggered_) {
-      isConnectTriggered_ = false;
+    if (isConnectTriggered_.exchange(false)) {
       handleConnect_();
     }
     return;
@@ -73,14 +139,23 @@ void AwsIotThread::yield_() {
 }
 
 void AwsIotThread::handleConnect_() {
-  common::Error errorCode = config_.awsIotClient.connect();
+  common::Error errorCode = config_.mqttClient.connect();
   if (errorCode != common::Error::OK) {
     ESP_LOGE(TAG.data(), "Failed to connect to AWS IoT");
     handleReconnect_();
     return;
   }
 
-  ESP_LOGI(TAG.data(), "Connected to AWS IoT");
+  reconnectBackoff_.reset();
+
+  const net::IMqttClient::TlsStats tlsStats = config_.mqttClient.getTlsStats();
+  ESP_LOGI(TAG.data(),
+           "Connected to AWS IoT, handshake %u ms, peak heap %u B, "
+           "resumed %u/%u",
+           static_cast<unsigned>(tlsStats.lastHandshakeMs),
+           static_cast<unsigned>(tlsStats.lastHandshakePeakHeap),
+           static_cast<unsigned>(tlsStats.resumedHandshakes),
+           static_cast<unsigned>(tlsStats.handshakes));
 
   errorCode = config_.connectionEventGroup.set(def::net::AWS_CONNECTED_BIT);
   if (errorCode != common::Error::OK) {
@@ -95,19 +170,21 @@ void AwsIotThread::handleConnect_() {
   }
 
   setSubscriptions_();
-}
 
-void AwsIotThread::handleReconnect_() {
-  ++connectCounter;
-  if (connectCounter >= MAX_CONNECT_ATTEMPTS) {
-    connectCounter = 0;
-    config_.reconnectTimer.startOnce(RECONNECT_AFTER_MAX_ATTEMPT_TIME_US);
-    return;
+  errorCode = config_.shadowClient.start();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to start shadow client");
   }
+}
 
-  const auto reconnectTimeUs =
-      RECONNECT_TIME_US * static_cast<common::Time>(connectCounter);
-  config_.reconnectTimer.startOnce(reconnectTimeUs);
+void AwsIotThread::handleReconnect_() {
+  reconnects_.add();
+  const common::Time delayMs = reconnectBackoff_.next();
+  ESP_LOGI(TAG.data(), "Reconnect attempt %u in %u ms",
+           static_cast<unsigned>(reconnectBackoff_.getState().attempts),
+           static_cast<unsigned>(delayMs));
+  config_.reconnectTimer.startOnce(
+      common::utils::msToUs<common::Time, common::Time>(delayMs));
 }
 
 void AwsIotThread::handleDisconnect_() {
@@ -134,13 +211,14 @@ void AwsIotThread::handleDisconnect_() {
              static_cast<int>(errorCode));
   }
 
-  isConnectTriggered_ = true;
+  // Hubs dropped by the same outage must not reconnect at the same moment
   ESP_LOGI(TAG.data(), "Disconnected from AWS IoT");
+  handleReconnect_();
 }
 
 void AwsIotThread::setSubscriptions_() {
-  common::Error errorCode = config_.awsIotClient.subscribe(
-      TELEMETRY_TOPIC, AwsIotClient::Qos::_1,
+  common::Error errorCode = config_.mqttClient.subscribe(
+      TELEMETRY_TOPIC, net::IMqttClient::Qos::_1,
       [](const char* topic, uint16_t packetId, void* payload,
          size_t payloadLength, common::Argument arg) {
         ESP_LOGI(TAG.data(), "Received message on topic: %s, message: %*s",
@@ -154,19 +232,204 @@ void AwsIotThread::setSubscriptions_() {
   }
 }
 
-common::Error AwsIotThread::publishTelemetry_(common::Telemetry telemetry) {
+common::Error
+AwsIotThread::publishTelemetry_(common::TelemetrySummary summary) {
+  sw::AllocationGuard guard{"telemetry publish"};
   std::array<char, packet::aws::BUFFER_SIZE> buffer{};
-  packet::aws::Telemetry telemetryPacket(telemetry);
-  common::Error errorCode =
-      telemetryPacket.serializeToJson(buffer.data(), buffer.size());
+  common::Error errorCode{common::Error::OK};
+  std::string_view topic{TELEMETRY_SUMMARY_TOPIC};
+  sw::trace::begin("json serialize");
+  if (summary.windowS == 0) {
+    // Raw sample keeps the original telemetry format
+    topic = TELEMETRY_TOPIC;
+    packet::aws::Telemetry telemetryPacket(
+        {summary.controllerId, summary.temperatureC.mean,
+         summary.humidityRh.mean});
+    errorCode = telemetryPacket.serializeToJson(buffer.data(), buffer.size());
+  } else {
+    packet::aws::TelemetrySummary summaryPacket(summary);
+    errorCode = summaryPacket.serializeToJson(buffer.data(), buffer.size());
+  }
+  sw::trace::end("json serialize");
   if (errorCode != common::Error::OK) {
     ESP_LOGE(TAG.data(), "Failed to parse telemetry to JSON");
     return errorCode;
   }
 
+  auto pending = std::find_if(
+      pendingTelemetry_.begin(), pendingTelemetry_.end(),
+      [](const PendingTelemetry& pending) { return not pending.isUsed; });
+  if (pending == pendingTelemetry_.end()) {
+    return common::Error::NO_MEM;
+  }
+
   const size_t bufferLength = std::strlen(buffer.data());
-  return config_.awsIotClient.publish(TELEMETRY_TOPIC, buffer.data(),
-                                      bufferLength);
+  uint16_t packetId{0};
+  errorCode = config_.mqttClient.publishAsync(
+      topic, buffer.data(), bufferLength, net::IMqttClient::Qos::_1,
+      [](uint16_t packetId, common::Error result, common::Argument arg) {
+        assert(arg);
+        auto* thread = static_cast<AwsIotThread*>(arg);
+        thread->handlePublishComplete_(packetId, result);
+      },
+      this, packetId);
+  if (errorCode != common::Error::OK) {
+    return errorCode;
+  }
+
+  *pending = {true, packetId, summary};
+  return common::Error::OK;
+}
+
+void AwsIotThread::handlePublishComplete_(const uint16_t packetId,
+                                          const common::Error result) {
+  auto pending = std::find_if(pendingTelemetry_.begin(),
+                              pendingTelemetry_.end(),
+                              [packetId](const PendingTelemetry& pending) {
+                                return pending.isUsed &&
+                                       pending.packetId == packetId;
+                              });
+  if (pending == pendingTelemetry_.end()) {
+    return;
+  }
+  pending->isUsed = false;
+
+  if (result == common::Error::OK) {
+    return;
+  }
+
+  ESP_LOGW(TAG.data(), "Telemetry not acknowledged, storing it");
+  common::Error errorCode = config_.telemetryLog.append(pending->summary);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to store telemetry errorCode: %d",
+             static_cast<int>(errorCode));
+  }
+}
+
+void AwsIotThread::handleTelemetry_(common::Telemetry telemetry) {
+  sw::AllocationGuard guard{"telemetry"};
+  if (config_.aggregator.getMode() == TelemetryAggregator::Mode::AGGREGATED) {
+    if (config_.aggregator.add(telemetry) == common::Error::OK) {
+      return;
+    }
+    ESP_LOGW(TAG.data(), "No aggregation window for controller %u, send raw",
+             telemetry.controllerId);
+  }
+
+  if (not config_.reportFilter.shouldReport(telemetry)) {
+    return;
+  }
+
+  handleSummary_(TelemetryAggregator::toSummary(telemetry));
+}
+
+void AwsIotThread::handleSummary_(const common::TelemetrySummary& summary) {
+  if (config_.connectionEventGroup.isBitsSet(def::net::AWS_CONNECTED_BIT)) {
+    common::Error errorCode = publishTelemetry_(summary);
+    if (errorCode == common::Error::OK) {
+      return;
+    }
+    if (errorCode != common::Error::NO_MEM) {
+      ESP_LOGE(TAG.data(), "Failed to publish telemetry");
+    }
+  }
+
+  common::Error errorCode = config_.telemetryLog.append(summary);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to store telemetry errorCode: %d",
+             static_cast<int>(errorCode));
+  }
+}
+
+void AwsIotThread::flushAggregator_() {
+  common::TelemetrySummary summary{};
+  while (config_.aggregator.poll(summary)) {
+    handleSummary_(summary);
+  }
+}
+
+void AwsIotThread::drainTelemetryLog_() {
+  while (config_.mqttClient.getFreeInFlightSlots() > LIVE_RESERVED_SLOTS) {
+    common::TelemetrySummary summary{};
+    if (config_.telemetryLog.peek(summary) != common::Error::OK) {
+      return;
+    }
+
+    // Removed before publishing, a record left in the log would be sent
+    // again by the next drain. The in-flight slot keeps it until PUBACK.
+    common::Error errorCode = config_.telemetryLog.pop();
+    if (errorCode != common::Error::OK) {
+      ESP_LOGE(TAG.data(), "Failed to remove stored telemetry errorCode: %d",
+               static_cast<int>(errorCode));
+      return;
+    }
+
+    errorCode = publishTelemetry_(summary);
+    if (errorCode != common::Error::OK) {
+      ESP_LOGW(TAG.data(), "Failed to publish stored telemetry");
+      errorCode = config_.telemetryLog.append(summary);
+      if (errorCode != common::Error::OK) {
+        ESP_LOGE(TAG.data(), "Failed to store telemetry errorCode: %d",
+                 static_cast<int>(errorCode));
+      }
+      return;
+    }
+  }
+}
+
+void AwsIotThread::updatePowerSave_() {
+  // Offline backlog is sent after reconnect, no need to stay awake for it
+  const bool isDraining =
+      isAwsConnected_() && not config_.telemetryLog.isEmpty();
+  if (isDraining == isDraining_) {
+    return;
+  }
+
+  isDraining_ = isDraining;
+  config_.linkPower.setBusy(isDraining_);
+  // Disconnect stops the drain too, the rest is sent after reconnect
+  if (not isDraining_ && config_.telemetryLog.isEmpty()) {
+    const net::IMqttClient::RttStats rttStats =
+        config_.mqttClient.getRttStats();
+    ESP_LOGI(TAG.data(), "Backlog sent, PUBACK RTT avg %u ms, max %u ms",
+             static_cast<unsigned>(
+                 rttStats.count > 0 ? rttStats.totalMs / rttStats.count : 0),
+             static_cast<unsigned>(rttStats.maxMs));
+    config_.mqttClient.resetRttStats();
+  }
+}
+
+void AwsIotThread::publishMetrics_() {
+  if (getMetricsWaitTimeMs_() != 0) {
+    return;
+  }
+  lastMetricsMs_ = sw::getUptimeMs();
+
+  sw::AllocationGuard guard{"metrics publish"};
+  constexpr uint64_t US_PER_S{1'000'000};
+  std::array<char, packet::aws::METRICS_BUFFER_SIZE> buffer{};
+  packet::aws::Metrics metricsPacket{
+      config_.metrics, static_cast<uint32_t>(sw::getUptimeUs() / US_PER_S)};
+  common::Error errorCode =
+      metricsPacket.serializeToJson(buffer.data(), buffer.size());
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to parse metrics to JSON");
+    return;
+  }
+
+  // Next snapshot replaces a lost one, no need to wait for PUBACK
+  errorCode = config_.mqttClient.publish(METRICS_TOPIC, buffer.data(),
+                                           std::strlen(buffer.data()),
+                                           net::IMqttClient::Qos::_0);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGW(TAG.data(), "Failed to publish metrics");
+  }
+}
+
+common::Time AwsIotThread::getMetricsWaitTimeMs_() const {
+  const common::Time sinceMetricsMs = sw::getUptimeMs() - lastMetricsMs_;
+  return sinceMetricsMs < METRICS_PERIOD_MS ? METRICS_PERIOD_MS - sinceMetricsMs
+                                            : 0;
 }
 
 } // namespace app
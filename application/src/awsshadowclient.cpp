@@ -0,0 +1,259 @@
+#include "awsshadowclient.hpp"
+#include "allocationguard.hpp"
+#include "awspacket.hpp"
+#include "esp_log.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+namespace {
+static constexpr std::string_view TAG{"AWS_SHADOW"};
+static constexpr std::string_view GET_PAYLOAD{"{}"};
+static constexpr std::string_view UPDATE_SUFFIX{"/update"};
+static constexpr std::string_view GET_SUFFIX{"/get"};
+
+/**
+ * @brief Writes $aws/things/<thingName>/shadow<action><reply> to the buffer.
+ *
+ * @return Topic and its start without the reply part, empty if too long.
+ */
+template <size_t N>
+std::pair<std::string_view, std::string_view>
+formatTopic(std::array<char, N>& buffer, const std::string_view thingName,
+            const std::string_view action, const char* reply) {
+  const int length = std::snprintf(
+      buffer.data(), buffer.size(), "$aws/things/%.*s/shadow%.*s%s",
+      static_cast<int>(thingName.size()), thingName.data(),
+      static_cast<int>(action.size()), action.data(), reply);
+  if (length < 0 || static_cast<size_t>(length) >= buffer.size()) {
+    buffer[0] = '\0';
+    return {};
+  }
+
+  const std::string_view topic{buffer.data(), static_cast<size_t>(length)};
+  return {topic, topic.substr(0, topic.size() - std::strlen(reply))};
+}
+} // namespace
+
+namespace app {
+AwsShadowClient::AwsShadowClient(Config config) : config_{config} {
+  std::tie(deltaTopic_, updateTopic_) = formatTopic(
+      deltaTopicBuffer_, config_.thingName, UPDATE_SUFFIX, "/delta");
+  std::tie(getAcceptedTopic_, getTopic_) = formatTopic(
+      getAcceptedTopicBuffer_, config_.thingName, GET_SUFFIX, "/accepted");
+  if (deltaTopic_.empty() || getAcceptedTopic_.empty()) {
+    ESP_LOGE(TAG.data(), "Thing name does not fit the topic buffer");
+  }
+}
+
+void AwsShadowClient::setDeltaCallback(deltaCallback cb, common::Argument arg) {
+  deltaCb_ = std::move(cb);
+  deltaArg_ = arg;
+}
+
+common::Error AwsShadowClient::setReported(const std::string_view key,
+                                           const double value) {
+  if (key.empty()) {
+    return common::Error::INVALID_ARG;
+  }
+
+  std::lock_guard<sw::Mutex> lock{fieldsMutex_};
+  Field* field = findField_(key);
+  if (field == nullptr) {
+    auto freeField =
+        std::find_if(fields_.begin(), fields_.end(),
+                     [](const Field& field) { return field.key.empty(); });
+    if (freeField == fields_.end()) {
+      return common::Error::NO_MEM;
+    }
+
+    *freeField = {key, value, 0.0, false, true, 0};
+    return common::Error::OK;
+  }
+
+  if (field->reportedValue != value) {
+    field->reportedValue = value;
+    field->isDirty = true;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error AwsShadowClient::start() {
+  if (deltaTopic_.empty() || getAcceptedTopic_.empty()) {
+    return common::Error::FAIL;
+  }
+
+  auto subscribeCb = [](const char* topic, uint16_t topicLength, void* payload,
+                        size_t payloadLength, common::Argument arg) {
+    assert(arg);
+    auto* client = static_cast<AwsShadowClient*>(arg);
+    const bool isGetAccepted =
+        std::string_view{topic, topicLength} == client->getAcceptedTopic_;
+    client->handleDelta_(payload, payloadLength, isGetAccepted);
+  };
+
+  common::Error errorCode = config_.mqttClient.subscribe(
+      deltaTopic_, net::IMqttClient::Qos::_1, subscribeCb, this);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to subscribe to topic: %s",
+             deltaTopicBuffer_.data());
+    return common::Error::FAIL;
+  }
+
+  errorCode = config_.mqttClient.subscribe(
+      getAcceptedTopic_, net::IMqttClient::Qos::_1, subscribeCb, this);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to subscribe to topic: %s",
+             getAcceptedTopicBuffer_.data());
+    return common::Error::FAIL;
+  }
+
+  // Delta is only pushed on change, ask for the one pending while offline
+  uint16_t packetId{0};
+  errorCode = config_.mqttClient.publishAsync(
+      getTopic_, GET_PAYLOAD.data(), GET_PAYLOAD.size(),
+      net::IMqttClient::Qos::_0, nullptr, nullptr, packetId);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to request shadow");
+    return common::Error::FAIL;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error AwsShadowClient::yield() {
+  std::lock_guard<sw::Mutex> lock{fieldsMutex_};
+  const bool isAnyDirty =
+      std::any_of(fields_.begin(), fields_.end(),
+                  [](const Field& field) { return field.isDirty; });
+  if (not isAnyDirty) {
+    return common::Error::OK;
+  }
+
+  if (config_.mqttClient.getFreeInFlightSlots() == 0) {
+    return common::Error::NO_MEM;
+  }
+
+  sw::AllocationGuard guard{"shadow report"};
+  packet::aws::ShadowReported reported{};
+  for (const auto& field : fields_) {
+    if (field.isDirty) {
+      reported.add(field.key, field.reportedValue);
+    }
+  }
+
+  std::array<char, BUFFER_SIZE> buffer{};
+  if (reported.serializeToJson(buffer.data(), buffer.size()) !=
+      common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Reported state does not fit the buffer");
+    return common::Error::FAIL;
+  }
+
+  uint16_t packetId{0};
+  common::Error errorCode = config_.mqttClient.publishAsync(
+      updateTopic_, buffer.data(), std::strlen(buffer.data()),
+      net::IMqttClient::Qos::_1,
+      [](uint16_t packetId, common::Error result, common::Argument arg) {
+        assert(arg);
+        auto* client = static_cast<AwsShadowClient*>(arg);
+        client->handleUpdateComplete_(packetId, result);
+      },
+      this, packetId);
+  if (errorCode != common::Error::OK) {
+    return errorCode;
+  }
+
+  for (auto& field : fields_) {
+    if (field.isDirty) {
+      field.isDirty = false;
+      field.packetId = packetId;
+    }
+  }
+
+  return common::Error::OK;
+}
+
+void AwsShadowClient::handleDelta_(const void* payload,
+                                   const size_t payloadLength,
+                                   const bool isGetAccepted) {
+  // Covers the delta callback, it runs on the cloud thread too
+  sw::AllocationGuard guard{"shadow delta"};
+  packet::aws::ShadowDelta delta{};
+  if (delta.parseFromJson(static_cast<const char*>(payload), payloadLength,
+                          isGetAccepted) != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to parse shadow document");
+    return;
+  }
+
+  if (not delta.hasDelta()) {
+    // Get without delta means desired and reported states are in sync
+    return;
+  }
+
+  if (delta.getVersion() <= desiredVersion_) {
+    return;
+  }
+  desiredVersion_ = delta.getVersion();
+
+  if (delta.getSkippedCount() > 0) {
+    ESP_LOGW(TAG.data(), "Skipping %u desired fields over the limit",
+             static_cast<unsigned>(delta.getSkippedCount()));
+  }
+
+  for (size_t i = 0; i < delta.getFieldCount(); ++i) {
+    const packet::aws::ShadowDelta::Field& item = delta.getField(i);
+    if (not item.isNumber) {
+      ESP_LOGW(TAG.data(), "Skipping non-numeric desired field: %.*s",
+               static_cast<int>(item.key.size()), item.key.data());
+      continue;
+    }
+
+    {
+      // Released for the callback, it may set reported fields
+      std::lock_guard<sw::Mutex> lock{fieldsMutex_};
+      Field* field = findField_(item.key);
+      if (field != nullptr) {
+        if (field->hasDesired && field->desiredValue == item.value) {
+          continue;
+        }
+        field->desiredValue = item.value;
+        field->hasDesired = true;
+      }
+    }
+
+    if (deltaCb_) {
+      deltaCb_(item.key, item.value, deltaArg_);
+    }
+  }
+}
+
+void AwsShadowClient::handleUpdateComplete_(const uint16_t packetId,
+                                            const common::Error result) {
+  if (result == common::Error::OK) {
+    return;
+  }
+
+  ESP_LOGW(TAG.data(), "Reported state update failed, retrying");
+  std::lock_guard<sw::Mutex> lock{fieldsMutex_};
+  for (auto& field : fields_) {
+    if (not field.key.empty() && field.packetId == packetId) {
+      field.isDirty = true;
+    }
+  }
+}
+
+AwsShadowClient::Field*
+AwsShadowClient::findField_(const std::string_view key) {
+  auto field = std::find_if(fields_.begin(), fields_.end(),
+                            [key](const Field& field) {
+                              return not field.key.empty() && field.key == key;
+                            });
+  return field != fields_.end() ? &(*field) : nullptr;
+}
+
+} // namespace app
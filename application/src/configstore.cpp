@@ -0,0 +1,106 @@
+#include "configstore.hpp"
+#include "defs.hpp"
+#include "esp_log.h"
+#include <mutex>
+#include <string_view>
+
+namespace {
+static constexpr std::string_view TAG{"ConfigStore"};
+}
+
+namespace app {
+ConfigStore::ConfigStore(Config config) : config_{config} {}
+
+common::Error ConfigStore::load(common::DeviceConfig& deviceConfig) {
+  // Packed fields can't be bound to references, read into locals.
+  // Missing keys are not an error, defaults stay until the first save.
+  uint32_t measurementPeriodS{deviceConfig.measurementPeriodS};
+  uint32_t requestPeriodS{deviceConfig.requestPeriodS};
+  uint8_t spreadingFactor{deviceConfig.link.spreadingFactor};
+  uint32_t bandwidthHz{deviceConfig.link.bandwidthHz};
+  uint8_t txPower{static_cast<uint8_t>(deviceConfig.link.txPowerDbm)};
+
+  config_.storage.getItem(def::key::config::MEASUREMENT_PERIOD,
+                          measurementPeriodS);
+  config_.storage.getItem(def::key::config::REQUEST_PERIOD, requestPeriodS);
+  config_.storage.getItem(def::key::config::SPREADING_FACTOR, spreadingFactor);
+  config_.storage.getItem(def::key::config::BANDWIDTH, bandwidthHz);
+  config_.storage.getItem(def::key::config::TX_POWER, txPower);
+
+  const common::DeviceConfig stored{
+      measurementPeriodS,
+      requestPeriodS,
+      {spreadingFactor, bandwidthHz, static_cast<int8_t>(txPower)}};
+  if (not isValid(stored)) {
+    return common::Error::INVALID_STATE;
+  }
+
+  deviceConfig = stored;
+  return common::Error::OK;
+}
+
+common::Error ConfigStore::save(const common::DeviceConfig& deviceConfig) {
+  if (not isValid(deviceConfig)) {
+    return common::Error::INVALID_ARG;
+  }
+
+  const uint32_t measurementPeriodS{deviceConfig.measurementPeriodS};
+  const uint32_t requestPeriodS{deviceConfig.requestPeriodS};
+  const uint8_t spreadingFactor{deviceConfig.link.spreadingFactor};
+  const uint32_t bandwidthHz{deviceConfig.link.bandwidthHz};
+  const uint8_t txPower{static_cast<uint8_t>(deviceConfig.link.txPowerDbm)};
+
+  if (config_.storage.setItem(def::key::config::MEASUREMENT_PERIOD,
+                              measurementPeriodS) != common::Error::OK ||
+      config_.storage.setItem(def::key::config::REQUEST_PERIOD,
+                              requestPeriodS) != common::Error::OK ||
+      config_.storage.setItem(def::key::config::SPREADING_FACTOR,
+                              spreadingFactor) != common::Error::OK ||
+      config_.storage.setItem(def::key::config::BANDWIDTH, bandwidthHz) !=
+          common::Error::OK ||
+      config_.storage.setItem(def::key::config::TX_POWER, txPower) !=
+          common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  return config_.storage.save();
+}
+
+common::Error ConfigStore::saveLater(const common::DeviceConfig& deviceConfig) {
+  if (not isValid(deviceConfig)) {
+    return common::Error::INVALID_ARG;
+  }
+
+  std::lock_guard<sw::Mutex> lock{pendingMutex_};
+  pendingConfig_ = deviceConfig;
+  hasPendingConfig_ = true;
+  return common::Error::OK;
+}
+
+void ConfigStore::yield() {
+  common::DeviceConfig deviceConfig{};
+  {
+    std::lock_guard<sw::Mutex> lock{pendingMutex_};
+    if (not hasPendingConfig_) {
+      return;
+    }
+    deviceConfig = pendingConfig_;
+    hasPendingConfig_ = false;
+  }
+
+  if (save(deviceConfig) != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Save config fail");
+  }
+}
+
+bool ConfigStore::isValid(const common::DeviceConfig& deviceConfig) {
+  // Only link settings the radio takes, hub and controllers share the PA pin
+  return deviceConfig.measurementPeriodS >= MIN_MEASUREMENT_PERIOD_S &&
+         deviceConfig.measurementPeriodS <= MAX_PERIOD_S &&
+         deviceConfig.requestPeriodS >= MIN_REQUEST_PERIOD_S &&
+         deviceConfig.requestPeriodS <= MAX_PERIOD_S &&
+         ::radio::Rfm95::isLinkSupported(deviceConfig.link,
+                                         def::radio::MODEM_SETTINGS.paPin);
+}
+
+} // namespace app
@@ -0,0 +1,89 @@
+#include "greenhousecontroller.hpp"
+#include "defs.hpp"
+#include "esp_log.h"
+#include "utils.hpp"
+#include <string_view>
+
+namespace {
+static constexpr std::string_view TAG{"Controller"};
+} // namespace
+
+namespace app {
+GreenhouseController::GreenhouseController(Config config)
+    : config_{config}, configStore_{{config.storage}},
+      lbtRadio_{{config.rfm95, config.rfm95}},
+      dutyCycleRadio_{{lbtRadio_, config.rfm95}},
+      timedMeter_{{config.measurementTimer, config.temperatureSensor,
+                   config.humiditySensor, telemetry_}},
+      radioThread_{{dutyCycleRadio_, telemetry_, config.rfm95, timedMeter_,
+                    configStore_, deviceConfig_}} {
+  telemetry_.controllerId = config.controllerId;
+}
+
+common::Error GreenhouseController::init() {
+  bool isInitOk{true};
+
+  common::Error errorCode = configStore_.load(deviceConfig_);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "stored config invalid, using defaults");
+  }
+
+  errorCode = config_.rfm95.init(radio::Rfm95::Modulation::LORA);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "radio init fail");
+    isInitOk = false;
+  }
+
+  errorCode = config_.rfm95.setAllSettings(def::radio::MODEM_SETTINGS);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "radio set all settings fail");
+    isInitOk = false;
+  }
+
+  errorCode = config_.rfm95.setLinkSettings(deviceConfig_.link);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "radio set link settings fail");
+    isInitOk = false;
+  }
+
+  return isInitOk ? common::Error::OK : common::Error::FAIL;
+}
+
+common::Error GreenhouseController::start() {
+  common::Error errorCode =
+      timedMeter_.start(common::utils::msToUs<common::Time, common::Time>(
+          common::utils::sToMs<common::Time, common::Time>(
+              deviceConfig_.measurementPeriodS)));
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "timed meter start fail");
+    return common::Error::FAIL;
+  }
+
+  errorCode = radioThread_.start();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "radio thread start fail");
+    return common::Error::FAIL;
+  }
+
+  return common::Error::OK;
+}
+
+void GreenhouseController::yield() {
+  timedMeter_.yield();
+  configStore_.yield();
+}
+
+const radio::ListenBeforeTalk&
+GreenhouseController::getListenBeforeTalk() const {
+  return lbtRadio_;
+}
+
+const radio::DutyCycleLimiter&
+GreenhouseController::getDutyCycleLimiter() const {
+  return dutyCycleRadio_;
+}
+
+const RadioThreadController& GreenhouseController::getRadioThread() const {
+  return radioThread_;
+}
+} // namespace app
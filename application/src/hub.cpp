@@ -0,0 +1,287 @@
+#include "hub.hpp"
+#include "allocationguard.hpp"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "utils.hpp"
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+static constexpr std::string_view TAG{"HUB"};
+// Report when air moved more than sensor noise, or every 15 minutes
+static constexpr app::ReportFilter::Settings REPORT_FILTER_SETTINGS{
+    {0.2f, 0.0f},
+    {1.0f, 0.0f},
+    common::utils::sToMs<common::Time, common::Time>(
+        common::utils::minToS<common::Time, common::Time>(15))};
+
+// Shadow keys of the device configuration fields
+static constexpr std::string_view MEASUREMENT_PERIOD_KEY{"measurementPeriodS"};
+static constexpr std::string_view REQUEST_PERIOD_KEY{"requestPeriodS"};
+static constexpr std::string_view SPREADING_FACTOR_KEY{"spreadingFactor"};
+static constexpr std::string_view BANDWIDTH_KEY{"bandwidthHz"};
+static constexpr std::string_view TX_POWER_KEY{"txPowerDbm"};
+
+/**
+ * @brief Check if a shadow number can be cast to a field type.
+ *
+ * @return False if value is not finite or out of the type range.
+ */
+template <typename T> bool fits(const double value) {
+  // Casting such a value is undefined, it may wrap into a valid one
+  return std::isfinite(value) and
+         value >= static_cast<double>(std::numeric_limits<T>::min()) and
+         value <= static_cast<double>(std::numeric_limits<T>::max());
+}
+
+/**
+ * @brief Set a device configuration field by its shadow key.
+ *
+ * @return False if key is unknown or value does not fit the field.
+ */
+bool setConfigField(common::DeviceConfig& deviceConfig,
+                    const std::string_view key, const double value) {
+  if (key == TX_POWER_KEY and fits<int8_t>(value)) {
+    deviceConfig.link.txPowerDbm = static_cast<int8_t>(value);
+  } else if (key == MEASUREMENT_PERIOD_KEY and fits<uint32_t>(value)) {
+    deviceConfig.measurementPeriodS = static_cast<uint32_t>(value);
+  } else if (key == REQUEST_PERIOD_KEY and fits<uint32_t>(value)) {
+    deviceConfig.requestPeriodS = static_cast<uint32_t>(value);
+  } else if (key == SPREADING_FACTOR_KEY and fits<uint8_t>(value)) {
+    deviceConfig.link.spreadingFactor = static_cast<uint8_t>(value);
+  } else if (key == BANDWIDTH_KEY and fits<uint32_t>(value)) {
+    deviceConfig.link.bandwidthHz = static_cast<uint32_t>(value);
+  } else {
+    return false;
+  }
+
+  return true;
+}
+} // namespace
+
+namespace app {
+Hub::Hub(Config config, const Settings settings)
+    : config_{config}, settings_{settings}, configStore_{{config.storage}},
+      lbtRadio_{{config.rfm95, config.rfm95}},
+      dutyCycleRadio_{{lbtRadio_, config.rfm95}},
+      radioThread_{{dutyCycleRadio_, requestTimer_, timeoutTimer_,
+                    config.ledEventQueue, telemetryQueue_, config.rfm95,
+                    configStore_, deviceConfig_}},
+      reportFilter_{REPORT_FILTER_SETTINGS}, aggregator_{settings.aggregator},
+      shadowClient_{{config.mqttClient, config.thingName}},
+      awsThread_{{config.mqttClient, config.connectionEventGroup,
+                  telemetryQueue_, config.ledEventQueue, reconnectTimer_,
+                  config.telemetryLog, reportFilter_, aggregator_,
+                  shadowClient_, config.linkPower, metrics_}},
+      publishBenchmark_{
+          {telemetryQueue_, config.mqttClient, config.connectionEventGroup},
+          settings.benchmark} {}
+
+common::Error Hub::init() {
+  bool isInitOk{true};
+
+  common::Error errorCode = configStore_.load(deviceConfig_);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Stored config invalid, using defaults");
+  }
+
+  errorCode = config_.rfm95.init(radio::Rfm95::Modulation::LORA);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init rfm95");
+    isInitOk = false;
+  }
+
+  errorCode = config_.rfm95.setAllSettings(def::radio::MODEM_SETTINGS);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to set all rfm95 settings");
+    isInitOk = false;
+  }
+
+  errorCode = requestTimer_.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init radio request timer");
+    isInitOk = false;
+  }
+
+  errorCode = timeoutTimer_.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init radio timeout timer");
+    isInitOk = false;
+  }
+
+  errorCode = reconnectTimer_.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init aws iot reconnect timer");
+    isInitOk = false;
+  }
+
+  errorCode = telemetryQueue_.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init telemetry queue");
+    isInitOk = false;
+  }
+
+  reportedConfig_ = radioThread_.getDeviceConfig();
+  reportDeviceConfig_(reportedConfig_);
+  shadowClient_.setDeltaCallback(
+      [](std::string_view key, double value, common::Argument arg) {
+        assert(arg);
+        static_cast<Hub*>(arg)->handleDelta_(key, value);
+      },
+      this);
+
+  errorCode = registerMetrics_();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to register metrics");
+    isInitOk = false;
+  }
+
+  return isInitOk ? common::Error::OK : common::Error::FAIL;
+}
+
+sw::metrics::Registry& Hub::getMetrics() { return metrics_; }
+
+common::Error Hub::start() {
+  const bool isBenchmark = settings_.benchmark.rateHz != 0;
+  common::Error errorCode{common::Error::OK};
+  // Telemetry queue has a single producer, the benchmark takes radio's place
+  if (not isBenchmark) {
+    errorCode = radioThread_.start();
+    if (errorCode != common::Error::OK) {
+      ESP_LOGE(TAG.data(), "Failed to start RadioThread");
+      return common::Error::FAIL;
+    }
+  }
+
+  errorCode = awsThread_.start();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to start AwsIotThread");
+    return common::Error::FAIL;
+  }
+
+  if (isBenchmark) {
+    errorCode = publishBenchmark_.start();
+    if (errorCode != common::Error::OK) {
+      ESP_LOGE(TAG.data(), "Failed to start PublishBenchmark");
+      return common::Error::FAIL;
+    }
+  }
+
+  return common::Error::OK;
+}
+
+void Hub::yield() {
+  configStore_.yield();
+
+  // Controllers are configured over radio, report the config once applied
+  const common::DeviceConfig applied = radioThread_.getDeviceConfig();
+  if (std::memcmp(&applied, &reportedConfig_, sizeof(applied)) != 0) {
+    reportedConfig_ = applied;
+    reportDeviceConfig_(applied);
+  }
+}
+
+const radio::ListenBeforeTalk& Hub::getListenBeforeTalk() const {
+  return lbtRadio_;
+}
+
+const radio::DutyCycleLimiter& Hub::getDutyCycleLimiter() const {
+  return dutyCycleRadio_;
+}
+
+const RadioThreadHub& Hub::getRadioThread() const { return radioThread_; }
+
+Hub::TelemetryQueue::Stats Hub::getTelemetryQueueStats() const {
+  return telemetryQueue_.getStats();
+}
+
+void Hub::handleDelta_(const std::string_view key, const double value) {
+  common::DeviceConfig deviceConfig = radioThread_.getDeviceConfig();
+  if (not setConfigField(deviceConfig, key, value)) {
+    ESP_LOGW(TAG.data(), "Unknown or out of range shadow field: %.*s",
+             static_cast<int>(key.size()), key.data());
+    return;
+  }
+
+  if (radioThread_.setDeviceConfig(deviceConfig) != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Invalid config field: %.*s",
+             static_cast<int>(key.size()), key.data());
+    return;
+  }
+
+  // Reported by yield() once applied, the cloud clears the delta when
+  // reported matches. A dropped config leaves the delta open.
+  ESP_LOGI(TAG.data(), "Shadow field %.*s set to %g",
+           static_cast<int>(key.size()), key.data(), value);
+}
+
+void Hub::reportDeviceConfig_(const common::DeviceConfig& deviceConfig) {
+  shadowClient_.setReported(MEASUREMENT_PERIOD_KEY,
+                            deviceConfig.measurementPeriodS);
+  shadowClient_.setReported(REQUEST_PERIOD_KEY, deviceConfig.requestPeriodS);
+  shadowClient_.setReported(SPREADING_FACTOR_KEY,
+                            deviceConfig.link.spreadingFactor);
+  shadowClient_.setReported(BANDWIDTH_KEY, deviceConfig.link.bandwidthHz);
+  shadowClient_.setReported(TX_POWER_KEY, deviceConfig.link.txPowerDbm);
+}
+
+common::Error Hub::registerMetrics_() {
+  // Registry is complete before the thread publishing it starts
+  common::Error errorCode = radioThread_.registerMetrics(metrics_);
+  if (errorCode == common::Error::OK) {
+    errorCode = dutyCycleRadio_.registerMetrics(metrics_);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = metrics_.add(
+        "queue.depth",
+        [](common::Argument arg) {
+          return static_cast<int32_t>(
+              static_cast<TelemetryQueue*>(arg)->size());
+        },
+        &telemetryQueue_);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = metrics_.add(
+        "queue.drops",
+        [](common::Argument arg) {
+          return static_cast<int32_t>(
+              static_cast<TelemetryQueue*>(arg)->getStats().drops);
+        },
+        &telemetryQueue_);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = config_.mqttClient.registerMetrics(metrics_);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = awsThread_.registerMetrics(metrics_);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = metrics_.add(
+        "heap.free",
+        [](common::Argument arg) {
+          return static_cast<int32_t>(esp_get_free_heap_size());
+        },
+        nullptr);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = metrics_.add(
+        "heap.minFree",
+        [](common::Argument arg) {
+          return static_cast<int32_t>(esp_get_minimum_free_heap_size());
+        },
+        nullptr);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = metrics_.add(
+        "heap.hotPathAllocs",
+        [](common::Argument arg) {
+          return static_cast<int32_t>(
+              sw::AllocationGuard::getTotalAllocations());
+        },
+        nullptr);
+  }
+  return errorCode;
+}
+} // namespace app
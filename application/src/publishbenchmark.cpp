@@ -0,0 +1,112 @@
+#include "publishbenchmark.hpp"
+#include "defs.hpp"
+#include "delay.hpp"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "uptime.hpp"
+#include "utils.hpp"
+#include <algorithm>
+
+namespace {
+static constexpr std::string_view TAG{"BENCHMARK"};
+}
+
+namespace app {
+PublishBenchmark::PublishBenchmark(Config config, const Settings settings)
+    : ThreadBase{{"PublishBenchmark", STACK_DEPTH, PRIORITY, CORE_ID}},
+      config_{config}, settings_{settings} {}
+
+void PublishBenchmark::run_() {
+  while (not config_.connectionEventGroup.isBitsSet(
+      def::net::AWS_CONNECTED_BIT)) {
+    sw::delayMs(CONNECT_WAIT_MS);
+  }
+
+  ESP_LOGI(TAG.data(), "Publishing %u msg/s for %u ms",
+           static_cast<unsigned>(settings_.rateHz),
+           static_cast<unsigned>(settings_.durationMs));
+  const Result result = measure_();
+
+  const uint32_t messagesPerS =
+      result.elapsedMs > 0
+          ? static_cast<uint32_t>(static_cast<uint64_t>(result.acknowledged) *
+                                  1000 / result.elapsedMs)
+          : 0;
+  // Single line, so it can be compared between builds
+  ESP_LOGI(TAG.data(),
+           "sent %u rejected %u acked %u msg/s %u p50 %u us p99 %u us "
+           "heap/msg %d B peak heap %u B",
+           static_cast<unsigned>(result.sent),
+           static_cast<unsigned>(result.rejected),
+           static_cast<unsigned>(result.acknowledged),
+           static_cast<unsigned>(messagesPerS),
+           static_cast<unsigned>(result.p50Us),
+           static_cast<unsigned>(result.p99Us),
+           static_cast<int>(result.heapPerMessageB),
+           static_cast<unsigned>(result.peakHeapB));
+
+  while (1) {
+    waitForNotification_(WAIT_FOREVER);
+  }
+}
+
+PublishBenchmark::Result PublishBenchmark::measure_() {
+  Result result{};
+  const sw::LatencyHistogram::Snapshot startLatency =
+      config_.mqttClient.getPublishLatency();
+  const uint32_t startHeapB = esp_get_free_heap_size();
+  uint32_t minHeapB{startHeapB};
+  const uint64_t startUs = sw::getUptimeUs();
+  const uint64_t durationUs =
+      common::utils::msToUs<uint64_t, uint64_t>(settings_.durationMs);
+
+  // Samples due so far are sent in a burst, rates above the tick rate work
+  uint32_t index{0};
+  uint64_t elapsedUs{0};
+  while ((elapsedUs = sw::getUptimeUs() - startUs) < durationUs) {
+    const uint64_t dueCount = elapsedUs * settings_.rateHz / 1'000'000 + 1;
+    for (; index < dueCount; ++index) {
+      if (config_.telemetryQueue.send(createTelemetry_(index)) ==
+          common::Error::OK) {
+        ++result.sent;
+      } else {
+        ++result.rejected;
+      }
+    }
+    minHeapB = std::min(minHeapB, esp_get_free_heap_size());
+    sw::delayMs(POLL_PERIOD_MS);
+  }
+
+  sw::LatencyHistogram::Snapshot latency{};
+  const common::Time drainStartMs = sw::getUptimeMs();
+  do {
+    minHeapB = std::min(minHeapB, esp_get_free_heap_size());
+    latency = config_.mqttClient.getPublishLatency().getDelta(startLatency);
+    if (latency.count >= result.sent) {
+      break;
+    }
+    sw::delayMs(POLL_PERIOD_MS);
+  } while (sw::getUptimeMs() - drainStartMs < DRAIN_TIMEOUT_MS);
+
+  result.acknowledged = latency.count;
+  result.elapsedMs =
+      static_cast<common::Time>((sw::getUptimeUs() - startUs) / 1000);
+  result.p50Us = latency.getPercentileUs(50);
+  result.p99Us = latency.getPercentileUs(99);
+  const int64_t retainedHeapB =
+      static_cast<int64_t>(startHeapB) - esp_get_free_heap_size();
+  result.heapPerMessageB =
+      result.acknowledged > 0
+          ? static_cast<int32_t>(retainedHeapB / result.acknowledged)
+          : 0;
+  result.peakHeapB = startHeapB - minHeapB;
+  return result;
+}
+
+common::Telemetry PublishBenchmark::createTelemetry_(const uint32_t index) {
+  // Consecutive samples of a controller differ more than any deadband
+  const bool isHigh = (index / CONTROLLERS) % 2;
+  return {static_cast<uint8_t>(index % CONTROLLERS + 1),
+          isHigh ? 25.0f : 20.0f, isHigh ? 60.0f : 40.0f};
+}
+} // namespace app
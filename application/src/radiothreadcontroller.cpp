@@ -1,38 +1,75 @@
 #include "radiothreadcontroller.hpp"
+#include "allocationguard.hpp"
+#include "defs.hpp"
 #include "esp_log.h"
+#include "ticks.hpp"
+#include "trace.hpp"
+#include "uptime.hpp"
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <cstring>
 #include <string_view>
 
 namespace {
 static constexpr std::string_view TAG{"Radio"};
+
+common::Time sToUs(const uint32_t timeS) {
+  return common::utils::msToUs<common::Time, common::Time>(
+      common::utils::sToMs<common::Time, common::Time>(timeS));
 }
+} // namespace
 
 namespace app {
 RadioThreadController::RadioThreadController(Config config)
     : ThreadBase{{"RadioThread", STACK_DEPTH, PRIORITY, CORE_ID}},
       config_{config} {}
 
+sw::LatencyMeter::Stats RadioThreadController::getIrqLatencyStats() const {
+  return irqLatency_.getStats();
+}
+
 void RadioThreadController::run_() {
   config_.radio.setIrqEventCallback(
       [](void* arg) {
         assert(arg);
-        resumeFromISR_(static_cast<ThreadHandle>(arg));
+        RadioThreadController* radioThread =
+            static_cast<RadioThreadController*>(arg);
+        radioThread->irqLatency_.start();
+        sw::trace::instant("dio0 irq");
+        notifyFromISR_(radioThread->handle_, def::radio::IRQ_BIT);
       },
-      handle_);
+      this);
 
   config_.radio.listening();
   while (1) {
-    suspend_();
-    processRadioIrqEvent_();
+    const NotificationBits bits = waitForNotification_(getWaitTimeMs_());
+    if (isLinkCheckArmed_ && getLinkCheckTimeLeftMs_() <= 0) {
+      revertLinkSettings_();
+    }
+
+    if (bits & def::radio::IRQ_BIT) {
+      const uint32_t latencyUs = irqLatency_.stop();
+      ESP_LOGD(TAG.data(), "IRQ latency: %lu [us]",
+               static_cast<unsigned long>(latencyUs));
+      processRadioIrqEvent_();
+    }
+
+    flushPendingFrame_();
   }
 }
 
 void RadioThreadController::processRadioIrqEvent_() {
+  sw::trace::Scope trace{"radio irq"};
+  sw::AllocationGuard guard{"radio irq"};
   common::radio::IrqEvent event = config_.radio.getIrqEvent();
   if (event == common::radio::IrqEvent::RX_DONE) {
     processReceiveData_();
 
   } else if (event == common::radio::IrqEvent::TX_DONE) {
+    if (hasPendingConfig_) {
+      applyPendingConfig_();
+    }
     config_.radio.listening();
   }
 }
@@ -45,6 +82,12 @@ void RadioThreadController::processReceiveData_() {
   }
 
   packet::radio::Type packetType = packet::radio::utils::getType(buffer.data());
+  if (packetType == packet::radio::Type::TELEMETRY_REQUEST ||
+      packetType == packet::radio::Type::CONFIG) {
+    // Hub is heard with the current link settings
+    isLinkCheckArmed_ = false;
+  }
+
   handlePacketData_(packetType, buffer.data(), buffer.size());
 }
 
@@ -62,6 +105,10 @@ void RadioThreadController::handlePacketData_(
     ESP_LOGI(TAG.data(), "Read: TELEMETRY_REQUEST");
     sendTelemetry_();
     break;
+  case packet::radio::Type::CONFIG:
+    ESP_LOGI(TAG.data(), "Read: CONFIG");
+    receiveConfig_(buffer, bufferLength);
+    break;
   default:
     ESP_LOGI(TAG.data(), "Read fail packet");
   }
@@ -78,10 +125,145 @@ void RadioThreadController::sendTelemetry_() {
   }
 
   ESP_LOGI(TAG.data(), "Send telemetry");
+  // INVALID_STATE: deferred, flushPendingFrame_() sends it
   errorCode = config_.radio.send(buffer.data(), buffer.size());
-  if (errorCode != common::Error::OK) {
+  if (errorCode != common::Error::OK &&
+      errorCode != common::Error::INVALID_STATE) {
     ESP_LOGE(TAG.data(), "Send telemetry fail");
   }
 }
 
+void RadioThreadController::receiveConfig_(const uint8_t* buffer,
+                                           const size_t bufferLength) {
+  packet::radio::DeviceConfig configPacket{common::DeviceConfig{}};
+  common::Error errorCode = configPacket.deserialize(buffer, bufferLength);
+  const common::DeviceConfig deviceConfig = configPacket.getDeviceConfig();
+  if (errorCode != common::Error::OK ||
+      not ConfigStore::isValid(deviceConfig)) {
+    ESP_LOGE(TAG.data(), "Invalid config");
+    sendResponse_(packet::radio::Type::NOT_OK);
+    return;
+  }
+
+  // Hub waits for the ACK with the current link settings
+  pendingConfig_ = deviceConfig;
+  hasPendingConfig_ = true;
+  sendResponse_(packet::radio::Type::OK);
+}
+
+void RadioThreadController::sendResponse_(const packet::radio::Type type) {
+  // Hub waits for the response of every controller it knows
+  packet::radio::Response response{type, config_.telemetry.controllerId};
+  std::array<uint8_t, sizeof(packet::radio::Response)> buffer{};
+  response.serialize(buffer.data(), buffer.size());
+
+  // A deferred ACK keeps the config pending until its TX_DONE
+  common::Error errorCode = config_.radio.send(buffer.data(), buffer.size());
+  if (errorCode != common::Error::OK &&
+      errorCode != common::Error::INVALID_STATE) {
+    ESP_LOGE(TAG.data(), "Send response fail");
+    hasPendingConfig_ = false;
+  }
+}
+
+void RadioThreadController::applyPendingConfig_() {
+  hasPendingConfig_ = false;
+  const common::DeviceConfig& deviceConfig = pendingConfig_;
+
+  const bool isLinkChanged =
+      std::memcmp(&deviceConfig.link, &config_.deviceConfig.link,
+                  sizeof(common::radio::LinkSettings)) != 0;
+  if (isLinkChanged) {
+    common::Error errorCode =
+        config_.channel.setLinkSettings(deviceConfig.link);
+    if (errorCode != common::Error::OK) {
+      // Settings were validated before the ACK, the radio failed to write
+      // them and may hold a part of them. Nothing is saved.
+      ESP_LOGE(TAG.data(), "Set link settings fail, config not applied");
+      errorCode = config_.channel.setLinkSettings(config_.deviceConfig.link);
+      if (errorCode != common::Error::OK) {
+        ESP_LOGE(TAG.data(), "Restore link settings fail");
+      }
+      return;
+    }
+
+    previousLink_ = config_.deviceConfig.link;
+    isLinkCheckArmed_ = true;
+    linkCheckDeadlineMs_ =
+        sw::getUptimeMs() +
+        common::utils::sToMs<common::Time, common::Time>(
+            deviceConfig.requestPeriodS * LINK_CHECK_PERIODS);
+  }
+
+  common::Error errorCode =
+      config_.timedMeter.setPeriod(sToUs(deviceConfig.measurementPeriodS));
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Set measurement period fail");
+  }
+
+  config_.deviceConfig = deviceConfig;
+  errorCode = config_.configStore.saveLater(deviceConfig);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Save config fail");
+  }
+
+  ESP_LOGI(TAG.data(), "Config applied");
+}
+
+void RadioThreadController::revertLinkSettings_() {
+  isLinkCheckArmed_ = false;
+  ESP_LOGW(TAG.data(), "Hub not heard after link change, reverting");
+
+  common::Error errorCode = config_.channel.setLinkSettings(previousLink_);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Set link settings fail");
+    return;
+  }
+
+  config_.deviceConfig.link = previousLink_;
+  errorCode = config_.configStore.saveLater(config_.deviceConfig);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Save config fail");
+  }
+
+  config_.radio.listening();
+}
+
+void RadioThreadController::flushPendingFrame_() {
+  if (not config_.radio.hasPending() ||
+      config_.radio.getPendingDelayMs() > 0) {
+    return;
+  }
+
+  common::Error errorCode = config_.radio.flushPending();
+  if (errorCode != common::Error::OK &&
+      errorCode != common::Error::INVALID_STATE) {
+    ESP_LOGW(TAG.data(), "Send deferred frame fail");
+    // It may have been the ACK, no TX_DONE will apply the config
+    hasPendingConfig_ = false;
+  }
+}
+
+common::Time RadioThreadController::getWaitTimeMs_() {
+  common::Time waitTimeMs{WAIT_FOREVER};
+  if (isLinkCheckArmed_) {
+    const int32_t timeLeftMs = getLinkCheckTimeLeftMs_();
+    waitTimeMs = timeLeftMs > 0 ? static_cast<common::Time>(timeLeftMs) : 0;
+  }
+
+  if (config_.radio.hasPending()) {
+    // A wait shorter than a tick does not block
+    const common::Time delayMs = config_.radio.getPendingDelayMs();
+    waitTimeMs = std::min(
+        waitTimeMs, delayMs > 0 ? std::max(delayMs, sw::TICK_PERIOD_MS) : 0);
+  }
+
+  return waitTimeMs;
+}
+
+int32_t RadioThreadController::getLinkCheckTimeLeftMs_() const {
+  // Uptime in milliseconds wraps after 49 days
+  return static_cast<int32_t>(linkCheckDeadlineMs_ - sw::getUptimeMs());
+}
+
 } // namespace app
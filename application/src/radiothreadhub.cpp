@@ -1,13 +1,24 @@
 #include "radiothreadhub.hpp"
+#include "allocationguard.hpp"
 #include "defs.hpp"
 #include "esp_log.h"
-#include "freertos/idf_additions.h"
+#include "ticks.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <cstring>
+#include <mutex>
 #include <string_view>
 
 namespace {
 static std::string_view TAG{"RADIO"};
+
+common::Time sToUs(const uint32_t timeS) {
+  return common::utils::msToUs<common::Time, common::Time>(
+      common::utils::sToMs<common::Time, common::Time>(timeS));
 }
+} // namespace
 
 namespace app {
 
@@ -15,61 +26,360 @@ RadioThreadHub::RadioThreadHub(Config config)
     : ThreadBase{{"RadioThread", STACK_DEPTH, PRIORITY, CORE_ID}},
       config_{config} {}
 
-void RadioThreadHub::run_() {
-  config_.timeoutTimer.setCallback(
-      [](void* arg) {
-        assert(arg);
-        RadioThreadHub* radioThread = static_cast<RadioThreadHub*>(arg);
-        radioThread->config_.ledEventQueue.send(
-            def::ui::LedEvent::RADIO_TIMEOUT);
-        ESP_LOGI(TAG.data(), "Radio timeout");
-      },
-      this);
+common::Error
+RadioThreadHub::setDeviceConfig(const common::DeviceConfig& deviceConfig) {
+  if (not ConfigStore::isValid(deviceConfig)) {
+    return common::Error::INVALID_ARG;
+  }
 
-  config_.requestTimer.setCallback(
-      [](void* arg) {
-        assert(arg);
-        std::array<uint8_t, sizeof(packet::radio::Type)> buffer{};
-        packet::radio::utils::serializeRequest(
-            packet::radio::Type::TELEMETRY_REQUEST, buffer.data(),
-            buffer.size());
+  std::lock_guard<sw::Mutex> lock{configMutex_};
+  const common::DeviceConfig& applied = config_.deviceConfig;
+  const bool isControllerChanged =
+      deviceConfig.measurementPeriodS != applied.measurementPeriodS ||
+      std::memcmp(&deviceConfig.link, &applied.link,
+                  sizeof(common::radio::LinkSettings)) != 0;
 
-        RadioThreadHub* radioThread = static_cast<RadioThreadHub*>(arg);
-        radioThread->config_.radio.send(buffer.data(), buffer.size());
-      },
-      this);
+  if (not isControllerChanged) {
+    // Request period is used by the hub only, no need to wait for the ACK
+    hasPendingConfig_ = false;
+    config_.deviceConfig = deviceConfig;
+    if (config_.configStore.saveLater(deviceConfig) != common::Error::OK) {
+      ESP_LOGE(TAG.data(), "Save config fail");
+    }
+    if (handle_ != nullptr) {
+      notify_(def::radio::REQUEST_PERIOD_BIT);
+    }
+    return common::Error::OK;
+  }
+
+  pendingConfig_ = deviceConfig;
+  hasPendingConfig_ = true;
+  isConfigSent_ = false;
+  configAttempts_ = 0;
+  return common::Error::OK;
+}
+
+common::DeviceConfig RadioThreadHub::getDeviceConfig() const {
+  std::lock_guard<sw::Mutex> lock{configMutex_};
+  return config_.deviceConfig;
+}
+
+sw::LatencyMeter::Stats RadioThreadHub::getIrqLatencyStats() const {
+  return irqLatency_.getStats();
+}
 
-  common::Error errorCode = config_.requestTimer.startPeriodic(REQUEST_TIME_US);
+common::Error
+RadioThreadHub::registerMetrics(sw::metrics::Registry& registry) const {
+  common::Error errorCode = registry.add("radio.tx", txFrames_);
+  if (errorCode == common::Error::OK) {
+    errorCode = registry.add("radio.rx", rxFrames_);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = registry.add("radio.crcErrors", crcErrors_);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = registry.add("radio.timeouts", timeouts_);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = registry.add("radio.rssi", rssi_);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = registry.add("radio.snr", snr_);
+  }
+  return errorCode;
+}
+
+void RadioThreadHub::run_() {
+  setTimeoutTimer_();
+
+  common::Error errorCode =
+      config_.channel.setLinkSettings(getDeviceConfig().link);
   if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "Start periodic fail");
+    ESP_LOGE(TAG.data(), "Set link settings fail");
   }
 
   config_.radio.setIrqEventCallback(
       [](void* arg) {
         assert(arg);
-        resumeFromISR_(static_cast<ThreadHandle>(arg));
+        RadioThreadHub* radioThread = static_cast<RadioThreadHub*>(arg);
+        radioThread->irqLatency_.start();
+        sw::trace::instant("dio0 irq");
+        notifyFromISR_(radioThread->handle_, def::radio::IRQ_BIT);
       },
-      handle_);
+      this);
 
   config_.radio.listening();
+  setRequestTimer_();
+
   while (1) {
-    suspend_();
+    processNotification_(waitForNotification_(getWaitTimeMs_()));
+    flushPendingFrame_();
+  }
+}
+
+void RadioThreadHub::processNotification_(const NotificationBits bits) {
+  if (bits & def::radio::IRQ_BIT) {
+    const uint32_t latencyUs = irqLatency_.stop();
+    ESP_LOGD(TAG.data(), "IRQ latency: %lu [us]",
+             static_cast<unsigned long>(latencyUs));
     processRadioIrqEvent_();
   }
+
+  if (bits & def::radio::TIMEOUT_BIT) {
+    timeouts_.add();
+    config_.ledEventQueue.send(def::ui::LedEvent::RADIO_TIMEOUT);
+    ESP_LOGI(TAG.data(), "Radio timeout");
+  }
+
+  if (bits & def::radio::REQUEST_DUE_BIT) {
+    sendRequest_();
+  }
+
+  if (bits & def::radio::REQUEST_PERIOD_BIT) {
+    common::Error errorCode = config_.requestTimer.startPeriodic(
+        sToUs(getDeviceConfig().requestPeriodS));
+    if (errorCode != common::Error::OK) {
+      ESP_LOGE(TAG.data(), "Restart periodic fail");
+    }
+  }
 }
 
 void RadioThreadHub::processRadioIrqEvent_() {
+  sw::trace::Scope trace{"radio irq"};
+  sw::AllocationGuard guard{"radio irq"};
   common::radio::IrqEvent event = config_.radio.getIrqEvent();
   if (event == common::radio::IrqEvent::RX_DONE) {
     config_.timeoutTimer.stop();
+    rxFrames_.add();
+    recordSignalQuality_();
     processReceiveData_();
 
+  } else if (event == common::radio::IrqEvent::CRC_ERROR) {
+    // Response is lost, the timeout reports it
+    crcErrors_.add();
+    recordSignalQuality_();
+
   } else if (event == common::radio::IrqEvent::TX_DONE) {
+    txFrames_.add();
     config_.radio.listening();
     config_.timeoutTimer.startOnce(TIMEOUT_TIME_US);
   }
 }
 
+void RadioThreadHub::recordSignalQuality_() {
+  const common::SignalQuality signalQuality = config_.radio.getSignalQuality();
+  if (signalQuality.rssi != common::SignalQuality::RSSI_INVALID_VALUE) {
+    rssi_.record(signalQuality.rssi);
+  }
+  if (signalQuality.snr != common::SignalQuality::SNR_INVALID_VALUE) {
+    snr_.record(static_cast<int32_t>(std::lround(signalQuality.snr)));
+  }
+}
+
+void RadioThreadHub::sendRequest_() {
+  if (sendConfig_()) {
+    return;
+  }
+
+  std::array<uint8_t, sizeof(packet::radio::Type)> buffer{};
+  packet::radio::utils::serializeRequest(packet::radio::Type::TELEMETRY_REQUEST,
+                                         buffer.data(), buffer.size());
+
+  // INVALID_STATE: deferred, flushPendingFrame_() sends it
+  common::Error errorCode = config_.radio.send(buffer.data(), buffer.size());
+  if (errorCode != common::Error::OK &&
+      errorCode != common::Error::INVALID_STATE) {
+    ESP_LOGW(TAG.data(), "Send request fail");
+  }
+}
+
+bool RadioThreadHub::sendConfig_() {
+  common::DeviceConfig deviceConfig{};
+  {
+    std::lock_guard<sw::Mutex> lock{configMutex_};
+    isConfigSent_ = false;
+    if (not hasPendingConfig_) {
+      return false;
+    }
+
+    if (configAttempts_ >= MAX_CONFIG_ATTEMPTS) {
+      // Controllers which switched already return after their link check
+      ESP_LOGE(TAG.data(), "Config not acknowledged by all, dropping it");
+      hasPendingConfig_ = false;
+      forgetUnconfirmedControllers_();
+      return false;
+    }
+
+    if (configAttempts_ == 0) {
+      for (ControllerState& controller : controllers_) {
+        controller.isConfirmed = false;
+      }
+    }
+    ++configAttempts_;
+    deviceConfig = pendingConfig_;
+  }
+
+  packet::radio::DeviceConfig configPacket{deviceConfig};
+  std::array<uint8_t, sizeof(packet::radio::DeviceConfig)> buffer{};
+  common::Error errorCode =
+      configPacket.serialize(buffer.data(), buffer.size());
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Parse config fail");
+    return false;
+  }
+
+  ESP_LOGI(TAG.data(), "Send config");
+  errorCode = config_.radio.send(buffer.data(), buffer.size());
+  if (errorCode != common::Error::OK &&
+      errorCode != common::Error::INVALID_STATE) {
+    ESP_LOGW(TAG.data(), "Send config fail");
+    return true;
+  }
+
+  std::lock_guard<sw::Mutex> lock{configMutex_};
+  isConfigSent_ = true;
+  return true;
+}
+
+void RadioThreadHub::handleConfigResponse_(const uint8_t* buffer,
+                                           const size_t bufferLength) {
+  packet::radio::Response response{packet::radio::Type::UNKNOWN, 0};
+  if (response.deserialize(buffer, bufferLength) != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Parse response fail");
+    return;
+  }
+
+  common::DeviceConfig deviceConfig{};
+  {
+    std::lock_guard<sw::Mutex> lock{configMutex_};
+    if (not isConfigSent_ || not hasPendingConfig_) {
+      return;
+    }
+
+    const uint8_t controllerId = response.getControllerId();
+    if (response.getType() != packet::radio::Type::OK) {
+      // Controllers which switched already return after their link check
+      ESP_LOGE(TAG.data(), "Config rejected by controller %u", controllerId);
+      isConfigSent_ = false;
+      hasPendingConfig_ = false;
+      return;
+    }
+
+    ControllerState* controller = addController_(controllerId);
+    if (controller != nullptr) {
+      controller->isConfirmed = true;
+    }
+
+    // Every controller which got it already switched, the rest is stranded
+    // if the hub followed now
+    const bool isConfirmedByAll = std::all_of(
+        controllers_.begin(), controllers_.end(),
+        [](const ControllerState& controller) {
+          return not controller.isUsed || controller.isConfirmed;
+        });
+    if (not isConfirmedByAll) {
+      ESP_LOGI(TAG.data(), "Config confirmed by controller %u", controllerId);
+      return;
+    }
+
+    isConfigSent_ = false;
+    hasPendingConfig_ = false;
+    deviceConfig = pendingConfig_;
+  }
+
+  applyDeviceConfig_(deviceConfig);
+}
+
+void RadioThreadHub::applyDeviceConfig_(
+    const common::DeviceConfig& deviceConfig) {
+  const common::DeviceConfig applied = getDeviceConfig();
+
+  // Controllers switch after their ACK was sent, follow them now
+  common::Error errorCode = config_.channel.setLinkSettings(deviceConfig.link);
+  if (errorCode != common::Error::OK) {
+    // Controllers return after their link check as the hub stays silent
+    ESP_LOGE(TAG.data(), "Set link settings fail, config not applied");
+    errorCode = config_.channel.setLinkSettings(applied.link);
+    if (errorCode != common::Error::OK) {
+      ESP_LOGE(TAG.data(), "Restore link settings fail");
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<sw::Mutex> lock{configMutex_};
+    config_.deviceConfig = deviceConfig;
+  }
+
+  errorCode = config_.configStore.saveLater(deviceConfig);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Save config fail");
+  }
+
+  errorCode =
+      config_.requestTimer.startPeriodic(sToUs(deviceConfig.requestPeriodS));
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Restart periodic fail");
+  }
+
+  ESP_LOGI(TAG.data(), "Config applied");
+}
+
+RadioThreadHub::ControllerState*
+RadioThreadHub::addController_(const uint8_t controllerId) {
+  auto controller = std::find_if(
+      controllers_.begin(), controllers_.end(),
+      [controllerId](const ControllerState& controller) {
+        return controller.isUsed && controller.controllerId == controllerId;
+      });
+  if (controller == controllers_.end()) {
+    controller = std::find_if(controllers_.begin(), controllers_.end(),
+                              [](const ControllerState& controller) {
+                                return not controller.isUsed;
+                              });
+    if (controller == controllers_.end()) {
+      return nullptr;
+    }
+    *controller = {true, controllerId, false};
+  }
+
+  return &*controller;
+}
+
+void RadioThreadHub::forgetUnconfirmedControllers_() {
+  // Heard again with its next telemetry, a silent one does not block configs
+  for (ControllerState& controller : controllers_) {
+    if (controller.isUsed && not controller.isConfirmed) {
+      ESP_LOGW(TAG.data(), "Controller %u not answering config",
+               controller.controllerId);
+      controller = {};
+    }
+  }
+}
+
+void RadioThreadHub::flushPendingFrame_() {
+  if (not config_.radio.hasPending() ||
+      config_.radio.getPendingDelayMs() > 0) {
+    return;
+  }
+
+  common::Error errorCode = config_.radio.flushPending();
+  if (errorCode != common::Error::OK &&
+      errorCode != common::Error::INVALID_STATE) {
+    ESP_LOGW(TAG.data(), "Send deferred frame fail");
+  }
+}
+
+common::Time RadioThreadHub::getWaitTimeMs_() {
+  if (not config_.radio.hasPending()) {
+    return WAIT_FOREVER;
+  }
+
+  // A wait shorter than a tick does not block
+  const common::Time delayMs = config_.radio.getPendingDelayMs();
+  return delayMs > 0 ? std::max(delayMs, sw::TICK_PERIOD_MS) : 0;
+}
+
 void RadioThreadHub::processReceiveData_() {
   std::array<uint8_t, MAX_READ_BUFFER> buffer{};
   common::Error errorCode = config_.radio.receive(buffer.data(), buffer.size());
@@ -87,9 +397,11 @@ void RadioThreadHub::handlePacketData_(const packet::radio::Type& packetType,
   switch (packetType) {
   case packet::radio::Type::OK:
     ESP_LOGI(TAG.data(), "Read: OK");
+    handleConfigResponse_(buffer, bufferLength);
     break;
   case packet::radio::Type::NOT_OK:
     ESP_LOGI(TAG.data(), "Read: NOT_OK");
+    handleConfigResponse_(buffer, bufferLength);
     break;
   case packet::radio::Type::TELEMETRY:
     ESP_LOGI(TAG.data(), "Read: TELEMETRY");
@@ -109,33 +421,48 @@ void RadioThreadHub::receiveTelemetry_(const uint8_t* buffer,
   }
 
   auto telemetry = telemetryPacket.getTelemetry();
+  if (errorCode == common::Error::OK) {
+    // Configuration waits for the ACK of every controller heard
+    addController_(telemetry.controllerId);
+  }
+
   errorCode = config_.telemetryQueue.send(telemetry);
   if (errorCode != common::Error::OK) {
     ESP_LOGE(TAG.data(), "Queue send telemetry fail");
   }
 
-  ESP_LOGI(TAG.data(), "Telemetry: temperature: %.2f [C], humidity: %.2f [RH]",
-           telemetry.temperatureC, telemetry.humidityRh);
+  ESP_LOGI(TAG.data(),
+           "Telemetry: controller: %u, temperature: %.2f [C], humidity: %.2f "
+           "[RH]",
+           telemetry.controllerId, telemetry.temperatureC,
+           telemetry.humidityRh);
 }
 
 void RadioThreadHub::setRequestTimer_() {
+  // Timer runs in the timer task, it only wakes the radio thread
   config_.requestTimer.setCallback(
       [](void* arg) {
         assert(arg);
-        std::array<uint8_t, sizeof(packet::radio::Type)> buffer{};
-        packet::radio::utils::serializeRequest(
-            packet::radio::Type::TELEMETRY_REQUEST, buffer.data(),
-            buffer.size());
-
         RadioThreadHub* radioThread = static_cast<RadioThreadHub*>(arg);
-        radioThread->config_.radio.send(buffer.data(), buffer.size());
+        radioThread->notify_(def::radio::REQUEST_DUE_BIT);
       },
       this);
 
-  common::Error errorCode = config_.requestTimer.startPeriodic(REQUEST_TIME_US);
+  common::Error errorCode = config_.requestTimer.startPeriodic(
+      sToUs(getDeviceConfig().requestPeriodS));
   if (errorCode != common::Error::OK) {
     ESP_LOGE(TAG.data(), "Start periodic fail");
   }
 }
 
+void RadioThreadHub::setTimeoutTimer_() {
+  config_.timeoutTimer.setCallback(
+      [](void* arg) {
+        assert(arg);
+        RadioThreadHub* radioThread = static_cast<RadioThreadHub*>(arg);
+        radioThread->notify_(def::radio::TIMEOUT_BIT);
+      },
+      this);
+}
+
 } // namespace app
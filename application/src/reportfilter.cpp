@@ -0,0 +1,84 @@
+#include "reportfilter.hpp"
+#include "uptime.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace app {
+ReportFilter::ReportFilter(const Settings settings) : settings_{settings} {}
+
+void ReportFilter::setSettings(const Settings settings) {
+  settings_ = settings;
+}
+
+bool ReportFilter::shouldReport(const common::Telemetry& telemetry) {
+  const common::Time nowMs = sw::getUptimeMs();
+  ControllerState& state = getState_(telemetry.controllerId);
+
+  if (state.isUsed) {
+    const bool isChanged =
+        isOutsideDeadband_(telemetry.temperatureC, state.telemetry.temperatureC,
+                           settings_.temperatureC) ||
+        isOutsideDeadband_(telemetry.humidityRh, state.telemetry.humidityRh,
+                           settings_.humidityRh);
+    const bool isSilenceExceeded =
+        nowMs - state.reportedMs >= settings_.maxSilenceMs;
+
+    if (not isChanged && not isSilenceExceeded) {
+      ++stats_.suppressed;
+      return false;
+    }
+
+    if (not isChanged) {
+      ++stats_.heartbeats;
+    }
+  }
+
+  state = {true, telemetry, nowMs};
+  ++stats_.reported;
+  return true;
+}
+
+void ReportFilter::reset() { states_ = {}; }
+
+ReportFilter::Stats ReportFilter::getStats() const { return stats_; }
+
+void ReportFilter::resetStats() { stats_ = Stats{}; }
+
+bool ReportFilter::isOutsideDeadband_(const float value,
+                                      const float reportedValue,
+                                      const Deadband deadband) {
+  const float threshold =
+      std::max(deadband.absolute, deadband.relative * std::fabs(reportedValue));
+  return std::fabs(value - reportedValue) > threshold;
+}
+
+ReportFilter::ControllerState&
+ReportFilter::getState_(const uint8_t controllerId) {
+  auto state = std::find_if(states_.begin(), states_.end(),
+                            [controllerId](const ControllerState& state) {
+                              return state.isUsed &&
+                                     state.telemetry.controllerId ==
+                                         controllerId;
+                            });
+  if (state != states_.end()) {
+    return *state;
+  }
+
+  state = std::find_if(
+      states_.begin(), states_.end(),
+      [](const ControllerState& state) { return not state.isUsed; });
+  if (state != states_.end()) {
+    return *state;
+  }
+
+  // Table is full, the controller reported least recently is forgotten
+  state = std::min_element(states_.begin(), states_.end(),
+                           [](const ControllerState& a,
+                              const ControllerState& b) {
+                             return a.reportedMs < b.reportedMs;
+                           });
+  state->isUsed = false;
+  return *state;
+}
+
+} // namespace app
@@ -0,0 +1,144 @@
+#include "telemetryaggregator.hpp"
+#include "uptime.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace app {
+TelemetryAggregator::TelemetryAggregator(const Settings settings)
+    : settings_{settings} {}
+
+void TelemetryAggregator::setSettings(const Settings settings) {
+  settings_ = settings;
+}
+
+TelemetryAggregator::Mode TelemetryAggregator::getMode() const {
+  return settings_.mode;
+}
+
+common::Error TelemetryAggregator::add(const common::Telemetry& telemetry) {
+  if (settings_.mode != Mode::AGGREGATED) {
+    return common::Error::INVALID_STATE;
+  }
+
+  Window* window = getWindow_(telemetry.controllerId);
+  if (window == nullptr) {
+    return common::Error::NO_MEM;
+  }
+
+  if (not window->isUsed) {
+    *window = {true, telemetry.controllerId, sw::getUptimeMs(), 0, {}, {}};
+  }
+
+  // Window is closed before the counter overflows
+  if (window->count == std::numeric_limits<uint16_t>::max()) {
+    return common::Error::NO_MEM;
+  }
+
+  ++window->count;
+  window->temperatureC.add(telemetry.temperatureC, window->count);
+  window->humidityRh.add(telemetry.humidityRh, window->count);
+  return common::Error::OK;
+}
+
+bool TelemetryAggregator::poll(common::TelemetrySummary& summary) {
+  const common::Time nowMs = sw::getUptimeMs();
+  auto window = std::find_if(windows_.begin(), windows_.end(),
+                             [this, nowMs](const Window& window) {
+                               return isWindowClosed_(window, nowMs);
+                             });
+  if (window == windows_.end()) {
+    return false;
+  }
+
+  summary.controllerId = window->controllerId;
+  summary.sampleCount = window->count;
+  summary.windowS = std::max<common::Time>((nowMs - window->startMs) / 1000, 1);
+  summary.temperatureC = window->temperatureC.getSummary(window->count);
+  summary.humidityRh = window->humidityRh.getSummary(window->count);
+  window->isUsed = false;
+  return true;
+}
+
+common::Time TelemetryAggregator::getWaitTimeMs() const {
+  const common::Time nowMs = sw::getUptimeMs();
+  common::Time waitTimeMs{NO_WINDOW_MS};
+  for (const Window& window : windows_) {
+    if (not window.isUsed) {
+      continue;
+    }
+    if (isWindowClosed_(window, nowMs)) {
+      return 0;
+    }
+    waitTimeMs =
+        std::min(waitTimeMs, settings_.windowMs - (nowMs - window.startMs));
+  }
+
+  return waitTimeMs;
+}
+
+common::TelemetrySummary
+TelemetryAggregator::toSummary(const common::Telemetry& telemetry) {
+  return {telemetry.controllerId,
+          1,
+          0,
+          {telemetry.temperatureC, telemetry.temperatureC,
+           telemetry.temperatureC, 0.0f},
+          {telemetry.humidityRh, telemetry.humidityRh, telemetry.humidityRh,
+           0.0f}};
+}
+
+void TelemetryAggregator::Accumulator::add(const float value,
+                                           const uint16_t count) {
+  if (count == 1) {
+    *this = {value, 0.0f, value, value};
+    return;
+  }
+
+  const float delta = value - mean;
+  mean += delta / static_cast<float>(count);
+  m2 += delta * (value - mean);
+  min = std::min(min, value);
+  max = std::max(max, value);
+}
+
+common::FieldSummary
+TelemetryAggregator::Accumulator::getSummary(const uint16_t count) const {
+  // Population standard deviation of the samples in the window
+  const float variance = count > 1 ? m2 / static_cast<float>(count) : 0.0f;
+  return {min, max, mean, std::sqrt(variance)};
+}
+
+TelemetryAggregator::Window*
+TelemetryAggregator::getWindow_(const uint8_t controllerId) {
+  auto window = std::find_if(windows_.begin(), windows_.end(),
+                             [controllerId](const Window& window) {
+                               return window.isUsed &&
+                                      window.controllerId == controllerId;
+                             });
+  if (window != windows_.end()) {
+    return &*window;
+  }
+
+  window =
+      std::find_if(windows_.begin(), windows_.end(),
+                   [](const Window& window) { return not window.isUsed; });
+  if (window != windows_.end()) {
+    return &*window;
+  }
+
+  return nullptr;
+}
+
+bool TelemetryAggregator::isWindowClosed_(const Window& window,
+                                          const common::Time nowMs) const {
+  if (not window.isUsed) {
+    return false;
+  }
+
+  return settings_.mode != Mode::AGGREGATED ||
+         nowMs - window.startMs >= settings_.windowMs ||
+         window.count == std::numeric_limits<uint16_t>::max();
+}
+
+} // namespace app
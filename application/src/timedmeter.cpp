@@ -26,13 +26,17 @@ common::Error TimedMeter::start(common::Time timeUs) {
   return config_.measurementTimer.startPeriodic(timeUs);
 }
 
+common::Error TimedMeter::setPeriod(common::Time timeUs) {
+  return config_.measurementTimer.startPeriodic(timeUs);
+}
+
 common::Error TimedMeter::stop() { return config_.measurementTimer.stop(); }
 
 common::Telemetry TimedMeter::getMeasurementData() { return config_.telemetry; }
 
 void TimedMeter::yield() {
-  if (isReadyToMeasure_) {
-    isReadyToMeasure_ = false;
+  // Set by the timer task, clear and test in one step not to lose a tick
+  if (isReadyToMeasure_.exchange(false)) {
     takeMeasurement_();
   }
 }
@@ -1,6 +1,8 @@
 #include "uithread.hpp"
 #include "delay.hpp"
 #include "esp_log.h"
+#include "trace.hpp"
+#include <cstdio>
 #include <string_view>
 
 namespace {
@@ -22,7 +24,13 @@ void UiThread::run_() {
       this);
 
   config_.button.setCallback(
-      [](common::Argument arg) { ESP_LOGI("BUTTON", "Click"); }, this);
+      [](common::Argument arg) {
+        ESP_LOGI("BUTTON", "Click");
+        if (sw::trace::isEnabled()) {
+          sw::trace::dump(stdout);
+        }
+      },
+      this);
 
   config_.queue.setCallback(
       [](def::ui::LedEvent event, common::Argument arg) {
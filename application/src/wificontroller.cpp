@@ -5,8 +5,10 @@
 #include "esp_netif.h"
 #include "esp_wifi.h"
 #include "esp_wifi_types.h"
+#include "uptime.hpp"
 #include "wifi.hpp"
 #include <cstring>
+#include <numeric>
 
 namespace {
 static std::string_view TAG{"WIFI_CONTROLLER"};
@@ -23,7 +25,6 @@ WifiController::WifiController(Config config) : config_{config} {
         assert(arg);
         WifiController* wifiController = static_cast<WifiController*>(arg);
         wifiController->getWifiInstance_().connect();
-        ++wifiController->reconnectAttempt_;
       },
       this);
 }
@@ -49,18 +50,26 @@ common::Error WifiController::init() {
   wifiConfig.sta.ssid = ssid;
   wifiConfig.sta.password = password;
   wifiConfig.sta.authenticateMode = net::Wifi::AuthenticateMode::WPA2_PSK;
+  wifiConfig.sta.listenInterval = LISTEN_INTERVAL;
   wifiConfig.ap.ssid = "esp";
   wifiConfig.ap.password = "123456789";
   wifiConfig.ap.authenticateMode = net::Wifi::AuthenticateMode::WPA2_PSK;
   wifiConfig.ap.maxStaConnected = 2;
   wifiConfig.ap.channel = 1;
   wifiConfig.mode = net::Wifi::Mode::APSTA;
+  wifiConfig.powerSave = idlePowerSave_;
 
   errorCode = getWifiInstance_().init(wifiConfig);
   if (errorCode != common::Error::OK) {
     return common::Error::FAIL;
   }
 
+  errorCode = config_.storage.getBlob(def::key::wifi::LAST_AP, apInfo_);
+  if (errorCode == common::Error::OK) {
+    isApInfoValid_ =
+        getWifiInstance_().setStaTarget(&apInfo_) == common::Error::OK;
+  }
+
   errorCode = getWifiInstance_().setWifiEventHandler(wifiEventHandler_, this);
   if (errorCode != common::Error::OK) {
     return common::Error::FAIL;
@@ -78,6 +87,52 @@ common::Error WifiController::start() { return getWifiInstance_().start(); }
 
 common::Error WifiController::stop() { return getWifiInstance_().stop(); }
 
+common::Error
+WifiController::setIdlePowerSave(const net::Wifi::PowerSave powerSave) {
+  idlePowerSave_ = powerSave;
+  if (isBusy_) {
+    return common::Error::OK;
+  }
+
+  return getWifiInstance_().setPowerSave(idlePowerSave_);
+}
+
+common::Error WifiController::setBusy(const bool isBusy) {
+  if (isBusy == isBusy_) {
+    return common::Error::OK;
+  }
+
+  isBusy_ = isBusy;
+  common::Error errorCode = getWifiInstance_().setPowerSave(
+      isBusy_ ? net::Wifi::PowerSave::NONE : idlePowerSave_);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to set power save");
+    return errorCode;
+  }
+
+  const net::Wifi::PowerSaveStats stats =
+      getWifiInstance_().getPowerSaveStats();
+  const uint64_t totalMs = std::accumulate(stats.timeInModeMs.begin(),
+                                           stats.timeInModeMs.end(),
+                                           static_cast<uint64_t>(0));
+  const uint64_t awakeMs =
+      stats.timeInModeMs[static_cast<size_t>(net::Wifi::PowerSave::NONE)];
+  ESP_LOGI(TAG.data(), "Power save %s, power save %u%% of time",
+           isBusy_ ? "off" : "on",
+           static_cast<unsigned>(
+               totalMs > 0 ? (totalMs - awakeMs) * 100 / totalMs : 0));
+  return common::Error::OK;
+}
+
+net::Wifi::PowerSaveStats WifiController::getPowerSaveStats() {
+  return getWifiInstance_().getPowerSaveStats();
+}
+
+common::Error
+WifiController::registerMetrics(sw::metrics::Registry& registry) const {
+  return registry.add("wifi.reconnects", reconnects_);
+}
+
 void WifiController::wifiEventHandler_(common::Argument arg,
                                        common::event::Base eventbase,
                                        common::event::Id eventId,
@@ -93,13 +148,13 @@ void WifiController::wifiEventHandler_(common::Argument arg,
     wifiController->getWifiInstance_().connect();
     break;
   case WIFI_EVENT_STA_CONNECTED:
-    wifiController->reconnectAttempt_ = 0;
+    wifiController->isStaConnected_ = true;
+    wifiController->reconnectBackoff_.reset();
     wifiController->config_.reconnectTimer.stop();
+    wifiController->storeApInfo_();
     break;
   case WIFI_EVENT_STA_DISCONNECTED:
-
-    wifiController->getWifiInstance_().scan();
-    wifiController->reconnect_();
+    wifiController->handleDisconnect_();
     break;
   case WIFI_EVENT_AP_STACONNECTED: {
     wifiController->showConnectedStaInfo_(eventData);
@@ -119,6 +174,12 @@ void WifiController::ipEventHandler_(common::Argument arg,
 
   if (eventId == IP_EVENT_STA_GOT_IP) {
     wifiController->showIp_(eventData);
+    if (wifiController->disconnectedMs_ != 0) {
+      ESP_LOGI(TAG.data(), "Reconnected in %u ms",
+               static_cast<unsigned>(sw::getUptimeMs() -
+                                     wifiController->disconnectedMs_));
+      wifiController->disconnectedMs_ = 0;
+    }
     wifiController->config_.connectionEventGroup.set(
         def::net::WIFI_CONNECTED_BIT);
     wifiController->config_.ledEventQueue.send(
@@ -130,17 +191,67 @@ net::Wifi& WifiController::getWifiInstance_() {
   return net::Wifi::getInstance();
 }
 
+void WifiController::handleDisconnect_() {
+  const bool wasConnected = isStaConnected_;
+  isStaConnected_ = false;
+
+  if (wasConnected) {
+    disconnectedMs_ = sw::getUptimeMs();
+    // Target is not changed while connected, it would drop the connection
+    if (isApInfoValid_) {
+      getWifiInstance_().setStaTarget(&apInfo_);
+    }
+  } else if (isApInfoValid_) {
+    // AP moved to another channel or was replaced, look for the SSID again
+    ESP_LOGW(TAG.data(), "Directed connect failed, scanning all channels");
+    isApInfoValid_ = false;
+    getWifiInstance_().setStaTarget(nullptr);
+    getWifiInstance_().scan();
+  }
+
+  reconnect_();
+}
+
+void WifiController::storeApInfo_() {
+  net::Wifi::ApInfo apInfo{};
+  if (getWifiInstance_().getStaApInfo(apInfo) != common::Error::OK) {
+    return;
+  }
+
+  if (isApInfoValid_ && apInfo.bssid == apInfo_.bssid &&
+      apInfo.channel == apInfo_.channel) {
+    return;
+  }
+
+  apInfo_ = apInfo;
+  isApInfoValid_ = true;
+  common::Error errorCode =
+      config_.storage.setBlob(def::key::wifi::LAST_AP, apInfo_);
+  if (errorCode == common::Error::OK) {
+    errorCode = config_.storage.save();
+  }
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to store access point");
+  }
+}
+
 common::Error WifiController::reconnect_() {
-  if (reconnectAttempt_ > MAX_RECONNECT_ATTEMPTS) {
-    reconnectAttempt_ = 0;
+  const uint32_t attempts = reconnectBackoff_.getState().attempts;
+  if (attempts == MAX_RECONNECT_ATTEMPTS) {
     config_.connectionEventGroup.clear(def::net::WIFI_CONNECTED_BIT);
     config_.ledEventQueue.send(def::ui::LedEvent::WIFI_DISCONNECTED);
-    return config_.reconnectTimer.startOnce(RECONNECT_TIME_US);
+  } else if (attempts < MAX_RECONNECT_ATTEMPTS) {
+    config_.ledEventQueue.send(def::ui::LedEvent::WIFI_CONNECTION);
   }
 
-  ++reconnectAttempt_;
-  config_.ledEventQueue.send(def::ui::LedEvent::WIFI_CONNECTION);
-  return getWifiInstance_().connect();
+  reconnects_.add();
+  // Every hub loses the AP together, jitter keeps them from returning so
+  const common::Time delayMs = reconnectBackoff_.next();
+  ESP_LOGI(TAG.data(), "Reconnect attempt %u in %u ms",
+           static_cast<unsigned>(attempts + 1),
+           static_cast<unsigned>(delayMs));
+  return config_.reconnectTimer.startOnce(
+      common::utils::msToUs<common::Time, common::Time>(delayMs));
 }
 
 void WifiController::showAvailableApList_() {
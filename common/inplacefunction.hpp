@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace common {
+template <typename Signature, size_t Capacity = 2 * sizeof(void*)>
+class InplaceFunction;
+
+/**
+ * @class InplaceFunction
+ * @brief Callable wrapper like std::function, the callable is stored inside
+ * the object and never on the heap. A callable bigger than the capacity does
+ * not compile. Move-only, a callback has one owner and the callable doesn't
+ * have to be copyable. A call is one indirect call.
+ *
+ * @tparam R Return type.
+ * @tparam Args Argument types.
+ * @tparam Capacity Storage size in bytes.
+ */
+template <typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+  public:
+    InplaceFunction() = default;
+
+    InplaceFunction(std::nullptr_t) {}
+
+    template <typename F,
+              typename = std::enable_if_t<
+                  not std::is_same_v<std::decay_t<F>, InplaceFunction> &&
+                  std::is_invocable_r_v<R, std::decay_t<F>&, Args...>>>
+    InplaceFunction(F&& callable) {
+      using Callable = std::decay_t<F>;
+      static_assert(sizeof(Callable) <= Capacity,
+                    "Callable does not fit InplaceFunction capacity");
+      static_assert(alignof(Callable) <= alignof(std::max_align_t),
+                    "Callable alignment not supported");
+
+      if constexpr (std::is_pointer_v<Callable>) {
+        if (callable == nullptr) {
+          return;
+        }
+      }
+
+      new (storage_) Callable(std::forward<F>(callable));
+      invoke_ = &invoke<Callable>;
+      manage_ = &manage<Callable>;
+    }
+
+    InplaceFunction(const InplaceFunction&) = delete;
+
+    InplaceFunction(InplaceFunction&& other) noexcept {
+      moveFrom_(std::move(other));
+    }
+
+    ~InplaceFunction() { reset_(); }
+
+    InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+    InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+      if (this != &other) {
+        reset_();
+        moveFrom_(std::move(other));
+      }
+      return *this;
+    }
+
+    InplaceFunction& operator=(std::nullptr_t) {
+      reset_();
+      return *this;
+    }
+
+    R operator()(Args... args) const {
+      return invoke_(storage_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const { return invoke_ != nullptr; }
+
+    bool operator==(std::nullptr_t) const { return invoke_ == nullptr; }
+
+    bool operator!=(std::nullptr_t) const { return invoke_ != nullptr; }
+
+  private:
+    enum class Operation : uint8_t { MOVE, DESTROY };
+
+    using Invoke = R (*)(void*, Args&&...);
+    using Manage = void (*)(void*, void*, Operation);
+
+    template <typename Callable>
+    static R invoke(void* storage, Args&&... args) {
+      return (*static_cast<Callable*>(storage))(std::forward<Args>(args)...);
+    }
+
+    template <typename Callable>
+    static void manage(void* destination, void* source,
+                       const Operation operation) {
+      auto* callable = static_cast<Callable*>(source);
+      switch (operation) {
+      case Operation::MOVE:
+        new (destination) Callable(std::move(*callable));
+        callable->~Callable();
+        break;
+      case Operation::DESTROY:
+        callable->~Callable();
+        break;
+      }
+    }
+
+    void moveFrom_(InplaceFunction&& other) {
+      if (other.manage_ != nullptr) {
+        other.manage_(storage_, other.storage_, Operation::MOVE);
+      }
+      invoke_ = other.invoke_;
+      manage_ = other.manage_;
+      other.invoke_ = nullptr;
+      other.manage_ = nullptr;
+    }
+
+    void reset_() {
+      if (manage_ != nullptr) {
+        manage_(nullptr, storage_, Operation::DESTROY);
+      }
+      invoke_ = nullptr;
+      manage_ = nullptr;
+    }
+
+    alignas(std::max_align_t) mutable unsigned char storage_[Capacity]{};
+    Invoke invoke_{nullptr};
+    Manage manage_{nullptr};
+};
+} // namespace common
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "types.hpp"
+#include <cstddef>
+
+namespace radio {
+class IChannel {
+  public:
+    virtual common::Error detectActivity(bool& isActive) = 0;
+
+    virtual common::Error getTimeOnAirUs(const size_t payloadLength,
+                                         uint32_t& timeUs) = 0;
+
+    virtual uint64_t getFrequencyHz() = 0;
+
+    virtual common::Error
+    setLinkSettings(const common::radio::LinkSettings& settings) = 0;
+};
+} // namespace radio
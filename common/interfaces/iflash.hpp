@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "types.hpp"
+
+namespace storage {
+class IFlash {
+  public:
+    virtual common::Error read(const size_t offset, uint8_t* buffer,
+                               const size_t bufferLength) = 0;
+
+    virtual common::Error write(const size_t offset, const uint8_t* data,
+                                const size_t dataLength) = 0;
+
+    virtual common::Error eraseSector(const size_t offset) = 0;
+
+    virtual size_t getSize() const = 0;
+
+    virtual size_t getSectorSize() const = 0;
+};
+} // namespace storage
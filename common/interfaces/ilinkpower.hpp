@@ -0,0 +1,10 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace net {
+class ILinkPower {
+  public:
+    virtual common::Error setBusy(const bool isBusy) = 0;
+};
+} // namespace net
@@ -7,6 +7,7 @@
 namespace radio {
 class IRadio {
   public:
+    // INVALID_STATE means the frame was deferred, flushPending() sends it
     virtual common::Error send(const uint8_t* data,
                                const size_t dataLength) = 0;
 
@@ -22,5 +23,12 @@ class IRadio {
     virtual common::radio::IrqEvent getIrqEvent() = 0;
 
     virtual common::SignalQuality getSignalQuality() = 0;
+
+    // Deferred frame handling, call flushPending() once the delay elapsed
+    virtual common::Error flushPending() = 0;
+
+    virtual bool hasPending() const = 0;
+
+    virtual common::Time getPendingDelayMs() = 0;
 };
 } // namespace radio
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+#include "types.hpp"
+
+namespace storage {
+template <typename T> class IRecordLog {
+  public:
+    virtual common::Error append(const T& record) = 0;
+
+    virtual common::Error peek(T& record) = 0;
+
+    virtual common::Error pop() = 0;
+
+    virtual common::Error flush() = 0;
+
+    virtual bool isEmpty() const = 0;
+};
+} // namespace storage
@@ -3,6 +3,7 @@
 #include "types.hpp"
 #include <any>
 #include <string_view>
+#include <type_traits>
 
 namespace storage {
 class IStorage {
@@ -13,12 +14,56 @@ class IStorage {
     virtual common::Error getItem(const std::string_view& key,
                                   uint8_t& item) = 0;
 
+    virtual common::Error setItem(const std::string_view& key,
+                                  const uint32_t& item) = 0;
+
+    virtual common::Error getItem(const std::string_view& key,
+                                  uint32_t& item) = 0;
+
     virtual common::Error setString(const std::string_view& key,
                                     const std::string& string) = 0;
 
     virtual common::Error getString(const std::string_view& key,
                                     std::string& string) = 0;
 
+    virtual common::Error setBlob(const std::string_view& key, const void* data,
+                                  const size_t size) = 0;
+
+    virtual common::Error getBlob(const std::string_view& key, void* data,
+                                  const size_t size) = 0;
+
     virtual common::Error save() = 0;
+
+    /**
+     * @brief Stores an object as a blob.
+     *
+     * @param key The key associated with the object.
+     * @param value Object, must be trivially copyable.
+     *
+     * @return See setBlob(key, data, size).
+     */
+    template <typename T>
+    common::Error setBlob(const std::string_view& key, const T& value) {
+      static_assert(std::is_trivially_copyable_v<T> &&
+                        not std::is_pointer_v<T>,
+                    "Blob must be a trivially copyable object");
+      return setBlob(key, &value, sizeof(value));
+    }
+
+    /**
+     * @brief Retrieves an object stored as a blob.
+     *
+     * @param key The key associated with the object.
+     * @param value Object, left unchanged unless common::Error::OK.
+     *
+     * @return See getBlob(key, data, size).
+     */
+    template <typename T>
+    common::Error getBlob(const std::string_view& key, T& value) {
+      static_assert(std::is_trivially_copyable_v<T> &&
+                        not std::is_pointer_v<T>,
+                    "Blob must be a trivially copyable object");
+      return getBlob(key, &value, sizeof(value));
+    }
 };
 } // namespace storage
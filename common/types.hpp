@@ -18,10 +18,29 @@ enum class Error : uint8_t {
 };
 
 struct __attribute__((packed)) Telemetry {
+    uint8_t controllerId{0};
     float temperatureC{0.0f};
     float humidityRh{0.0f};
 };
 
+// Statistics of a single telemetry field over an aggregation window
+struct __attribute__((packed)) FieldSummary {
+    float min{0.0f};
+    float max{0.0f};
+    float mean{0.0f};
+    float stddev{0.0f};
+};
+
+// Telemetry of a controller over an aggregation window, a raw sample has
+// window equal to 0
+struct __attribute__((packed)) TelemetrySummary {
+    uint8_t controllerId{0};
+    uint16_t sampleCount{0};
+    uint32_t windowS{0};
+    FieldSummary temperatureC{};
+    FieldSummary humidityRh{};
+};
+
 struct SignalQuality {
     static constexpr int16_t RSSI_INVALID_VALUE{
         std::numeric_limits<int16_t>::max()};
@@ -31,8 +50,22 @@ struct SignalQuality {
 };
 
 namespace radio {
-enum class IrqEvent : uint8_t { UNKNOWN, RX_DONE, TX_DONE };
-}
+enum class IrqEvent : uint8_t { UNKNOWN, RX_DONE, TX_DONE, CRC_ERROR };
+
+// LoRa parameters which can be changed at runtime
+struct __attribute__((packed)) LinkSettings {
+    uint8_t spreadingFactor{12};
+    uint32_t bandwidthHz{125'000};
+    int8_t txPowerDbm{20};
+};
+} // namespace radio
+
+// Runtime configuration, set from the cloud and sent to the controllers
+struct __attribute__((packed)) DeviceConfig {
+    uint32_t measurementPeriodS{1};
+    uint32_t requestPeriodS{10};
+    radio::LinkSettings link{};
+};
 
 namespace event {
 // Identifies the source of an event.
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 namespace common {
 namespace utils {
 
@@ -24,5 +27,26 @@ template <typename TReturn, typename T> constexpr TReturn minToS(T numberMin) {
   return static_cast<TReturn>(numberMin * static_cast<T>(60));
 }
 
+/**
+ * @brief Calculate CRC-32 (IEEE 802.3) of the data.
+ *
+ * @param data Data to calculate the checksum of.
+ * @param dataLength Data length.
+ * @param crc Result of the previous call, to continue over split data.
+ */
+inline uint32_t crc32(const uint8_t* data, const size_t dataLength,
+                      uint32_t crc = 0) {
+  constexpr uint32_t POLYNOMIAL{0xEDB88320};
+  crc = ~crc;
+  for (size_t i{0}; i < dataLength; ++i) {
+    crc ^= data[i];
+    for (uint8_t bit{0}; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ (POLYNOMIAL & (0 - (crc & 1)));
+    }
+  }
+
+  return ~crc;
+}
+
 } // namespace utils
 } // namespace common
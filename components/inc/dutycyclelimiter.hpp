@@ -0,0 +1,258 @@
+#pragma once
+
+#include "ichannel.hpp"
+#include "iradio.hpp"
+#include "metrics.hpp"
+#include "types.hpp"
+#include <array>
+
+namespace radio {
+/**
+ * @class DutyCycleLimiter
+ * @brief Radio wrapper which keeps transmissions within the regulatory
+ * duty-cycle of the current sub-band.
+ *
+ * Time on air of every sent frame is accounted per ETSI EN 300 220 sub-band
+ * over a sliding window of one hour, kept as one-minute buckets. A frame that
+ * would exceed the budget is not sent but kept as pending. A newer frame
+ * replaces the pending one, so only the latest deferred frame is sent by
+ * flushPending() once enough airtime is available again.
+ *
+ * A frame deferred by the wrapped radio is accounted when it is handed over,
+ * flushPending() and getPendingDelayMs() cover the wrapped radio too.
+ */
+class DutyCycleLimiter final : public IRadio {
+  public:
+    /**
+     * @brief Configuration for the DutyCycleLimiter
+     */
+    struct Config {
+        IRadio& radio;
+        IChannel& channel;
+    };
+
+    /**
+     * @brief Sub-band with its duty-cycle limit
+     */
+    struct SubBand {
+        uint64_t minFrequencyHz;
+        uint64_t maxFrequencyHz;
+        uint16_t dutyCyclePermyriad; // Limit in 0.01% units
+    };
+
+    /**
+     * @brief Airtime statistics
+     */
+    struct Stats {
+        uint32_t transmissions; // Frames sent
+        uint32_t deferrals;     // Frames held back, budget exhausted
+        uint32_t coalesced;     // Pending frames replaced by a newer one
+        uint64_t airtimeUs;     // Total time on air
+    };
+
+    /**
+     * @brief Construct a new DutyCycleLimiter object
+     *
+     * @param config Configuration for the DutyCycleLimiter
+     */
+    explicit DutyCycleLimiter(Config config);
+
+    /**
+     * @brief Send data if the duty-cycle budget allows it
+     *
+     * @param data Data to send
+     * @param dataLength Data length
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Frame too long.
+     *   - common::Error::INVALID_STATE: Frame deferred, by the budget or by
+     *     the wrapped radio.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error send(const uint8_t* data, const size_t dataLength) override;
+
+    common::Error receive(uint8_t* data, const size_t dataLength) override;
+
+    size_t getReceiveDataLength() override;
+
+    common::Error listening() override;
+
+    common::Error setIrqEventCallback(common::Callback cb,
+                                      common::Argument arg) override;
+
+    common::radio::IrqEvent getIrqEvent() override;
+
+    common::SignalQuality getSignalQuality() override;
+
+    /**
+     * @brief Send the pending frame if the budget allows it
+     *
+     * @return
+     *   - common::Error::OK: Success or nothing pending.
+     *   - common::Error::INVALID_STATE: Budget still exhausted or the wrapped
+     *     radio deferred the frame again.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error flushPending() override;
+
+    /**
+     * @brief Check if a deferred frame waits for transmission
+     *
+     * @return True if a frame is pending here or in the wrapped radio.
+     */
+    bool hasPending() const override;
+
+    /**
+     * @brief Get time after which the pending frame fits into the budget
+     *
+     * @return Time in milliseconds, 0 if nothing pending or it can be sent
+     * now.
+     */
+    common::Time getPendingDelayMs() override;
+
+    /**
+     * @brief Get airtime left in the current window for the current sub-band
+     *
+     * @return Remaining airtime in microseconds.
+     */
+    uint32_t getRemainingBudgetUs();
+
+    /**
+     * @brief Add the remaining airtime as radio.dutyCycleBudgetUs, updated
+     * on every transmission attempt.
+     *
+     * @param registry Registry to add to.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NO_MEM: Registry is full.
+     */
+    common::Error registerMetrics(sw::metrics::Registry& registry) const;
+
+    /**
+     * @brief Get airtime statistics
+     *
+     * @return Statistics since start or last reset.
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief Reset airtime statistics
+     */
+    void resetStats();
+
+    static constexpr size_t MAX_FRAME_LENGTH{255};
+
+  private:
+    /**
+     * @brief Get index of the sub-band which contains the frequency
+     *
+     * @param frequencyHz Carrier frequency
+     *
+     * @return Sub-band index, fallback index if frequency is not listed.
+     */
+    static size_t getSubBandIndex_(const uint64_t frequencyHz);
+
+    /**
+     * @brief Get airtime allowed within the window for the sub-band
+     *
+     * @param subBand Sub-band index
+     *
+     * @return Budget in microseconds.
+     */
+    static uint32_t getBudgetUs_(const size_t subBand);
+
+    /**
+     * @brief Move the window to the current time, clearing expired buckets
+     */
+    void advanceWindow_();
+
+    /**
+     * @brief Get airtime used in the window by the sub-band
+     *
+     * @param subBand Sub-band index
+     *
+     * @return Used airtime in microseconds.
+     */
+    uint32_t getUsedUs_(const size_t subBand) const;
+
+    /**
+     * @brief Check if a frame fits into the budget of the current sub-band
+     *
+     * @param dataLength Data length
+     * @param timeOnAirUs Set to the time on air of the frame
+     * @param subBand Set to the current sub-band index
+     *
+     * @return
+     *   - common::Error::OK: Frame fits.
+     *   - common::Error::INVALID_STATE: Budget exhausted.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error checkBudget_(const size_t dataLength, uint32_t& timeOnAirUs,
+                               size_t& subBand);
+
+    /**
+     * @brief Hand a frame to the wrapped radio and account its airtime
+     *
+     * @param data Data to send
+     * @param dataLength Data length
+     * @param timeOnAirUs Time on air of the frame
+     * @param subBand Sub-band index
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Deferred by the wrapped radio.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error sendAccounted_(const uint8_t* data, const size_t dataLength,
+                                 const uint32_t timeOnAirUs,
+                                 const size_t subBand);
+
+    /**
+     * @brief Get time after which the own pending frame fits into the budget
+     *
+     * @return Time in milliseconds, 0 if nothing pending or it fits now.
+     */
+    common::Time getOwnPendingDelayMs_();
+
+    /**
+     * @brief Publish the remaining airtime of a sub-band to the gauge
+     *
+     * @param subBand Sub-band index
+     */
+    void updateBudgetGauge_(const size_t subBand);
+
+    /**
+     * @brief Keep a frame for later transmission, replacing an older one
+     *
+     * @param data Data to keep
+     * @param dataLength Data length
+     */
+    void storePending_(const uint8_t* data, const size_t dataLength);
+
+    // EU 863-870 MHz sub-bands for non-specific SRD, ETSI EN 300 220-2
+    static constexpr std::array<SubBand, 5> SUB_BANDS{{
+        {863'000'000, 868'000'000, 100},  // g
+        {868'000'000, 868'600'000, 100},  // g1
+        {868'700'000, 869'200'000, 10},   // g2
+        {869'400'000, 869'650'000, 1000}, // g3
+        {869'700'000, 870'000'000, 100},  // g4
+    }};
+    // Used for frequencies outside of the table, most restrictive limit
+    static constexpr uint16_t FALLBACK_DUTY_CYCLE_PERMYRIAD{10};
+    static constexpr size_t SUB_BAND_COUNT{SUB_BANDS.size() + 1};
+    static constexpr common::Time WINDOW_MS{3'600'000};
+    static constexpr common::Time BUCKET_MS{60'000};
+    // One extra bucket, so airtime is never forgotten before a full window
+    static constexpr size_t BUCKET_COUNT{WINDOW_MS / BUCKET_MS + 1};
+
+    Config config_;
+    std::array<std::array<uint32_t, BUCKET_COUNT>, SUB_BAND_COUNT> airtimeUs_{};
+    uint64_t currentBucket_{0};
+    std::array<uint8_t, MAX_FRAME_LENGTH> pendingData_{};
+    size_t pendingLength_{0};
+    Stats stats_{};
+    sw::metrics::Gauge remainingBudgetUs_{};
+};
+} // namespace radio
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "ichannel.hpp"
+#include "iradio.hpp"
+#include "types.hpp"
+#include <array>
+
+namespace radio {
+/**
+ * @class ListenBeforeTalk
+ * @brief Radio wrapper which checks the channel before every transmission.
+ *
+ * Before sending, channel activity detection is run on the underlying radio.
+ * When the channel is busy, the frame is kept as pending and send() returns
+ * without blocking. flushPending() checks the channel again once the binary
+ * exponential backoff with random jitter has passed. A newer frame replaces
+ * the pending one. All other calls are forwarded to the radio.
+ */
+class ListenBeforeTalk final : public IRadio {
+  public:
+    /**
+     * @brief Configuration for the ListenBeforeTalk
+     */
+    struct Config {
+        IRadio& radio;
+        IChannel& channel;
+    };
+
+    /**
+     * @brief Backoff settings
+     */
+    struct Settings {
+        uint8_t maxAttempts;
+        common::Time baseBackoffMs;
+        common::Time maxBackoffMs;
+    };
+
+    /**
+     * @brief Channel access statistics
+     */
+    struct Stats {
+        uint32_t transmissions;     // Frames sent
+        uint32_t deferrals;         // Frames delayed at least once
+        uint32_t collisionsAvoided; // Busy channel detections
+        uint32_t busyDrops;         // Frames dropped, channel busy too long
+    };
+
+    /**
+     * @brief Construct a new ListenBeforeTalk object
+     *
+     * @param config Configuration for the ListenBeforeTalk
+     */
+    explicit ListenBeforeTalk(Config config);
+
+    /**
+     * @brief Set backoff settings
+     *
+     * @param settings Backoff settings
+     */
+    void setSettings(const Settings settings);
+
+    /**
+     * @brief Send data when the channel is free, defer it when it is busy
+     *
+     * @param data Data to send
+     * @param dataLength Data length
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Frame too long.
+     *   - common::Error::INVALID_STATE: Channel busy, frame kept pending.
+     *   - common::Error::FAIL: Fail or channel busy after all attempts.
+     */
+    common::Error send(const uint8_t* data, const size_t dataLength) override;
+
+    common::Error receive(uint8_t* data, const size_t dataLength) override;
+
+    size_t getReceiveDataLength() override;
+
+    common::Error listening() override;
+
+    common::Error setIrqEventCallback(common::Callback cb,
+                                      common::Argument arg) override;
+
+    common::radio::IrqEvent getIrqEvent() override;
+
+    common::SignalQuality getSignalQuality() override;
+
+    /**
+     * @brief Check the channel again and send the pending frame if it is free
+     *
+     * @return
+     *   - common::Error::OK: Success or nothing pending.
+     *   - common::Error::INVALID_STATE: Backoff not passed or channel still
+     *     busy, frame kept pending.
+     *   - common::Error::FAIL: Fail or channel busy after all attempts.
+     */
+    common::Error flushPending() override;
+
+    /**
+     * @brief Check if a deferred frame waits for transmission
+     *
+     * @return True if a frame is pending here or in the wrapped radio.
+     */
+    bool hasPending() const override;
+
+    /**
+     * @brief Get time after which the pending frame is checked again
+     *
+     * @return Time in milliseconds, 0 if nothing pending or it is due.
+     */
+    common::Time getPendingDelayMs() override;
+
+    /**
+     * @brief Get channel access statistics
+     *
+     * @return Statistics since start or last reset.
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief Reset channel access statistics
+     */
+    void resetStats();
+
+    static constexpr size_t MAX_FRAME_LENGTH{255};
+
+  private:
+    /**
+     * @brief Send a frame if the channel is free, keep it pending if busy
+     *
+     * @param data Data to send
+     * @param dataLength Data length
+     * @param attempt Number of busy detections of this frame so far
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Channel busy, frame kept pending.
+     *   - common::Error::FAIL: Fail or channel busy after all attempts.
+     */
+    common::Error trySend_(const uint8_t* data, const size_t dataLength,
+                           const uint8_t attempt);
+
+    /**
+     * @brief Get backoff time for a given attempt
+     *
+     * @param attempt Number of busy detections so far
+     *
+     * @return Backoff time in milliseconds.
+     */
+    common::Time getBackoffTimeMs_(const uint8_t attempt) const;
+
+    static constexpr Settings DEFAULT_SETTINGS{6, 100, 3200};
+    Config config_;
+    Settings settings_{DEFAULT_SETTINGS};
+    Stats stats_{};
+    std::array<uint8_t, MAX_FRAME_LENGTH> pendingData_{};
+    size_t pendingLength_{0};
+    uint8_t pendingAttempt_{0};
+    common::Time pendingDueMs_{0};
+};
+} // namespace radio
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "ichannel.hpp"
 #include "iradio.hpp"
 #include "ispi.hpp"
 #include "sx127xmodem.hpp"
@@ -11,7 +12,7 @@ namespace radio {
  * @class Rfm95
  * @brief Rfm95 class
  */
-class Rfm95 final : public IRadio {
+class Rfm95 final : public IRadio, public IChannel {
   public:
     using Mode = sx127x::Mode;
     using Modulation = sx127x::Modulation;
@@ -123,6 +124,7 @@ class Rfm95 final : public IRadio {
      *
      * @return
      *   - common::radio::IrqEvent::RX_DONE: Packet reception complete
+     *   - common::radio::IrqEvent::CRC_ERROR: Packet received with wrong CRC
      *   - common::radio::IrqEvent::TX_DONE: FIFO Payload transmission complete
      *   - common::radio::IrqEvent::UNKNOWN: Unknown event
      */
@@ -137,6 +139,62 @@ class Rfm95 final : public IRadio {
      */
     common::SignalQuality getSignalQuality() override;
 
+    /**
+     * @brief Send the deferred frame, Rfm95 sends every frame immediately
+     *
+     * @return
+     *   - common::Error::OK: Nothing pending.
+     */
+    common::Error flushPending() override;
+
+    /**
+     * @brief Check if a deferred frame waits for transmission
+     *
+     * @return False, frames are never deferred.
+     */
+    bool hasPending() const override;
+
+    /**
+     * @brief Get time after which the deferred frame can be sent
+     *
+     * @return 0, frames are never deferred.
+     */
+    common::Time getPendingDelayMs() override;
+
+    /**
+     * @brief Check if another node is transmitting on the channel (CAD)
+     * @note Radio is left in standby, call listening() to receive again.
+     *
+     * @param isActive Set to true if channel activity was detected
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error detectActivity(bool& isActive) override;
+
+    /**
+     * @brief Get time on air of a packet with the current modem settings
+     *
+     * @param payloadLength Payload length in bytes
+     * @param timeUs Time on air in microseconds
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error getTimeOnAirUs(const size_t payloadLength,
+                                 uint32_t& timeUs) override;
+
+    /**
+     * @brief Get carrier frequency
+     *
+     * @return
+     *   - Frequency in Hz if success
+     *   - 0 if failed
+     */
+    uint64_t getFrequencyHz() override;
+
     /**
      * @brief Set all settings
      *
@@ -257,6 +315,31 @@ class Rfm95 final : public IRadio {
      */
     common::Error setPaConfig(PaPin pin, int8_t power);
 
+    /**
+     * @brief Set spreading factor, bandwidth and output power.
+     * @note Output power uses the PA pin given in setAllSettings().
+     *
+     * @param settings Link settings
+     *
+     * @return
+     *   - common::Error::OK Success.
+     *   - common::Error::INVALID_ARG: Unsupported value, nothing changed.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error
+    setLinkSettings(const common::radio::LinkSettings& settings) override;
+
+    /**
+     * @brief Check if link settings are supported by the modem.
+     *
+     * @param settings Link settings
+     * @param paPin PA pin the output power is checked for
+     *
+     * @return True if setLinkSettings() accepts them with this PA pin.
+     */
+    static bool isLinkSupported(const common::radio::LinkSettings& settings,
+                                PaPin paPin);
+
     static constexpr int SPI_CLOCK_SPEED_HZ{3'000'000};
 
   private:
@@ -266,5 +349,6 @@ class Rfm95 final : public IRadio {
 
     Config config_;
     std::unique_ptr<sx127x::ModemBase> modem_{nullptr};
+    PaPin paPin_{PaPin::BOOST};
 };
 } // namespace radio
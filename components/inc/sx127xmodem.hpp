@@ -220,6 +220,16 @@ class ModemBase {
      */
     common::Error setPaConfig(PaPin pin, int8_t power);
 
+    /**
+     * @brief Check if an output power is in the range of a Pa pin.
+     *
+     * @param pin Pa pin
+     * @param power Power in dBm
+     *
+     * @return True if setPaConfig() accepts it.
+     */
+    static bool isPowerSupported(PaPin pin, int8_t power);
+
     virtual common::Error getRxData(uint8_t* data, const size_t dataLength) = 0;
 
     virtual size_t getRxDataLength() = 0;
@@ -250,6 +260,11 @@ class ModemBase {
 
     virtual common::radio::IrqEvent getIrqEvent() = 0;
 
+    virtual common::Error detectChannelActivity(bool& isActive) = 0;
+
+    virtual common::Error getTimeOnAirUs(const size_t payloadLength,
+                                         uint32_t& timeUs) = 0;
+
     static constexpr uint64_t INVALID_FREQUENCY_HZ{0};
 
   protected:
@@ -412,16 +427,45 @@ class LoRa final : public ModemBase {
      *
      * @return
      *   - common::radio::IrqEvent::RX_DONE: Packet reception complete
+     *   - common::radio::IrqEvent::CRC_ERROR: Packet received with wrong CRC
      *   - common::radio::IrqEvent::TX_DONE: FIFO Payload transmission complete
      *   - common::radio::IrqEvent::UNKNOWN: Unknown event
      */
     common::radio::IrqEvent getIrqEvent() override;
 
+    /**
+     * @brief Run channel activity detection (CAD)
+     * @note Modem is left in STANDBY mode after detection.
+     *
+     * @param isActive Set to true if a LoRa preamble was detected
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail or CAD did not finish in time.
+     */
+    common::Error detectChannelActivity(bool& isActive) override;
+
+    /**
+     * @brief Calculate time on air of a packet for the current modem settings
+     * @note Based on the formula from the SX1276 datasheet, section 4.1.1.7.
+     *
+     * @param payloadLength Payload length in bytes
+     * @param timeUs Time on air in microseconds
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error getTimeOnAirUs(const size_t payloadLength,
+                                 uint32_t& timeUs) override;
+
   private:
     common::Error reloadLowDatarateOptimization_();
 
     common::Error getBandwidth_(uint32_t* bandwidth);
 
+    common::Error getSymbolDurationUs_(uint32_t& durationUs);
+
     common::Error setLowDatarateOptimization_(bool enable);
 
     int16_t getRssi_();
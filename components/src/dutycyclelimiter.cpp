@@ -0,0 +1,277 @@
+#include "dutycyclelimiter.hpp"
+#include "esp_log.h"
+#include "uptime.hpp"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace {
+static constexpr std::string_view TAG{"DUTY_CYCLE"};
+}
+
+namespace radio {
+DutyCycleLimiter::DutyCycleLimiter(Config config) : config_{config} {}
+
+common::Error DutyCycleLimiter::send(const uint8_t* data,
+                                     const size_t dataLength) {
+  if (data == nullptr || dataLength > MAX_FRAME_LENGTH) {
+    return common::Error::INVALID_ARG;
+  }
+
+  uint32_t timeOnAirUs{0};
+  size_t subBand{0};
+  common::Error errorCode = checkBudget_(dataLength, timeOnAirUs, subBand);
+  if (errorCode == common::Error::INVALID_STATE) {
+    storePending_(data, dataLength);
+    ESP_LOGW(TAG.data(), "Frame deferred, remaining budget: %lu [us]",
+             static_cast<unsigned long>(remainingBudgetUs_.get()));
+    return common::Error::INVALID_STATE;
+  } else if (errorCode != common::Error::OK) {
+    return errorCode;
+  }
+
+  errorCode = sendAccounted_(data, dataLength, timeOnAirUs, subBand);
+  const bool isAccepted = errorCode == common::Error::OK ||
+                          errorCode == common::Error::INVALID_STATE;
+  if (isAccepted && pendingLength_ > 0) {
+    // Newer frame supersedes the deferred one
+    ++stats_.coalesced;
+    pendingLength_ = 0;
+  }
+  return errorCode;
+}
+
+common::Error DutyCycleLimiter::receive(uint8_t* data,
+                                        const size_t dataLength) {
+  return config_.radio.receive(data, dataLength);
+}
+
+size_t DutyCycleLimiter::getReceiveDataLength() {
+  return config_.radio.getReceiveDataLength();
+}
+
+common::Error DutyCycleLimiter::listening() {
+  return config_.radio.listening();
+}
+
+common::Error DutyCycleLimiter::setIrqEventCallback(common::Callback cb,
+                                                    common::Argument arg) {
+  return config_.radio.setIrqEventCallback(cb, arg);
+}
+
+common::radio::IrqEvent DutyCycleLimiter::getIrqEvent() {
+  return config_.radio.getIrqEvent();
+}
+
+common::SignalQuality DutyCycleLimiter::getSignalQuality() {
+  return config_.radio.getSignalQuality();
+}
+
+common::Error DutyCycleLimiter::flushPending() {
+  if (config_.radio.hasPending()) {
+    common::Error errorCode = config_.radio.flushPending();
+    if (errorCode != common::Error::OK) {
+      return errorCode;
+    }
+  }
+
+  if (pendingLength_ == 0) {
+    return common::Error::OK;
+  }
+
+  uint32_t timeOnAirUs{0};
+  size_t subBand{0};
+  common::Error errorCode =
+      checkBudget_(pendingLength_, timeOnAirUs, subBand);
+  if (errorCode != common::Error::OK) {
+    return errorCode;
+  }
+
+  errorCode = sendAccounted_(pendingData_.data(), pendingLength_, timeOnAirUs,
+                             subBand);
+  if (errorCode == common::Error::OK ||
+      errorCode == common::Error::INVALID_STATE) {
+    pendingLength_ = 0;
+  }
+  return errorCode;
+}
+
+bool DutyCycleLimiter::hasPending() const {
+  return pendingLength_ > 0 || config_.radio.hasPending();
+}
+
+common::Time DutyCycleLimiter::getPendingDelayMs() {
+  if (not config_.radio.hasPending()) {
+    return getOwnPendingDelayMs_();
+  }
+
+  const common::Time delayMs = config_.radio.getPendingDelayMs();
+  return pendingLength_ > 0 ? std::min(delayMs, getOwnPendingDelayMs_())
+                            : delayMs;
+}
+
+uint32_t DutyCycleLimiter::getRemainingBudgetUs() {
+  advanceWindow_();
+  const size_t subBand = getSubBandIndex_(config_.channel.getFrequencyHz());
+  updateBudgetGauge_(subBand);
+
+  return static_cast<uint32_t>(remainingBudgetUs_.get());
+}
+
+common::Error
+DutyCycleLimiter::registerMetrics(sw::metrics::Registry& registry) const {
+  return registry.add("radio.dutyCycleBudgetUs", remainingBudgetUs_);
+}
+
+DutyCycleLimiter::Stats DutyCycleLimiter::getStats() const { return stats_; }
+
+void DutyCycleLimiter::resetStats() { stats_ = Stats{}; }
+
+common::Time DutyCycleLimiter::getOwnPendingDelayMs_() {
+  if (pendingLength_ == 0) {
+    return 0;
+  }
+
+  uint32_t timeOnAirUs{0};
+  common::Error errorCode =
+      config_.channel.getTimeOnAirUs(pendingLength_, timeOnAirUs);
+  if (errorCode != common::Error::OK) {
+    return 0;
+  }
+
+  advanceWindow_();
+  const size_t subBand = getSubBandIndex_(config_.channel.getFrequencyHz());
+  const uint64_t usedUs = getUsedUs_(subBand);
+  const uint64_t budgetUs = getBudgetUs_(subBand);
+  if (usedUs + timeOnAirUs <= budgetUs) {
+    return 0;
+  }
+
+  // Walk from the oldest bucket until enough airtime expires
+  const uint64_t neededUs = usedUs + timeOnAirUs - budgetUs;
+  const uint64_t oldestBucket = currentBucket_ >= BUCKET_COUNT - 1
+                                    ? currentBucket_ - (BUCKET_COUNT - 1)
+                                    : 0;
+  uint64_t freedUs{0};
+  for (uint64_t bucket{oldestBucket}; bucket <= currentBucket_; ++bucket) {
+    freedUs += airtimeUs_[subBand][bucket % BUCKET_COUNT];
+    if (freedUs >= neededUs) {
+      constexpr uint64_t US_PER_MS{1000};
+      const uint64_t expireMs = (bucket + BUCKET_COUNT) * BUCKET_MS;
+      const uint64_t nowMs = sw::getUptimeUs() / US_PER_MS;
+      return expireMs > nowMs ? static_cast<common::Time>(expireMs - nowMs)
+                              : 0;
+    }
+  }
+
+  // Frame longer than the whole budget, it will never fit
+  return WINDOW_MS;
+}
+
+size_t DutyCycleLimiter::getSubBandIndex_(const uint64_t frequencyHz) {
+  for (size_t i{0}; i < SUB_BANDS.size(); ++i) {
+    if (frequencyHz >= SUB_BANDS[i].minFrequencyHz &&
+        frequencyHz < SUB_BANDS[i].maxFrequencyHz) {
+      return i;
+    }
+  }
+
+  return SUB_BANDS.size();
+}
+
+uint32_t DutyCycleLimiter::getBudgetUs_(const size_t subBand) {
+  constexpr uint64_t US_PER_MS{1000};
+  constexpr uint64_t PERMYRIAD{10'000};
+  const uint16_t dutyCycle = subBand < SUB_BANDS.size()
+                                 ? SUB_BANDS[subBand].dutyCyclePermyriad
+                                 : FALLBACK_DUTY_CYCLE_PERMYRIAD;
+
+  return static_cast<uint32_t>((WINDOW_MS * US_PER_MS * dutyCycle) /
+                               PERMYRIAD);
+}
+
+void DutyCycleLimiter::advanceWindow_() {
+  constexpr uint64_t US_PER_MS{1000};
+  const uint64_t nowBucket = sw::getUptimeUs() / US_PER_MS / BUCKET_MS;
+  if (nowBucket <= currentBucket_) {
+    return;
+  }
+
+  const uint64_t steps =
+      std::min<uint64_t>(nowBucket - currentBucket_, BUCKET_COUNT);
+  for (uint64_t i{1}; i <= steps; ++i) {
+    const size_t index = (currentBucket_ + i) % BUCKET_COUNT;
+    for (auto& buckets : airtimeUs_) {
+      buckets[index] = 0;
+    }
+  }
+  currentBucket_ = nowBucket;
+}
+
+uint32_t DutyCycleLimiter::getUsedUs_(const size_t subBand) const {
+  uint32_t usedUs{0};
+  for (const uint32_t airtimeUs : airtimeUs_[subBand]) {
+    usedUs += airtimeUs;
+  }
+
+  return usedUs;
+}
+
+common::Error DutyCycleLimiter::checkBudget_(const size_t dataLength,
+                                             uint32_t& timeOnAirUs,
+                                             size_t& subBand) {
+  common::Error errorCode =
+      config_.channel.getTimeOnAirUs(dataLength, timeOnAirUs);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  advanceWindow_();
+  subBand = getSubBandIndex_(config_.channel.getFrequencyHz());
+  updateBudgetGauge_(subBand);
+  if (getUsedUs_(subBand) + timeOnAirUs > getBudgetUs_(subBand)) {
+    return common::Error::INVALID_STATE;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error DutyCycleLimiter::sendAccounted_(const uint8_t* data,
+                                               const size_t dataLength,
+                                               const uint32_t timeOnAirUs,
+                                               const size_t subBand) {
+  // A frame deferred by the wrapped radio goes out later, account it now. If
+  // a newer frame replaces it there, the budget is charged conservatively.
+  common::Error errorCode = config_.radio.send(data, dataLength);
+  if (errorCode != common::Error::OK &&
+      errorCode != common::Error::INVALID_STATE) {
+    return errorCode;
+  }
+
+  airtimeUs_[subBand][currentBucket_ % BUCKET_COUNT] += timeOnAirUs;
+  ++stats_.transmissions;
+  stats_.airtimeUs += timeOnAirUs;
+  updateBudgetGauge_(subBand);
+  return errorCode;
+}
+
+void DutyCycleLimiter::updateBudgetGauge_(const size_t subBand) {
+  const uint32_t usedUs = getUsedUs_(subBand);
+  const uint32_t budgetUs = getBudgetUs_(subBand);
+  remainingBudgetUs_.set(
+      static_cast<int32_t>(usedUs < budgetUs ? budgetUs - usedUs : 0));
+}
+
+void DutyCycleLimiter::storePending_(const uint8_t* data,
+                                     const size_t dataLength) {
+  // A frame held by the wrapped radio is not replaced, only count our own
+  if (pendingLength_ > 0) {
+    ++stats_.coalesced;
+  }
+  ++stats_.deferrals;
+
+  std::memcpy(pendingData_.data(), data, dataLength);
+  pendingLength_ = dataLength;
+}
+
+} // namespace radio
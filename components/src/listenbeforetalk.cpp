@@ -0,0 +1,134 @@
+#include "listenbeforetalk.hpp"
+#include "random.hpp"
+#include "uptime.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace radio {
+ListenBeforeTalk::ListenBeforeTalk(Config config) : config_{config} {}
+
+void ListenBeforeTalk::setSettings(const Settings settings) {
+  settings_ = settings;
+}
+
+common::Error ListenBeforeTalk::send(const uint8_t* data,
+                                     const size_t dataLength) {
+  if (data == nullptr || dataLength > MAX_FRAME_LENGTH) {
+    return common::Error::INVALID_ARG;
+  }
+
+  // Newer frame supersedes the deferred one
+  pendingLength_ = 0;
+  return trySend_(data, dataLength, 0);
+}
+
+common::Error ListenBeforeTalk::receive(uint8_t* data,
+                                        const size_t dataLength) {
+  return config_.radio.receive(data, dataLength);
+}
+
+size_t ListenBeforeTalk::getReceiveDataLength() {
+  return config_.radio.getReceiveDataLength();
+}
+
+common::Error ListenBeforeTalk::listening() {
+  return config_.radio.listening();
+}
+
+common::Error ListenBeforeTalk::setIrqEventCallback(common::Callback cb,
+                                                    common::Argument arg) {
+  return config_.radio.setIrqEventCallback(cb, arg);
+}
+
+common::radio::IrqEvent ListenBeforeTalk::getIrqEvent() {
+  return config_.radio.getIrqEvent();
+}
+
+common::SignalQuality ListenBeforeTalk::getSignalQuality() {
+  return config_.radio.getSignalQuality();
+}
+
+common::Error ListenBeforeTalk::flushPending() {
+  if (pendingLength_ == 0) {
+    return config_.radio.flushPending();
+  }
+
+  if (getPendingDelayMs() > 0) {
+    return common::Error::INVALID_STATE;
+  }
+
+  // trySend_() keeps the frame again if the channel is still busy
+  const size_t dataLength = pendingLength_;
+  pendingLength_ = 0;
+  return trySend_(pendingData_.data(), dataLength, pendingAttempt_);
+}
+
+bool ListenBeforeTalk::hasPending() const {
+  return pendingLength_ > 0 || config_.radio.hasPending();
+}
+
+common::Time ListenBeforeTalk::getPendingDelayMs() {
+  if (pendingLength_ == 0) {
+    return config_.radio.getPendingDelayMs();
+  }
+
+  // Uptime in milliseconds wraps after 49 days
+  const int32_t timeLeftMs =
+      static_cast<int32_t>(pendingDueMs_ - sw::getUptimeMs());
+  return timeLeftMs > 0 ? static_cast<common::Time>(timeLeftMs) : 0;
+}
+
+ListenBeforeTalk::Stats ListenBeforeTalk::getStats() const { return stats_; }
+
+void ListenBeforeTalk::resetStats() { stats_ = Stats{}; }
+
+common::Error ListenBeforeTalk::trySend_(const uint8_t* data,
+                                         const size_t dataLength,
+                                         const uint8_t attempt) {
+  bool isActive{false};
+  common::Error errorCode = config_.channel.detectActivity(isActive);
+  if (errorCode != common::Error::OK) {
+    // CAD failed, don't block the frame because of it
+    isActive = false;
+  }
+
+  if (not isActive) {
+    errorCode = config_.radio.send(data, dataLength);
+    if (errorCode == common::Error::OK) {
+      ++stats_.transmissions;
+    }
+    return errorCode;
+  }
+
+  ++stats_.collisionsAvoided;
+  if (attempt == 0) {
+    ++stats_.deferrals;
+  }
+
+  // Keep receiving while waiting, the busy channel may be a frame for us
+  config_.radio.listening();
+  if (attempt + 1 >= settings_.maxAttempts) {
+    ++stats_.busyDrops;
+    return common::Error::FAIL;
+  }
+
+  if (data != pendingData_.data()) {
+    std::memcpy(pendingData_.data(), data, dataLength);
+  }
+  pendingLength_ = dataLength;
+  pendingAttempt_ = attempt + 1;
+  pendingDueMs_ = sw::getUptimeMs() + getBackoffTimeMs_(attempt);
+  return common::Error::INVALID_STATE;
+}
+
+common::Time ListenBeforeTalk::getBackoffTimeMs_(const uint8_t attempt) const {
+  constexpr uint8_t MAX_SHIFT{16};
+  const uint8_t shift = std::min(attempt, MAX_SHIFT);
+  const common::Time windowMs =
+      std::min(settings_.maxBackoffMs,
+               static_cast<common::Time>(settings_.baseBackoffMs << shift));
+
+  return sw::random(windowMs / 2, windowMs);
+}
+
+} // namespace radio
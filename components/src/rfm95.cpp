@@ -2,7 +2,33 @@
 #include "delay.hpp"
 #include "esp_log.h"
 #include "sx127xregisters.hpp"
+#include <algorithm>
 #include <array>
+#include <utility>
+
+namespace {
+// Bandwidths of the modem, link settings give them in Hz
+constexpr std::array<std::pair<uint32_t, radio::Rfm95::Bandwidth>, 10>
+    BANDWIDTHS{{
+        {7'800, radio::Rfm95::Bandwidth::BW_7800},
+        {10'400, radio::Rfm95::Bandwidth::BW_10400},
+        {15'600, radio::Rfm95::Bandwidth::BW_15600},
+        {20'800, radio::Rfm95::Bandwidth::BW_20800},
+        {31'250, radio::Rfm95::Bandwidth::BW_31250},
+        {41'700, radio::Rfm95::Bandwidth::BW_41700},
+        {62'500, radio::Rfm95::Bandwidth::BW_62500},
+        {125'000, radio::Rfm95::Bandwidth::BW_125000},
+        {250'000, radio::Rfm95::Bandwidth::BW_250000},
+        {500'000, radio::Rfm95::Bandwidth::BW_500000},
+    }};
+
+auto findBandwidth(const uint32_t bandwidthHz) {
+  return std::find_if(BANDWIDTHS.begin(), BANDWIDTHS.end(),
+                      [bandwidthHz](const auto& entry) {
+                        return entry.first == bandwidthHz;
+                      });
+}
+} // namespace
 
 namespace radio {
 Rfm95::Rfm95(Config config) : config_{config} {}
@@ -139,9 +165,37 @@ common::Error Rfm95::setAllSettings(ModemSettings settings) {
     return common::Error::FAIL;
   }
 
+  paPin_ = settings.paPin;
   return common::Error::OK;
 }
 
+common::Error
+Rfm95::setLinkSettings(const common::radio::LinkSettings& settings) {
+  if (modem_ == nullptr) {
+    return common::Error::FAIL;
+  }
+
+  if (not isLinkSupported(settings, paPin_)) {
+    return common::Error::INVALID_ARG;
+  }
+
+  // SF register field holds the spreading factor in the upper nibble
+  const auto spreadingFactor =
+      static_cast<SF>(settings.spreadingFactor << 4);
+
+  common::Error errorCode = setPaConfig(paPin_, settings.txPowerDbm);
+  if (errorCode != common::Error::OK) {
+    return errorCode;
+  }
+
+  errorCode = setBandwidth(findBandwidth(settings.bandwidthHz)->second);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  return setModemConfig(spreadingFactor);
+}
+
 common::Error Rfm95::setFrequency(uint64_t frequencyHz) {
   if (modem_ == nullptr) {
     return common::Error::FAIL;
@@ -206,6 +260,16 @@ common::Error Rfm95::setPreambleLength(uint16_t length) {
   return modem_->setPreambleLength(length);
 }
 
+bool Rfm95::isLinkSupported(const common::radio::LinkSettings& settings,
+                            PaPin paPin) {
+  constexpr uint8_t MIN_SF{7};
+  constexpr uint8_t MAX_SF{12};
+  return settings.spreadingFactor >= MIN_SF &&
+         settings.spreadingFactor <= MAX_SF &&
+         findBandwidth(settings.bandwidthHz) != BANDWIDTHS.end() &&
+         sx127x::ModemBase::isPowerSupported(paPin, settings.txPowerDbm);
+}
+
 common::Error Rfm95::setPaConfig(PaPin pin, int8_t power) {
   if (modem_ == nullptr) {
     return common::Error::FAIL;
@@ -223,6 +287,37 @@ common::SignalQuality Rfm95::getSignalQuality() {
   return modem_->getSignalQuality();
 }
 
+common::Error Rfm95::flushPending() { return common::Error::OK; }
+
+bool Rfm95::hasPending() const { return false; }
+
+common::Time Rfm95::getPendingDelayMs() { return 0; }
+
+common::Error Rfm95::detectActivity(bool& isActive) {
+  if (modem_ == nullptr) {
+    return common::Error::FAIL;
+  }
+
+  return modem_->detectChannelActivity(isActive);
+}
+
+common::Error Rfm95::getTimeOnAirUs(const size_t payloadLength,
+                                    uint32_t& timeUs) {
+  if (modem_ == nullptr) {
+    return common::Error::FAIL;
+  }
+
+  return modem_->getTimeOnAirUs(payloadLength, timeUs);
+}
+
+uint64_t Rfm95::getFrequencyHz() {
+  if (modem_ == nullptr) {
+    return sx127x::ModemBase::INVALID_FREQUENCY_HZ;
+  }
+
+  return modem_->getFrequencyHz();
+}
+
 common::Error Rfm95::setModem_(Modulation& modulation) {
   if (modulation != Modulation::LORA) {
     return common::Error::INVALID_ARG;
@@ -1,6 +1,8 @@
 #include "sx127xmodem.hpp"
 #include "delay.hpp"
 #include "sx127xregisters.hpp"
+#include "ticks.hpp"
+#include "uptime.hpp"
 #include <array>
 
 namespace sx127x {
@@ -39,6 +41,13 @@ uint64_t ModemBase::getFrequencyHz() {
   return (frf * OSCILLATOR_FREQUENCY_HZ) >> 19;
 }
 
+bool ModemBase::isPowerSupported(PaPin pin, int8_t power) {
+  if (pin == PaPin::RFO) {
+    return power >= -4 && power <= 15;
+  }
+  return power >= 2 && power <= 20;
+}
+
 common::Error ModemBase::setLnaBoostHf(bool enable) {
   constexpr uint8_t LNA_BOOST_HF_ON{0b00000011};
   constexpr uint8_t LNA_BOOST_HF_OFF{0b00000000};
@@ -55,10 +64,7 @@ common::Error ModemBase::setLnaGain(Gain gain) {
 }
 
 common::Error ModemBase::setPaConfig(PaPin pin, int8_t power) {
-  if (pin == PaPin::RFO && (power < -4 || power > 15)) {
-    return common::Error::INVALID_ARG;
-  }
-  if (pin == PaPin::BOOST && (power < 2 || power > 20)) {
+  if (not isPowerSupported(pin, power)) {
     return common::Error::INVALID_ARG;
   }
 
@@ -379,8 +385,13 @@ common::radio::IrqEvent LoRa::getIrqEvent() {
   }
 
   constexpr uint8_t IRQ_RX_DONE{0b01000000};
+  constexpr uint8_t IRQ_PAYLOAD_CRC_ERROR{0b00100000};
   constexpr uint8_t IRQ_TX_DONE{0b00001000};
   if (value & IRQ_RX_DONE) {
+    // RX_DONE is raised for a corrupted payload too
+    if (value & IRQ_PAYLOAD_CRC_ERROR) {
+      return common::radio::IrqEvent::CRC_ERROR;
+    }
     return common::radio::IrqEvent::RX_DONE;
   } else if (value & IRQ_TX_DONE) {
     return common::radio::IrqEvent::TX_DONE;
@@ -389,6 +400,126 @@ common::radio::IrqEvent LoRa::getIrqEvent() {
   return common::radio::IrqEvent::UNKNOWN;
 }
 
+common::Error LoRa::detectChannelActivity(bool& isActive) {
+  constexpr uint8_t IRQ_CAD_DONE{0b00000100};
+  constexpr uint8_t IRQ_CAD_DETECTED{0b00000001};
+  constexpr uint32_t CAD_TIMEOUT_SYMBOLS{4};
+  constexpr uint32_t US_PER_MS{1000};
+
+  uint32_t symbolDurationUs{0};
+  common::Error errorCode = getSymbolDurationUs_(symbolDurationUs);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+  const uint64_t timeoutUs =
+      static_cast<uint64_t>(symbolDurationUs) * CAD_TIMEOUT_SYMBOLS +
+      US_PER_MS;
+
+  errorCode = setMode(Mode::STANDBY);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  uint8_t flags{IRQ_CAD_DONE | IRQ_CAD_DETECTED};
+  errorCode = write_(reg::lora::IRQ_FLAGS, &flags, reg::size::DEFAULT);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  errorCode = setMode(Mode::CAD);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  // A delay shorter than a tick does not block, count time instead of
+  // iterations. Flags are read once more after the timeout passed.
+  const uint64_t startUs = sw::getUptimeUs();
+  flags = 0;
+  while (1) {
+    errorCode = read_(reg::lora::IRQ_FLAGS, &flags, reg::size::DEFAULT);
+    if (errorCode != common::Error::OK) {
+      return common::Error::FAIL;
+    }
+
+    if ((flags & IRQ_CAD_DONE) or sw::getUptimeUs() - startUs > timeoutUs) {
+      break;
+    }
+
+    sw::delayMs(sw::TICK_PERIOD_MS);
+  }
+
+  if (not(flags & IRQ_CAD_DONE)) {
+    setMode(Mode::STANDBY);
+    return common::Error::FAIL;
+  }
+
+  isActive = (flags & IRQ_CAD_DETECTED);
+
+  flags = IRQ_CAD_DONE | IRQ_CAD_DETECTED;
+  return write_(reg::lora::IRQ_FLAGS, &flags, reg::size::DEFAULT);
+}
+
+common::Error LoRa::getTimeOnAirUs(const size_t payloadLength,
+                                   uint32_t& timeUs) {
+  constexpr uint8_t CODING_RATE_MASK{0b00001110};
+  constexpr uint8_t IMPLICIT_HEADER_MASK{0b00000001};
+  constexpr uint8_t PAYLOAD_CRC_MASK{0b00000100};
+  constexpr uint8_t LOW_DATA_RATE_OPTIMIZE_MASK{0b00001000};
+  constexpr uint32_t PREAMBLE_FIXED_QUARTER_SYMBOLS{17}; // 4.25 symbols
+  constexpr uint32_t HEADER_SYMBOLS{8};
+
+  std::array<uint8_t, 2> modemConfig{};
+  common::Error errorCode = read_(reg::lora::MODEM_CONFIG_1,
+                                  modemConfig.data(), modemConfig.size());
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  uint8_t modemConfig3{0};
+  errorCode =
+      read_(reg::lora::MODEM_CONFIG_3, &modemConfig3, reg::size::DEFAULT);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  std::array<uint8_t, reg::size::PREAMBLE> preamble{};
+  errorCode = read_(reg::lora::PREAMBLE_MSB, preamble.data(), preamble.size());
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  uint32_t symbolDurationUs{0};
+  errorCode = getSymbolDurationUs_(symbolDurationUs);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  const int32_t codingRate = (modemConfig[0] & CODING_RATE_MASK) >> 1;
+  const int32_t implicitHeader = (modemConfig[0] & IMPLICIT_HEADER_MASK);
+  const int32_t spreadingFactor = (modemConfig[1] >> 4);
+  const int32_t crc = (modemConfig[1] & PAYLOAD_CRC_MASK) ? 1 : 0;
+  const int32_t lowDataRate =
+      (modemConfig3 & LOW_DATA_RATE_OPTIMIZE_MASK) ? 1 : 0;
+  const uint32_t preambleLength = (static_cast<uint32_t>(preamble[0]) << 8) |
+                                  static_cast<uint32_t>(preamble[1]);
+
+  const int32_t numerator = 8 * static_cast<int32_t>(payloadLength) -
+                            4 * spreadingFactor + 28 + 16 * crc -
+                            20 * implicitHeader;
+  const int32_t denominator = 4 * (spreadingFactor - 2 * lowDataRate);
+  int32_t payloadSymbols = HEADER_SYMBOLS;
+  if (numerator > 0 && denominator > 0) {
+    payloadSymbols += ((numerator + denominator - 1) / denominator) *
+                      (codingRate + 4);
+  }
+
+  const uint64_t quarterSymbols =
+      4 * static_cast<uint64_t>(preambleLength + payloadSymbols) +
+      PREAMBLE_FIXED_QUARTER_SYMBOLS;
+  timeUs = static_cast<uint32_t>((quarterSymbols * symbolDurationUs) / 4);
+  return common::Error::OK;
+}
+
 common::Error LoRa::reloadLowDatarateOptimization_() {
   uint32_t bandwidth{0};
   common::Error errorCode = getBandwidth_(&bandwidth);
@@ -461,6 +592,25 @@ common::Error LoRa::getBandwidth_(uint32_t* bandwidth) {
   return common::Error::OK;
 }
 
+common::Error LoRa::getSymbolDurationUs_(uint32_t& durationUs) {
+  uint32_t bandwidth{0};
+  common::Error errorCode = getBandwidth_(&bandwidth);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  uint8_t data{0};
+  errorCode = read_(reg::lora::MODEM_CONFIG_2, &data, reg::size::DEFAULT);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  const uint8_t spreadingFactor = (data >> 4);
+  durationUs = static_cast<uint32_t>(
+      (static_cast<uint64_t>(1UL << spreadingFactor) * 1'000'000) / bandwidth);
+  return common::Error::OK;
+}
+
 common::Error LoRa::setLowDatarateOptimization_(bool enable) {
   constexpr uint8_t LOW_DATA_RATE_OPTIMIZE_ENABLE{0b00001000};
   constexpr uint8_t LOW_DATA_RATE_OPTIMIZE_DISABLE{0b00000000};
@@ -503,7 +653,8 @@ float LoRa::getSnr_() {
     return common::SignalQuality::SNR_INVALID_VALUE;
   }
 
-  return static_cast<float>(snrValue) * 0.25f;
+  // Two's complement in quarters of dB
+  return static_cast<float>(static_cast<int8_t>(snrValue)) * 0.25f;
 }
 
 } // namespace sx127x
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "types.hpp"
+#include "uptime.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace hw {
+
+/**
+ * @class NoBusStats
+ * @brief Bus statistics policy which records nothing, calls compile to no
+ * code.
+ */
+class NoBusStats {
+  public:
+    static constexpr uint64_t start() { return 0; }
+
+    static constexpr void finish(uintptr_t, size_t, uint64_t) {}
+};
+
+/**
+ * @class BusStats
+ * @brief Bus statistics policy which records transactions per device.
+ *
+ * A device is an SPI device handle or an I2C address. Transactions of devices
+ * past MAX_DEVICES are not recorded. Updates are lock-free, a transaction
+ * finishing during reset() may be partly kept.
+ */
+class BusStats {
+  public:
+    /**
+     * @brief Counters of a device
+     */
+    struct Stats {
+        uintptr_t device;      // SPI device handle or I2C address
+        uint32_t transactions; // Transactions, failed ones included
+        uint32_t bytes;        // Bytes on the bus, address bytes included
+        uint64_t busTimeUs;    // Sum of transaction times
+        uint32_t maxLatencyUs; // Longest transaction
+    };
+
+    static constexpr size_t MAX_DEVICES{4};
+
+    /**
+     * @brief Get the start time of a transaction.
+     *
+     * @return Time passed to finish().
+     */
+    static uint64_t start() { return sw::getUptimeUs(); }
+
+    /**
+     * @brief Record a finished transaction.
+     *
+     * @param device SPI device handle or I2C address.
+     * @param bytes Bytes on the bus.
+     * @param startUs Time returned by start().
+     */
+    void finish(const uintptr_t device, const size_t bytes,
+                const uint64_t startUs);
+
+    /**
+     * @brief Get the counters of a device.
+     *
+     * @param index Device index, devices are listed in order of their first
+     * transaction.
+     * @param stats Counters since the last reset.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NOT_FOUND: No device with this index.
+     */
+    common::Error getStats(const size_t index, Stats& stats) const;
+
+    /**
+     * @brief Clear the counters, devices are kept.
+     */
+    void reset();
+
+  private:
+    static constexpr uintptr_t NO_DEVICE{UINTPTR_MAX};
+
+    struct Entry {
+        std::atomic<uintptr_t> device{NO_DEVICE};
+        std::atomic<uint32_t> transactions{0};
+        std::atomic<uint32_t> bytes{0};
+        std::atomic<uint64_t> busTimeUs{0};
+        std::atomic<uint32_t> maxLatencyUs{0};
+    };
+
+    /**
+     * @brief Find the entry of a device, claims a free one for a new device.
+     *
+     * @return Entry, nullptr if all entries are used by other devices.
+     */
+    Entry* getEntry_(const uintptr_t device);
+
+    std::array<Entry, MAX_DEVICES> entries_{};
+};
+
+} // namespace hw
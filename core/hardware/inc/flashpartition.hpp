@@ -0,0 +1,97 @@
+#pragma once
+
+#include "iflash.hpp"
+#include "types.hpp"
+#include <string_view>
+
+namespace storage {
+namespace hw {
+
+/**
+ * @class FlashPartition
+ * @brief Raw access to a data partition from the partition table.
+ */
+class FlashPartition final : public IFlash {
+  public:
+    /**
+     * @brief Constructor for FlashPartition.
+     *
+     * @param label Label of the partition in the partition table.
+     */
+    explicit FlashPartition(const std::string_view label);
+
+    /**
+     * @brief Finds the partition.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NOT_FOUND: Partition does not exist.
+     */
+    common::Error init();
+
+    /**
+     * @brief Reads data from the partition.
+     *
+     * @param offset Offset from the partition start.
+     * @param buffer Buffer for the data.
+     * @param bufferLength Number of bytes to read.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Partition not initialized.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error read(const size_t offset, uint8_t* buffer,
+                       const size_t bufferLength) override;
+
+    /**
+     * @brief Writes data to the partition.
+     * @note Bits can only be cleared, the area must be erased before.
+     *
+     * @param offset Offset from the partition start.
+     * @param data Data to write.
+     * @param dataLength Number of bytes to write.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Partition not initialized.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error write(const size_t offset, const uint8_t* data,
+                        const size_t dataLength) override;
+
+    /**
+     * @brief Erases a sector of the partition.
+     *
+     * @param offset Offset of the sector, aligned to the sector size.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Partition not initialized.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error eraseSector(const size_t offset) override;
+
+    /**
+     * @brief Gets the partition size.
+     *
+     * @return Size in bytes, 0 if not initialized.
+     */
+    size_t getSize() const override;
+
+    /**
+     * @brief Gets the erase sector size.
+     *
+     * @return Sector size in bytes.
+     */
+    size_t getSectorSize() const override;
+
+  private:
+    using Handle = const void*;
+
+    std::string_view label_;
+    Handle handle_{nullptr};
+};
+
+} // namespace hw
+} // namespace storage
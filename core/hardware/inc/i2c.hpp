@@ -1,11 +1,20 @@
 #pragma once
 
+#include "busstats.hpp"
 #include "driver/gpio.h"
 #include "driver/i2c.h"
 #include "interfaces/ii2c.hpp"
 
 namespace hw {
-class I2c final : public II2c {
+/**
+ * @class BasicI2c
+ * @brief Class representing the I2C master.
+ *
+ * @tparam StatsPolicy Records read and write transactions per device,
+ * NoBusStats or BusStats.
+ */
+template <typename StatsPolicy = NoBusStats>
+class BasicI2c final : public II2c {
   public:
     /**
      * @brief Initialize I2C.
@@ -59,6 +68,13 @@ class I2c final : public II2c {
     common::Error read(const uint8_t deviceAddress, uint8_t* buffer,
                        const size_t bufferLength) override;
 
+    /**
+     * @brief Get the bus statistics, keyed by device address.
+     *
+     * @return Statistics policy.
+     */
+    StatsPolicy& getBusStats() { return stats_; }
+
   private:
     const i2c_port_t I2C_PORT{I2C_NUM_1};
     const i2c_mode_t I2C_MODE{I2C_MODE_MASTER};
@@ -67,5 +83,11 @@ class I2c final : public II2c {
     const gpio_pullup_t I2C_SDA_PULLUP_EN{GPIO_PULLUP_ENABLE};
     const gpio_pullup_t I2C_SCL_PULLUP_EN{GPIO_PULLUP_ENABLE};
     const uint32_t I2C_CLOCK_SPEED{400'000};
+    // Command link on the stack, one transaction of start, address,
+    // register, data and stop
+    static constexpr size_t CMD_LINK_SIZE{I2C_LINK_RECOMMENDED_SIZE(1)};
+    StatsPolicy stats_{};
 };
+
+using I2c = BasicI2c<>;
 } // namespace hw
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "istorage.hpp"
+#include "mutex.hpp"
 #include "types.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string_view>
 
 namespace storage {
@@ -10,6 +15,10 @@ namespace hw {
 /**
  * @class NvsStore
  * @brief Implementation Non-Volatile Storage (NVS)
+ *
+ * The namespace is opened on first use and stays open. uint8_t and uint32_t
+ * items are cached in RAM, repeated reads don't touch flash. Keys must be
+ * null-terminated, e.g. string literals.
  */
 class NvsStore final : public IStorage {
   public:
@@ -20,6 +29,17 @@ class NvsStore final : public IStorage {
      */
     NvsStore(const std::string_view nvsNamespace);
 
+    /**
+     * @brief Destructor for NvsStore, closes the namespace.
+     */
+    ~NvsStore();
+
+    NvsStore(const NvsStore&) = delete;
+    NvsStore& operator=(const NvsStore&) = delete;
+
+    using IStorage::getBlob;
+    using IStorage::setBlob;
+
     /**
      * @brief Initializes the NVS storage system.
      *
@@ -30,7 +50,9 @@ class NvsStore final : public IStorage {
     static common::Error init();
 
     /**
-     * @brief Erases all stored data in NVS.
+     * @brief Erases all stored data in NVS, open namespaces are opened again
+     * and their caches cleared on next use.
+     *
      * @return
      *   - common::Error::OK: Success.
      *   - common::Error::FAIL: Fail.
@@ -63,6 +85,32 @@ class NvsStore final : public IStorage {
      */
     common::Error getItem(const std::string_view& key, uint8_t& item) override;
 
+    /**
+     * @brief Stores a 32-bit integer value in NVS.
+     *
+     * @param key The key associated with the value.
+     * @param item The 32-bit integer value to store.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error setItem(const std::string_view& key,
+                          const uint32_t& item) override;
+
+    /**
+     * @brief Retrieves a 32-bit integer value from NVS.
+     *
+     * @param key The key associated with the value.
+     * @param item Reference to a variable where the retrieved value will be
+     * stored.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error getItem(const std::string_view& key, uint32_t& item) override;
+
     /**
      * @brief Stores a string in NVS.
      *
@@ -81,8 +129,7 @@ class NvsStore final : public IStorage {
      *
      * @param key The key associated with the string.
      * @param string Reference to a variable where the retrieved string will be
-     * stored.
-     * @param size The maximum size of the string to retrieve.
+     * stored, its capacity is reused.
      *
      * @return
      *   - common::Error::OK: Success.
@@ -91,6 +138,37 @@ class NvsStore final : public IStorage {
     common::Error getString(const std::string_view& key,
                             std::string& string) override;
 
+    /**
+     * @brief Stores binary data in NVS.
+     *
+     * @param key The key associated with the data.
+     * @param data The data to store.
+     * @param size Size of the data.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Data is nullptr or empty.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error setBlob(const std::string_view& key, const void* data,
+                          const size_t size) override;
+
+    /**
+     * @brief Retrieves binary data from NVS.
+     *
+     * @param key The key associated with the data.
+     * @param data Buffer where the retrieved data will be stored.
+     * @param size Expected size of the data.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Data is nullptr or empty.
+     *   - common::Error::NOT_FOUND: No data or data of other size stored.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error getBlob(const std::string_view& key, void* data,
+                          const size_t size) override;
+
     /**
      * @brief Saves any pending changes to NVS.
      *
@@ -101,11 +179,70 @@ class NvsStore final : public IStorage {
     common::Error save() override;
 
   private:
-    // 's' stands for "size" — shortened due to the 15-character maximum key
-    // length limitation.
-    static constexpr std::string_view STRING_SIZE_KEY_SUFFIX{"s"};
+    static constexpr size_t MAX_KEY_SIZE{16}; // NVS_KEY_NAME_MAX_SIZE
+    static constexpr size_t MAX_CACHED_ITEMS{8};
+
+    enum class ItemType : uint8_t { NONE, U8, U32 };
+
+    /**
+     * @brief Item value kept in RAM
+     */
+    struct CachedItem {
+        std::array<char, MAX_KEY_SIZE> key;
+        ItemType type;
+        uint32_t value;
+    };
+
+    /**
+     * @brief Open the namespace if not open or NVS was erased since.
+     * @note Called with mutex_ held.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error open_();
+
+    /**
+     * @brief Find the cached item of a key.
+     *
+     * @return Item, nullptr if the key is not cached.
+     */
+    CachedItem* findCached_(const std::string_view key);
+
+    /**
+     * @brief Cache an item value, not cached if the cache is full or the key
+     * is too long.
+     */
+    void cache_(const std::string_view key, const ItemType type,
+                const uint32_t value);
+
+    /**
+     * @brief Remove a key from the cache, e.g. before it is written with
+     * another type.
+     */
+    void forget_(const std::string_view key);
+
+    /**
+     * @brief Write an item and update the cache.
+     */
+    common::Error setItem_(const std::string_view key, const ItemType type,
+                           const uint32_t value);
+
+    /**
+     * @brief Read an item from the cache, from NVS on a miss.
+     */
+    common::Error getItem_(const std::string_view key, const ItemType type,
+                           uint32_t& value);
+
     static bool isNvsInitialized_;
+    static std::atomic<uint32_t> eraseCount_;
     std::string_view namespace_;
+    sw::Mutex mutex_{};
+    uint32_t handle_{0};
+    bool isOpen_{false};
+    uint32_t openEraseCount_{0};
+    std::array<CachedItem, MAX_CACHED_ITEMS> cachedItems_{};
 };
 
 } // namespace hw
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "busstats.hpp"
 #include "ispi.hpp"
 #include "types.hpp"
 #include <cstdint>
@@ -7,10 +8,14 @@
 namespace hw {
 
 /**
- * @class Spi
+ * @class BasicSpi
  * @brief Class representing an SPI interface.
+ *
+ * @tparam StatsPolicy Records read and write transactions per device,
+ * NoBusStats or BusStats.
  */
-class Spi final : public ISpi {
+template <typename StatsPolicy = NoBusStats>
+class BasicSpi final : public ISpi {
   public:
     /**
      * @brief Enum representing different SPI hosts.
@@ -39,11 +44,11 @@ class Spi final : public ISpi {
     };
 
     /**
-     * @brief Construct a new Spi object.
+     * @brief Construct a new BasicSpi object.
      *
      * @param config Configuration for the SPI.
      */
-    Spi(Spi::Config config);
+    BasicSpi(Config config);
 
     /**
      * @brief Initialize the SPI interface.
@@ -100,6 +105,13 @@ class Spi final : public ISpi {
                        const uint8_t registerAddress, uint8_t* buffer,
                        const size_t bufferLength) override;
 
+    /**
+     * @brief Get the bus statistics, keyed by device handle.
+     *
+     * @return Statistics policy.
+     */
+    StatsPolicy& getBusStats() { return stats_; }
+
   private:
     static constexpr int DMA_ENABLE{0};
     static constexpr int NOT_USE_WRITE_PROTECT{-1};
@@ -111,6 +123,9 @@ class Spi final : public ISpi {
     static constexpr int CPOL_0_CPHA_0{0};
 
     Config config_;
+    StatsPolicy stats_{};
 };
 
+using Spi = BasicSpi<>;
+
 } // namespace hw
@@ -0,0 +1,72 @@
+#include "busstats.hpp"
+
+namespace hw {
+
+void BusStats::finish(const uintptr_t device, const size_t bytes,
+                      const uint64_t startUs) {
+  const uint64_t latencyUs = sw::getUptimeUs() - startUs;
+
+  Entry* entry = getEntry_(device);
+  if (entry == nullptr) {
+    return;
+  }
+
+  entry->transactions.fetch_add(1, std::memory_order_relaxed);
+  entry->bytes.fetch_add(static_cast<uint32_t>(bytes),
+                         std::memory_order_relaxed);
+  entry->busTimeUs.fetch_add(latencyUs, std::memory_order_relaxed);
+
+  const uint32_t latencyUs32 = static_cast<uint32_t>(
+      latencyUs < UINT32_MAX ? latencyUs : UINT32_MAX);
+  uint32_t maxLatencyUs = entry->maxLatencyUs.load(std::memory_order_relaxed);
+  while (latencyUs32 > maxLatencyUs and
+         not entry->maxLatencyUs.compare_exchange_weak(
+             maxLatencyUs, latencyUs32, std::memory_order_relaxed)) {
+  }
+}
+
+common::Error BusStats::getStats(const size_t index, Stats& stats) const {
+  if (index >= MAX_DEVICES) {
+    return common::Error::NOT_FOUND;
+  }
+
+  const Entry& entry = entries_[index];
+  stats.device = entry.device.load(std::memory_order_acquire);
+  if (stats.device == NO_DEVICE) {
+    return common::Error::NOT_FOUND;
+  }
+
+  stats.transactions = entry.transactions.load(std::memory_order_relaxed);
+  stats.bytes = entry.bytes.load(std::memory_order_relaxed);
+  stats.busTimeUs = entry.busTimeUs.load(std::memory_order_relaxed);
+  stats.maxLatencyUs = entry.maxLatencyUs.load(std::memory_order_relaxed);
+  return common::Error::OK;
+}
+
+void BusStats::reset() {
+  for (Entry& entry : entries_) {
+    entry.transactions.store(0, std::memory_order_relaxed);
+    entry.bytes.store(0, std::memory_order_relaxed);
+    entry.busTimeUs.store(0, std::memory_order_relaxed);
+    entry.maxLatencyUs.store(0, std::memory_order_relaxed);
+  }
+}
+
+BusStats::Entry* BusStats::getEntry_(const uintptr_t device) {
+  // Entries are claimed in order and never released, the first free entry
+  // ends the search
+  for (Entry& entry : entries_) {
+    uintptr_t claimed = entry.device.load(std::memory_order_acquire);
+    if (claimed == NO_DEVICE and
+        entry.device.compare_exchange_strong(claimed, device,
+                                             std::memory_order_acq_rel)) {
+      return &entry;
+    }
+    if (claimed == device) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace hw
@@ -0,0 +1,65 @@
+#include "flashpartition.hpp"
+#include "esp_partition.h"
+
+namespace storage {
+namespace hw {
+
+FlashPartition::FlashPartition(const std::string_view label) : label_{label} {}
+
+common::Error FlashPartition::init() {
+  handle_ = static_cast<Handle>(esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label_.data()));
+  if (handle_ == nullptr) {
+    return common::Error::NOT_FOUND;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error FlashPartition::read(const size_t offset, uint8_t* buffer,
+                                   const size_t bufferLength) {
+  if (handle_ == nullptr) {
+    return common::Error::INVALID_STATE;
+  }
+
+  esp_err_t espErrorCode =
+      esp_partition_read(static_cast<const esp_partition_t*>(handle_), offset,
+                         buffer, bufferLength);
+  return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
+}
+
+common::Error FlashPartition::write(const size_t offset, const uint8_t* data,
+                                    const size_t dataLength) {
+  if (handle_ == nullptr) {
+    return common::Error::INVALID_STATE;
+  }
+
+  esp_err_t espErrorCode =
+      esp_partition_write(static_cast<const esp_partition_t*>(handle_), offset,
+                          data, dataLength);
+  return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
+}
+
+common::Error FlashPartition::eraseSector(const size_t offset) {
+  if (handle_ == nullptr) {
+    return common::Error::INVALID_STATE;
+  }
+
+  esp_err_t espErrorCode =
+      esp_partition_erase_range(static_cast<const esp_partition_t*>(handle_),
+                                offset, getSectorSize());
+  return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
+}
+
+size_t FlashPartition::getSize() const {
+  if (handle_ == nullptr) {
+    return 0;
+  }
+
+  return static_cast<const esp_partition_t*>(handle_)->size;
+}
+
+size_t FlashPartition::getSectorSize() const { return SPI_FLASH_SEC_SIZE; }
+
+} // namespace hw
+} // namespace storage
@@ -1,7 +1,9 @@
 #include "i2c.hpp"
+#include <array>
 
 namespace hw {
-common::Error I2c::init() {
+template <typename StatsPolicy>
+common::Error BasicI2c<StatsPolicy>::init() {
   i2c_config_t i2cConfig{};
   i2cConfig.mode = I2C_MODE;
   i2cConfig.sda_io_num = I2C_SDA_IO_NUM;
@@ -24,8 +26,15 @@ common::Error I2c::init() {
   return common::Error::OK;
 }
 
-common::Error I2c::write(const uint8_t deviceAddress, const uint8_t command) {
-  i2c_cmd_handle_t cmdHandle = i2c_cmd_link_create();
+template <typename StatsPolicy>
+common::Error BasicI2c<StatsPolicy>::write(const uint8_t deviceAddress,
+                                           const uint8_t command) {
+  std::array<uint8_t, CMD_LINK_SIZE> cmdLink{};
+  i2c_cmd_handle_t cmdHandle =
+      i2c_cmd_link_create_static(cmdLink.data(), cmdLink.size());
+  if (cmdHandle == nullptr) {
+    return common::Error::FAIL;
+  }
 
   esp_err_t errorCode = i2c_master_start(cmdHandle);
   if (errorCode != ESP_OK) {
@@ -48,9 +57,12 @@ common::Error I2c::write(const uint8_t deviceAddress, const uint8_t command) {
     return common::Error::FAIL;
   }
 
+  const uint64_t startUs = stats_.start();
   errorCode =
       i2c_master_cmd_begin(I2C_PORT, cmdHandle, 1000 / portTICK_PERIOD_MS);
-  i2c_cmd_link_delete(cmdHandle);
+  // Address and command bytes
+  stats_.finish(deviceAddress, 2, startUs);
+  i2c_cmd_link_delete_static(cmdHandle);
   if (errorCode != ESP_OK) {
     return common::Error::FAIL;
   }
@@ -58,10 +70,17 @@ common::Error I2c::write(const uint8_t deviceAddress, const uint8_t command) {
   return common::Error::OK;
 }
 
-common::Error I2c::write(const uint8_t deviceAddress,
-                         const uint8_t registerAddress, const uint8_t* buffer,
-                         const size_t bufferLength) {
-  i2c_cmd_handle_t cmdHandle = i2c_cmd_link_create();
+template <typename StatsPolicy>
+common::Error BasicI2c<StatsPolicy>::write(const uint8_t deviceAddress,
+                                           const uint8_t registerAddress,
+                                           const uint8_t* buffer,
+                                           const size_t bufferLength) {
+  std::array<uint8_t, CMD_LINK_SIZE> cmdLink{};
+  i2c_cmd_handle_t cmdHandle =
+      i2c_cmd_link_create_static(cmdLink.data(), cmdLink.size());
+  if (cmdHandle == nullptr) {
+    return common::Error::FAIL;
+  }
 
   esp_err_t errorCode = i2c_master_start(cmdHandle);
   if (errorCode != ESP_OK) {
@@ -89,9 +108,12 @@ common::Error I2c::write(const uint8_t deviceAddress,
     return common::Error::FAIL;
   }
 
+  const uint64_t startUs = stats_.start();
   errorCode =
       i2c_master_cmd_begin(I2C_PORT, cmdHandle, 1000 / portTICK_PERIOD_MS);
-  i2c_cmd_link_delete(cmdHandle);
+  // Address, register and data bytes
+  stats_.finish(deviceAddress, bufferLength + 2, startUs);
+  i2c_cmd_link_delete_static(cmdHandle);
   if (errorCode != ESP_OK) {
     return common::Error::FAIL;
   }
@@ -99,9 +121,16 @@ common::Error I2c::write(const uint8_t deviceAddress,
   return common::Error::OK;
 }
 
-common::Error I2c::read(const uint8_t deviceAddress, uint8_t* buffer,
-                        const size_t bufferLength) {
-  i2c_cmd_handle_t cmdHandle = i2c_cmd_link_create();
+template <typename StatsPolicy>
+common::Error BasicI2c<StatsPolicy>::read(const uint8_t deviceAddress,
+                                          uint8_t* buffer,
+                                          const size_t bufferLength) {
+  std::array<uint8_t, CMD_LINK_SIZE> cmdLink{};
+  i2c_cmd_handle_t cmdHandle =
+      i2c_cmd_link_create_static(cmdLink.data(), cmdLink.size());
+  if (cmdHandle == nullptr) {
+    return common::Error::FAIL;
+  }
 
   esp_err_t errorCode = i2c_master_start(cmdHandle);
   if (errorCode != ESP_OK) {
@@ -125,13 +154,19 @@ common::Error I2c::read(const uint8_t deviceAddress, uint8_t* buffer,
     return common::Error::FAIL;
   }
 
+  const uint64_t startUs = stats_.start();
   errorCode =
       i2c_master_cmd_begin(I2C_PORT, cmdHandle, 1000 / portTICK_PERIOD_MS);
-  i2c_cmd_link_delete(cmdHandle);
+  // Address and data bytes
+  stats_.finish(deviceAddress, bufferLength + 1, startUs);
+  i2c_cmd_link_delete_static(cmdHandle);
   if (errorCode != ESP_OK) {
     return common::Error::FAIL;
   }
 
   return common::Error::OK;
 }
+
+template class BasicI2c<NoBusStats>;
+template class BasicI2c<BusStats>;
 } // namespace hw
@@ -1,15 +1,35 @@
 #include "nvsstore.hpp"
 #include "esp_log.h"
+#include "nvs.h"
 #include "nvs_flash.h"
-#include "nvs_handle.hpp"
-#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+namespace {
+constexpr std::string_view TAG{"NvsStore"};
+} // namespace
 
 namespace storage {
 namespace hw {
+static_assert(std::is_same_v<nvs_handle_t, uint32_t>,
+              "NVS handle type changed");
+
 bool NvsStore::isNvsInitialized_{false};
+std::atomic<uint32_t> NvsStore::eraseCount_{0};
 
 NvsStore::NvsStore(const std::string_view nvsNamepsace)
-    : namespace_{nvsNamepsace} {}
+    : namespace_{nvsNamepsace} {
+  static_assert(MAX_KEY_SIZE == NVS_KEY_NAME_MAX_SIZE,
+                "NVS key size changed");
+}
+
+NvsStore::~NvsStore() {
+  if (isOpen_) {
+    nvs_close(handle_);
+  }
+}
 
 common::Error NvsStore::init() {
   if (isNvsInitialized_) {
@@ -43,102 +63,238 @@ common::Error NvsStore::erease() {
   }
 
   isNvsInitialized_ = false;
+  eraseCount_.fetch_add(1, std::memory_order_relaxed);
   return common::Error::OK;
 }
 
 common::Error NvsStore::setItem(const std::string_view& key,
                                 const uint8_t& item) {
-  esp_err_t espErrorCode{ESP_OK};
+  return setItem_(key, ItemType::U8, item);
+}
 
-  std::unique_ptr<nvs::NVSHandle> handle =
-      nvs::open_nvs_handle(namespace_.data(), NVS_READWRITE, &espErrorCode);
-  if (espErrorCode != ESP_OK) {
+common::Error NvsStore::getItem(const std::string_view& key, uint8_t& item) {
+  uint32_t value{0};
+  common::Error errorCode = getItem_(key, ItemType::U8, value);
+  if (errorCode == common::Error::OK) {
+    item = static_cast<uint8_t>(value);
+  }
+  return errorCode;
+}
+
+common::Error NvsStore::setItem(const std::string_view& key,
+                                const uint32_t& item) {
+  return setItem_(key, ItemType::U32, item);
+}
+
+common::Error NvsStore::getItem(const std::string_view& key, uint32_t& item) {
+  return getItem_(key, ItemType::U32, item);
+}
+
+common::Error NvsStore::setString(const std::string_view& key,
+                                  const std::string& string) {
+  std::lock_guard<sw::Mutex> lock{mutex_};
+  if (open_() != common::Error::OK) {
     return common::Error::FAIL;
   }
 
-  espErrorCode = handle->set_item(key.data(), item);
+  forget_(key);
+  esp_err_t espErrorCode = nvs_set_str(handle_, key.data(), string.c_str());
   return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
 }
 
-common::Error NvsStore::getItem(const std::string_view& key, uint8_t& item) {
-  esp_err_t espErrorCode{ESP_OK};
+common::Error NvsStore::getString(const std::string_view& key,
+                                  std::string& string) {
+  std::lock_guard<sw::Mutex> lock{mutex_};
+  if (open_() != common::Error::OK) {
+    return common::Error::FAIL;
+  }
 
-  std::unique_ptr<nvs::NVSHandle> handle =
-      nvs::open_nvs_handle(namespace_.data(), NVS_READWRITE, &espErrorCode);
+  // Read into the capacity the string already has, its terminator takes the
+  // last byte. A longer string is read again after the length is known.
+  string.resize(string.capacity());
+  size_t length = string.size() + 1;
+  esp_err_t espErrorCode =
+      nvs_get_str(handle_, key.data(), string.data(), &length);
+  if (espErrorCode == ESP_ERR_NVS_INVALID_LENGTH) {
+    string.resize(length - 1);
+    espErrorCode = nvs_get_str(handle_, key.data(), string.data(), &length);
+  }
   if (espErrorCode != ESP_OK) {
+    string.clear();
+    return common::Error::FAIL;
+  }
+
+  string.resize(length - 1);
+  return common::Error::OK;
+}
+
+common::Error NvsStore::setBlob(const std::string_view& key, const void* data,
+                                const size_t size) {
+  if (data == nullptr || size == 0) {
+    return common::Error::INVALID_ARG;
+  }
+
+  std::lock_guard<sw::Mutex> lock{mutex_};
+  if (open_() != common::Error::OK) {
     return common::Error::FAIL;
   }
 
-  espErrorCode = handle->get_item(key.data(), item);
+  forget_(key);
+  esp_err_t espErrorCode = nvs_set_blob(handle_, key.data(), data, size);
   return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
 }
 
-common::Error NvsStore::setString(const std::string_view& key,
-                                  const std::string& string) {
-  esp_err_t espErrorCode{ESP_OK};
+common::Error NvsStore::getBlob(const std::string_view& key, void* data,
+                                const size_t size) {
+  if (data == nullptr || size == 0) {
+    return common::Error::INVALID_ARG;
+  }
 
-  std::unique_ptr<nvs::NVSHandle> handle =
-      nvs::open_nvs_handle(namespace_.data(), NVS_READWRITE, &espErrorCode);
-  if (espErrorCode != ESP_OK) {
+  std::lock_guard<sw::Mutex> lock{mutex_};
+  if (open_() != common::Error::OK) {
     return common::Error::FAIL;
   }
 
-  const std::string stringSizeKey{std::string(key) +
-                                  STRING_SIZE_KEY_SUFFIX.data()};
-  espErrorCode = handle->set_item(stringSizeKey.data(),
-                                  static_cast<uint8_t>(string.size()));
+  // Data of other size was written by another layout, don't misread it
+  size_t storedSize{0};
+  esp_err_t espErrorCode =
+      nvs_get_blob(handle_, key.data(), nullptr, &storedSize);
+  if (espErrorCode == ESP_ERR_NVS_NOT_FOUND) {
+    return common::Error::NOT_FOUND;
+  }
   if (espErrorCode != ESP_OK) {
     return common::Error::FAIL;
   }
+  if (storedSize != size) {
+    return common::Error::NOT_FOUND;
+  }
 
-  espErrorCode = handle->set_string(key.data(), string.data());
-  if (espErrorCode != ESP_OK) {
+  espErrorCode = nvs_get_blob(handle_, key.data(), data, &storedSize);
+  return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
+}
+
+common::Error NvsStore::save() {
+  std::lock_guard<sw::Mutex> lock{mutex_};
+  if (open_() != common::Error::OK) {
     return common::Error::FAIL;
   }
 
-  return common::Error::OK;
+  esp_err_t espErrorCode = nvs_commit(handle_);
+  return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
 }
 
-common::Error NvsStore::getString(const std::string_view& key,
-                                  std::string& string) {
-  esp_err_t espErrorCode{ESP_OK};
+common::Error NvsStore::open_() {
+  const uint32_t eraseCount = eraseCount_.load(std::memory_order_relaxed);
+  if (isOpen_ && openEraseCount_ == eraseCount) {
+    return common::Error::OK;
+  }
 
-  std::unique_ptr<nvs::NVSHandle> handle =
-      nvs::open_nvs_handle(namespace_.data(), NVS_READWRITE, &espErrorCode);
+  // Handles don't survive an erase, neither do the cached values
+  if (isOpen_) {
+    nvs_close(handle_);
+    isOpen_ = false;
+  }
+  cachedItems_ = {};
+
+  esp_err_t espErrorCode =
+      nvs_open(namespace_.data(), NVS_READWRITE, &handle_);
   if (espErrorCode != ESP_OK) {
+    ESP_LOGE(TAG.data(), "Failed to open %s: %d", namespace_.data(),
+             espErrorCode);
     return common::Error::FAIL;
   }
 
-  const std::string stringSizeKey{std::string(key) +
-                                  STRING_SIZE_KEY_SUFFIX.data()};
-  uint8_t stringSize{0};
-  espErrorCode = handle->get_item(stringSizeKey.data(), stringSize);
-  if (espErrorCode != ESP_OK) {
+  isOpen_ = true;
+  openEraseCount_ = eraseCount;
+  return common::Error::OK;
+}
+
+NvsStore::CachedItem* NvsStore::findCached_(const std::string_view key) {
+  auto item = std::find_if(cachedItems_.begin(), cachedItems_.end(),
+                           [key](const CachedItem& cached) {
+                             return cached.type != ItemType::NONE &&
+                                    key == cached.key.data();
+                           });
+  return item == cachedItems_.end() ? nullptr : &*item;
+}
+
+void NvsStore::cache_(const std::string_view key, const ItemType type,
+                      const uint32_t value) {
+  if (key.size() >= MAX_KEY_SIZE) {
+    return;
+  }
+
+  CachedItem* item = findCached_(key);
+  if (item == nullptr) {
+    auto freeItem = std::find_if(
+        cachedItems_.begin(), cachedItems_.end(),
+        [](const CachedItem& cached) { return cached.type == ItemType::NONE; });
+    if (freeItem == cachedItems_.end()) {
+      return;
+    }
+    item = &*freeItem;
+    std::memcpy(item->key.data(), key.data(), key.size());
+    item->key[key.size()] = '\0';
+  }
+
+  item->type = type;
+  item->value = value;
+}
+
+void NvsStore::forget_(const std::string_view key) {
+  CachedItem* item = findCached_(key);
+  if (item != nullptr) {
+    item->type = ItemType::NONE;
+  }
+}
+
+common::Error NvsStore::setItem_(const std::string_view key,
+                                 const ItemType type, const uint32_t value) {
+  std::lock_guard<sw::Mutex> lock{mutex_};
+  if (open_() != common::Error::OK) {
     return common::Error::FAIL;
   }
-  stringSize = stringSize + 1;
 
-  std::vector<char> buffer(stringSize, '\0');
-  espErrorCode = handle->get_string(key.data(), buffer.data(), stringSize);
+  esp_err_t espErrorCode =
+      type == ItemType::U8
+          ? nvs_set_u8(handle_, key.data(), static_cast<uint8_t>(value))
+          : nvs_set_u32(handle_, key.data(), value);
   if (espErrorCode != ESP_OK) {
+    forget_(key);
     return common::Error::FAIL;
   }
 
-  string.assign(buffer.data());
+  cache_(key, type, value);
   return common::Error::OK;
 }
 
-common::Error NvsStore::save() {
-  esp_err_t espErrorCode{ESP_OK};
+common::Error NvsStore::getItem_(const std::string_view key,
+                                 const ItemType type, uint32_t& value) {
+  std::lock_guard<sw::Mutex> lock{mutex_};
+  if (open_() != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  const CachedItem* item = findCached_(key);
+  if (item != nullptr && item->type == type) {
+    value = item->value;
+    return common::Error::OK;
+  }
 
-  std::unique_ptr<nvs::NVSHandle> handle =
-      nvs::open_nvs_handle(namespace_.data(), NVS_READWRITE, &espErrorCode);
+  esp_err_t espErrorCode{ESP_OK};
+  if (type == ItemType::U8) {
+    uint8_t u8Value{0};
+    espErrorCode = nvs_get_u8(handle_, key.data(), &u8Value);
+    value = u8Value;
+  } else {
+    espErrorCode = nvs_get_u32(handle_, key.data(), &value);
+  }
   if (espErrorCode != ESP_OK) {
     return common::Error::FAIL;
   }
 
-  espErrorCode = handle->commit();
-  return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
+  cache_(key, type, value);
+  return common::Error::OK;
 }
 
 } // namespace hw
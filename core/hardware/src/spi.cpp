@@ -2,11 +2,14 @@
 
 #include "driver/spi_common.h"
 #include "driver/spi_master.h"
+#include "trace.hpp"
 
 namespace hw {
-Spi::Spi(Config config) : config_{config} {}
+template <typename StatsPolicy>
+BasicSpi<StatsPolicy>::BasicSpi(Config config) : config_{config} {}
 
-common::Error Spi::init(const DmaChannel dmaChannel) {
+template <typename StatsPolicy>
+common::Error BasicSpi<StatsPolicy>::init(const DmaChannel dmaChannel) {
   if (config_.mosi.isGpioAssigned() == false or
       config_.miso.isGpioAssigned() == false or
       config_.sck.isGpioAssigned() == false) {
@@ -38,7 +41,9 @@ common::Error Spi::init(const DmaChannel dmaChannel) {
   return common::Error::OK;
 }
 
-SpiDeviceHandle Spi::addDevice(IGpio& csPin, const int clockSpeedHz) {
+template <typename StatsPolicy>
+SpiDeviceHandle BasicSpi<StatsPolicy>::addDevice(IGpio& csPin,
+                                                 const int clockSpeedHz) {
   if (csPin.isGpioAssigned() == false) {
     return nullptr;
   }
@@ -62,9 +67,11 @@ SpiDeviceHandle Spi::addDevice(IGpio& csPin, const int clockSpeedHz) {
   return static_cast<SpiDeviceHandle>(handle);
 }
 
-common::Error Spi::write(SpiDeviceHandle& deviceHandle,
-                         const uint8_t registerAddress, const uint8_t* buffer,
-                         const size_t bufferLength) {
+template <typename StatsPolicy>
+common::Error BasicSpi<StatsPolicy>::write(SpiDeviceHandle& deviceHandle,
+                                           const uint8_t registerAddress,
+                                           const uint8_t* buffer,
+                                           const size_t bufferLength) {
   const size_t lengthInBits{bufferLength * 8};
 
   spi_transaction_t transaction{};
@@ -74,8 +81,14 @@ common::Error Spi::write(SpiDeviceHandle& deviceHandle,
   transaction.rxlength = lengthInBits;
   transaction.length = lengthInBits;
 
+  sw::trace::begin("spi write");
+  const uint64_t startUs = stats_.start();
   esp_err_t espErrorCode = spi_device_polling_transmit(
       (spi_device_handle_t)deviceHandle, &transaction);
+  // Address byte and data
+  stats_.finish(reinterpret_cast<uintptr_t>(deviceHandle), bufferLength + 1,
+                startUs);
+  sw::trace::end("spi write");
   if (espErrorCode != ESP_OK) {
     return common::Error::FAIL;
   }
@@ -83,9 +96,11 @@ common::Error Spi::write(SpiDeviceHandle& deviceHandle,
   return common::Error::OK;
 }
 
-common::Error Spi::read(SpiDeviceHandle& deviceHandle,
-                        const uint8_t registerAddress, uint8_t* buffer,
-                        const size_t bufferLength) {
+template <typename StatsPolicy>
+common::Error BasicSpi<StatsPolicy>::read(SpiDeviceHandle& deviceHandle,
+                                          const uint8_t registerAddress,
+                                          uint8_t* buffer,
+                                          const size_t bufferLength) {
   const size_t lengthInBits{bufferLength * 8};
 
   spi_transaction_t transaction{};
@@ -95,12 +110,21 @@ common::Error Spi::read(SpiDeviceHandle& deviceHandle,
   transaction.rxlength = lengthInBits;
   transaction.length = lengthInBits;
 
+  sw::trace::begin("spi read");
+  const uint64_t startUs = stats_.start();
   esp_err_t espErrorCode = spi_device_polling_transmit(
       (spi_device_handle_t)deviceHandle, &transaction);
+  // Address byte and data
+  stats_.finish(reinterpret_cast<uintptr_t>(deviceHandle), bufferLength + 1,
+                startUs);
+  sw::trace::end("spi read");
   if (espErrorCode != ESP_OK) {
     return common::Error::FAIL;
   }
 
   return common::Error::OK;
 }
+
+template class BasicSpi<NoBusStats>;
+template class BasicSpi<BusStats>;
 } // namespace hw
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "types.hpp"
+#include <cstdint>
+
+namespace net {
+
+/**
+ * @class EventSelector
+ * @brief Blocks a thread until a socket is readable or the selector is
+ * signaled.
+ *
+ * Internally it selects on the socket and an eventfd, so local events (queue
+ * data, timers) and network data wake the same wait.
+ */
+class EventSelector {
+  public:
+    /**
+     * @brief Result of a wait.
+     */
+    struct Result {
+        bool isSignaled; // signal() was called since the last wait
+        bool isReadable; // Socket has data to read
+    };
+
+    /**
+     * @brief Default constructor for the EventSelector class.
+     */
+    EventSelector() = default;
+
+    /**
+     * @brief Destructor for the EventSelector class.
+     */
+    ~EventSelector();
+
+    /**
+     * @brief Initializes the selector.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error init();
+
+    /**
+     * @brief Wakes up the waiting thread.
+     * @note Safe to call from an ISR and from any thread.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Selector is not initialized.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error signal();
+
+    /**
+     * @brief Waits for a signal or socket data.
+     *
+     * @param socket Socket to watch, NO_SOCKET to wait only for a signal.
+     * @param timeoutMs Maximum time to wait.
+     * @param result Reason of wake up, both false on timeout.
+     *
+     * @return
+     *   - common::Error::OK: Success or timeout.
+     *   - common::Error::INVALID_STATE: Selector is not initialized.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error wait(const int socket, const common::Time timeoutMs,
+                       Result& result);
+
+    static constexpr int NO_SOCKET{-1};
+
+  private:
+    int eventFd_{NO_SOCKET};
+};
+
+} // namespace net
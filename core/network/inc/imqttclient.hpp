@@ -0,0 +1,105 @@
+#pragma once
+
+#include "inplacefunction.hpp"
+#include "latencyhistogram.hpp"
+#include "metrics.hpp"
+#include "types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace net {
+class IMqttClient {
+  public:
+    /**
+     * @brief Callback type for handling disconnect events.
+     */
+    using disconnectCallback = common::InplaceFunction<void(common::Argument)>;
+
+    /**
+     * @brief Callback type for handling subscription messages.
+     * Stored inside the subscription table, it never allocates.
+     */
+    using subscribeCallback = common::InplaceFunction<void(
+        const char*, uint16_t, void*, size_t, common::Argument)>;
+
+    /**
+     * @brief Callback type for handling publish completion.
+     * Called with the packet ID and common::Error::OK when the message is
+     * acknowledged (QoS1) or sent (QoS0), common::Error::FAIL when it was
+     * given up.
+     */
+    using publishCallback = common::InplaceFunction<void(
+        uint16_t, common::Error, common::Argument)>;
+
+    /**
+     * @brief Quality of Service levels for MQTT messages.
+     */
+    enum class Qos : uint8_t { _0, _1 };
+
+    /**
+     * @brief TLS handshake statistics.
+     */
+    struct TlsStats {
+        uint32_t handshakes;            // Successful handshakes
+        uint32_t resumedHandshakes;     // Handshakes resuming cached session
+        common::Time lastHandshakeMs;   // Duration of the last handshake
+        uint32_t lastHandshakePeakHeap; // Heap used at most by the last one
+    };
+
+    /**
+     * @brief Round-trip time from PUBLISH to PUBACK of asynchronous messages.
+     */
+    struct RttStats {
+        uint32_t count;
+        common::Time lastMs;
+        common::Time minMs;
+        common::Time maxMs;
+        uint64_t totalMs;
+    };
+
+    static constexpr uint16_t MQTT_KEEP_ALIVE_INTERVAL_S{10};
+    static constexpr uint8_t MAX_IN_FLIGHT{8};
+    // Fits shadow topics of the longest thing name
+    static constexpr size_t MAX_TOPIC_SIZE{192};
+
+    virtual void setDisconnectCallback(disconnectCallback cb,
+                                       common::Argument arg) = 0;
+
+    virtual common::Error subscribe(const std::string_view& topic,
+                                    const Qos qos, subscribeCallback cb,
+                                    common::Argument arg) = 0;
+
+    virtual common::Error connect() = 0;
+
+    virtual common::Error disconnect() = 0;
+
+    virtual common::Error publish(const std::string_view& topic, char* payload,
+                                  size_t payloadSize, const Qos qos) = 0;
+
+    virtual common::Error publishAsync(const std::string_view& topic,
+                                       const char* payload, size_t payloadSize,
+                                       const Qos qos, publishCallback cb,
+                                       common::Argument arg,
+                                       uint16_t& packetId) = 0;
+
+    virtual uint8_t getFreeInFlightSlots() const = 0;
+
+    virtual void yield() = 0;
+
+    virtual int getSocket() = 0;
+
+    virtual bool hasPendingData() = 0;
+
+    virtual TlsStats getTlsStats() const = 0;
+
+    virtual RttStats getRttStats() const = 0;
+
+    virtual void resetRttStats() = 0;
+
+    virtual sw::LatencyHistogram::Snapshot getPublishLatency() const = 0;
+
+    virtual common::Error
+    registerMetrics(sw::metrics::Registry& registry) const = 0;
+};
+} // namespace net
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "imqttclient.hpp"
+#include "inplacefunction.hpp"
+#include "latencyhistogram.hpp"
+#include "metrics.hpp"
+#include "types.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace net {
+/**
+ * @class InFlightWindow
+ * @brief QoS1 messages published without waiting for PUBACK.
+ *
+ * A message keeps its slot until a PUBACK with its packet ID arrives. It is
+ * sent again with the DUP flag when the PUBACK is late, and given up after
+ * the retries. The client owns the connection, messages are written through
+ * its send function. Nothing here depends on the MQTT library, so the AWS IoT
+ * client and the host socket client share the window.
+ */
+class InFlightWindow {
+  public:
+    static constexpr size_t PAYLOAD_SIZE{256};
+    static constexpr common::Time ACK_TIMEOUT_MS{5000};
+    static constexpr uint8_t MAX_RETRIES{3};
+    static constexpr uint8_t DEFAULT_WINDOW{4};
+
+    /**
+     * @brief Message waiting for PUBACK.
+     */
+    struct Message {
+        bool isUsed;
+        uint16_t packetId;
+        uint8_t retries;
+        common::Time sentMs;
+        uint32_t publishedUs; // Time of publish(), kept over retries
+        std::string_view topic;
+        std::array<char, PAYLOAD_SIZE> payload;
+        size_t payloadSize;
+        IMqttClient::publishCallback cb;
+        common::Argument arg;
+    };
+
+    /**
+     * @brief Writes a QoS1 PUBLISH of the message, DUP set if the flag is
+     * true.
+     */
+    using sendFunction =
+        common::InplaceFunction<common::Error(const Message&, bool)>;
+
+    /**
+     * @brief Construct a new InFlightWindow object.
+     *
+     * @param send Function writing a message to the connection.
+     */
+    explicit InFlightWindow(sendFunction send);
+
+    /**
+     * @brief Sends a message and keeps it until acknowledged.
+     * @note Topic must stay valid until the message is completed.
+     *
+     * @param topic The topic to publish to.
+     * @param payload The message payload, it is copied.
+     * @param payloadSize The size of the payload.
+     * @param packetId Packet ID not in flight, see isInFlight().
+     * @param cb The callback function called on completion, may be nullptr.
+     * @param arg User-defined argument passed to the callback.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Payload too long.
+     *   - common::Error::NO_MEM: Window is full.
+     *   - Error of the send function, the message is not kept.
+     */
+    common::Error publish(const std::string_view topic, const char* payload,
+                          const size_t payloadSize, const uint16_t packetId,
+                          IMqttClient::publishCallback cb,
+                          common::Argument arg);
+
+    /**
+     * @brief Completes the message of a PUBACK.
+     *
+     * @param packetId Packet ID of the PUBACK.
+     *
+     * @return True if the message was in flight.
+     */
+    bool acknowledge(const uint16_t packetId);
+
+    /**
+     * @brief Sends again or gives up messages without PUBACK in time.
+     */
+    void checkTimeouts();
+
+    /**
+     * @brief Sends again all messages, e.g. after reconnect.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - Error of the send function, the rest is sent on timeout.
+     */
+    common::Error resend();
+
+    /**
+     * @brief Checks if a packet ID waits for PUBACK.
+     *
+     * @param packetId Packet ID.
+     *
+     * @return True if in flight.
+     */
+    bool isInFlight(const uint16_t packetId) const;
+
+    /**
+     * @brief Sets the number of messages which may wait for PUBACK.
+     *
+     * @param window Window size, limited to 1..IMqttClient::MAX_IN_FLIGHT.
+     */
+    void setWindow(const uint8_t window);
+
+    /**
+     * @brief Gets the number of messages which can be sent without waiting.
+     *
+     * @return Free slots in the window.
+     */
+    uint8_t getFreeSlots() const;
+
+    /**
+     * @brief Gets the number of messages waiting for PUBACK.
+     *
+     * @return Messages in flight.
+     */
+    uint8_t getCount() const;
+
+    /**
+     * @brief Gets PUBACK round-trip time statistics.
+     *
+     * @return Statistics since start or last reset.
+     */
+    IMqttClient::RttStats getRttStats() const;
+
+    /**
+     * @brief Resets PUBACK round-trip time statistics.
+     */
+    void resetRttStats();
+
+    /**
+     * @brief Gets latency from publish() to PUBACK, including retries.
+     * @note Safe to call from another thread.
+     *
+     * @return Latency histogram since start.
+     */
+    sw::LatencyHistogram::Snapshot getPublishLatency() const;
+
+    /**
+     * @brief Adds the metrics: publish latency, retries and messages given
+     * up without PUBACK.
+     *
+     * @param registry Registry to add to.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NO_MEM: Registry is full.
+     */
+    common::Error registerMetrics(sw::metrics::Registry& registry) const;
+
+  private:
+    /**
+     * @brief Completes a message and frees its slot.
+     *
+     * @param message Message to complete.
+     * @param result Result passed to the completion callback.
+     */
+    void complete_(Message& message, const common::Error result);
+
+    /**
+     * @brief Finds the message with the given packet ID.
+     *
+     * @param packetId Packet ID.
+     *
+     * @return Message or nullptr if not found.
+     */
+    Message* find_(const uint16_t packetId);
+
+    sendFunction send_;
+    std::array<Message, IMqttClient::MAX_IN_FLIGHT> messages_{};
+    uint8_t window_{DEFAULT_WINDOW};
+    uint8_t count_{0};
+    IMqttClient::RttStats rttStats_{};
+    sw::LatencyHistogram publishLatency_{};
+    sw::metrics::Counter retries_{};
+    sw::metrics::Counter fails_{};
+};
+} // namespace net
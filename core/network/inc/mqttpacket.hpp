@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace net {
+namespace mqtt {
+/**
+ * @brief MQTT 3.1.1 control packet types, the high nibble of the first byte.
+ */
+enum class PacketType : uint8_t {
+  CONNECT = 1,
+  CONNACK = 2,
+  PUBLISH = 3,
+  PUBACK = 4,
+  SUBSCRIBE = 8,
+  SUBACK = 9,
+  PINGREQ = 12,
+  PINGRESP = 13,
+  DISCONNECT = 14,
+};
+
+/**
+ * @brief Fields of a PUBLISH packet. Topic and payload point into the
+ * packet.
+ */
+struct Publish {
+    std::string_view topic;
+    const uint8_t* payload;
+    size_t payloadSize;
+    uint16_t packetId; // 0 for QoS0
+    uint8_t qos;
+    bool isDuplicate;
+};
+
+// Fixed header byte and the longest remaining length
+static constexpr size_t MAX_FIXED_HEADER_SIZE{5};
+static constexpr size_t MAX_REMAINING_LENGTH{268'435'455};
+static constexpr uint8_t CONNACK_ACCEPTED{0};
+static constexpr uint8_t SUBACK_FAILURE{0x80};
+
+/**
+ * @brief Parses the fixed header.
+ *
+ * @param buffer Received data.
+ * @param length Length of the received data.
+ * @param type Packet type.
+ * @param remainingLength Length of the packet after the fixed header.
+ *
+ * @return Size of the fixed header, 0 if it is incomplete or invalid.
+ */
+size_t parseFixedHeader(const uint8_t* buffer, const size_t length,
+                        PacketType& type, size_t& remainingLength);
+
+/**
+ * @brief Writes a PUBLISH packet.
+ *
+ * @param buffer Destination buffer.
+ * @param size Size of the buffer.
+ * @param publish Packet fields, packet ID is only written for QoS1.
+ *
+ * @return Packet length, 0 if it does not fit the buffer.
+ */
+size_t serializePublish(uint8_t* buffer, const size_t size,
+                        const Publish& publish);
+
+/**
+ * @brief Reads a PUBLISH packet.
+ *
+ * @param packet Whole packet including the fixed header.
+ * @param length Packet length.
+ * @param publish Packet fields.
+ *
+ * @return True if the packet is a valid PUBLISH.
+ */
+bool deserializePublish(const uint8_t* packet, const size_t length,
+                        Publish& publish);
+
+/**
+ * @brief Writes a CONNECT packet without will, user name and password.
+ *
+ * @param buffer Destination buffer.
+ * @param size Size of the buffer.
+ * @param clientId Client identifier.
+ * @param keepAliveS Keep alive interval, 0 disables it.
+ * @param isCleanSession True to start without session state.
+ *
+ * @return Packet length, 0 if it does not fit the buffer.
+ */
+size_t serializeConnect(uint8_t* buffer, const size_t size,
+                        const std::string_view clientId,
+                        const uint16_t keepAliveS, const bool isCleanSession);
+
+/**
+ * @brief Reads a CONNACK packet.
+ *
+ * @param packet Whole packet including the fixed header.
+ * @param length Packet length.
+ * @param returnCode Connect return code, 0 if accepted.
+ *
+ * @return True if the packet is a valid CONNACK.
+ */
+bool deserializeConnack(const uint8_t* packet, const size_t length,
+                        uint8_t& returnCode);
+
+/**
+ * @brief Writes a SUBSCRIBE packet with one topic filter.
+ *
+ * @param buffer Destination buffer.
+ * @param size Size of the buffer.
+ * @param packetId Packet ID, not 0.
+ * @param filter Topic filter.
+ * @param qos Requested QoS.
+ *
+ * @return Packet length, 0 if it does not fit the buffer.
+ */
+size_t serializeSubscribe(uint8_t* buffer, const size_t size,
+                          const uint16_t packetId,
+                          const std::string_view filter, const uint8_t qos);
+
+/**
+ * @brief Reads a PUBACK packet.
+ *
+ * @param packet Received data starting with the packet, may be longer.
+ * @param length Length of the received data.
+ * @param packetId Acknowledged packet ID.
+ *
+ * @return True if the packet is a valid PUBACK.
+ */
+bool deserializePuback(const uint8_t* packet, const size_t length,
+                       uint16_t& packetId);
+
+/**
+ * @brief Writes a PUBACK packet.
+ *
+ * @param buffer Destination buffer.
+ * @param size Size of the buffer.
+ * @param packetId Packet ID of the acknowledged PUBLISH.
+ *
+ * @return Packet length, 0 if it does not fit the buffer.
+ */
+size_t serializePuback(uint8_t* buffer, const size_t size,
+                       const uint16_t packetId);
+
+/**
+ * @brief Reads a SUBACK packet of a SUBSCRIBE with one topic filter.
+ *
+ * @param packet Received data starting with the packet, may be longer.
+ * @param length Length of the received data.
+ * @param packetId Acknowledged packet ID.
+ * @param returnCode Granted QoS, SUBACK_FAILURE if refused.
+ *
+ * @return True if the packet is a valid SUBACK.
+ */
+bool deserializeSuback(const uint8_t* packet, const size_t length,
+                       uint16_t& packetId, uint8_t& returnCode);
+
+/**
+ * @brief Writes a packet without variable header and payload, e.g. PINGREQ
+ * or DISCONNECT.
+ *
+ * @param buffer Destination buffer.
+ * @param size Size of the buffer.
+ * @param type Packet type.
+ *
+ * @return Packet length, 0 if it does not fit the buffer.
+ */
+size_t serializeZero(uint8_t* buffer, const size_t size,
+                     const PacketType type);
+} // namespace mqtt
+} // namespace net
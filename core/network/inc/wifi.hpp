@@ -1,6 +1,7 @@
 #pragma once
 
 #include "types.hpp"
+#include <array>
 #include <string>
 
 namespace net {
@@ -37,6 +38,26 @@ class Wifi {
       WPA2_WPA3_ENTERPRISE
     };
 
+    /**
+     * @brief Modem power save of the STA.
+     * @note Power save is only applied by the driver in STA mode.
+     */
+    enum class PowerSave : uint8_t {
+      NONE = 0,  // Radio always on, lowest latency
+      MIN_MODEM, // Wake up every DTIM
+      MAX_MODEM  // Wake up every listen interval
+    };
+
+    /**
+     * @brief Time spent in each power save mode, a proxy for the average
+     * current. Outside of STA mode the driver does not apply modem sleep,
+     * that time is counted as NONE.
+     */
+    struct PowerSaveStats {
+        std::array<uint64_t, 3> timeInModeMs; // Indexed by PowerSave
+        uint32_t switches;
+    };
+
     /**
      * @brief Wi-fi Ap mode Configuration.
      */
@@ -55,6 +76,15 @@ class Wifi {
         std::string ssid;
         std::string password;
         AuthenticateMode authenticateMode;
+        uint16_t listenInterval; // Beacon intervals in MAX_MODEM, 0 default
+    };
+
+    /**
+     * @brief Access point the STA is connected to.
+     */
+    struct ApInfo {
+        std::array<uint8_t, 6> bssid;
+        uint8_t channel;
     };
 
     /**
@@ -64,6 +94,7 @@ class Wifi {
         StaConfig sta;
         ApConfig ap;
         Mode mode;
+        PowerSave powerSave;
     };
 
     /**
@@ -181,6 +212,56 @@ class Wifi {
      */
     common::Error scan();
 
+    /**
+     * @brief Sets the access point the STA connects to.
+     * A known BSSID and channel skip the scan of all channels.
+     *
+     * @param apInfo Access point, nullptr to scan all channels for the SSID.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     *   - common::Error::INVALID_STATE: Wi-Fi not set to Sta mode.
+     */
+    common::Error setStaTarget(const ApInfo* apInfo);
+
+    /**
+     * @brief Gets the access point the STA is connected to.
+     *
+     * @param apInfo Access point information.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail or not connected.
+     *   - common::Error::INVALID_STATE: Wi-Fi not set to Sta mode.
+     */
+    common::Error getStaApInfo(ApInfo& apInfo);
+
+    /**
+     * @brief Sets modem power save, can be changed at any time.
+     *
+     * @param powerSave Power save mode.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error setPowerSave(const PowerSave powerSave);
+
+    /**
+     * @brief Gets modem power save.
+     *
+     * @return Power save mode.
+     */
+    PowerSave getPowerSave() const;
+
+    /**
+     * @brief Gets time spent in each power save mode applied by the driver.
+     *
+     * @return Statistics since Wi-Fi init, including the current mode.
+     */
+    PowerSaveStats getPowerSaveStats() const;
+
     /**
      * @brief Check if Wi-Fi is in STA mode.
      *
@@ -218,8 +299,24 @@ class Wifi {
 
     common::Error setApConfig_(const ApConfig config);
 
+    /**
+     * @brief Gets power save applied by the driver, modem sleep works in STA
+     * mode only.
+     *
+     * @return Power save mode.
+     */
+    PowerSave getAppliedPowerSave_() const;
+
+    /**
+     * @brief Adds the time since the last change to the applied mode.
+     */
+    void accountPowerSave_();
+
     static constexpr int32_t EVENT_ANY_ID{-1};
     Mode mode_{Mode::NONE};
+    PowerSave powerSave_{PowerSave::NONE};
+    common::Time powerSaveSinceMs_{0};
+    PowerSaveStats powerSaveStats_{};
 };
 
 } // namespace net
@@ -0,0 +1,101 @@
+#include "eventselector.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <sys/select.h>
+#include <unistd.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_vfs_eventfd.h"
+#else
+#include <sys/eventfd.h>
+#endif
+
+namespace net {
+
+EventSelector::~EventSelector() {
+  if (eventFd_ != NO_SOCKET) {
+    close(eventFd_);
+    eventFd_ = NO_SOCKET;
+  }
+}
+
+common::Error EventSelector::init() {
+  if (eventFd_ != NO_SOCKET) {
+    return common::Error::OK;
+  }
+
+#ifdef ESP_PLATFORM
+  esp_vfs_eventfd_config_t config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+  esp_err_t espErrorCode = esp_vfs_eventfd_register(&config);
+  // Already registered by another selector
+  if (espErrorCode != ESP_OK && espErrorCode != ESP_ERR_INVALID_STATE) {
+    return common::Error::FAIL;
+  }
+
+  eventFd_ = eventfd(0, EFD_SUPPORT_ISR);
+#else
+  eventFd_ = eventfd(0, EFD_CLOEXEC);
+#endif
+  if (eventFd_ < 0) {
+    eventFd_ = NO_SOCKET;
+    return common::Error::FAIL;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error EventSelector::signal() {
+  if (eventFd_ == NO_SOCKET) {
+    return common::Error::INVALID_STATE;
+  }
+
+  const uint64_t value{1};
+  const ssize_t written = write(eventFd_, &value, sizeof(value));
+  return written == sizeof(value) ? common::Error::OK : common::Error::FAIL;
+}
+
+common::Error EventSelector::wait(const int socket,
+                                  const common::Time timeoutMs,
+                                  Result& result) {
+  if (eventFd_ == NO_SOCKET) {
+    return common::Error::INVALID_STATE;
+  }
+
+  result = Result{false, false};
+
+  fd_set readFds;
+  FD_ZERO(&readFds);
+  FD_SET(eventFd_, &readFds);
+  if (socket != NO_SOCKET) {
+    FD_SET(socket, &readFds);
+  }
+
+  constexpr common::Time MS_PER_S{1000};
+  constexpr common::Time US_PER_MS{1000};
+  timeval timeout{};
+  timeout.tv_sec = timeoutMs / MS_PER_S;
+  timeout.tv_usec = (timeoutMs % MS_PER_S) * US_PER_MS;
+
+  const int maxFd = std::max(eventFd_, socket);
+  const int readyCount =
+      select(maxFd + 1, &readFds, nullptr, nullptr, &timeout);
+  if (readyCount < 0) {
+    // Signal handler ran meanwhile, like a timeout the caller waits again
+    return errno == EINTR ? common::Error::OK : common::Error::FAIL;
+  }
+
+  if (FD_ISSET(eventFd_, &readFds)) {
+    // Reading resets the counter, signals raised meanwhile are merged
+    uint64_t value{0};
+    read(eventFd_, &value, sizeof(value));
+    result.isSignaled = true;
+  }
+
+  if (socket != NO_SOCKET && FD_ISSET(socket, &readFds)) {
+    result.isReadable = true;
+  }
+
+  return common::Error::OK;
+}
+
+} // namespace net
@@ -0,0 +1,167 @@
+#include "inflightwindow.hpp"
+#include "trace.hpp"
+#include "uptime.hpp"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace net {
+InFlightWindow::InFlightWindow(sendFunction send) : send_{std::move(send)} {}
+
+common::Error InFlightWindow::publish(const std::string_view topic,
+                                      const char* payload,
+                                      const size_t payloadSize,
+                                      const uint16_t packetId,
+                                      IMqttClient::publishCallback cb,
+                                      common::Argument arg) {
+  if (payloadSize > PAYLOAD_SIZE) {
+    return common::Error::INVALID_ARG;
+  }
+
+  if (getFreeSlots() == 0) {
+    return common::Error::NO_MEM;
+  }
+
+  auto slot = std::find_if(
+      messages_.begin(), messages_.end(),
+      [](const Message& message) { return not message.isUsed; });
+
+  Message& message = *slot;
+  message.packetId = packetId;
+  message.retries = 0;
+  message.publishedUs = static_cast<uint32_t>(sw::getUptimeUs());
+  message.topic = topic;
+  std::memcpy(message.payload.data(), payload, payloadSize);
+  message.payloadSize = payloadSize;
+
+  common::Error errorCode = send_(message, false);
+  if (errorCode != common::Error::OK) {
+    return errorCode;
+  }
+
+  message.sentMs = sw::getUptimeMs();
+  message.cb = std::move(cb);
+  message.arg = arg;
+  message.isUsed = true;
+  ++count_;
+  return common::Error::OK;
+}
+
+bool InFlightWindow::acknowledge(const uint16_t packetId) {
+  Message* message = find_(packetId);
+  if (message == nullptr) {
+    return false;
+  }
+
+  sw::trace::instant("mqtt puback");
+  // Measured from the last send, a retried message is not counted twice
+  const common::Time rttMs = sw::getUptimeMs() - message->sentMs;
+  if (rttStats_.count == 0 || rttMs < rttStats_.minMs) {
+    rttStats_.minMs = rttMs;
+  }
+  rttStats_.maxMs = std::max(rttStats_.maxMs, rttMs);
+  rttStats_.lastMs = rttMs;
+  rttStats_.totalMs += rttMs;
+  ++rttStats_.count;
+  publishLatency_.record(static_cast<uint32_t>(sw::getUptimeUs()) -
+                         message->publishedUs);
+  complete_(*message, common::Error::OK);
+  return true;
+}
+
+void InFlightWindow::checkTimeouts() {
+  const common::Time nowMs = sw::getUptimeMs();
+  for (Message& message : messages_) {
+    if (not message.isUsed || nowMs - message.sentMs < ACK_TIMEOUT_MS) {
+      continue;
+    }
+
+    if (message.retries >= MAX_RETRIES) {
+      fails_.add();
+      complete_(message, common::Error::FAIL);
+      continue;
+    }
+
+    ++message.retries;
+    retries_.add();
+    if (send_(message, true) != common::Error::OK) {
+      // Connection is broken, retry after reconnect
+      return;
+    }
+    message.sentMs = nowMs;
+  }
+}
+
+common::Error InFlightWindow::resend() {
+  for (Message& message : messages_) {
+    if (not message.isUsed) {
+      continue;
+    }
+
+    common::Error errorCode = send_(message, true);
+    if (errorCode != common::Error::OK) {
+      return errorCode;
+    }
+    message.sentMs = sw::getUptimeMs();
+  }
+
+  return common::Error::OK;
+}
+
+bool InFlightWindow::isInFlight(const uint16_t packetId) const {
+  return std::any_of(messages_.begin(), messages_.end(),
+                     [packetId](const Message& message) {
+                       return message.isUsed && message.packetId == packetId;
+                     });
+}
+
+void InFlightWindow::setWindow(const uint8_t window) {
+  window_ = std::clamp<uint8_t>(window, 1, IMqttClient::MAX_IN_FLIGHT);
+}
+
+uint8_t InFlightWindow::getFreeSlots() const {
+  return count_ < window_ ? window_ - count_ : 0;
+}
+
+uint8_t InFlightWindow::getCount() const { return count_; }
+
+IMqttClient::RttStats InFlightWindow::getRttStats() const { return rttStats_; }
+
+void InFlightWindow::resetRttStats() { rttStats_ = IMqttClient::RttStats{}; }
+
+sw::LatencyHistogram::Snapshot InFlightWindow::getPublishLatency() const {
+  return publishLatency_.getSnapshot();
+}
+
+common::Error
+InFlightWindow::registerMetrics(sw::metrics::Registry& registry) const {
+  common::Error errorCode =
+      registry.add("mqtt.publishLatencyUs", publishLatency_);
+  if (errorCode == common::Error::OK) {
+    errorCode = registry.add("mqtt.retries", retries_);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = registry.add("mqtt.fails", fails_);
+  }
+  return errorCode;
+}
+
+void InFlightWindow::complete_(Message& message, const common::Error result) {
+  message.isUsed = false;
+  --count_;
+  IMqttClient::publishCallback cb = std::move(message.cb);
+  message.cb = nullptr;
+  if (cb) {
+    cb(message.packetId, result, message.arg);
+  }
+}
+
+InFlightWindow::Message* InFlightWindow::find_(const uint16_t packetId) {
+  auto message = std::find_if(messages_.begin(), messages_.end(),
+                              [packetId](const Message& message) {
+                                return message.isUsed &&
+                                       message.packetId == packetId;
+                              });
+  return message != messages_.end() ? &(*message) : nullptr;
+}
+} // namespace net
@@ -0,0 +1,299 @@
+#include "mqttpacket.hpp"
+#include <cstring>
+
+namespace {
+constexpr uint8_t PUBLISH_DUP_FLAG{0x08};
+constexpr uint8_t PUBLISH_QOS_SHIFT{1};
+constexpr uint8_t PUBLISH_QOS_MASK{0x03};
+// Bits 3..0 of SUBSCRIBE are reserved and must be 0010
+constexpr uint8_t SUBSCRIBE_FLAGS{0x02};
+constexpr uint8_t CONNECT_CLEAN_SESSION_FLAG{0x02};
+constexpr uint8_t MQTT_3_1_1_LEVEL{4};
+constexpr std::string_view PROTOCOL_NAME{"MQTT"};
+constexpr size_t PUBACK_REMAINING_LENGTH{2};
+constexpr size_t SUBACK_REMAINING_LENGTH{3};
+constexpr size_t CONNACK_REMAINING_LENGTH{2};
+constexpr uint8_t REMAINING_LENGTH_MAX_BYTES{4};
+
+uint8_t toHeader(const net::mqtt::PacketType type, const uint8_t flags) {
+  return static_cast<uint8_t>(static_cast<uint8_t>(type) << 4 | flags);
+}
+
+/**
+ * @brief Gets the size of the remaining length field.
+ *
+ * @param length Remaining length.
+ *
+ * @return Number of bytes the variable length integer takes.
+ */
+size_t getRemainingLengthSize(size_t length) {
+  size_t bytes{1};
+  while (length >= 128) {
+    length /= 128;
+    ++bytes;
+  }
+  return bytes;
+}
+
+/**
+ * @brief Writes the fixed header.
+ *
+ * @param buffer Destination buffer.
+ * @param header Packet type and flags.
+ * @param length Remaining length.
+ *
+ * @return Number of bytes written.
+ */
+size_t writeFixedHeader(uint8_t* buffer, const uint8_t header, size_t length) {
+  size_t index{0};
+  buffer[index++] = header;
+  do {
+    uint8_t byte = length % 128;
+    length /= 128;
+    if (length > 0) {
+      byte |= 0x80;
+    }
+    buffer[index++] = byte;
+  } while (length > 0);
+
+  return index;
+}
+
+/**
+ * @brief Writes a 16-bit value in network byte order.
+ *
+ * @param buffer Destination buffer.
+ * @param value Value to write.
+ *
+ * @return Number of bytes written.
+ */
+size_t writeUint16(uint8_t* buffer, const uint16_t value) {
+  buffer[0] = static_cast<uint8_t>(value >> 8);
+  buffer[1] = static_cast<uint8_t>(value & 0xFF);
+  return sizeof(uint16_t);
+}
+
+uint16_t readUint16(const uint8_t* buffer) {
+  return static_cast<uint16_t>(buffer[0] << 8 | buffer[1]);
+}
+
+/**
+ * @brief Writes a length prefixed UTF-8 string.
+ *
+ * @param buffer Destination buffer.
+ * @param value String to write.
+ *
+ * @return Number of bytes written.
+ */
+size_t writeString(uint8_t* buffer, const std::string_view value) {
+  const size_t length =
+      writeUint16(buffer, static_cast<uint16_t>(value.size()));
+  std::memcpy(&buffer[length], value.data(), value.size());
+  return length + value.size();
+}
+
+/**
+ * @brief Gets the packet size and checks the remaining length.
+ *
+ * @return Size of the whole packet, 0 if it does not fit the buffer.
+ */
+size_t getPacketSize(const size_t size, const size_t remainingLength) {
+  if (remainingLength > net::mqtt::MAX_REMAINING_LENGTH) {
+    return 0;
+  }
+
+  const size_t packetSize =
+      1 + getRemainingLengthSize(remainingLength) + remainingLength;
+  return packetSize <= size ? packetSize : 0;
+}
+} // namespace
+
+namespace net {
+namespace mqtt {
+size_t parseFixedHeader(const uint8_t* buffer, const size_t length,
+                        PacketType& type, size_t& remainingLength) {
+  remainingLength = 0;
+  size_t multiplier{1};
+  for (size_t index = 1; index < length; ++index) {
+    const uint8_t byte = buffer[index];
+    remainingLength += (byte & 0x7F) * multiplier;
+    if ((byte & 0x80) == 0) {
+      type = static_cast<PacketType>(buffer[0] >> 4);
+      return index + 1;
+    }
+    if (index == REMAINING_LENGTH_MAX_BYTES) {
+      // Continuation bit on the last byte
+      return 0;
+    }
+    multiplier *= 128;
+  }
+
+  return 0;
+}
+
+size_t serializePublish(uint8_t* buffer, const size_t size,
+                        const Publish& publish) {
+  const bool hasPacketId = publish.qos > 0;
+  const size_t remainingLength = sizeof(uint16_t) + publish.topic.size() +
+                                 (hasPacketId ? sizeof(uint16_t) : 0) +
+                                 publish.payloadSize;
+  const size_t packetSize = getPacketSize(size, remainingLength);
+  if (packetSize == 0 || publish.topic.size() > UINT16_MAX) {
+    return 0;
+  }
+
+  const uint8_t flags =
+      static_cast<uint8_t>((publish.qos & PUBLISH_QOS_MASK)
+                           << PUBLISH_QOS_SHIFT) |
+      (publish.isDuplicate ? PUBLISH_DUP_FLAG : 0);
+  size_t length = writeFixedHeader(
+      buffer, toHeader(PacketType::PUBLISH, flags), remainingLength);
+  length += writeString(&buffer[length], publish.topic);
+  if (hasPacketId) {
+    length += writeUint16(&buffer[length], publish.packetId);
+  }
+  std::memcpy(&buffer[length], publish.payload, publish.payloadSize);
+  return length + publish.payloadSize;
+}
+
+bool deserializePublish(const uint8_t* packet, const size_t length,
+                        Publish& publish) {
+  PacketType type{};
+  size_t remainingLength{0};
+  size_t index = parseFixedHeader(packet, length, type, remainingLength);
+  if (index == 0 || type != PacketType::PUBLISH ||
+      index + remainingLength != length) {
+    return false;
+  }
+
+  publish.qos = (packet[0] >> PUBLISH_QOS_SHIFT) & PUBLISH_QOS_MASK;
+  publish.isDuplicate = (packet[0] & PUBLISH_DUP_FLAG) != 0;
+  const size_t idSize = publish.qos > 0 ? sizeof(uint16_t) : 0;
+  if (publish.qos > 1 || remainingLength < sizeof(uint16_t) + idSize) {
+    return false;
+  }
+
+  const size_t topicSize = readUint16(&packet[index]);
+  index += sizeof(uint16_t);
+  if (index + topicSize + idSize > length) {
+    return false;
+  }
+
+  publish.topic = {reinterpret_cast<const char*>(&packet[index]), topicSize};
+  index += topicSize;
+  publish.packetId = idSize > 0 ? readUint16(&packet[index]) : 0;
+  index += idSize;
+  publish.payload = &packet[index];
+  publish.payloadSize = length - index;
+  return true;
+}
+
+size_t serializeConnect(uint8_t* buffer, const size_t size,
+                        const std::string_view clientId,
+                        const uint16_t keepAliveS, const bool isCleanSession) {
+  // Protocol name, level, flags, keep alive and client ID
+  const size_t remainingLength = sizeof(uint16_t) + PROTOCOL_NAME.size() + 1 +
+                                 1 + sizeof(uint16_t) + sizeof(uint16_t) +
+                                 clientId.size();
+  if (getPacketSize(size, remainingLength) == 0) {
+    return 0;
+  }
+
+  size_t length =
+      writeFixedHeader(buffer, toHeader(PacketType::CONNECT, 0),
+                       remainingLength);
+  length += writeString(&buffer[length], PROTOCOL_NAME);
+  buffer[length++] = MQTT_3_1_1_LEVEL;
+  buffer[length++] = isCleanSession ? CONNECT_CLEAN_SESSION_FLAG : 0;
+  length += writeUint16(&buffer[length], keepAliveS);
+  length += writeString(&buffer[length], clientId);
+  return length;
+}
+
+bool deserializeConnack(const uint8_t* packet, const size_t length,
+                        uint8_t& returnCode) {
+  PacketType type{};
+  size_t remainingLength{0};
+  const size_t index = parseFixedHeader(packet, length, type, remainingLength);
+  if (index == 0 || type != PacketType::CONNACK ||
+      remainingLength != CONNACK_REMAINING_LENGTH ||
+      index + remainingLength != length) {
+    return false;
+  }
+
+  // Session present flag is ignored, sessions are always clean
+  returnCode = packet[index + 1];
+  return true;
+}
+
+size_t serializeSubscribe(uint8_t* buffer, const size_t size,
+                          const uint16_t packetId,
+                          const std::string_view filter, const uint8_t qos) {
+  const size_t remainingLength =
+      sizeof(uint16_t) + sizeof(uint16_t) + filter.size() + 1;
+  if (getPacketSize(size, remainingLength) == 0) {
+    return 0;
+  }
+
+  size_t length = writeFixedHeader(
+      buffer, toHeader(PacketType::SUBSCRIBE, SUBSCRIBE_FLAGS),
+      remainingLength);
+  length += writeUint16(&buffer[length], packetId);
+  length += writeString(&buffer[length], filter);
+  buffer[length++] = qos & PUBLISH_QOS_MASK;
+  return length;
+}
+
+bool deserializePuback(const uint8_t* packet, const size_t length,
+                       uint16_t& packetId) {
+  PacketType type{};
+  size_t remainingLength{0};
+  const size_t index = parseFixedHeader(packet, length, type, remainingLength);
+  if (index == 0 || type != PacketType::PUBACK ||
+      remainingLength != PUBACK_REMAINING_LENGTH ||
+      index + remainingLength > length) {
+    return false;
+  }
+
+  packetId = readUint16(&packet[index]);
+  return true;
+}
+
+size_t serializePuback(uint8_t* buffer, const size_t size,
+                       const uint16_t packetId) {
+  if (getPacketSize(size, PUBACK_REMAINING_LENGTH) == 0) {
+    return 0;
+  }
+
+  size_t length = writeFixedHeader(buffer, toHeader(PacketType::PUBACK, 0),
+                                   PUBACK_REMAINING_LENGTH);
+  return length + writeUint16(&buffer[length], packetId);
+}
+
+bool deserializeSuback(const uint8_t* packet, const size_t length,
+                       uint16_t& packetId, uint8_t& returnCode) {
+  PacketType type{};
+  size_t remainingLength{0};
+  const size_t index = parseFixedHeader(packet, length, type, remainingLength);
+  // One return code, SUBSCRIBE carries one filter
+  if (index == 0 || type != PacketType::SUBACK ||
+      remainingLength != SUBACK_REMAINING_LENGTH ||
+      index + remainingLength > length) {
+    return false;
+  }
+
+  packetId = readUint16(&packet[index]);
+  returnCode = packet[index + sizeof(uint16_t)];
+  return true;
+}
+
+size_t serializeZero(uint8_t* buffer, const size_t size,
+                     const PacketType type) {
+  if (getPacketSize(size, 0) == 0) {
+    return 0;
+  }
+
+  return writeFixedHeader(buffer, toHeader(type, 0), 0);
+}
+} // namespace mqtt
+} // namespace net
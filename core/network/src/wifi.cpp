@@ -3,6 +3,7 @@
 #include "esp_event.h"
 #include "esp_netif.h"
 #include "esp_wifi.h"
+#include "uptime.hpp"
 #include <array>
 #include <cstring>
 #include <string_view>
@@ -19,6 +20,7 @@ common::Error Wifi::init(const Config config) {
     return errorCode;
   }
 
+  powerSaveSinceMs_ = sw::getUptimeMs();
   errorCode = setMode_(config.mode);
   if (errorCode != common::Error::OK) {
     return errorCode;
@@ -30,7 +32,7 @@ common::Error Wifi::init(const Config config) {
     return errorCode;
   }
 
-  return common::Error::OK;
+  return setPowerSave(config.powerSave);
 }
 
 common::Error Wifi::deinit() {
@@ -114,6 +116,75 @@ common::Error Wifi::scan() {
   return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
 }
 
+common::Error Wifi::setStaTarget(const ApInfo* apInfo) {
+  if (not isStaMode()) {
+    return common::Error::INVALID_STATE;
+  }
+
+  wifi_config_t wifiConfig{};
+  esp_err_t espErrorCode = esp_wifi_get_config(WIFI_IF_STA, &wifiConfig);
+  if (espErrorCode != ESP_OK) {
+    return common::Error::FAIL;
+  }
+
+  if (apInfo != nullptr) {
+    wifiConfig.sta.bssid_set = true;
+    std::memcpy(wifiConfig.sta.bssid, apInfo->bssid.data(),
+                apInfo->bssid.size());
+    wifiConfig.sta.channel = apInfo->channel;
+    wifiConfig.sta.scan_method = WIFI_FAST_SCAN;
+  } else {
+    wifiConfig.sta.bssid_set = false;
+    wifiConfig.sta.channel = 0;
+    wifiConfig.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    wifiConfig.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+  }
+
+  espErrorCode = esp_wifi_set_config(WIFI_IF_STA, &wifiConfig);
+  return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
+}
+
+common::Error Wifi::getStaApInfo(ApInfo& apInfo) {
+  if (not isStaMode()) {
+    return common::Error::INVALID_STATE;
+  }
+
+  wifi_ap_record_t apRecord{};
+  esp_err_t espErrorCode = esp_wifi_sta_get_ap_info(&apRecord);
+  if (espErrorCode != ESP_OK) {
+    return common::Error::FAIL;
+  }
+
+  std::memcpy(apInfo.bssid.data(), apRecord.bssid, apInfo.bssid.size());
+  apInfo.channel = apRecord.primary;
+  return common::Error::OK;
+}
+
+common::Error Wifi::setPowerSave(const PowerSave powerSave) {
+  esp_err_t espErrorCode =
+      esp_wifi_set_ps(static_cast<wifi_ps_type_t>(powerSave));
+  if (espErrorCode != ESP_OK) {
+    return common::Error::FAIL;
+  }
+
+  accountPowerSave_();
+  const PowerSave previous = getAppliedPowerSave_();
+  powerSave_ = powerSave;
+  if (getAppliedPowerSave_() != previous) {
+    ++powerSaveStats_.switches;
+  }
+  return common::Error::OK;
+}
+
+Wifi::PowerSave Wifi::getPowerSave() const { return powerSave_; }
+
+Wifi::PowerSaveStats Wifi::getPowerSaveStats() const {
+  PowerSaveStats stats = powerSaveStats_;
+  stats.timeInModeMs[static_cast<size_t>(getAppliedPowerSave_())] +=
+      sw::getUptimeMs() - powerSaveSinceMs_;
+  return stats;
+}
+
 bool Wifi::isStaMode() const {
   return mode_ == Mode::STA || mode_ == Mode::APSTA;
 }
@@ -148,6 +219,7 @@ common::Error Wifi::setMode_(const Mode mode) {
     return common::Error::FAIL;
   }
 
+  accountPowerSave_();
   mode_ = mode;
   return common::Error::OK;
 }
@@ -181,6 +253,7 @@ common::Error Wifi::setStaConfig_(const StaConfig config) {
               config.password.size());
   wifiConfig.sta.threshold.authmode =
       static_cast<wifi_auth_mode_t>(config.authenticateMode);
+  wifiConfig.sta.listen_interval = config.listenInterval;
 
   esp_err_t espErrorCode = esp_wifi_set_config(WIFI_IF_STA, &wifiConfig);
   return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
@@ -203,4 +276,15 @@ common::Error Wifi::setApConfig_(const ApConfig config) {
   return espErrorCode == ESP_OK ? common::Error::OK : common::Error::FAIL;
 }
 
+Wifi::PowerSave Wifi::getAppliedPowerSave_() const {
+  return mode_ == Mode::STA ? powerSave_ : PowerSave::NONE;
+}
+
+void Wifi::accountPowerSave_() {
+  const common::Time nowMs = sw::getUptimeMs();
+  powerSaveStats_.timeInModeMs[static_cast<size_t>(getAppliedPowerSave_())] +=
+      nowMs - powerSaveSinceMs_;
+  powerSaveSinceMs_ = nowMs;
+}
+
 } // namespace net
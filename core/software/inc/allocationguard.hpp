@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sw {
+
+/**
+ * @class AllocationGuard
+ * @brief Counts heap allocations of the current thread while in scope.
+ *
+ * Paths which must not allocate in steady state, e.g. radio, queue and
+ * publish, put a guard on the stack. Allocations are seen by a heap hook:
+ * esp_heap_trace_alloc_hook with CONFIG_HEAP_USE_HOOKS on ESP-IDF, a malloc
+ * wrapper on the host. Without the hook nothing is counted. Guards nest.
+ */
+class AllocationGuard {
+  public:
+    /**
+     * @brief Construct a new AllocationGuard object.
+     *
+     * @param name Scope name, a string literal.
+     */
+    explicit AllocationGuard(const char* name);
+
+    /**
+     * @brief Destroy the AllocationGuard object, remembers the scope if it
+     * allocated.
+     */
+    ~AllocationGuard();
+
+    AllocationGuard(const AllocationGuard&) = delete;
+    AllocationGuard& operator=(const AllocationGuard&) = delete;
+
+    /**
+     * @brief Get the allocations since construction.
+     *
+     * @return Allocations of this thread in this scope.
+     */
+    uint32_t getAllocations() const;
+
+    /**
+     * @brief Get the allocations of all guarded scopes.
+     * @note Safe to call from any thread.
+     *
+     * @return Allocations since start.
+     */
+    static uint32_t getTotalAllocations();
+
+    /**
+     * @brief Get the bytes requested by all guarded scopes.
+     * @note Safe to call from any thread.
+     *
+     * @return Requested bytes since start.
+     */
+    static uint32_t getTotalBytes();
+
+    /**
+     * @brief Get the last scope which allocated.
+     *
+     * @return Scope name, nullptr if no scope allocated.
+     */
+    static const char* getLastScope();
+
+    /**
+     * @brief Abort on an allocation in a guarded scope, the backtrace shows
+     * the caller.
+     *
+     * @param isEnabled True to abort, false to only count.
+     */
+    static void setAbortOnAllocation(const bool isEnabled);
+
+    /**
+     * @brief Count an allocation, called by the heap hook.
+     * @note Must not allocate.
+     *
+     * @param size Allocated size.
+     */
+    static void onAllocation(const size_t size);
+
+  private:
+    const char* name_;
+    uint32_t startCount_;
+};
+
+} // namespace sw
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "types.hpp"
+#include <cstdint>
+
+namespace sw {
+/**
+ * @class Backoff
+ * @brief Exponential backoff with decorrelated jitter.
+ *
+ * Each delay is drawn from [base, 3 * previous delay] and capped, so devices
+ * which failed at the same moment spread their retries instead of retrying
+ * in lockstep. The delay starts again from base after reset(), which should
+ * be called when the attempt succeeded.
+ */
+class Backoff {
+  public:
+    /**
+     * @brief Backoff settings
+     */
+    struct Settings {
+        common::Time baseMs; // Minimal delay
+        common::Time capMs;  // Maximal delay
+    };
+
+    /**
+     * @brief Backoff state
+     */
+    struct State {
+        uint32_t attempts;        // Delays taken since last reset
+        common::Time lastDelayMs; // Last delay, 0 after reset
+    };
+
+    /**
+     * @brief Construct a new Backoff object.
+     *
+     * @param settings Backoff settings.
+     */
+    explicit Backoff(const Settings settings);
+
+    /**
+     * @brief Get the delay before the next attempt.
+     *
+     * @return Delay in milliseconds.
+     */
+    common::Time next();
+
+    /**
+     * @brief Start again from the base delay.
+     */
+    void reset();
+
+    /**
+     * @brief Get backoff state.
+     *
+     * @return Backoff state.
+     */
+    State getState() const;
+
+  private:
+    static constexpr uint32_t GROWTH_FACTOR{3};
+    Settings settings_;
+    State state_{};
+};
+} // namespace sw
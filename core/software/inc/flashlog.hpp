@@ -0,0 +1,192 @@
+#pragma once
+
+#include "iflash.hpp"
+#include "irecordlog.hpp"
+#include "types.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+namespace storage {
+
+/**
+ * @class FlashLog
+ * @brief Append-only ring log of fixed size records on raw flash.
+ *
+ * Records are collected in RAM and written as one page (with CRC) when the
+ * page is full or flush() is called. Pages are written in a ring over the
+ * whole flash area, so every sector is erased equally often. The sector in
+ * front of the write position is erased just before it is used; when it still
+ * holds unread pages, the oldest data is dropped.
+ *
+ * A consumed record is marked by clearing its bit in the page header, which
+ * needs no erase. After a reboot reading continues from the first record not
+ * marked as consumed. Records in the RAM page are lost on power loss.
+ *
+ * @tparam T Type of record, must be trivially copyable.
+ */
+template <typename T> class FlashLog final : public IRecordLog<T> {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "FlashLog record must be trivially copyable");
+
+  public:
+    /**
+     * @brief Log statistics
+     */
+    struct Stats {
+        uint32_t appended;       // Records appended
+        uint32_t pagesWritten;   // Pages written to flash
+        uint32_t pagesDropped;   // Unread pages erased, log was full
+        uint32_t pagesCorrupted; // Pages skipped because of wrong CRC
+    };
+
+    /**
+     * @brief Construct a new FlashLog object.
+     *
+     * @param flash Flash area used only by the log.
+     */
+    explicit FlashLog(IFlash& flash);
+
+    /**
+     * @brief Scan the flash and restore read and write positions.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Flash area too small or misaligned.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error init();
+
+    /**
+     * @brief Append a record, the page is written when full.
+     *
+     * @param record Record to append.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Log is not initialized.
+     *   - common::Error::FAIL: Page write fail, record kept in RAM.
+     */
+    common::Error append(const T& record) override;
+
+    /**
+     * @brief Get the oldest record without removing it.
+     *
+     * @param record Reference to the record.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NOT_FOUND: Log is empty.
+     */
+    common::Error peek(T& record) override;
+
+    /**
+     * @brief Remove the oldest record.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NOT_FOUND: Log is empty.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error pop() override;
+
+    /**
+     * @brief Write records kept in RAM as a page, even if it is not full.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Log is not initialized.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error flush() override;
+
+    /**
+     * @brief Check if there is no record to read.
+     *
+     * @return True if the log is empty.
+     */
+    bool isEmpty() const override;
+
+    /**
+     * @brief Get log statistics.
+     *
+     * @return Statistics since start.
+     */
+    Stats getStats() const;
+
+    static constexpr size_t PAGE_SIZE{256};
+
+  private:
+    struct __attribute__((packed)) PageHeader {
+        uint32_t magic;
+        uint32_t sequence;
+        uint16_t count;
+        uint16_t recordSize;
+        uint32_t crc;
+        uint32_t consumedMask; // Bit cleared when the record is read
+    };
+
+    using Page = std::array<uint8_t, PAGE_SIZE>;
+
+    /**
+     * @brief Read the header of a page.
+     */
+    common::Error readHeader_(const size_t page, PageHeader& header);
+
+    /**
+     * @brief Load the read page into the cache and verify it.
+     *
+     * @return
+     *   - common::Error::OK: Page has records to read.
+     *   - common::Error::NOT_FOUND: Page is consumed, blank or corrupted.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error loadReadPage_();
+
+    /**
+     * @brief Find the next page with records to read.
+     *
+     * @return True if the read cache holds a page with records to read.
+     */
+    bool prepareReadPage_();
+
+    /**
+     * @brief Erase the sector which contains the write page.
+     */
+    common::Error eraseWriteSector_();
+
+    size_t nextPage_(const size_t page) const;
+
+    uint32_t calculateCrc_(const Page& page) const;
+
+    static constexpr uint32_t MAGIC{0x474C4F47}; // "GLOG"
+    static constexpr uint32_t ERASED{0xFFFFFFFF};
+    static constexpr size_t HEADER_SIZE{sizeof(PageHeader)};
+    static constexpr size_t CRC_OFFSET{offsetof(PageHeader, crc)};
+    static constexpr size_t MASK_OFFSET{offsetof(PageHeader, consumedMask)};
+    static constexpr size_t MAX_MASK_RECORDS{32};
+    static constexpr size_t RECORDS_PER_PAGE{
+        std::min(MAX_MASK_RECORDS, (PAGE_SIZE - HEADER_SIZE) / sizeof(T))};
+    static_assert(RECORDS_PER_PAGE > 0, "FlashLog record too big");
+
+    IFlash& flash_;
+    size_t pageCount_{0};
+    size_t pagesPerSector_{0};
+    size_t writePage_{0};
+    size_t readPage_{0};
+    size_t readIndex_{0};
+    uint32_t nextSequence_{1};
+    Page readCache_{};
+    bool isReadCacheValid_{false};
+    bool isWriteSectorErased_{true};
+    std::array<T, RECORDS_PER_PAGE> writeBatch_{};
+    size_t writeHead_{0};
+    size_t writeCount_{0};
+    bool isInitialized_{false};
+    Stats stats_{};
+};
+
+} // namespace storage
+
+#include "impl/flashlog.tpp"
@@ -0,0 +1,317 @@
+#pragma once
+
+#include "utils.hpp"
+#include <cstring>
+
+template <typename T>
+storage::FlashLog<T>::FlashLog(IFlash& flash) : flash_{flash} {}
+
+template <typename T> common::Error storage::FlashLog<T>::init() {
+  const size_t sectorSize = flash_.getSectorSize();
+  if (sectorSize == 0 || sectorSize % PAGE_SIZE != 0) {
+    return common::Error::INVALID_ARG;
+  }
+
+  pagesPerSector_ = sectorSize / PAGE_SIZE;
+  pageCount_ = (flash_.getSize() / sectorSize) * pagesPerSector_;
+  // Erase-ahead needs one sector which holds no unread data
+  if (pageCount_ < 2 * pagesPerSector_) {
+    return common::Error::INVALID_ARG;
+  }
+
+  bool isNewestFound{false};
+  size_t newestPage{0};
+  uint32_t newestSequence{0};
+  for (size_t page{0}; page < pageCount_; ++page) {
+    PageHeader header{};
+    if (readHeader_(page, header) != common::Error::OK) {
+      return common::Error::FAIL;
+    }
+
+    if (header.magic == MAGIC && header.sequence >= newestSequence) {
+      isNewestFound = true;
+      newestPage = page;
+      newestSequence = header.sequence;
+    }
+  }
+
+  isInitialized_ = true;
+  if (not isNewestFound) {
+    writePage_ = 0;
+    readPage_ = 0;
+    isWriteSectorErased_ = false;
+    return eraseWriteSector_();
+  }
+
+  nextSequence_ = newestSequence + 1;
+  writePage_ = nextPage_(newestPage);
+  PageHeader header{};
+  if (readHeader_(writePage_, header) != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  if (writePage_ % pagesPerSector_ != 0 && header.magic != ERASED) {
+    // Interrupted write, continue in the next sector
+    writePage_ = (writePage_ / pagesPerSector_ + 1) * pagesPerSector_;
+    writePage_ %= pageCount_;
+    header.magic = 0;
+  }
+
+  if (writePage_ % pagesPerSector_ == 0 && header.magic != ERASED) {
+    // Erase-ahead was interrupted, the sector may still hold old data
+    isWriteSectorErased_ = false;
+    common::Error errorCode = eraseWriteSector_();
+    if (errorCode != common::Error::OK) {
+      return common::Error::FAIL;
+    }
+  }
+
+  // Oldest data follows the write position
+  readPage_ = writePage_;
+  size_t page{writePage_};
+  do {
+    if (readHeader_(page, header) != common::Error::OK) {
+      return common::Error::FAIL;
+    }
+
+    const uint32_t countMask =
+        header.count >= MAX_MASK_RECORDS ? ERASED : (1UL << header.count) - 1;
+    if (header.magic == MAGIC && (header.consumedMask & countMask) != 0) {
+      readPage_ = page;
+      break;
+    }
+    page = nextPage_(page);
+  } while (page != writePage_);
+
+  isReadCacheValid_ = false;
+  return common::Error::OK;
+}
+
+template <typename T>
+common::Error storage::FlashLog<T>::append(const T& record) {
+  if (not isInitialized_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  if (writeCount_ == RECORDS_PER_PAGE) {
+    // Previous page write failed, retry before taking more data
+    if (flush() != common::Error::OK) {
+      return common::Error::FAIL;
+    }
+  }
+
+  writeBatch_[writeCount_++] = record;
+  ++stats_.appended;
+
+  if (writeCount_ == RECORDS_PER_PAGE) {
+    return flush();
+  }
+
+  return common::Error::OK;
+}
+
+template <typename T> common::Error storage::FlashLog<T>::peek(T& record) {
+  if (prepareReadPage_()) {
+    std::memcpy(&record,
+                readCache_.data() + HEADER_SIZE + readIndex_ * sizeof(T),
+                sizeof(T));
+    return common::Error::OK;
+  }
+
+  if (writeHead_ < writeCount_) {
+    record = writeBatch_[writeHead_];
+    return common::Error::OK;
+  }
+
+  return common::Error::NOT_FOUND;
+}
+
+template <typename T> common::Error storage::FlashLog<T>::pop() {
+  if (prepareReadPage_()) {
+    PageHeader header{};
+    std::memcpy(&header, readCache_.data(), HEADER_SIZE);
+    header.consumedMask &= ~(1UL << readIndex_);
+
+    common::Error errorCode =
+        flash_.write(readPage_ * PAGE_SIZE + MASK_OFFSET,
+                     reinterpret_cast<const uint8_t*>(&header.consumedMask),
+                     sizeof(header.consumedMask));
+    if (errorCode != common::Error::OK) {
+      return common::Error::FAIL;
+    }
+
+    std::memcpy(readCache_.data(), &header, HEADER_SIZE);
+    ++readIndex_;
+    if (readIndex_ >= header.count) {
+      readPage_ = nextPage_(readPage_);
+      isReadCacheValid_ = false;
+    }
+    return common::Error::OK;
+  }
+
+  if (writeHead_ < writeCount_) {
+    ++writeHead_;
+    if (writeHead_ == writeCount_) {
+      writeHead_ = 0;
+      writeCount_ = 0;
+    }
+    return common::Error::OK;
+  }
+
+  return common::Error::NOT_FOUND;
+}
+
+template <typename T> common::Error storage::FlashLog<T>::flush() {
+  if (not isInitialized_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  if (writeHead_ == writeCount_) {
+    return common::Error::OK;
+  }
+
+  if (not isWriteSectorErased_) {
+    common::Error errorCode = eraseWriteSector_();
+    if (errorCode != common::Error::OK) {
+      return common::Error::FAIL;
+    }
+  }
+
+  Page page{};
+  page.fill(0xFF);
+  const size_t count = writeCount_ - writeHead_;
+  std::memcpy(page.data() + HEADER_SIZE, &writeBatch_[writeHead_],
+              count * sizeof(T));
+
+  PageHeader header{};
+  header.magic = MAGIC;
+  header.sequence = nextSequence_;
+  header.count = static_cast<uint16_t>(count);
+  header.recordSize = static_cast<uint16_t>(sizeof(T));
+  header.consumedMask = ERASED;
+  std::memcpy(page.data(), &header, HEADER_SIZE);
+  header.crc = calculateCrc_(page);
+  std::memcpy(page.data(), &header, HEADER_SIZE);
+
+  common::Error errorCode =
+      flash_.write(writePage_ * PAGE_SIZE, page.data(), page.size());
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  ++nextSequence_;
+  writeHead_ = 0;
+  writeCount_ = 0;
+  ++stats_.pagesWritten;
+
+  const size_t nextPage = nextPage_(writePage_);
+  if (nextPage % pagesPerSector_ != 0) {
+    writePage_ = nextPage;
+    return common::Error::OK;
+  }
+
+  // Flash is not empty now, so unread data in the next sector is the oldest
+  const size_t sectorEndPage = nextPage + pagesPerSector_;
+  if (readPage_ >= nextPage && readPage_ < sectorEndPage) {
+    stats_.pagesDropped += static_cast<uint32_t>(sectorEndPage - readPage_);
+    readPage_ = sectorEndPage % pageCount_;
+    isReadCacheValid_ = false;
+  }
+
+  writePage_ = nextPage;
+  isWriteSectorErased_ = false;
+  // Erase failure is retried before the next page write
+  eraseWriteSector_();
+  return common::Error::OK;
+}
+
+template <typename T> bool storage::FlashLog<T>::isEmpty() const {
+  return readPage_ == writePage_ && writeHead_ == writeCount_;
+}
+
+template <typename T>
+typename storage::FlashLog<T>::Stats storage::FlashLog<T>::getStats() const {
+  return stats_;
+}
+
+template <typename T>
+common::Error storage::FlashLog<T>::readHeader_(const size_t page,
+                                                PageHeader& header) {
+  return flash_.read(page * PAGE_SIZE, reinterpret_cast<uint8_t*>(&header),
+                     HEADER_SIZE);
+}
+
+template <typename T> common::Error storage::FlashLog<T>::loadReadPage_() {
+  common::Error errorCode =
+      flash_.read(readPage_ * PAGE_SIZE, readCache_.data(), readCache_.size());
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  PageHeader header{};
+  std::memcpy(&header, readCache_.data(), HEADER_SIZE);
+  if (header.magic != MAGIC) {
+    return common::Error::NOT_FOUND;
+  }
+
+  if (header.count == 0 || header.count > RECORDS_PER_PAGE ||
+      header.recordSize != sizeof(T) ||
+      header.crc != calculateCrc_(readCache_)) {
+    ++stats_.pagesCorrupted;
+    return common::Error::NOT_FOUND;
+  }
+
+  readIndex_ = 0;
+  while (readIndex_ < header.count &&
+         (header.consumedMask & (1UL << readIndex_)) == 0) {
+    ++readIndex_;
+  }
+
+  return readIndex_ < header.count ? common::Error::OK
+                                   : common::Error::NOT_FOUND;
+}
+
+template <typename T> bool storage::FlashLog<T>::prepareReadPage_() {
+  while (not isReadCacheValid_ && readPage_ != writePage_) {
+    common::Error errorCode = loadReadPage_();
+    if (errorCode == common::Error::FAIL) {
+      return false;
+    }
+
+    if (errorCode == common::Error::OK) {
+      isReadCacheValid_ = true;
+    } else {
+      readPage_ = nextPage_(readPage_);
+    }
+  }
+
+  return isReadCacheValid_;
+}
+
+template <typename T>
+common::Error storage::FlashLog<T>::eraseWriteSector_() {
+  const size_t sectorStartPage = writePage_ - (writePage_ % pagesPerSector_);
+  common::Error errorCode = flash_.eraseSector(sectorStartPage * PAGE_SIZE);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  isWriteSectorErased_ = true;
+  return common::Error::OK;
+}
+
+template <typename T>
+size_t storage::FlashLog<T>::nextPage_(const size_t page) const {
+  return (page + 1) % pageCount_;
+}
+
+template <typename T>
+uint32_t storage::FlashLog<T>::calculateCrc_(const Page& page) const {
+  PageHeader header{};
+  std::memcpy(&header, page.data(), HEADER_SIZE);
+
+  // Consumed mask changes after writing, so it is not covered
+  uint32_t crc = common::utils::crc32(page.data(), CRC_OFFSET);
+  return common::utils::crc32(page.data() + HEADER_SIZE,
+                              header.count * sizeof(T), crc);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace sw::posix {
+/**
+ * @brief Fixed-size FIFO behind a Queue handle.
+ */
+template <typename T> struct QueueStorage {
+    std::mutex mutex;
+    std::vector<T> items;
+    size_t head; // Index of the oldest item
+    size_t count;
+};
+} // namespace sw::posix
+
+template <typename T> sw::Queue<T>::Queue(size_t size) : size_{size} {}
+
+template <typename T> sw::Queue<T>::~Queue() {
+  delete static_cast<posix::QueueStorage<T>*>(handle_);
+}
+
+template <typename T> common::Error sw::Queue<T>::init() {
+  if (size_ == 0) {
+    return common::Error::FAIL;
+  }
+
+  auto* storage = new (std::nothrow) posix::QueueStorage<T>{};
+  if (storage == nullptr) {
+    return common::Error::FAIL;
+  }
+
+  storage->items.resize(size_);
+  handle_ = static_cast<Handle>(storage);
+  return common::Error::OK;
+}
+
+template <typename T> common::Error sw::Queue<T>::send(T data) {
+  if (not handle_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  auto* storage = static_cast<posix::QueueStorage<T>*>(handle_);
+  {
+    std::lock_guard<std::mutex> lock{storage->mutex};
+    if (storage->count == size_) {
+      return common::Error::FAIL;
+    }
+
+    storage->items[(storage->head + storage->count) % size_] = data;
+    ++storage->count;
+  }
+
+  trace::instant("queue send");
+  // Acquire pairs with setNotifyCallback(), the argument is set before
+  const common::Callback notifyCb =
+      notifyCb_.load(std::memory_order_acquire);
+  if (notifyCb) {
+    notifyCb(notifyArg_);
+  }
+  return common::Error::OK;
+}
+
+template <typename T>
+void sw::Queue<T>::setCallback(Callback cb, common::Argument arg) {
+  cb_ = cb;
+  arg_ = arg;
+}
+
+template <typename T>
+void sw::Queue<T>::setNotifyCallback(common::Callback cb,
+                                     common::Argument arg) {
+  // Senders may run, they see the callback only with its argument
+  notifyArg_ = arg;
+  notifyCb_.store(cb, std::memory_order_release);
+}
+
+template <typename T> bool sw::Queue<T>::yield() {
+  T data;
+  if (receive_(data) == common::Error::OK) {
+    cb_(data, arg_);
+    return true;
+  }
+
+  return false;
+}
+
+template <typename T> common::Error sw::Queue<T>::receive_(T& data) {
+  if (not handle_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  auto* storage = static_cast<posix::QueueStorage<T>*>(handle_);
+  std::lock_guard<std::mutex> lock{storage->mutex};
+  if (storage->count == 0) {
+    return common::Error::FAIL;
+  }
+
+  data = storage->items[storage->head];
+  storage->head = (storage->head + 1) % size_;
+  --storage->count;
+  trace::instant("queue receive");
+  return common::Error::OK;
+}
@@ -34,6 +34,13 @@ template <typename T> common::Error sw::Queue<T>::send(T data) {
     return common::Error::FAIL;
   }
 
+  trace::instant("queue send");
+  // Acquire pairs with setNotifyCallback(), the argument is set before
+  const common::Callback notifyCb =
+      notifyCb_.load(std::memory_order_acquire);
+  if (notifyCb) {
+    notifyCb(notifyArg_);
+  }
   return common::Error::OK;
 }
 
@@ -43,11 +50,22 @@ void sw::Queue<T>::setCallback(Callback cb, common::Argument arg) {
   arg_ = arg;
 }
 
-template <typename T> void sw::Queue<T>::yield() {
+template <typename T>
+void sw::Queue<T>::setNotifyCallback(common::Callback cb,
+                                     common::Argument arg) {
+  // Senders may run, they see the callback only with its argument
+  notifyArg_ = arg;
+  notifyCb_.store(cb, std::memory_order_release);
+}
+
+template <typename T> bool sw::Queue<T>::yield() {
   T data;
   if (receive_(data) == common::Error::OK) { // Timeout = 0 → tryb non-blocking
     cb_(data, arg_);
+    return true;
   }
+
+  return false;
 }
 
 template <typename T> common::Error sw::Queue<T>::receive_(T& data) {
@@ -61,5 +79,6 @@ template <typename T> common::Error sw::Queue<T>::receive_(T& data) {
     return common::Error::FAIL;
   }
 
+  trace::instant("queue receive");
   return common::Error::OK;
 }
@@ -0,0 +1,169 @@
+#pragma once
+
+template <typename T, size_t Capacity, sw::OverflowPolicy Policy>
+common::Error sw::RingBuffer<T, Capacity, Policy>::init() {
+  if (isInitialized_) {
+    return common::Error::OK;
+  }
+
+  common::Error errorCode = dataAvailable_.init();
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  isInitialized_ = true;
+  return common::Error::OK;
+}
+
+template <typename T, size_t Capacity, sw::OverflowPolicy Policy>
+common::Error sw::RingBuffer<T, Capacity, Policy>::send(const T data) {
+  const size_t head = head_.load(std::memory_order_relaxed);
+
+  if constexpr (Policy == OverflowPolicy::DROP_NEWEST) {
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    if (head - tail >= Capacity) {
+      drops_.fetch_add(1, std::memory_order_relaxed);
+      return common::Error::FAIL;
+    }
+  } else if constexpr (Policy == OverflowPolicy::DROP_OLDEST) {
+    size_t tail = tail_.load(std::memory_order_acquire);
+    if (head - tail >= Capacity) {
+      // Fails only when the consumer took the item first, which makes room too
+      if (tail_.compare_exchange_strong(tail, tail + 1,
+                                        std::memory_order_acq_rel)) {
+        drops_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  items_[head & INDEX_MASK] = data;
+  head_.store(head + 1, std::memory_order_release);
+
+  if constexpr (Policy == OverflowPolicy::OVERWRITE) {
+    updateHighWaterMark_(
+        std::min(head + 1 - tail_.load(std::memory_order_relaxed), Capacity));
+  } else {
+    updateHighWaterMark_(head + 1 - tail_.load(std::memory_order_relaxed));
+  }
+
+  trace::instant("queue send");
+  if (isInitialized_) {
+    dataAvailable_.give();
+  }
+  // Acquire pairs with setNotifyCallback(), the argument is set before
+  const common::Callback notifyCb =
+      notifyCb_.load(std::memory_order_acquire);
+  if (notifyCb) {
+    notifyCb(notifyArg_);
+  }
+  return common::Error::OK;
+}
+
+template <typename T, size_t Capacity, sw::OverflowPolicy Policy>
+common::Error sw::RingBuffer<T, Capacity, Policy>::tryReceive(T& data) {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  while (1) {
+    const size_t head = head_.load(std::memory_order_acquire);
+    if (head == tail) {
+      return common::Error::NOT_FOUND;
+    }
+
+    if constexpr (Policy == OverflowPolicy::OVERWRITE) {
+      // Keep one slot of distance, the producer may be writing slot `head`
+      if (head - tail >= Capacity) {
+        drops_.fetch_add(static_cast<uint32_t>(head - tail - (Capacity - 1)),
+                         std::memory_order_relaxed);
+        tail = head - (Capacity - 1);
+      }
+    }
+
+    data = items_[tail & INDEX_MASK];
+
+    if constexpr (Policy == OverflowPolicy::DROP_OLDEST) {
+      // Producer may have dropped this item while it was copied
+      if (tail_.compare_exchange_strong(tail, tail + 1,
+                                        std::memory_order_acq_rel)) {
+        trace::instant("queue receive");
+        return common::Error::OK;
+      }
+    } else if constexpr (Policy == OverflowPolicy::OVERWRITE) {
+      // Producer may have overwritten this slot while it was copied
+      if (head_.load(std::memory_order_acquire) - tail < Capacity) {
+        tail_.store(tail + 1, std::memory_order_release);
+        trace::instant("queue receive");
+        return common::Error::OK;
+      }
+    } else {
+      tail_.store(tail + 1, std::memory_order_release);
+      trace::instant("queue receive");
+      return common::Error::OK;
+    }
+  }
+}
+
+template <typename T, size_t Capacity, sw::OverflowPolicy Policy>
+common::Error
+sw::RingBuffer<T, Capacity, Policy>::receive(T& data,
+                                             const common::Time timeoutMs) {
+  if (not isInitialized_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  while (tryReceive(data) != common::Error::OK) {
+    if (dataAvailable_.take(timeoutMs) != common::Error::OK) {
+      return common::Error::NOT_FOUND;
+    }
+  }
+
+  return common::Error::OK;
+}
+
+template <typename T, size_t Capacity, sw::OverflowPolicy Policy>
+void sw::RingBuffer<T, Capacity, Policy>::setCallback(Callback cb,
+                                                      common::Argument arg) {
+  cb_ = cb;
+  arg_ = arg;
+}
+
+template <typename T, size_t Capacity, sw::OverflowPolicy Policy>
+void sw::RingBuffer<T, Capacity, Policy>::setNotifyCallback(
+    common::Callback cb, common::Argument arg) {
+  // Senders may run, they see the callback only with its argument
+  notifyArg_ = arg;
+  notifyCb_.store(cb, std::memory_order_release);
+}
+
+template <typename T, size_t Capacity, sw::OverflowPolicy Policy>
+bool sw::RingBuffer<T, Capacity, Policy>::yield() {
+  T data;
+  if (cb_ && tryReceive(data) == common::Error::OK) {
+    cb_(data, arg_);
+    return true;
+  }
+
+  return false;
+}
+
+template <typename T, size_t Capacity, sw::OverflowPolicy Policy>
+size_t sw::RingBuffer<T, Capacity, Policy>::size() const {
+  const size_t count = head_.load(std::memory_order_acquire) -
+                       tail_.load(std::memory_order_acquire);
+  return count > Capacity ? Capacity : count;
+}
+
+template <typename T, size_t Capacity, sw::OverflowPolicy Policy>
+typename sw::RingBuffer<T, Capacity, Policy>::Stats
+sw::RingBuffer<T, Capacity, Policy>::getStats() const {
+  return Stats{highWaterMark_.load(std::memory_order_relaxed),
+               drops_.load(std::memory_order_relaxed)};
+}
+
+template <typename T, size_t Capacity, sw::OverflowPolicy Policy>
+void sw::RingBuffer<T, Capacity, Policy>::updateHighWaterMark_(
+    const size_t count) {
+  // Only the producer raises the mark, a plain compare is enough
+  if (count > highWaterMark_.load(std::memory_order_relaxed)) {
+    highWaterMark_.store(static_cast<uint32_t>(count),
+                         std::memory_order_relaxed);
+  }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace sw {
+/**
+ * @class LatencyHistogram
+ * @brief Fixed-bucket log-scale latency histogram.
+ *
+ * Each power of two is split into SUB_BUCKETS linear buckets, so a percentile
+ * is reported with at most 1 / SUB_BUCKETS relative error over the whole
+ * 32-bit range. Recording is lock-free and doesn't allocate, a snapshot may
+ * be taken from another thread.
+ */
+class LatencyHistogram {
+  public:
+    static constexpr size_t SUB_BUCKET_BITS{2};
+    static constexpr size_t SUB_BUCKETS{1 << SUB_BUCKET_BITS};
+    static constexpr size_t BUCKETS{(32 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS};
+
+    /**
+     * @brief Copy of the histogram counters
+     */
+    struct Snapshot {
+        std::array<uint32_t, BUCKETS> counts;
+        uint32_t count;
+        uint32_t maxUs;
+
+        /**
+         * @brief Get a percentile.
+         *
+         * @param percent Percentile, 0 to 100.
+         *
+         * @return Upper bound of the bucket holding the percentile in
+         * microseconds, 0 if nothing was recorded.
+         */
+        uint32_t getPercentileUs(const uint8_t percent) const;
+
+        /**
+         * @brief Get counters recorded since an older snapshot.
+         *
+         * @param older Snapshot taken before this one.
+         *
+         * @return Difference of the snapshots, max is kept from this one.
+         */
+        Snapshot getDelta(const Snapshot& older) const;
+    };
+
+    /**
+     * @brief Record a latency
+     *
+     * @param valueUs Latency in microseconds.
+     */
+    void record(const uint32_t valueUs);
+
+    /**
+     * @brief Get a copy of the counters
+     *
+     * @return Counters since start or last reset.
+     */
+    Snapshot getSnapshot() const;
+
+    /**
+     * @brief Reset the counters
+     * @note Values recorded concurrently may be lost.
+     */
+    void reset();
+
+    /**
+     * @brief Get the bucket of a value
+     *
+     * @param valueUs Value in microseconds.
+     *
+     * @return Bucket index.
+     */
+    static size_t getBucket(const uint32_t valueUs);
+
+    /**
+     * @brief Get the largest value of a bucket
+     *
+     * @param bucket Bucket index.
+     *
+     * @return Value in microseconds.
+     */
+    static uint32_t getBucketMaxUs(const size_t bucket);
+
+  private:
+    std::array<std::atomic<uint32_t>, BUCKETS> counts_{};
+    std::atomic<uint32_t> maxUs_{0};
+};
+} // namespace sw
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "uptime.hpp"
+#include <atomic>
+#include <cstdint>
+
+namespace sw {
+/**
+ * @class LatencyMeter
+ * @brief Measures time between an event (e.g. an interrupt) and its handling.
+ *
+ * start() is meant to be called from the ISR and only stores a timestamp.
+ * stop() is called by the handler and updates the statistics, so it must
+ * always be called from the same thread.
+ */
+class LatencyMeter {
+  public:
+    /**
+     * @brief Latency statistics
+     */
+    struct Stats {
+        uint32_t count;
+        uint32_t lastUs;
+        uint32_t minUs;
+        uint32_t maxUs;
+        uint64_t totalUs;
+    };
+
+    /**
+     * @brief Mark the moment the event occurred
+     * @note Safe to call from an ISR.
+     */
+    void start() {
+      startUs_.store(static_cast<uint32_t>(getUptimeUs()),
+                     std::memory_order_relaxed);
+      isStarted_.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief Mark the moment the event is handled and record the latency
+     *
+     * @return Measured latency in microseconds, 0 if start() was not called.
+     */
+    uint32_t stop() {
+      if (not isStarted_.exchange(false, std::memory_order_acquire)) {
+        return 0;
+      }
+
+      // 32-bit subtraction stays valid across the counter wrap-around
+      const uint32_t latencyUs = static_cast<uint32_t>(getUptimeUs()) -
+                                 startUs_.load(std::memory_order_relaxed);
+      if (stats_.count == 0 || latencyUs < stats_.minUs) {
+        stats_.minUs = latencyUs;
+      }
+      if (latencyUs > stats_.maxUs) {
+        stats_.maxUs = latencyUs;
+      }
+      stats_.lastUs = latencyUs;
+      stats_.totalUs += latencyUs;
+      ++stats_.count;
+
+      return latencyUs;
+    }
+
+    /**
+     * @brief Get latency statistics
+     *
+     * @return Statistics since start or last reset.
+     */
+    Stats getStats() const { return stats_; }
+
+    /**
+     * @brief Reset latency statistics
+     */
+    void resetStats() { stats_ = Stats{}; }
+
+  private:
+    std::atomic<uint32_t> startUs_{0};
+    std::atomic<bool> isStarted_{false};
+    Stats stats_{};
+};
+} // namespace sw
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "latencyhistogram.hpp"
+#include "types.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace sw {
+/**
+ * @brief Runtime metrics of the system, e.g. radio and publish counts.
+ *
+ * Metrics are owned by the modules which update them, updates are lock-free
+ * and safe from any thread. A Registry lists them by name for a snapshot.
+ */
+namespace metrics {
+
+/**
+ * @class Counter
+ * @brief Monotonic event counter, wraps around at 2^32.
+ */
+class Counter {
+  public:
+    /**
+     * @brief Add to the counter.
+     * @note Safe to call from an ISR.
+     *
+     * @param value Number of events.
+     */
+    void add(const uint32_t value = 1) {
+      value_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of events.
+     *
+     * @return Events since start.
+     */
+    uint32_t get() const { return value_.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<uint32_t> value_{0};
+};
+
+/**
+ * @class Gauge
+ * @brief Last value of a quantity.
+ */
+class Gauge {
+  public:
+    /**
+     * @brief Set the value.
+     * @note Safe to call from an ISR.
+     *
+     * @param value New value.
+     */
+    void set(const int32_t value) {
+      value_.store(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the value.
+     *
+     * @return Last value set, 0 if never set.
+     */
+    int32_t get() const { return value_.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<int32_t> value_{0};
+};
+
+/**
+ * @class LinearHistogram
+ * @brief Fixed-bucket histogram with equal bucket width, e.g. for RSSI.
+ *
+ * Values below the first bucket are counted in the first one, values above
+ * the last bucket in the last one.
+ */
+class LinearHistogram {
+  public:
+    static constexpr size_t BUCKETS{32};
+
+    /**
+     * @brief Bucket layout
+     */
+    struct Settings {
+        int32_t min;   // Lowest value of the first bucket
+        uint32_t step; // Bucket width, must not be 0
+    };
+
+    /**
+     * @brief Copy of the histogram counters
+     */
+    struct Snapshot {
+        Settings settings;
+        std::array<uint32_t, BUCKETS> counts;
+        uint32_t count;
+
+        /**
+         * @brief Get a percentile.
+         *
+         * @param percent Percentile, 0 to 100.
+         *
+         * @return Lowest value of the bucket holding the percentile, 0 if
+         * nothing was recorded.
+         */
+        int32_t getPercentile(const uint8_t percent) const;
+    };
+
+    /**
+     * @brief Construct a new LinearHistogram object.
+     *
+     * @param settings Bucket layout.
+     */
+    explicit constexpr LinearHistogram(Settings settings)
+        : settings_{settings} {}
+
+    /**
+     * @brief Record a value
+     *
+     * @param value Value, clamped to the buckets.
+     */
+    void record(const int32_t value);
+
+    /**
+     * @brief Get a copy of the counters
+     *
+     * @return Counters since start.
+     */
+    Snapshot getSnapshot() const;
+
+  private:
+    Settings settings_;
+    std::array<std::atomic<uint32_t>, BUCKETS> counts_{};
+};
+
+/**
+ * @class Registry
+ * @brief Fixed-capacity list of named metrics.
+ *
+ * Metrics are added while the system is set up, before the threads which
+ * take snapshots start. Names and metrics must outlive the registry, names
+ * are usually string literals.
+ */
+class Registry {
+  public:
+    /**
+     * @brief Reads a value owned by another module, e.g. a queue depth.
+     */
+    using Reader = int32_t (*)(common::Argument arg);
+
+    /**
+     * @brief Kind of a metric
+     */
+    enum class Type : uint8_t { COUNTER, GAUGE, READER, LATENCY, LINEAR };
+
+    /**
+     * @brief Registered metric, the member matching type is set.
+     */
+    struct Entry {
+        std::string_view name;
+        Type type;
+        const Counter* counter;
+        const Gauge* gauge;
+        Reader reader;
+        common::Argument readerArg;
+        const LatencyHistogram* latency;
+        const LinearHistogram* linear;
+    };
+
+    static constexpr size_t MAX_METRICS{24};
+
+    /**
+     * @brief Add a metric.
+     *
+     * @param name Metric name.
+     * @param metric Metric.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Name is empty.
+     *   - common::Error::NO_MEM: Registry is full.
+     */
+    common::Error add(std::string_view name, const Counter& metric);
+
+    common::Error add(std::string_view name, const Gauge& metric);
+
+    common::Error add(std::string_view name, const LatencyHistogram& metric);
+
+    common::Error add(std::string_view name, const LinearHistogram& metric);
+
+    /**
+     * @brief Add a value read when a snapshot is taken.
+     *
+     * @param name Metric name.
+     * @param reader Function returning the value, called from the thread
+     * taking the snapshot.
+     * @param arg Argument passed to the reader.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Name is empty or reader is null.
+     *   - common::Error::NO_MEM: Registry is full.
+     */
+    common::Error add(std::string_view name, Reader reader,
+                      common::Argument arg);
+
+    const Entry* begin() const { return entries_.data(); }
+
+    const Entry* end() const { return entries_.data() + size_; }
+
+    size_t size() const { return size_; }
+
+  private:
+    common::Error add_(const Entry& entry);
+
+    std::array<Entry, MAX_METRICS> entries_{};
+    size_t size_{0};
+};
+
+} // namespace metrics
+} // namespace sw
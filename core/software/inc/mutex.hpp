@@ -0,0 +1,42 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace sw {
+/**
+ * @class Mutex
+ * @brief Mutex shared between threads, meets BasicLockable so it can be used
+ * with std::lock_guard.
+ * @note Not usable from an ISR.
+ */
+class Mutex {
+  public:
+    /**
+     * @brief Constructor for the Mutex class, creates the mutex.
+     */
+    Mutex();
+
+    /**
+     * @brief Destructor for the Mutex class.
+     */
+    ~Mutex();
+
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    /**
+     * @brief Blocks until the mutex is taken.
+     */
+    void lock();
+
+    /**
+     * @brief Releases the mutex taken by lock().
+     */
+    void unlock();
+
+  private:
+    using Handle = void*;
+
+    Handle handle_{nullptr};
+};
+} // namespace sw
@@ -1,9 +1,10 @@
 #pragma once
 
 #include "ticks.hpp"
+#include "trace.hpp"
 #include "types.hpp"
+#include <atomic>
 #include <cstddef>
-#include <functional>
 
 namespace sw {
 
@@ -26,11 +27,15 @@ template <typename T> class IQueueSender {
  */
 template <typename T> class IQueueReceiver {
   public:
-    using Callback = std::function<void(T, common::Argument)>;
+    // Plain function, a queue callback never allocates
+    using Callback = void (*)(T, common::Argument);
 
     virtual void setCallback(Callback cb, common::Argument arg) = 0;
 
-    virtual void yield() = 0;
+    virtual void setNotifyCallback(common::Callback cb,
+                                   common::Argument arg) = 0;
+
+    virtual bool yield() = 0;
 };
 
 /**
@@ -42,7 +47,7 @@ template <typename T> class IQueueReceiver {
 template <typename T>
 class Queue : public IQueueSender<T>, public IQueueReceiver<T> {
   public:
-    using Callback = IQueueReceiver<T>::Callback;
+    using Callback = typename IQueueReceiver<T>::Callback;
 
     /**
      * @brief Construct a new Queue object.
@@ -84,9 +89,21 @@ class Queue : public IQueueSender<T>, public IQueueReceiver<T> {
     void setCallback(Callback cb, common::Argument arg);
 
     /**
-     * @brief Yield the current thread until data is received.
+     * @brief Set the function called by the sender after data was queued.
+     * @note Called in the sender context, it should only wake the receiver.
+     * May be set while senders run, but only once.
+     *
+     * @param cb Callback function.
+     * @param arg Argument to be passed to the callback function.
+     */
+    void setNotifyCallback(common::Callback cb, common::Argument arg);
+
+    /**
+     * @brief Receive one item without waiting and pass it to the callback.
+     *
+     * @return True if an item was received.
      */
-    void yield();
+    bool yield();
 
   private:
     using Handle = void*;
@@ -108,8 +125,14 @@ class Queue : public IQueueSender<T>, public IQueueReceiver<T> {
     Handle handle_{nullptr};
     Callback cb_{nullptr};
     common::Argument arg_{nullptr};
+    std::atomic<common::Callback> notifyCb_{nullptr};
+    common::Argument notifyArg_{nullptr};
 };
 
 } // namespace sw
 
+#ifdef ESP_PLATFORM
 #include "impl/queue.tpp"
+#else
+#include "impl/posix/queue.tpp"
+#endif
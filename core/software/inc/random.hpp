@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+namespace sw {
+
+/**
+ * @brief Get a random 32-bit number from the hardware RNG.
+ *
+ * @return Random number.
+ */
+uint32_t random();
+
+/**
+ * @brief Get a random number in the range [min, max].
+ *
+ * @param min Lower bound (inclusive).
+ * @param max Upper bound (inclusive).
+ *
+ * @return Random number, or min if max is lower than min.
+ */
+uint32_t random(const uint32_t min, const uint32_t max);
+
+} // namespace sw
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "queue.hpp"
+#include "semaphore.hpp"
+#include "trace.hpp"
+#include "types.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace sw {
+
+/**
+ * @brief Behaviour of RingBuffer::send() when the buffer is full.
+ */
+enum class OverflowPolicy : uint8_t {
+  DROP_NEWEST, // Keep buffered items, the new item is dropped
+  DROP_OLDEST, // Producer removes the oldest item to make room
+  OVERWRITE    // Producer overwrites the oldest item, consumer skips it
+};
+
+/**
+ * @class RingBuffer
+ * @brief Lock-free single-producer single-consumer ring buffer.
+ *
+ * Exactly one thread (or ISR) may send and exactly one thread may receive.
+ * Head and tail are free-running indices, each on its own cache line.
+ * With OVERWRITE the producer never waits on nor writes the consumer index,
+ * the consumer detects that it was lapped and skips the overwritten items.
+ * The slot being written is never read, so at most Capacity - 1 items are
+ * kept in this mode.
+ *
+ * @tparam T Type of item, must be trivially copyable.
+ * @tparam Capacity Number of items, must be a power of two.
+ * @tparam Policy Behaviour when the buffer is full.
+ */
+template <typename T, size_t Capacity,
+          OverflowPolicy Policy = OverflowPolicy::DROP_NEWEST>
+class RingBuffer final : public IQueueSender<T>, public IQueueReceiver<T> {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "RingBuffer item must be trivially copyable");
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "RingBuffer capacity must be a power of two");
+
+  public:
+    using Callback = typename IQueueReceiver<T>::Callback;
+
+    /**
+     * @brief Ring buffer statistics
+     */
+    struct Stats {
+        uint32_t highWaterMark; // Maximum number of buffered items
+        uint32_t drops;         // Items lost because of overflow
+    };
+
+    /**
+     * @brief Initialize the ring buffer.
+     * @note Only needed by a consumer which waits in receive().
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error init();
+
+    /**
+     * @brief Send an item to the buffer.
+     * @note Safe to call from an ISR or a timer callback.
+     *
+     * @param data Item to send.
+     *
+     * @return
+     *   - common::Error::OK: Success, with OVERWRITE also when an item was lost.
+     *   - common::Error::FAIL: Buffer full, item dropped (DROP_NEWEST).
+     */
+    common::Error send(const T data) override;
+
+    /**
+     * @brief Receive an item without waiting.
+     *
+     * @param data Reference to the received item.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NOT_FOUND: Buffer is empty.
+     */
+    common::Error tryReceive(T& data);
+
+    /**
+     * @brief Receive an item, waiting until one is available.
+     *
+     * @param data Reference to the received item.
+     * @param timeoutMs Time to wait, Semaphore::WAIT_FOREVER to block.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NOT_FOUND: Timeout, buffer is empty.
+     *   - common::Error::INVALID_STATE: Buffer is not initialized.
+     */
+    common::Error receive(T& data, const common::Time timeoutMs);
+
+    /**
+     * @brief Set the callback function to be called when data is received.
+     *
+     * @param cb Callback function.
+     * @param arg Argument to be passed to the callback function.
+     */
+    void setCallback(Callback cb, common::Argument arg) override;
+
+    /**
+     * @brief Set the function called by the sender after data was queued.
+     * @note Called in the sender context, which may be an ISR. May be set
+     * while senders run, but only once.
+     *
+     * @param cb Callback function.
+     * @param arg Argument to be passed to the callback function.
+     */
+    void setNotifyCallback(common::Callback cb, common::Argument arg) override;
+
+    /**
+     * @brief Receive one item without waiting and pass it to the callback.
+     *
+     * @return True if an item was received.
+     */
+    bool yield() override;
+
+    /**
+     * @brief Get number of buffered items.
+     *
+     * @return Number of items.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get buffer statistics.
+     *
+     * @return Statistics since start.
+     */
+    Stats getStats() const;
+
+  private:
+    /**
+     * @brief Update the high-water mark with the current item count.
+     */
+    void updateHighWaterMark_(const size_t count);
+
+    static constexpr size_t INDEX_MASK{Capacity - 1};
+    static constexpr size_t CACHE_LINE_SIZE{64};
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    alignas(CACHE_LINE_SIZE) std::array<T, Capacity> items_{};
+    std::atomic<uint32_t> highWaterMark_{0};
+    std::atomic<uint32_t> drops_{0};
+    Semaphore dataAvailable_{};
+    bool isInitialized_{false};
+    Callback cb_{nullptr};
+    common::Argument arg_{nullptr};
+    std::atomic<common::Callback> notifyCb_{nullptr};
+    common::Argument notifyArg_{nullptr};
+};
+
+} // namespace sw
+
+#include "impl/ringbuffer.tpp"
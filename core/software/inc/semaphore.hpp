@@ -0,0 +1,61 @@
+#pragma once
+
+#include "types.hpp"
+#include <cstdint>
+
+namespace sw {
+/**
+ * @class Semaphore
+ * @brief Binary semaphore used to signal an event to a waiting thread.
+ */
+class Semaphore {
+  public:
+    /**
+     * @brief Default constructor for the Semaphore class.
+     */
+    Semaphore() = default;
+
+    /**
+     * @brief Destructor for the Semaphore class.
+     */
+    ~Semaphore();
+
+    /**
+     * @brief Initializes the semaphore.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error init();
+
+    /**
+     * @brief Signals the semaphore.
+     * @note Safe to call from an ISR.
+     *
+     * @return
+     *   - common::Error::OK: Success or semaphore was already signaled.
+     *   - common::Error::INVALID_STATE: Semaphore is not initialized.
+     */
+    common::Error give();
+
+    /**
+     * @brief Waits until the semaphore is signaled.
+     *
+     * @param timeoutMs Time to wait, WAIT_FOREVER to block indefinitely.
+     *
+     * @return
+     *   - common::Error::OK: Semaphore was signaled.
+     *   - common::Error::FAIL: Timeout.
+     *   - common::Error::INVALID_STATE: Semaphore is not initialized.
+     */
+    common::Error take(const common::Time timeoutMs);
+
+    static constexpr common::Time WAIT_FOREVER{UINT32_MAX};
+
+  private:
+    using Handle = void*;
+
+    Handle handle_{nullptr};
+};
+} // namespace sw
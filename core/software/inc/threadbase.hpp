@@ -67,6 +67,11 @@ class ThreadBase {
      */
     enum class CoreId : uint8_t { _0, _1 };
 
+    /**
+     * @brief Bits delivered with a task notification
+     */
+    using NotificationBits = uint32_t;
+
     /**
      * @brief Thread configuration
      */
@@ -146,11 +151,38 @@ class ThreadBase {
      */
     static void resumeFromISR_(ThreadHandle handle);
 
+    /**
+     * @brief Sets notification bits of the thread, wakes it if waiting
+     * @note Bits are latched, so a notification sent before the thread waits
+     * is not lost.
+     *
+     * @param bits Bits to set
+     */
+    void notify_(NotificationBits bits);
+
+    /**
+     * @brief Sets notification bits of the thread from an ISR
+     *
+     * @param handle Handle of the thread to notify
+     * @param bits Bits to set
+     */
+    static void notifyFromISR_(ThreadHandle handle, NotificationBits bits);
+
+    /**
+     * @brief Waits for any notification bit and clears all of them
+     *
+     * @param timeoutMs Time to wait, WAIT_FOREVER to block indefinitely
+     *
+     * @return Bits which were set, 0 on timeout.
+     */
+    NotificationBits waitForNotification_(common::Time timeoutMs);
+
     /**
      * @brief Deletes the thread
      */
     void delete_();
 
+    static constexpr common::Time WAIT_FOREVER{UINT32_MAX};
     ThreadHandle handle_{nullptr};
 
   private:
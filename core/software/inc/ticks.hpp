@@ -1,14 +1,32 @@
 #pragma once
 
+#ifdef ESP_PLATFORM
 #include "freertos/FreeRTOS.h"
+#endif
 #include "types.hpp"
 #include <cstdint>
 
 namespace sw {
 using Ticks = uint32_t;
 
+#ifdef ESP_PLATFORM
+static constexpr Ticks TICK_PERIOD_MS{portTICK_PERIOD_MS};
+static constexpr Ticks MAX_DELAY_TICKS{portMAX_DELAY};
+#else
+// POSIX backend waits with millisecond resolution
+static constexpr Ticks TICK_PERIOD_MS{1};
+static constexpr Ticks MAX_DELAY_TICKS{UINT32_MAX};
+#endif
+
 inline Ticks msToTicks(const common::Time timeMs) {
-  return timeMs / portTICK_PERIOD_MS;
+  return timeMs / TICK_PERIOD_MS;
+}
+
+/**
+ * @brief Convert a timeout to ticks, UINT32_MAX means wait forever.
+ */
+inline Ticks timeoutMsToTicks(const common::Time timeoutMs) {
+  return timeoutMs == UINT32_MAX ? MAX_DELAY_TICKS : msToTicks(timeoutMs);
 }
 
 inline Ticks usToTicks(const common::Time timeUs) {
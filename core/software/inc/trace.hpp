@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+
+namespace sw {
+/**
+ * @brief Event trace for hot paths, exported in the Chrome trace format.
+ *
+ * Events are kept in one lock-free ring buffer per core (per thread on the
+ * host), the oldest events are overwritten. Every event carries the id of
+ * its task, ISRs get one id per core, so begin/end pairs of a preempted task
+ * stay nested. Recording is off until enable() and costs one atomic load
+ * while off. Event names must be string literals, only the pointer is
+ * stored.
+ */
+namespace trace {
+
+/**
+ * @brief Event type, the value is the Chrome trace phase.
+ */
+enum class Phase : char { BEGIN = 'B', END = 'E', INSTANT = 'i' };
+
+static constexpr size_t EVENTS_PER_LANE{512};
+// Tasks named in the output, later ones are shown by id only
+static constexpr size_t MAX_NAMED_THREADS{24};
+
+/**
+ * @brief Start recording events.
+ */
+void enable();
+
+/**
+ * @brief Stop recording events, recorded events are kept.
+ */
+void disable();
+
+/**
+ * @brief Check if events are recorded.
+ *
+ * @return True if enabled.
+ */
+bool isEnabled();
+
+/**
+ * @brief Record an event.
+ * @note Safe to call from an ISR.
+ *
+ * @param name Event name, a string literal.
+ * @param phase Event type.
+ */
+void record(const char* name, Phase phase);
+
+/**
+ * @brief Record the start of a duration.
+ * @note Safe to call from an ISR.
+ *
+ * @param name Event name, a string literal.
+ */
+inline void begin(const char* name) { record(name, Phase::BEGIN); }
+
+/**
+ * @brief Record the end of a duration started with begin().
+ * @note Safe to call from an ISR.
+ *
+ * @param name Event name, the same as passed to begin().
+ */
+inline void end(const char* name) { record(name, Phase::END); }
+
+/**
+ * @brief Record a point in time.
+ * @note Safe to call from an ISR.
+ *
+ * @param name Event name, a string literal.
+ */
+inline void instant(const char* name) { record(name, Phase::INSTANT); }
+
+/**
+ * @brief Write recorded events as Chrome trace JSON.
+ *
+ * Recording is paused while writing. The output can be opened in
+ * chrome://tracing or ui.perfetto.dev, each task is shown as a thread.
+ *
+ * @param file Output, e.g. stdout.
+ *
+ * @return Number of events written.
+ */
+size_t dump(std::FILE* file);
+
+/**
+ * @class Scope
+ * @brief Records a duration from construction to destruction.
+ */
+class Scope {
+  public:
+    explicit Scope(const char* name) : name_{name} { begin(name_); }
+
+    ~Scope() { end(name_); }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    const char* name_;
+};
+
+} // namespace trace
+} // namespace sw
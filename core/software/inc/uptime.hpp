@@ -0,0 +1,24 @@
+#pragma once
+
+#include "types.hpp"
+#include <cstdint>
+
+namespace sw {
+
+/**
+ * @brief Get time since boot in microseconds.
+ * @note Safe to call from an ISR.
+ *
+ * @return Time since boot in microseconds.
+ */
+uint64_t getUptimeUs();
+
+/**
+ * @brief Get time since boot in milliseconds.
+ * @note Value wraps around after ~49 days, compare with subtraction.
+ *
+ * @return Time since boot in milliseconds.
+ */
+common::Time getUptimeMs();
+
+} // namespace sw
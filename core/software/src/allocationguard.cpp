@@ -0,0 +1,107 @@
+#include "allocationguard.hpp"
+#include <atomic>
+#include <cstdlib>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#endif
+
+namespace {
+thread_local uint32_t guardDepth{0};
+thread_local uint32_t guardedAllocations{0};
+std::atomic<uint32_t> totalAllocations{0};
+std::atomic<uint32_t> totalBytes{0};
+std::atomic<const char*> lastScope{nullptr};
+std::atomic<bool> isAbortEnabled{false};
+
+bool isThreadLocalReady() {
+#ifdef ESP_PLATFORM
+  // Startup code allocates before tasks have their thread local storage
+  return xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
+#else
+  return true;
+#endif
+}
+} // namespace
+
+namespace sw {
+
+AllocationGuard::AllocationGuard(const char* name)
+    : name_{name}, startCount_{guardedAllocations} {
+  ++guardDepth;
+}
+
+AllocationGuard::~AllocationGuard() {
+  --guardDepth;
+  if (getAllocations() != 0) {
+    lastScope.store(name_, std::memory_order_relaxed);
+  }
+}
+
+uint32_t AllocationGuard::getAllocations() const {
+  return guardedAllocations - startCount_;
+}
+
+uint32_t AllocationGuard::getTotalAllocations() {
+  return totalAllocations.load(std::memory_order_relaxed);
+}
+
+uint32_t AllocationGuard::getTotalBytes() {
+  return totalBytes.load(std::memory_order_relaxed);
+}
+
+const char* AllocationGuard::getLastScope() {
+  return lastScope.load(std::memory_order_relaxed);
+}
+
+void AllocationGuard::setAbortOnAllocation(const bool isEnabled) {
+  isAbortEnabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+void AllocationGuard::onAllocation(const size_t size) {
+  if (not isThreadLocalReady() or guardDepth == 0) {
+    return;
+  }
+
+  ++guardedAllocations;
+  totalAllocations.fetch_add(1, std::memory_order_relaxed);
+  totalBytes.fetch_add(static_cast<uint32_t>(size), std::memory_order_relaxed);
+  if (isAbortEnabled.load(std::memory_order_relaxed)) {
+    std::abort();
+  }
+}
+
+} // namespace sw
+
+// The hook lives with the guard, code using a guard links it in
+#ifdef ESP_PLATFORM
+#ifdef CONFIG_HEAP_USE_HOOKS
+extern "C" void esp_heap_trace_alloc_hook(void*, size_t size, uint32_t) {
+  sw::AllocationGuard::onAllocation(size);
+}
+#endif
+#elif not defined(__SANITIZE_ADDRESS__) and not defined(__SANITIZE_THREAD__)
+// Sanitizers bring their own malloc, allocations are not counted there
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) {
+  sw::AllocationGuard::onAllocation(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  sw::AllocationGuard::onAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  sw::AllocationGuard::onAllocation(size);
+  return __libc_realloc(ptr, size);
+}
+}
+#endif
@@ -0,0 +1,27 @@
+#include "backoff.hpp"
+#include "random.hpp"
+#include <algorithm>
+
+namespace sw {
+Backoff::Backoff(const Settings settings) : settings_{settings} {}
+
+common::Time Backoff::next() {
+  const common::Time previousMs =
+      state_.attempts == 0 ? settings_.baseMs : state_.lastDelayMs;
+  // Upper bound is computed in 64 bits, a long cap must not wrap it
+  const uint64_t upperMs =
+      std::min<uint64_t>(static_cast<uint64_t>(previousMs) * GROWTH_FACTOR,
+                         settings_.capMs);
+  const common::Time delayMs =
+      random(settings_.baseMs, static_cast<uint32_t>(upperMs));
+
+  state_.lastDelayMs = std::min(delayMs, settings_.capMs);
+  ++state_.attempts;
+  return state_.lastDelayMs;
+}
+
+void Backoff::reset() { state_ = State{}; }
+
+Backoff::State Backoff::getState() const { return state_; }
+
+} // namespace sw
@@ -0,0 +1,88 @@
+#include "latencyhistogram.hpp"
+#include <algorithm>
+
+namespace sw {
+void LatencyHistogram::record(const uint32_t valueUs) {
+  counts_[getBucket(valueUs)].fetch_add(1, std::memory_order_relaxed);
+
+  uint32_t maxUs = maxUs_.load(std::memory_order_relaxed);
+  while (valueUs > maxUs &&
+         not maxUs_.compare_exchange_weak(maxUs, valueUs,
+                                          std::memory_order_relaxed)) {
+  }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::getSnapshot() const {
+  Snapshot snapshot{};
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+    snapshot.count += snapshot.counts[i];
+  }
+  snapshot.maxUs = maxUs_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+void LatencyHistogram::reset() {
+  for (auto& count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  maxUs_.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::getBucket(const uint32_t valueUs) {
+  if (valueUs < SUB_BUCKETS) {
+    return valueUs;
+  }
+
+  // Bits below the most significant one and its SUB_BUCKET_BITS followers
+  // are dropped
+  const size_t msb = 31 - __builtin_clz(valueUs);
+  const size_t shift = msb - SUB_BUCKET_BITS;
+  const size_t subBucket = (valueUs >> shift) & (SUB_BUCKETS - 1);
+  return (shift + 1) * SUB_BUCKETS + subBucket;
+}
+
+uint32_t LatencyHistogram::getBucketMaxUs(const size_t bucket) {
+  if (bucket < SUB_BUCKETS) {
+    return static_cast<uint32_t>(bucket);
+  }
+
+  const size_t shift = bucket / SUB_BUCKETS - 1;
+  const uint64_t minUs =
+      static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+  return static_cast<uint32_t>(minUs + (uint64_t{1} << shift) - 1);
+}
+
+uint32_t
+LatencyHistogram::Snapshot::getPercentileUs(const uint8_t percent) const {
+  if (count == 0) {
+    return 0;
+  }
+
+  const uint64_t rank = std::max<uint64_t>(
+      (static_cast<uint64_t>(count) * std::min<uint8_t>(percent, 100) + 99) /
+          100,
+      1);
+  uint64_t cumulative{0};
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    cumulative += counts[i];
+    if (cumulative >= rank) {
+      // Bucket bound may be above any recorded value
+      return std::min(getBucketMaxUs(i), maxUs);
+    }
+  }
+
+  return maxUs;
+}
+
+LatencyHistogram::Snapshot
+LatencyHistogram::Snapshot::getDelta(const Snapshot& older) const {
+  Snapshot delta{};
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    delta.counts[i] = counts[i] - older.counts[i];
+    delta.count += delta.counts[i];
+  }
+  delta.maxUs = maxUs;
+  return delta;
+}
+} // namespace sw
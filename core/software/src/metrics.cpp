@@ -0,0 +1,111 @@
+#include "metrics.hpp"
+#include <algorithm>
+
+namespace sw {
+namespace metrics {
+
+void LinearHistogram::record(const int32_t value) {
+  size_t bucket{0};
+  if (value > settings_.min) {
+    const uint64_t offset =
+        static_cast<uint64_t>(static_cast<int64_t>(value) - settings_.min);
+    bucket = static_cast<size_t>(
+        std::min<uint64_t>(offset / settings_.step, BUCKETS - 1));
+  }
+  counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+LinearHistogram::Snapshot LinearHistogram::getSnapshot() const {
+  Snapshot snapshot{};
+  snapshot.settings = settings_;
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+    snapshot.count += snapshot.counts[i];
+  }
+  return snapshot;
+}
+
+int32_t LinearHistogram::Snapshot::getPercentile(const uint8_t percent) const {
+  if (count == 0) {
+    return 0;
+  }
+
+  const uint64_t rank = std::max<uint64_t>(
+      (static_cast<uint64_t>(count) * std::min<uint8_t>(percent, 100) + 99) /
+          100,
+      1);
+  uint64_t cumulative{0};
+  size_t bucket{0};
+  for (; bucket < BUCKETS - 1; ++bucket) {
+    cumulative += counts[bucket];
+    if (cumulative >= rank) {
+      break;
+    }
+  }
+
+  return settings.min + static_cast<int32_t>(bucket * settings.step);
+}
+
+common::Error Registry::add(std::string_view name, const Counter& metric) {
+  Entry entry{};
+  entry.name = name;
+  entry.type = Type::COUNTER;
+  entry.counter = &metric;
+  return add_(entry);
+}
+
+common::Error Registry::add(std::string_view name, const Gauge& metric) {
+  Entry entry{};
+  entry.name = name;
+  entry.type = Type::GAUGE;
+  entry.gauge = &metric;
+  return add_(entry);
+}
+
+common::Error Registry::add(std::string_view name,
+                            const LatencyHistogram& metric) {
+  Entry entry{};
+  entry.name = name;
+  entry.type = Type::LATENCY;
+  entry.latency = &metric;
+  return add_(entry);
+}
+
+common::Error Registry::add(std::string_view name,
+                            const LinearHistogram& metric) {
+  Entry entry{};
+  entry.name = name;
+  entry.type = Type::LINEAR;
+  entry.linear = &metric;
+  return add_(entry);
+}
+
+common::Error Registry::add(std::string_view name, Reader reader,
+                            common::Argument arg) {
+  if (reader == nullptr) {
+    return common::Error::INVALID_ARG;
+  }
+
+  Entry entry{};
+  entry.name = name;
+  entry.type = Type::READER;
+  entry.reader = reader;
+  entry.readerArg = arg;
+  return add_(entry);
+}
+
+common::Error Registry::add_(const Entry& entry) {
+  if (entry.name.empty()) {
+    return common::Error::INVALID_ARG;
+  }
+
+  if (size_ == MAX_METRICS) {
+    return common::Error::NO_MEM;
+  }
+
+  entries_[size_++] = entry;
+  return common::Error::OK;
+}
+
+} // namespace metrics
+} // namespace sw
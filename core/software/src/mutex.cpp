@@ -0,0 +1,27 @@
+#include "mutex.hpp"
+#include "freertos/idf_additions.h"
+#include "freertos/semphr.h"
+#include <cassert>
+
+namespace sw {
+Mutex::Mutex()
+    : handle_{static_cast<Handle>(xSemaphoreCreateMutex())} {
+  assert(handle_);
+}
+
+Mutex::~Mutex() {
+  if (handle_ != nullptr) {
+    vSemaphoreDelete(static_cast<SemaphoreHandle_t>(handle_));
+    handle_ = nullptr;
+  }
+}
+
+void Mutex::lock() {
+  xSemaphoreTake(static_cast<SemaphoreHandle_t>(handle_), portMAX_DELAY);
+}
+
+void Mutex::unlock() {
+  xSemaphoreGive(static_cast<SemaphoreHandle_t>(handle_));
+}
+
+} // namespace sw
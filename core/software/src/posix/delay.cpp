@@ -0,0 +1,15 @@
+#include "delay.hpp"
+#include <cerrno>
+#include <ctime>
+
+namespace sw {
+
+void delayMs(const common::Time timeMs) {
+  timespec remaining{static_cast<time_t>(timeMs / 1000),
+                     static_cast<long>(timeMs % 1000) * 1'000'000};
+  // Sleep is restarted with the remaining time after a signal
+  while (clock_nanosleep(CLOCK_MONOTONIC, 0, &remaining, &remaining) == EINTR) {
+  }
+}
+
+} // namespace sw
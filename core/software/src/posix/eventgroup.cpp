@@ -0,0 +1,91 @@
+#include "eventgroup.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+
+namespace {
+struct EventGroupState {
+  std::mutex mutex;
+  std::condition_variable changed;
+  sw::EventGroup::Bits bits;
+};
+} // namespace
+
+namespace sw {
+EventGroup::~EventGroup() {
+  delete static_cast<EventGroupState*>(handler_);
+  handler_ = nullptr;
+}
+
+common::Error EventGroup::init() {
+  handler_ = static_cast<Handler>(new (std::nothrow) EventGroupState{});
+  if (handler_ == nullptr) {
+    return common::Error::FAIL;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error EventGroup::set(Bits bits) {
+  if (handler_ == nullptr) {
+    return common::Error::INVALID_STATE;
+  }
+
+  if (bits == 0) {
+    return common::Error::INVALID_ARG;
+  }
+
+  auto* state = static_cast<EventGroupState*>(handler_);
+  {
+    std::lock_guard<std::mutex> lock{state->mutex};
+    state->bits |= bits;
+    allBits_ = state->bits;
+  }
+  state->changed.notify_all();
+  return common::Error::OK;
+}
+
+common::Error EventGroup::clear(Bits bits) {
+  if (handler_ == nullptr) {
+    return common::Error::INVALID_STATE;
+  }
+
+  if (bits == 0) {
+    return common::Error::INVALID_ARG;
+  }
+
+  auto* state = static_cast<EventGroupState*>(handler_);
+  std::lock_guard<std::mutex> lock{state->mutex};
+  state->bits &= ~bits;
+  allBits_ = state->bits;
+  return common::Error::OK;
+}
+
+common::Error EventGroup::wait(Bits bits, common::Time timeoutMs) {
+  if (handler_ == nullptr) {
+    return common::Error::INVALID_STATE;
+  }
+
+  if (bits == 0) {
+    return common::Error::INVALID_ARG;
+  }
+
+  // Same as the FreeRTOS backend: wait for all bits and don't clear them
+  auto* state = static_cast<EventGroupState*>(handler_);
+  std::unique_lock<std::mutex> lock{state->mutex};
+  auto isSet = [state, bits]() { return (state->bits & bits) == bits; };
+  bool isAllSet{true};
+  if (timeoutMs == UINT32_MAX) {
+    state->changed.wait(lock, isSet);
+  } else {
+    isAllSet = state->changed.wait_for(
+        lock, std::chrono::milliseconds{timeoutMs}, isSet);
+  }
+  allBits_ = state->bits;
+  return isAllSet ? common::Error::OK : common::Error::FAIL;
+}
+
+bool EventGroup::isBitsSet(Bits bits) const { return (allBits_ & bits); }
+
+} // namespace sw
@@ -0,0 +1,20 @@
+#include "mutex.hpp"
+#include <cassert>
+#include <mutex>
+#include <new>
+
+namespace sw {
+Mutex::Mutex() : handle_{static_cast<Handle>(new (std::nothrow) std::mutex{})} {
+  assert(handle_);
+}
+
+Mutex::~Mutex() {
+  delete static_cast<std::mutex*>(handle_);
+  handle_ = nullptr;
+}
+
+void Mutex::lock() { static_cast<std::mutex*>(handle_)->lock(); }
+
+void Mutex::unlock() { static_cast<std::mutex*>(handle_)->unlock(); }
+
+} // namespace sw
@@ -0,0 +1,26 @@
+#include "random.hpp"
+#include <sys/random.h>
+
+namespace sw {
+
+uint32_t random() {
+  uint32_t value{0};
+  // Reads of up to 256 bytes from the urandom source are not interrupted
+  getrandom(&value, sizeof(value), 0);
+  return value;
+}
+
+uint32_t random(const uint32_t min, const uint32_t max) {
+  if (max <= min) {
+    return min;
+  }
+
+  const uint32_t range = max - min;
+  if (range == UINT32_MAX) {
+    return random();
+  }
+
+  return min + (random() % (range + 1));
+}
+
+} // namespace sw
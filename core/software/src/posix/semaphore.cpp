@@ -0,0 +1,63 @@
+#include "semaphore.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+
+namespace {
+struct SemaphoreState {
+  std::mutex mutex;
+  std::condition_variable signaled;
+  bool isGiven;
+};
+} // namespace
+
+namespace sw {
+Semaphore::~Semaphore() {
+  delete static_cast<SemaphoreState*>(handle_);
+  handle_ = nullptr;
+}
+
+common::Error Semaphore::init() {
+  handle_ = static_cast<Handle>(new (std::nothrow) SemaphoreState{});
+  if (handle_ == nullptr) {
+    return common::Error::FAIL;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error Semaphore::give() {
+  if (handle_ == nullptr) {
+    return common::Error::INVALID_STATE;
+  }
+
+  auto* state = static_cast<SemaphoreState*>(handle_);
+  {
+    std::lock_guard<std::mutex> lock{state->mutex};
+    state->isGiven = true;
+  }
+  state->signaled.notify_one();
+  return common::Error::OK;
+}
+
+common::Error Semaphore::take(const common::Time timeoutMs) {
+  if (handle_ == nullptr) {
+    return common::Error::INVALID_STATE;
+  }
+
+  auto* state = static_cast<SemaphoreState*>(handle_);
+  std::unique_lock<std::mutex> lock{state->mutex};
+  auto isGiven = [state]() { return state->isGiven; };
+  if (timeoutMs == WAIT_FOREVER) {
+    state->signaled.wait(lock, isGiven);
+  } else if (not state->signaled.wait_for(
+                 lock, std::chrono::milliseconds{timeoutMs}, isGiven)) {
+    return common::Error::FAIL;
+  }
+
+  state->isGiven = false;
+  return common::Error::OK;
+}
+
+} // namespace sw
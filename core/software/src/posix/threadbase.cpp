@@ -0,0 +1,169 @@
+#include "threadbase.hpp"
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+namespace {
+/**
+ * @brief Thread behind a handle, notification bits are kept like the
+ * FreeRTOS task notification value.
+ */
+struct ThreadState {
+  pthread_t thread;
+  std::mutex mutex;
+  std::condition_variable changed;
+  sw::ThreadBase::NotificationBits bits;
+  bool isSuspended;
+};
+
+ThreadState* toState(void* handle) { return static_cast<ThreadState*>(handle); }
+
+void setBits(void* handle, const sw::ThreadBase::NotificationBits bits) {
+  ThreadState* state = toState(handle);
+  {
+    std::lock_guard<std::mutex> lock{state->mutex};
+    state->bits |= bits;
+  }
+  state->changed.notify_all();
+}
+
+void setSuspended(void* handle, const bool isSuspended) {
+  ThreadState* state = toState(handle);
+  {
+    std::lock_guard<std::mutex> lock{state->mutex};
+    state->isSuspended = isSuspended;
+  }
+  state->changed.notify_all();
+}
+
+constexpr size_t MAX_NAME_LENGTH{15};
+} // namespace
+
+namespace sw {
+
+ThreadBase::ThreadBase(const Config config) : config_{config} {}
+
+ThreadBase::~ThreadBase() { delete_(); }
+
+common::Error ThreadBase::start() {
+  if (handle_) {
+    resume_();
+    return common::Error::OK;
+  }
+
+  auto* state = new (std::nothrow) ThreadState{};
+  if (state == nullptr) {
+    return common::Error::FAIL;
+  }
+
+  // Handle is used by the thread as soon as it runs. Stack depth is sized for
+  // the target, the host uses the default stack size.
+  handle_ = state;
+  if (pthread_create(
+          &state->thread, nullptr,
+          [](void* arg) -> void* {
+            taskFunction_(arg);
+            return nullptr;
+          },
+          this) != 0) {
+    handle_ = nullptr;
+    delete state;
+    return common::Error::FAIL;
+  }
+
+  char name[MAX_NAME_LENGTH + 1]{};
+  config_.name.copy(name, MAX_NAME_LENGTH);
+  pthread_setname_np(state->thread, name);
+
+  // Pinned like on the target, as long as the host has the core
+  const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  const long core = static_cast<long>(config_.coreId);
+  if (core < cores) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    pthread_setaffinity_np(state->thread, sizeof(cpus), &cpus);
+  }
+
+  return common::Error::OK;
+}
+
+common::Error ThreadBase::stop() {
+  suspend_();
+  return common::Error::OK;
+}
+
+void ThreadBase::cleanup_() { delete_(); }
+
+void ThreadBase::suspend_() {
+  // Threads can't be stopped from outside, the thread parks when it waits for
+  // the next notification. Suspending itself takes effect at once.
+  setSuspended(handle_, true);
+  ThreadState* state = toState(handle_);
+  if (pthread_equal(pthread_self(), state->thread)) {
+    std::unique_lock<std::mutex> lock{state->mutex};
+    state->changed.wait(lock, [state]() { return not state->isSuspended; });
+  }
+}
+
+void ThreadBase::resume_() { setSuspended(handle_, false); }
+
+void ThreadBase::resumeFromISR_(ThreadHandle handle) {
+  setSuspended(handle, false);
+}
+
+void ThreadBase::notify_(NotificationBits bits) { setBits(handle_, bits); }
+
+void ThreadBase::notifyFromISR_(ThreadHandle handle, NotificationBits bits) {
+  setBits(handle, bits);
+}
+
+ThreadBase::NotificationBits
+ThreadBase::waitForNotification_(common::Time timeoutMs) {
+  ThreadState* state = toState(handle_);
+  std::unique_lock<std::mutex> lock{state->mutex};
+  state->changed.wait(lock, [state]() { return not state->isSuspended; });
+
+  auto isNotified = [state]() { return state->bits != 0; };
+  if (timeoutMs == WAIT_FOREVER) {
+    state->changed.wait(lock, isNotified);
+  } else if (not state->changed.wait_for(
+                 lock, std::chrono::milliseconds{timeoutMs}, isNotified)) {
+    return 0;
+  }
+
+  const NotificationBits bits = state->bits;
+  state->bits = 0;
+  return bits;
+}
+
+void ThreadBase::delete_() {
+  if (not handle_) {
+    return;
+  }
+
+  ThreadState* state = toState(handle_);
+  if (pthread_equal(pthread_self(), state->thread)) {
+    pthread_detach(state->thread);
+  } else {
+    pthread_cancel(state->thread);
+    pthread_join(state->thread, nullptr);
+  }
+
+  delete state;
+  handle_ = nullptr;
+}
+
+void ThreadBase::taskFunction_(void* arg) {
+  assert(arg);
+  ThreadBase* thread = static_cast<ThreadBase*>(arg);
+  thread->run_();
+  thread->cleanup_();
+}
+
+} // namespace sw
@@ -0,0 +1,248 @@
+#include "timer.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+/**
+ * @brief Timer behind a handle.
+ */
+struct TimerState {
+  int fd;
+  common::Callback dispatch; // Calls the user callback of the timer
+  common::Argument timer;
+  timespec period;
+  bool isReload;
+};
+
+/**
+ * @brief Single thread running callbacks of all timers, like the FreeRTOS
+ * timer service task. It waits on the timerfds with epoll.
+ *
+ * Callbacks run with the service lock held, timer calls take it too. So a
+ * deleted timer is never dispatched and the lock is recursive, callbacks may
+ * restart or stop timers.
+ */
+class TimerService {
+  public:
+    using Lock = std::lock_guard<std::recursive_mutex>;
+
+    static TimerService& getInstance() {
+      static TimerService service{};
+      return service;
+    }
+
+    bool add(TimerState& state) {
+      std::call_once(startFlag_, [this]() { start_(); });
+      if (epollFd_ < 0) {
+        return false;
+      }
+
+      Lock lock{mutex_};
+      epoll_event event{};
+      event.events = EPOLLIN;
+      event.data.ptr = &state;
+      if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, state.fd, &event) != 0) {
+        return false;
+      }
+
+      timers_.push_back(&state);
+      return true;
+    }
+
+    void remove(TimerState& state) {
+      Lock lock{mutex_};
+      epoll_ctl(epollFd_, EPOLL_CTL_DEL, state.fd, nullptr);
+      timers_.erase(std::remove(timers_.begin(), timers_.end(), &state),
+                    timers_.end());
+    }
+
+    std::recursive_mutex& getMutex() { return mutex_; }
+
+  private:
+    void start_() {
+      epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+      if (epollFd_ < 0) {
+        return;
+      }
+
+      pthread_t thread;
+      if (pthread_create(
+              &thread, nullptr,
+              [](void* arg) -> void* {
+                static_cast<TimerService*>(arg)->run_();
+                return nullptr;
+              },
+              this) != 0) {
+        close(epollFd_);
+        epollFd_ = -1;
+        return;
+      }
+      pthread_setname_np(thread, "TimerService");
+      pthread_detach(thread);
+    }
+
+    void run_() {
+      epoll_event events[MAX_EVENTS];
+      while (1) {
+        const int count = epoll_wait(epollFd_, events, MAX_EVENTS, -1);
+        Lock lock{mutex_};
+        for (int i = 0; i < count; ++i) {
+          auto* state = static_cast<TimerState*>(events[i].data.ptr);
+          // Timer may be deleted after the wait returned
+          if (std::find(timers_.begin(), timers_.end(), state) ==
+              timers_.end()) {
+            continue;
+          }
+
+          uint64_t expirations{0};
+          // Stopped or restarted timer has nothing to read
+          if (read(state->fd, &expirations, sizeof(expirations)) ==
+                  sizeof(expirations) &&
+              expirations > 0) {
+            state->dispatch(state->timer);
+          }
+        }
+      }
+    }
+
+    static constexpr int MAX_EVENTS{16};
+    std::once_flag startFlag_{};
+    std::recursive_mutex mutex_{};
+    std::vector<TimerState*> timers_{};
+    int epollFd_{-1};
+};
+
+TimerState* toState(timer::TimerHandle handle) {
+  return static_cast<TimerState*>(handle);
+}
+} // namespace
+
+namespace timer {
+namespace sw {
+
+common::Error Timer::init() {
+  const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd < 0) {
+    return common::Error::FAIL;
+  }
+
+  auto dispatch = [](void* arg) {
+    Timer* timer = static_cast<Timer*>(arg);
+    if (timer->cb_) {
+      timer->cb_(timer->arg_);
+    }
+  };
+  auto* state =
+      new (std::nothrow) TimerState{fd, dispatch, this, {}, false};
+  if (state == nullptr) {
+    close(fd);
+    return common::Error::FAIL;
+  }
+
+  if (not TimerService::getInstance().add(*state)) {
+    close(fd);
+    delete state;
+    return common::Error::FAIL;
+  }
+
+  handle_ = static_cast<void*>(state);
+  return common::Error::OK;
+}
+
+common::Error Timer::deinit() {
+  if (not handle_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  TimerState* state = toState(handle_);
+  TimerService& service = TimerService::getInstance();
+  TimerService::Lock lock{service.getMutex()};
+  service.remove(*state);
+  close(state->fd);
+  delete state;
+  handle_ = nullptr;
+  return common::Error::OK;
+}
+
+void Timer::setCallback(common::Callback cb, common::Argument arg) {
+  cb_ = cb;
+  arg_ = arg;
+}
+
+common::Error Timer::startOnce(const common::Time timeUs) {
+  if (not handle_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  common::Error errorCode = setPeriodAndReload_(timeUs, false);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  return start_();
+}
+
+common::Error Timer::startPeriodic(const common::Time timeUs) {
+  if (not handle_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  common::Error errorCode = setPeriodAndReload_(timeUs, true);
+  if (errorCode != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  return start_();
+}
+
+common::Error Timer::stop() {
+  if (not handle_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  TimerService::Lock lock{TimerService::getInstance().getMutex()};
+  const itimerspec disarm{};
+  return timerfd_settime(toState(handle_)->fd, 0, &disarm, nullptr) == 0
+             ? common::Error::OK
+             : common::Error::FAIL;
+}
+
+common::Error Timer::setPeriodAndReload_(common::Time timeUs, bool isReload) {
+  // Period is rounded to ticks like on the target, and is at least one tick
+  const ::sw::Ticks ticks = ::sw::usToTicks(timeUs);
+  if (ticks == 0) {
+    return common::Error::FAIL;
+  }
+
+  const common::Time periodMs = ticks * ::sw::TICK_PERIOD_MS;
+  TimerService::Lock lock{TimerService::getInstance().getMutex()};
+  TimerState* state = toState(handle_);
+  state->period = {static_cast<time_t>(periodMs / 1000),
+                   static_cast<long>(periodMs % 1000) * 1'000'000};
+  state->isReload = isReload;
+  return common::Error::OK;
+}
+
+common::Error Timer::start_() {
+  TimerService::Lock lock{TimerService::getInstance().getMutex()};
+  TimerState* state = toState(handle_);
+  itimerspec spec{};
+  spec.it_value = state->period;
+  if (state->isReload) {
+    spec.it_interval = state->period;
+  }
+
+  return timerfd_settime(state->fd, 0, &spec, nullptr) == 0
+             ? common::Error::OK
+             : common::Error::FAIL;
+}
+
+} // namespace sw
+} // namespace timer
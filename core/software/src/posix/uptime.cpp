@@ -0,0 +1,25 @@
+#include "uptime.hpp"
+#include <ctime>
+
+namespace {
+uint64_t getMonotonicUs() {
+  timespec now{};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1'000'000 +
+         static_cast<uint64_t>(now.tv_nsec) / 1000;
+}
+
+// Process start stands in for boot
+const uint64_t START_US{getMonotonicUs()};
+} // namespace
+
+namespace sw {
+
+uint64_t getUptimeUs() { return getMonotonicUs() - START_US; }
+
+common::Time getUptimeMs() {
+  constexpr uint64_t US_PER_MS{1000};
+  return static_cast<common::Time>(getUptimeUs() / US_PER_MS);
+}
+
+} // namespace sw
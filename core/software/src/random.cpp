@@ -0,0 +1,21 @@
+#include "random.hpp"
+#include "esp_random.h"
+
+namespace sw {
+
+uint32_t random() { return esp_random(); }
+
+uint32_t random(const uint32_t min, const uint32_t max) {
+  if (max <= min) {
+    return min;
+  }
+
+  const uint32_t range = max - min;
+  if (range == UINT32_MAX) {
+    return random();
+  }
+
+  return min + (random() % (range + 1));
+}
+
+} // namespace sw
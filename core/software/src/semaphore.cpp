@@ -0,0 +1,51 @@
+#include "semaphore.hpp"
+#include "freertos/idf_additions.h"
+#include "freertos/semphr.h"
+#include "ticks.hpp"
+
+namespace sw {
+Semaphore::~Semaphore() {
+  if (handle_ != nullptr) {
+    vSemaphoreDelete(static_cast<SemaphoreHandle_t>(handle_));
+    handle_ = nullptr;
+  }
+}
+
+common::Error Semaphore::init() {
+  handle_ = static_cast<Handle>(xSemaphoreCreateBinary());
+  if (handle_ == nullptr) {
+    return common::Error::FAIL;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error Semaphore::give() {
+  if (handle_ == nullptr) {
+    return common::Error::INVALID_STATE;
+  }
+
+  if (xPortInIsrContext()) {
+    BaseType_t higherPriorityTaskWoken{pdFALSE};
+    xSemaphoreGiveFromISR(static_cast<SemaphoreHandle_t>(handle_),
+                          &higherPriorityTaskWoken);
+    portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    return common::Error::OK;
+  }
+
+  // Giving an already given binary semaphore fails, the event is still pending
+  xSemaphoreGive(static_cast<SemaphoreHandle_t>(handle_));
+  return common::Error::OK;
+}
+
+common::Error Semaphore::take(const common::Time timeoutMs) {
+  if (handle_ == nullptr) {
+    return common::Error::INVALID_STATE;
+  }
+
+  BaseType_t baseErrorCode = xSemaphoreTake(
+      static_cast<SemaphoreHandle_t>(handle_), timeoutMsToTicks(timeoutMs));
+  return baseErrorCode == pdTRUE ? common::Error::OK : common::Error::FAIL;
+}
+
+} // namespace sw
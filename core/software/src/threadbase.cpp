@@ -1,5 +1,6 @@
 #include "threadbase.hpp"
 #include "freertos/idf_additions.h"
+#include "ticks.hpp"
 #include <cassert>
 
 namespace sw {
@@ -40,6 +41,29 @@ void ThreadBase::resumeFromISR_(ThreadHandle handle) {
   xTaskResumeFromISR(static_cast<TaskHandle_t>(handle));
 }
 
+void ThreadBase::notify_(NotificationBits bits) {
+  xTaskNotify(static_cast<TaskHandle_t>(handle_), bits, eSetBits);
+}
+
+void ThreadBase::notifyFromISR_(ThreadHandle handle, NotificationBits bits) {
+  BaseType_t higherPriorityTaskWoken{pdFALSE};
+  xTaskNotifyFromISR(static_cast<TaskHandle_t>(handle), bits, eSetBits,
+                     &higherPriorityTaskWoken);
+  portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+ThreadBase::NotificationBits
+ThreadBase::waitForNotification_(common::Time timeoutMs) {
+  constexpr uint32_t CLEAR_ALL_BITS{UINT32_MAX};
+  uint32_t bits{0};
+  if (xTaskNotifyWait(0, CLEAR_ALL_BITS, &bits, timeoutMsToTicks(timeoutMs)) !=
+      pdPASS) {
+    return 0;
+  }
+
+  return static_cast<NotificationBits>(bits);
+}
+
 void ThreadBase::delete_() {
   if (not handle_) {
     return;
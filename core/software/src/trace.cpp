@@ -0,0 +1,198 @@
+#include "trace.hpp"
+#include "uptime.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <pthread.h>
+#endif
+
+namespace {
+#ifdef ESP_PLATFORM
+static constexpr size_t LANES{portNUM_PROCESSORS};
+
+size_t getLane() { return xPortGetCoreID(); }
+#else
+// Host threads move between CPUs, a lane per thread keeps begin/end pairs
+static constexpr size_t LANES{8};
+
+size_t getLane() {
+  static std::atomic<size_t> nextLane{0};
+  thread_local const size_t lane =
+      nextLane.fetch_add(1, std::memory_order_relaxed) % LANES;
+  return lane;
+}
+#endif
+
+static constexpr size_t THREAD_NAME_LENGTH{16};
+// Thread ids from here on are ISRs, one per core
+static constexpr uint16_t ISR_THREAD_ID{0xFF00};
+
+/**
+ * @brief Name of a task, ready is set once the name is written.
+ */
+struct ThreadName {
+    std::atomic<bool> isReady{false};
+    std::array<char, THREAD_NAME_LENGTH> name{};
+};
+
+/**
+ * @brief Recorded event, name is null while the slot is written.
+ */
+struct Slot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint32_t> timeUs{0};
+    std::atomic<uint16_t> threadId{0};
+    std::atomic<char> phase{0};
+};
+
+/**
+ * @brief Events of one core, shared by its tasks and ISRs.
+ */
+struct Lane {
+    std::atomic<uint32_t> head{0};
+    std::array<Slot, sw::trace::EVENTS_PER_LANE> slots{};
+};
+
+std::atomic<bool> isRecording{false};
+std::array<Lane, LANES> lanes{};
+std::atomic<uint16_t> threadCount{0};
+std::array<ThreadName, sw::trace::MAX_NAMED_THREADS> threadNames{};
+
+/**
+ * @brief Give the calling task the next id and keep its name.
+ */
+uint16_t registerThread() {
+  const uint16_t id = threadCount.fetch_add(1, std::memory_order_relaxed);
+  if (id < threadNames.size()) {
+    ThreadName& threadName = threadNames[id];
+#ifdef ESP_PLATFORM
+    std::snprintf(threadName.name.data(), threadName.name.size(), "%s",
+                  pcTaskGetName(nullptr));
+#else
+    pthread_getname_np(pthread_self(), threadName.name.data(),
+                       threadName.name.size());
+#endif
+    threadName.isReady.store(true, std::memory_order_release);
+  }
+  return id;
+}
+
+uint16_t getThreadId() {
+#ifdef ESP_PLATFORM
+  // Thread local storage is the one of the interrupted task
+  if (xPortInIsrContext()) {
+    return ISR_THREAD_ID + xPortGetCoreID();
+  }
+#endif
+  thread_local const uint16_t id = registerThread();
+  return id;
+}
+} // namespace
+
+namespace sw {
+namespace trace {
+
+void enable() { isRecording.store(true, std::memory_order_relaxed); }
+
+void disable() { isRecording.store(false, std::memory_order_relaxed); }
+
+bool isEnabled() { return isRecording.load(std::memory_order_relaxed); }
+
+void record(const char* name, Phase phase) {
+  if (not isRecording.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  Lane& lane = lanes[getLane()];
+  const uint32_t head = lane.head.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = lane.slots[head % EVENTS_PER_LANE];
+
+  slot.name.store(nullptr, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.timeUs.store(static_cast<uint32_t>(getUptimeUs()),
+                    std::memory_order_relaxed);
+  slot.threadId.store(getThreadId(), std::memory_order_relaxed);
+  slot.phase.store(static_cast<char>(phase), std::memory_order_relaxed);
+  slot.name.store(name, std::memory_order_release);
+}
+
+size_t dump(std::FILE* file) {
+  const bool wasEnabled = isRecording.exchange(false);
+
+  // Timestamps are 32-bit, extend them relative to now
+  const uint64_t nowUs = getUptimeUs();
+  const uint32_t nowUs32 = static_cast<uint32_t>(nowUs);
+
+  size_t count{0};
+  std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  const size_t namedCount = std::min<size_t>(
+      threadCount.load(std::memory_order_relaxed), threadNames.size());
+  for (size_t id = 0; id < namedCount; ++id) {
+    const ThreadName& threadName = threadNames[id];
+    if (not threadName.isReady.load(std::memory_order_acquire)) {
+      continue;
+    }
+    std::fprintf(file,
+                 "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                 "\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n",
+                 static_cast<unsigned>(id), threadName.name.data());
+  }
+#ifdef ESP_PLATFORM
+  for (size_t core = 0; core < LANES; ++core) {
+    std::fprintf(file,
+                 "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                 "\"tid\":%u,\"args\":{\"name\":\"isr core %u\"}},\n",
+                 static_cast<unsigned>(ISR_THREAD_ID + core),
+                 static_cast<unsigned>(core));
+  }
+#endif
+
+  for (size_t laneId = 0; laneId < LANES; ++laneId) {
+    const Lane& lane = lanes[laneId];
+    const uint32_t head = lane.head.load(std::memory_order_relaxed);
+    const uint32_t first = head > EVENTS_PER_LANE ? head - EVENTS_PER_LANE : 0;
+    for (uint32_t index = first; index != head; ++index) {
+      const Slot& slot = lane.slots[index % EVENTS_PER_LANE];
+      const char* name = slot.name.load(std::memory_order_acquire);
+      if (name == nullptr) {
+        continue;
+      }
+      const uint32_t timeUs = slot.timeUs.load(std::memory_order_relaxed);
+      const uint16_t threadId = slot.threadId.load(std::memory_order_relaxed);
+      const char phase = slot.phase.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      // Skip a slot rewritten by an event recorded before disable()
+      if (slot.name.load(std::memory_order_relaxed) != name) {
+        continue;
+      }
+
+      const uint64_t ts = nowUs - static_cast<uint32_t>(nowUs32 - timeUs);
+      std::fprintf(file,
+                   "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":0,"
+                   "\"tid\":%u%s},\n",
+                   name, phase, static_cast<unsigned long long>(ts),
+                   static_cast<unsigned>(threadId),
+                   phase == static_cast<char>(Phase::INSTANT) ? ",\"s\":\"t\""
+                                                              : "");
+      ++count;
+    }
+  }
+  // Metadata event without a trailing comma closes the list
+  std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,"
+                     "\"args\":{\"name\":\"greenhouse\"}}\n]}\n");
+  std::fflush(file);
+
+  if (wasEnabled) {
+    enable();
+  }
+  return count;
+}
+
+} // namespace trace
+} // namespace sw
@@ -0,0 +1,13 @@
+#include "uptime.hpp"
+#include "esp_timer.h"
+
+namespace sw {
+
+uint64_t getUptimeUs() { return static_cast<uint64_t>(esp_timer_get_time()); }
+
+common::Time getUptimeMs() {
+  constexpr uint64_t US_PER_MS{1000};
+  return static_cast<common::Time>(getUptimeUs() / US_PER_MS);
+}
+
+} // namespace sw
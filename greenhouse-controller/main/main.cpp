@@ -1,39 +1,84 @@
 #include "adc.hpp"
+#include "delay.hpp"
 #include "esp_log.h"
 #include "gpio.hpp"
+#include "greenhousecontroller.hpp"
 #include "hrtimer.hpp"
 #include "i2c.hpp"
-#include "radiothreadcontroller.hpp"
+#include "nvsstore.hpp"
 #include "rfm95.hpp"
 #include "sht40.hpp"
 #include "spi.hpp"
-#include "timedmeter.hpp"
-#include "timer.hpp"
 #include "types.hpp"
+#include "uptime.hpp"
 #include "utils.hpp"
 #include <string_view>
 
 namespace {
 static constexpr std::string_view TAG{"Controller"};
-static constexpr common::Time MEASUREMENT_TIME_US{
-    common::utils::msToUs<common::Time, common::Time>(
-        common::utils::sToMs<common::Time, common::Time>(1))};
+// Unique per controller, the hub keeps report state for each
+static constexpr uint8_t CONTROLLER_ID{1};
+
+#ifdef CONFIG_CONTROLLER_BUS_STATS
+using Spi = hw::BasicSpi<hw::BusStats>;
+using I2c = hw::BasicI2c<hw::BusStats>;
+static constexpr common::Time BUS_STATS_PERIOD_MS{
+    common::utils::sToMs<common::Time, common::Time>(60)};
+
+/**
+ * @brief Log the transactions of each device on a bus and clear them.
+ *
+ * @param bus Bus name.
+ * @param busStats Statistics of the bus.
+ * @param periodMs Time since the last clear, for the bus time share.
+ */
+void logBusStats(const std::string_view bus, hw::BusStats& busStats,
+                 const common::Time periodMs) {
+  hw::BusStats::Stats stats{};
+  for (size_t i = 0; busStats.getStats(i, stats) == common::Error::OK; ++i) {
+    // Bus time share in hundredths of a percent
+    const uint64_t share = stats.busTimeUs * 10 / periodMs;
+    ESP_LOGI(TAG.data(),
+             "%.*s 0x%lx: %lu transactions, %lu bytes, %llu us "
+             "(%lu.%02lu%%), max %lu us",
+             static_cast<int>(bus.size()), bus.data(),
+             static_cast<unsigned long>(stats.device),
+             static_cast<unsigned long>(stats.transactions),
+             static_cast<unsigned long>(stats.bytes),
+             static_cast<unsigned long long>(stats.busTimeUs),
+             static_cast<unsigned long>(share / 100),
+             static_cast<unsigned long>(share % 100),
+             static_cast<unsigned long>(stats.maxLatencyUs));
+  }
+  busStats.reset();
+}
+#else
+using Spi = hw::Spi;
+using I2c = hw::I2c;
+#endif
 } // namespace
 
 extern "C" {
 void app_main(void) {
   common::Error errorCode{common::Error::OK};
 
+  errorCode = storage::hw::NvsStore::init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "nvs init fail");
+  }
+
+  storage::hw::NvsStore storage{"storage"};
+
   hw::Gpio mosi{23};
   hw::Gpio miso{19};
   hw::Gpio sck{18};
-  hw::Spi spi{{miso, mosi, sck, hw::Spi::Host::VSPI}};
-  errorCode = spi.init(hw::Spi::DmaChannel::CHANNEL_1);
+  Spi spi{{miso, mosi, sck, Spi::Host::VSPI}};
+  errorCode = spi.init(Spi::DmaChannel::CHANNEL_1);
   if (errorCode != common::Error::OK) {
     ESP_LOGE(TAG.data(), "spi init fail");
   }
 
-  hw::I2c i2c;
+  I2c i2c;
   errorCode = i2c.init();
   if (errorCode != common::Error::OK) {
     ESP_LOGE(TAG.data(), "i2c init fail");
@@ -63,42 +108,38 @@ void app_main(void) {
   hw::Gpio rst{4};
   hw::Gpio dio0{17};
   radio::Rfm95 rfm95{{rst, dio0, spi, spiRfm95Handle}};
-  errorCode = rfm95.init(radio::Rfm95::Modulation::LORA);
+
+  timer::hw::HrTimer measurementTimer;
+  errorCode = measurementTimer.init();
   if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "radio init fail");
+    ESP_LOGE(TAG.data(), "Measurement timer init fail");
   }
 
-  radio::Rfm95::ModemSettings settings;
-  settings.frequencyHz = 868'000'000;
-  settings.lnaBoostHfEnable = true;
-  settings.gain = radio::Rfm95::Gain::G1;
-  settings.bandwidth = radio::Rfm95::Bandwidth::BW_125000;
-  settings.spreadingFactor = radio::Rfm95::SF::SF_12;
-  settings.syncWord = 18;
-  settings.preambleLength = 8;
-  settings.paPin = radio::Rfm95::PaPin::BOOST;
-  settings.power = 20;
-
-  errorCode = rfm95.setAllSettings(settings);
+  app::GreenhouseController controller{
+      {rfm95, sht40, sht40, measurementTimer, storage, CONTROLLER_ID}};
+  errorCode = controller.init();
   if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "radio set all settings fail");
+    ESP_LOGE(TAG.data(), "controller init fail");
   }
 
-  timer::hw::HrTimer measurementTimer;
-  measurementTimer.init();
+  errorCode = controller.start();
   if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "Measurement timer init fail");
+    ESP_LOGE(TAG.data(), "controller start fail");
   }
 
-  common::Telemetry telemetry{};
-  app::TimedMeter timedMeter{{measurementTimer, sht40, sht40, telemetry}};
-  timedMeter.start(MEASUREMENT_TIME_US);
-
-  app::RadioThreadController radioThread{{rfm95, telemetry}};
-  radioThread.start();
-
+#ifdef CONFIG_CONTROLLER_BUS_STATS
+  common::Time busStatsMs = sw::getUptimeMs();
+#endif
   while (1) {
-    timedMeter.yield();
+#ifdef CONFIG_CONTROLLER_BUS_STATS
+    const common::Time nowMs = sw::getUptimeMs();
+    if (nowMs - busStatsMs >= BUS_STATS_PERIOD_MS) {
+      logBusStats("spi", spi.getBusStats(), nowMs - busStatsMs);
+      logBusStats("i2c", i2c.getBusStats(), nowMs - busStatsMs);
+      busStatsMs = nowMs;
+    }
+#endif
+    controller.yield();
     sw::delayMs(10);
   }
 }
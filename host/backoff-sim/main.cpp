@@ -0,0 +1,205 @@
+#include "backoff.hpp"
+#include "types.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Reconnect storm after a broker outage. All hubs lose the connection at
+// the same moment, the broker comes back after the outage and accepts a
+// limited number of connections per second. Time is simulated, so a run of
+// hours takes milliseconds. Retry strategies are compared by the attempts
+// the broker sees per second and the time until every hub is connected.
+
+namespace {
+// Same settings as AwsIotThread
+static constexpr sw::Backoff::Settings BACKOFF_SETTINGS{
+    common::utils::sToMs<common::Time, common::Time>(1),
+    common::utils::sToMs<common::Time, common::Time>(
+        common::utils::minToS<common::Time, common::Time>(10))};
+static constexpr common::Time MS_PER_S{1000};
+static constexpr uint32_t HISTOGRAM_BIN_S{10};
+static constexpr uint32_t HISTOGRAM_BINS{30};
+static constexpr uint32_t HISTOGRAM_WIDTH{50};
+
+/**
+ * @brief Command line options
+ */
+struct Options {
+    uint32_t hubs{1000};
+    uint32_t outageS{60};
+    uint32_t acceptedPerS{50}; // Connections the broker accepts per second
+};
+
+/**
+ * @brief Result of one strategy
+ */
+struct Result {
+    uint64_t attempts;
+    uint32_t peakAttemptsPerS;
+    uint32_t allConnectedS;
+    std::vector<uint32_t> attemptsPerS;
+};
+
+/**
+ * @brief Retry after a fixed delay, the hubs stay in lockstep.
+ */
+class FixedDelay {
+  public:
+    explicit FixedDelay(const sw::Backoff::Settings settings)
+        : delayMs_{settings.baseMs} {}
+
+    common::Time next() { return delayMs_; }
+
+  private:
+    common::Time delayMs_;
+};
+
+/**
+ * @brief Doubling delay without jitter, the hubs still retry together.
+ */
+class Exponential {
+  public:
+    explicit Exponential(const sw::Backoff::Settings settings)
+        : settings_{settings}, delayMs_{settings.baseMs} {}
+
+    common::Time next() {
+      const common::Time delayMs = delayMs_;
+      delayMs_ = std::min(delayMs_ * 2, settings_.capMs);
+      return delayMs;
+    }
+
+  private:
+    sw::Backoff::Settings settings_;
+    common::Time delayMs_;
+};
+
+void printUsage(const char* name) {
+  std::printf("Usage: %s [-n hubs] [-o outage_s] [-c accepted_per_s]\n", name);
+}
+
+/**
+ * @brief Parse command line options.
+ *
+ * @return False if an option is unknown.
+ */
+bool parseOptions(int argc, char** argv, Options& options) {
+  int option{0};
+  while ((option = getopt(argc, argv, "n:o:c:h")) != -1) {
+    switch (option) {
+    case 'n':
+      options.hubs = static_cast<uint32_t>(std::atoi(optarg));
+      break;
+    case 'o':
+      options.outageS = static_cast<uint32_t>(std::atoi(optarg));
+      break;
+    case 'c':
+      options.acceptedPerS = static_cast<uint32_t>(std::atoi(optarg));
+      break;
+    default:
+      return false;
+    }
+  }
+  return options.hubs > 0 && options.acceptedPerS > 0;
+}
+
+/**
+ * @brief Simulate the storm with one retry strategy object per hub.
+ */
+template <typename Strategy> Result simulate(const Options& options) {
+  using Attempt = std::pair<uint64_t, uint32_t>; // Time in ms, hub
+  std::priority_queue<Attempt, std::vector<Attempt>, std::greater<>> attempts;
+  std::vector<Strategy> strategies(options.hubs, Strategy{BACKOFF_SETTINGS});
+
+  // Disconnect is detected at once, the first retry follows the strategy
+  for (uint32_t hub = 0; hub < options.hubs; ++hub) {
+    attempts.push({strategies[hub].next(), hub});
+  }
+
+  const uint64_t outageEndMs = uint64_t{options.outageS} * MS_PER_S;
+  Result result{};
+  std::vector<uint32_t> acceptedPerS;
+  uint32_t connected{0};
+  while (connected < options.hubs) {
+    const auto [timeMs, hub] = attempts.top();
+    attempts.pop();
+
+    const size_t second = timeMs / MS_PER_S;
+    if (second >= result.attemptsPerS.size()) {
+      result.attemptsPerS.resize(second + 1, 0);
+      acceptedPerS.resize(second + 1, 0);
+    }
+    ++result.attemptsPerS[second];
+    ++result.attempts;
+
+    if (timeMs >= outageEndMs && acceptedPerS[second] < options.acceptedPerS) {
+      ++acceptedPerS[second];
+      ++connected;
+      result.allConnectedS = static_cast<uint32_t>(second);
+      continue;
+    }
+
+    attempts.push({timeMs + strategies[hub].next(), hub});
+  }
+
+  result.peakAttemptsPerS = *std::max_element(result.attemptsPerS.begin(),
+                                              result.attemptsPerS.end());
+  return result;
+}
+
+/**
+ * @brief Print totals and a histogram of attempts over time.
+ */
+void print(const char* name, const Result& result) {
+  std::printf("\n%s: %llu attempts, peak %u attempts/s, all connected after "
+              "%u s\n",
+              name, static_cast<unsigned long long>(result.attempts),
+              result.peakAttemptsPerS, result.allConnectedS);
+
+  std::vector<uint32_t> bins(HISTOGRAM_BINS, 0);
+  for (size_t second = 0; second < result.attemptsPerS.size(); ++second) {
+    const size_t bin =
+        std::min<size_t>(second / HISTOGRAM_BIN_S, HISTOGRAM_BINS - 1);
+    bins[bin] += result.attemptsPerS[second];
+  }
+
+  const uint32_t maxBin = std::max(*std::max_element(bins.begin(), bins.end()),
+                                   uint32_t{1});
+  for (uint32_t bin = 0; bin < HISTOGRAM_BINS; ++bin) {
+    if (bins[bin] == 0) {
+      continue;
+    }
+    const uint32_t width =
+        std::max<uint32_t>(1, bins[bin] * HISTOGRAM_WIDTH / maxBin);
+    std::printf("  %4u s%s %6u ", bin * HISTOGRAM_BIN_S,
+                bin + 1 == HISTOGRAM_BINS ? "+" : " ", bins[bin]);
+    for (uint32_t i = 0; i < width; ++i) {
+      std::putchar('#');
+    }
+    std::putchar('\n');
+  }
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options{};
+  if (not parseOptions(argc, argv, options)) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::printf("%u hubs, broker down for %u s, accepts %u connections/s, "
+              "attempts per %u s\n",
+              options.hubs, options.outageS, options.acceptedPerS,
+              HISTOGRAM_BIN_S);
+  print("Fixed delay", simulate<FixedDelay>(options));
+  print("Exponential, no jitter", simulate<Exponential>(options));
+  print("sw::Backoff, decorrelated jitter", simulate<sw::Backoff>(options));
+  return EXIT_SUCCESS;
+}
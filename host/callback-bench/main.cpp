@@ -0,0 +1,97 @@
+#include "allocationguard.hpp"
+#include "inplacefunction.hpp"
+#include "types.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <utility>
+
+// Dispatch cost and heap use of the callback types. A callback captures
+// three pointers, like a lambda taking a thread, a queue and a counter.
+
+namespace {
+static constexpr uint32_t CALLS{50'000'000};
+static constexpr uint32_t CONSTRUCTIONS{100'000};
+
+using Signature = void(uint32_t, common::Argument);
+using FunctionPointer = void (*)(uint32_t, common::Argument);
+using Inplace = common::InplaceFunction<Signature, 3 * sizeof(void*)>;
+using StdFunction = std::function<Signature>;
+
+/**
+ * @brief State reached through the captures
+ */
+struct Target {
+    uint64_t sum;
+};
+
+void addToTarget(uint32_t value, common::Argument arg) {
+  static_cast<Target*>(arg)->sum += value;
+}
+
+// Not inlined, the callback target is only known at run time
+template <typename Callback>
+__attribute__((noinline)) void dispatch(const Callback& cb,
+                                        common::Argument arg) {
+  for (uint32_t i = 0; i < CALLS; ++i) {
+    cb(i, arg);
+  }
+}
+
+template <typename Callback> Callback makeCallback(Target& target) {
+  Target* first = &target;
+  Target* second = &target;
+  Target* third = &target;
+  return [first, second, third](uint32_t value, common::Argument) {
+    (value & 1 ? first : value & 2 ? second : third)->sum += value;
+  };
+}
+
+/**
+ * @brief Call a callback CALLS times and print the time per call and the
+ * heap allocations of creating it.
+ */
+template <typename Callback>
+void run(const char* name, Callback (*create)(Target&)) {
+  Target target{};
+  uint32_t allocations{0};
+  {
+    sw::AllocationGuard guard{"callback construction"};
+    for (uint32_t i = 0; i < CONSTRUCTIONS; ++i) {
+      Callback cb = create(target);
+      Callback moved = std::move(cb);
+      moved(i, &target);
+    }
+    allocations = guard.getAllocations();
+  }
+
+  Callback cb = create(target);
+  uint32_t dispatchAllocations{0};
+  const auto start = std::chrono::steady_clock::now();
+  {
+    sw::AllocationGuard guard{"callback dispatch"};
+    dispatch(cb, &target);
+    dispatchAllocations = guard.getAllocations();
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  const double ns =
+      std::chrono::duration<double, std::nano>(end - start).count();
+  std::printf("%-22s %6.2f ns/call  %8.3f allocs/construction  %u allocs "
+              "in dispatch  (sum %llu)\n",
+              name, ns / CALLS,
+              static_cast<double>(allocations) / CONSTRUCTIONS,
+              dispatchAllocations,
+              static_cast<unsigned long long>(target.sum));
+}
+} // namespace
+
+int main() {
+  run<FunctionPointer>("function pointer + arg",
+                       [](Target&) -> FunctionPointer { return addToTarget; });
+  run<Inplace>("InplaceFunction", makeCallback<Inplace>);
+  run<StdFunction>("std::function", makeCallback<StdFunction>);
+  return EXIT_SUCCESS;
+}
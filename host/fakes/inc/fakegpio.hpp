@@ -0,0 +1,114 @@
+#pragma once
+
+#include "igpio.hpp"
+#include "types.hpp"
+#include <mutex>
+
+namespace hw {
+namespace fake {
+/**
+ * @class Gpio
+ * @brief Gpio without a pin. An output keeps the level it was set to, an
+ * input is driven by a simulated device with drive().
+ *
+ * The interrupt callback is called from the thread calling drive(), where an
+ * ISR would run on the target.
+ */
+class Gpio final : public IGpio {
+  public:
+    /**
+     * @brief Construct a new Gpio object.
+     *
+     * @param number Gpio number, only reported back.
+     */
+    explicit Gpio(const GpioNumber number);
+
+    /**
+     * @brief Set gpio mode.
+     *
+     * @param mode Gpio mode.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     */
+    common::Error setMode(const GpioMode mode) override;
+
+    /**
+     * @brief Set gpio level.
+     *
+     * @param level Gpio level.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_STATE: Gpio is not set in output mode.
+     */
+    common::Error setLevel(const GpioLevel level) override;
+
+    /**
+     * @brief Pull resistors have no effect.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     */
+    common::Error configurePullUpDown(const bool pullUpEnable,
+                                      const bool pullDownEnable) override;
+
+    /**
+     * @brief Get gpio level.
+     *
+     * @return Gpio level.
+     */
+    GpioLevel getLevel() const override;
+
+    /**
+     * @brief Get gpio number.
+     *
+     * @return GpioNumber Gpio number.
+     */
+    GpioNumber getNumber() const override;
+
+    /**
+     * @brief Set interrupt.
+     *
+     * @param interruptType Interrupt type.
+     * @param interruptCallback Interrupt callback.
+     * @param callbackData Interrupt callback data.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     */
+    common::Error setInterrupt(const GpioInterruptType interruptType,
+                               common::Callback interruptCallback,
+                               common::Argument callbackData) override;
+
+    /**
+     * @brief Is gpio assigned.
+     *
+     * @return Always true.
+     */
+    bool isGpioAssigned() const override;
+
+    /**
+     * @brief Drive the level of an input, as the connected device would.
+     *
+     * @param level Gpio level.
+     */
+    void drive(const GpioLevel level);
+
+  private:
+    /**
+     * @brief Check if a level change triggers the interrupt.
+     */
+    bool isInterruptTriggered_(const GpioLevel previous,
+                               const GpioLevel level) const;
+
+    const GpioNumber number_;
+    mutable std::mutex mutex_;
+    GpioMode mode_{GpioMode::DISABLE};
+    GpioLevel level_{GpioLevel::LOW};
+    GpioInterruptType interruptType_{GpioInterruptType::DISABLE};
+    common::Callback interruptCallback_{nullptr};
+    common::Argument callbackData_{nullptr};
+};
+} // namespace fake
+} // namespace hw
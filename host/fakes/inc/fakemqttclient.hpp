@@ -0,0 +1,214 @@
+#pragma once
+
+#include "imqttclient.hpp"
+#include "latencyhistogram.hpp"
+#include "metrics.hpp"
+#include "subscriptiontable.hpp"
+#include "types.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+
+namespace net {
+namespace fake {
+/**
+ * @class MqttClient
+ * @brief MQTT client with a broker stand-in, messages are logged and
+ * counted instead of sent.
+ *
+ * QoS1 messages take a slot of the in-flight window until their PUBACK,
+ * which arrives after the set delay on the next yield(). The socket is a
+ * timerfd, it turns readable when a PUBACK or an injected message is due,
+ * so the caller waits on it like on a real connection.
+ */
+class MqttClient final : public IMqttClient {
+  public:
+    /**
+     * @brief Message counters
+     */
+    struct Stats {
+        uint32_t published;    // Messages taken for publishing
+        uint32_t acknowledged; // QoS1 messages completed with PUBACK
+        uint32_t delivered;    // Injected messages passed to subscribers
+    };
+
+    // Same as the default window of the AWS IoT client
+    static constexpr uint8_t IN_FLIGHT_WINDOW{4};
+    static constexpr size_t MAX_SUBSCRIPTIONS{8};
+    static constexpr size_t MAX_PAYLOAD_SIZE{256};
+
+    /**
+     * @brief Construct a new MqttClient object.
+     *
+     * @param ackDelayMs Time from publish to PUBACK, the broker round trip.
+     */
+    explicit MqttClient(const common::Time ackDelayMs = 0);
+
+    /**
+     * @brief Destroy the MqttClient object, closes the socket.
+     */
+    ~MqttClient();
+
+    /**
+     * @brief Creates the socket.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error init();
+
+    /**
+     * @brief Queues a message from the broker, it is passed to the matching
+     * subscriptions on the next yield().
+     * @note Safe to call from another thread.
+     *
+     * @param topic Topic, it is copied.
+     * @param payload Payload, it is copied.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Topic or payload too long.
+     *   - common::Error::INVALID_STATE: Not initialized.
+     *   - common::Error::NO_MEM: Previous message not delivered yet.
+     */
+    common::Error injectMessage(const std::string_view topic,
+                                const std::string_view payload);
+
+    /**
+     * @brief Gets message counters.
+     * @note Safe to call from another thread.
+     *
+     * @return Counters since start.
+     */
+    Stats getStats() const;
+
+    void setDisconnectCallback(disconnectCallback cb,
+                               common::Argument arg) override;
+
+    common::Error subscribe(const std::string_view& topic, const Qos qos,
+                            subscribeCallback cb,
+                            common::Argument arg) override;
+
+    common::Error connect() override;
+
+    /**
+     * @brief Drops the connection, messages in flight are given up.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     */
+    common::Error disconnect() override;
+
+    common::Error publish(const std::string_view& topic, char* payload,
+                          size_t payloadSize, const Qos qos) override;
+
+    common::Error publishAsync(const std::string_view& topic,
+                               const char* payload, size_t payloadSize,
+                               const Qos qos, publishCallback cb,
+                               common::Argument arg,
+                               uint16_t& packetId) override;
+
+    uint8_t getFreeInFlightSlots() const override;
+
+    /**
+     * @brief Completes messages whose PUBACK is due and delivers an
+     * injected message.
+     */
+    void yield() override;
+
+    int getSocket() override;
+
+    bool hasPendingData() override;
+
+    TlsStats getTlsStats() const override;
+
+    RttStats getRttStats() const override;
+
+    void resetRttStats() override;
+
+    sw::LatencyHistogram::Snapshot getPublishLatency() const override;
+
+    common::Error
+    registerMetrics(sw::metrics::Registry& registry) const override;
+
+  private:
+    /**
+     * @brief Message waiting for PUBACK.
+     */
+    struct InFlightMessage {
+        bool isUsed;
+        uint16_t packetId;
+        uint64_t publishedUs;
+        publishCallback cb;
+        common::Argument arg;
+    };
+
+    /**
+     * @brief Message from the broker waiting for yield().
+     */
+    struct InjectedMessage {
+        bool isPending;
+        std::array<char, MAX_TOPIC_SIZE> topic;
+        size_t topicLength;
+        std::array<char, MAX_PAYLOAD_SIZE> payload;
+        size_t payloadLength;
+    };
+
+    /**
+     * @brief Completes messages whose PUBACK is due.
+     */
+    void completeDue_();
+
+    /**
+     * @brief Passes an injected message to the matching subscriptions.
+     */
+    void deliverInjected_();
+
+    /**
+     * @brief Makes the socket readable when the next PUBACK or an injected
+     * message is due.
+     */
+    void arm_();
+
+    /**
+     * @brief Makes the socket readable at once.
+     * @note Caller holds injectedMutex_, so arm_() can't undo it.
+     */
+    void wakeUp_();
+
+    /**
+     * @brief Logs a message as the broker would receive it.
+     */
+    void log_(const std::string_view topic, const char* payload,
+              const size_t payloadSize, const Qos qos);
+
+    using Subscriptions =
+        app::SubscriptionTable<subscribeCallback, MAX_SUBSCRIPTIONS,
+                               MAX_TOPIC_SIZE>;
+
+    uint64_t ackDelayUs_;
+    int timerFd_{-1};
+    bool isConnected_{false};
+    uint16_t nextPacketId_{1};
+    uint32_t connects_{0};
+    disconnectCallback disconnectCb_{nullptr};
+    common::Argument disconnectArg_{nullptr};
+    Subscriptions subscriptions_{};
+    std::array<InFlightMessage, IN_FLIGHT_WINDOW> inFlight_{};
+    std::mutex injectedMutex_{};
+    InjectedMessage injected_{};
+    InjectedMessage delivering_{}; // Copy passed to subscribers unlocked
+    RttStats rttStats_{};
+    sw::LatencyHistogram publishLatency_{};
+    sw::metrics::Counter publishRetries_{};
+    sw::metrics::Counter publishFails_{};
+    std::atomic<uint32_t> published_{0};
+    std::atomic<uint32_t> acknowledged_{0};
+    std::atomic<uint32_t> delivered_{0};
+};
+} // namespace fake
+} // namespace net
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "ii2c.hpp"
+#include "types.hpp"
+#include <array>
+#include <mutex>
+
+namespace hw {
+namespace fake {
+/**
+ * @class Sht40
+ * @brief I2C bus with a simulated SHT40 sensor.
+ *
+ * A measurement command latches the current air values, the next read
+ * returns them in the sensor format with CRC. Air drifts slowly around the
+ * base values with a bit of noise, so every sample differs.
+ */
+class Sht40 final : public II2c {
+  public:
+    /**
+     * @brief Simulated air
+     */
+    struct Settings {
+        float temperatureC; // Mean temperature
+        float humidityRh;   // Mean relative humidity
+        float swingC;       // Amplitude of the temperature drift
+        float swingRh;      // Amplitude of the humidity drift
+        common::Time periodMs; // Period of the drift
+    };
+
+    /**
+     * @brief Construct a new Sht40 object.
+     *
+     * @param settings Simulated air.
+     */
+    explicit Sht40(const Settings settings);
+
+    /**
+     * @brief Write a command to the sensor.
+     *
+     * @param deviceAddress Device address.
+     * @param command Reset or measurement command.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Wrong address or unknown command.
+     */
+    common::Error write(const uint8_t deviceAddress,
+                        const uint8_t command) override;
+
+    /**
+     * @brief The sensor has no registers.
+     *
+     * @return
+     *   - common::Error::FAIL: Always.
+     */
+    common::Error write(const uint8_t deviceAddress,
+                        const uint8_t registerAddress, const uint8_t* buffer,
+                        const size_t bufferLength) override;
+
+    /**
+     * @brief Read the latched measurement.
+     *
+     * @param deviceAddress Device address.
+     * @param buffer Buffer for temperature and humidity words with CRC.
+     * @param bufferLength Buffer length, at most 6 bytes.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Buffer is too long.
+     *   - common::Error::FAIL: Wrong address or no measurement taken.
+     */
+    common::Error read(const uint8_t deviceAddress, uint8_t* buffer,
+                       const size_t bufferLength) override;
+
+  private:
+    /**
+     * @brief Convert air values to the sensor format.
+     */
+    void latchMeasurement_();
+
+    /**
+     * @brief Add a word and its CRC to the measurement.
+     */
+    void setWord_(const size_t offset, const uint16_t word);
+
+    /**
+     * @brief CRC-8 of a word, polynomial 0x31, initial value 0xFF.
+     */
+    static uint8_t getCrc_(const uint16_t word);
+
+    static constexpr uint8_t ADDRESS{0x44};
+    static constexpr uint8_t RESET_COMMAND{0x94};
+    static constexpr size_t MEASUREMENT_SIZE{6};
+    Settings settings_;
+    std::mutex mutex_;
+    std::array<uint8_t, MEASUREMENT_SIZE> measurement_{};
+    bool isMeasured_{false};
+};
+} // namespace fake
+} // namespace hw
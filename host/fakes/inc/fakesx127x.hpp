@@ -0,0 +1,211 @@
+#pragma once
+
+#include "fakegpio.hpp"
+#include "ispi.hpp"
+#include "timer.hpp"
+#include "types.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace hw {
+namespace fake {
+/**
+ * @class Sx127x
+ * @brief SPI bus with a simulated SX127x modem in LoRa mode, the air is UDP on
+ * localhost.
+ *
+ * Each node listens on basePort + nodeId and sends its frames to the ports of
+ * all other nodes. A frame is received when the receiver is in continuous RX
+ * from its start to its end and frequency, bandwidth, spreading factor and
+ * sync word match. Overlapping frames are lost, channel activity detection
+ * reports a frame on air. TX_DONE and RX_DONE are raised once the time on air
+ * has passed and signalled on DIO0 as mapped.
+ */
+class Sx127x final : public ISpi {
+  public:
+    /**
+     * @brief Configuration structure for Sx127x.
+     */
+    struct Config {
+        Gpio& dio0;
+        uint8_t nodeId;    // 0 for the hub, controller ID otherwise
+        uint16_t basePort; // UDP port of node 0
+    };
+
+    /**
+     * @brief Frame counters
+     */
+    struct Stats {
+        uint32_t sent;       // Frames transmitted
+        uint32_t received;   // Frames passed to the driver
+        uint32_t collisions; // Frames lost to another frame on air
+        uint32_t missed;     // Frames lost, not listening or other settings
+    };
+
+    static constexpr uint16_t DEFAULT_BASE_PORT{47800};
+    static constexpr uint8_t MAX_NODES{9}; // Hub and up to 8 controllers
+
+    /**
+     * @brief Construct a new Sx127x object.
+     *
+     * @param config Configuration for the Sx127x.
+     */
+    explicit Sx127x(Config config);
+
+    /**
+     * @brief Destroy the Sx127x object, stops the receiver.
+     */
+    ~Sx127x();
+
+    /**
+     * @brief Open the UDP socket and start the receiver.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Node ID out of range.
+     *   - common::Error::FAIL: Socket or timer setup failed, port may be
+     *     used by another node with the same ID.
+     */
+    common::Error init();
+
+    /**
+     * @brief Write modem registers, bit 7 of the address is ignored.
+     *
+     * @param deviceHandle Unused, the bus has one device.
+     * @param registerAddress First register.
+     * @param buffer Data written, FIFO data is written at the FIFO pointer.
+     * @param bufferLength Data length.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Buffer is null or past last register.
+     */
+    common::Error write(SpiDeviceHandle& deviceHandle,
+                        const uint8_t registerAddress, const uint8_t* buffer,
+                        const size_t bufferLength) override;
+
+    /**
+     * @brief Read modem registers.
+     *
+     * @param deviceHandle Unused, the bus has one device.
+     * @param registerAddress First register.
+     * @param buffer Buffer for the data, FIFO data is read at the FIFO
+     * pointer.
+     * @param bufferLength Data length.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Buffer is null or past last register.
+     */
+    common::Error read(SpiDeviceHandle& deviceHandle,
+                       const uint8_t registerAddress, uint8_t* buffer,
+                       const size_t bufferLength) override;
+
+    /**
+     * @brief Get frame counters.
+     *
+     * @return Counters since init.
+     */
+    Stats getStats() const;
+
+  private:
+    /**
+     * @brief Frame as sent over UDP
+     */
+    struct __attribute__((packed)) AirFrame {
+        uint64_t startUs; // Monotonic clock, shared by processes on one host
+        uint32_t timeOnAirUs;
+        std::array<uint8_t, 3> frf;
+        uint8_t modemConfig1;
+        uint8_t modemConfig2;
+        uint8_t syncWord;
+        uint8_t length;
+        std::array<uint8_t, UINT8_MAX> payload;
+    };
+
+    /**
+     * @brief Frame being received
+     */
+    struct Reception {
+        bool isPending;
+        bool isCollided;
+        AirFrame frame;
+    };
+
+    /**
+     * @brief Receives frames until stopped.
+     */
+    void receiveLoop_();
+
+    /**
+     * @brief Starts receiving a frame, it is lost if it overlaps another.
+     */
+    void handleFrame_(const AirFrame& frame);
+
+    /**
+     * @brief Completes the reception when the frame is over.
+     */
+    void finishRx_();
+
+    /**
+     * @brief Completes the transmission when the frame is over.
+     */
+    void finishTx_();
+
+    void writeRegister_(const uint8_t address, const uint8_t value);
+
+    uint8_t readRegister_(const uint8_t address) const;
+
+    /**
+     * @brief Apply an operating mode written to OP_MODE.
+     */
+    void setMode_(const uint8_t value);
+
+    /**
+     * @brief Send the frame in the FIFO to the other nodes.
+     *
+     * @return Time on air of the frame in microseconds.
+     */
+    uint32_t startTx_();
+
+    /**
+     * @brief Time on air of a payload with the current modem settings.
+     */
+    uint32_t getTimeOnAirUs_(const uint8_t payloadLength) const;
+
+    /**
+     * @brief Check if a frame can be received with the current settings.
+     */
+    bool isMatch_(const AirFrame& frame) const;
+
+    /**
+     * @brief Set DIO0 from the IRQ flags and DIO mapping.
+     */
+    void updateDio0_();
+
+    uint8_t getMode_() const;
+
+    static uint64_t getMonotonicUs_();
+
+    static constexpr size_t REGISTER_COUNT{0x80};
+    static constexpr size_t FIFO_SIZE{256};
+    static constexpr common::Time RECEIVE_POLL_MS{100};
+    Config config_;
+    mutable std::mutex mutex_;
+    std::array<uint8_t, REGISTER_COUNT> registers_{};
+    std::array<uint8_t, FIFO_SIZE> fifo_{};
+    uint8_t irqFlags_{0};
+    uint64_t channelBusyUntilUs_{0};
+    Reception reception_{};
+    Stats stats_{};
+    timer::sw::Timer txTimer_;
+    timer::sw::Timer rxTimer_;
+    int socket_{-1};
+    std::atomic<bool> isRunning_{false};
+    std::thread receiver_;
+};
+} // namespace fake
+} // namespace hw
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "iflash.hpp"
+#include "types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace storage {
+namespace fake {
+/**
+ * @class FileFlash
+ * @brief NOR flash area kept in a file, so its contents survive a restart of
+ * the process like a partition survives a reboot.
+ *
+ * Writes behave like on flash: bits can only be cleared, erasing a sector
+ * sets all of its bytes to 0xFF. A new file starts erased.
+ */
+class FileFlash final : public IFlash {
+  public:
+    static constexpr size_t DEFAULT_SECTOR_SIZE{4096};
+
+    /**
+     * @brief Construct a new FileFlash object.
+     *
+     * @param path File holding the flash contents.
+     * @param size Size of the flash area, a multiple of the sector size.
+     * @param sectorSize Erase sector size.
+     */
+    FileFlash(const std::string_view path, const size_t size,
+              const size_t sectorSize = DEFAULT_SECTOR_SIZE);
+
+    /**
+     * @brief Destroy the FileFlash object, the file is kept.
+     */
+    ~FileFlash();
+
+    FileFlash(const FileFlash&) = delete;
+    FileFlash& operator=(const FileFlash&) = delete;
+
+    /**
+     * @brief Open the file, it is created erased if it does not exist.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Size is not a multiple of sector size.
+     *   - common::Error::FAIL: File cannot be opened or resized.
+     */
+    common::Error init();
+
+    /**
+     * @brief Read data from the flash area.
+     *
+     * @param offset Offset from the area start.
+     * @param buffer Buffer for the data.
+     * @param bufferLength Number of bytes to read.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Out of the area or buffer is null.
+     *   - common::Error::INVALID_STATE: Flash is not initialized.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error read(const size_t offset, uint8_t* buffer,
+                       const size_t bufferLength) override;
+
+    /**
+     * @brief Write data to the flash area.
+     * @note Bits can only be cleared, the area must be erased before.
+     *
+     * @param offset Offset from the area start.
+     * @param data Data to write.
+     * @param dataLength Number of bytes to write.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Out of the area or data is null.
+     *   - common::Error::INVALID_STATE: Flash is not initialized.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error write(const size_t offset, const uint8_t* data,
+                        const size_t dataLength) override;
+
+    /**
+     * @brief Erase a sector of the flash area.
+     *
+     * @param offset Offset of the sector, aligned to the sector size.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Offset is misaligned or out of area.
+     *   - common::Error::INVALID_STATE: Flash is not initialized.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error eraseSector(const size_t offset) override;
+
+    /**
+     * @brief Get the flash area size.
+     *
+     * @return Size in bytes.
+     */
+    size_t getSize() const override;
+
+    /**
+     * @brief Get the erase sector size.
+     *
+     * @return Sector size in bytes.
+     */
+    size_t getSectorSize() const override;
+
+  private:
+    /**
+     * @brief Check that a range lies in the area of an open file.
+     */
+    common::Error checkRange_(const size_t offset, const size_t length) const;
+
+    std::string path_;
+    size_t size_;
+    size_t sectorSize_;
+    int fd_{-1};
+    std::mutex mutex_;
+};
+} // namespace fake
+} // namespace storage
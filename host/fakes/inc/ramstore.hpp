@@ -0,0 +1,164 @@
+#pragma once
+
+#include "istorage.hpp"
+#include "types.hpp"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace storage {
+namespace fake {
+/**
+ * @class RamStore
+ * @brief Key-value storage in RAM, contents are lost when the process exits.
+ *
+ * Items are typed like in NVS, reading a key with another type than it was
+ * written with fails.
+ */
+class RamStore final : public IStorage {
+  public:
+    RamStore() = default;
+
+    using IStorage::getBlob;
+    using IStorage::setBlob;
+
+    /**
+     * @brief Set a uint8_t item.
+     *
+     * @param key Item key.
+     * @param item Item value.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     */
+    common::Error setItem(const std::string_view& key,
+                          const uint8_t& item) override;
+
+    /**
+     * @brief Get a uint8_t item.
+     *
+     * @param key Item key.
+     * @param item Item value.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NOT_FOUND: No item of this type under the key.
+     */
+    common::Error getItem(const std::string_view& key, uint8_t& item) override;
+
+    /**
+     * @brief Set a uint32_t item.
+     *
+     * @param key Item key.
+     * @param item Item value.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     */
+    common::Error setItem(const std::string_view& key,
+                          const uint32_t& item) override;
+
+    /**
+     * @brief Get a uint32_t item.
+     *
+     * @param key Item key.
+     * @param item Item value.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NOT_FOUND: No item of this type under the key.
+     */
+    common::Error getItem(const std::string_view& key,
+                          uint32_t& item) override;
+
+    /**
+     * @brief Set a string.
+     *
+     * @param key String key.
+     * @param string String value.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     */
+    common::Error setString(const std::string_view& key,
+                            const std::string& string) override;
+
+    /**
+     * @brief Get a string.
+     *
+     * @param key String key.
+     * @param string String value.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NOT_FOUND: No string under the key.
+     */
+    common::Error getString(const std::string_view& key,
+                            std::string& string) override;
+
+    /**
+     * @brief Set a blob.
+     *
+     * @param key Blob key.
+     * @param data Blob data.
+     * @param size Blob size.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Data is null.
+     */
+    common::Error setBlob(const std::string_view& key, const void* data,
+                          const size_t size) override;
+
+    /**
+     * @brief Get a blob.
+     *
+     * @param key Blob key.
+     * @param data Buffer for blob data.
+     * @param size Expected blob size.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Data is null or size is 0.
+     *   - common::Error::NOT_FOUND: No blob of this size under the key.
+     */
+    common::Error getBlob(const std::string_view& key, void* data,
+                          const size_t size) override;
+
+    /**
+     * @brief Items are stored on set, nothing to commit.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     */
+    common::Error save() override;
+
+  private:
+    enum class Type : uint8_t { U8, U32, STRING, BLOB };
+
+    struct Item {
+        Type type;
+        std::vector<uint8_t> data;
+    };
+
+    /**
+     * @brief Store item data under a key.
+     */
+    void set_(const std::string_view& key, const Type type, const void* data,
+              const size_t size);
+
+    /**
+     * @brief Find an item of a type.
+     *
+     * @return Item, nullptr if not found.
+     */
+    const Item* find_(const std::string_view& key, const Type type) const;
+
+    std::mutex mutex_;
+    std::map<std::string, Item, std::less<>> items_;
+};
+} // namespace fake
+} // namespace storage
@@ -0,0 +1,343 @@
+#pragma once
+
+#include "imqttclient.hpp"
+#include "inflightwindow.hpp"
+#include "latencyhistogram.hpp"
+#include "metrics.hpp"
+#include "mqttpacket.hpp"
+#include "subscriptiontable.hpp"
+#include "types.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <openssl/ssl.h>
+#include <string_view>
+
+namespace net {
+namespace fake {
+/**
+ * @class SocketMqttClient
+ * @brief MQTT 3.1.1 client on a TCP socket, optionally TLS, the host
+ * counterpart of app::AwsIotClient.
+ *
+ * PUBLISH encoding and the in-flight window are the ones of the AWS IoT
+ * client, only the transport is OpenSSL instead of the SDK on mbedTLS. The
+ * client is used against the broker stand-in of host/mqtt-broker.
+ *
+ * Like on the hub, the TLS session is kept over reconnects and offered again,
+ * so the broker can resume it. Handshake heap is sampled between handshake
+ * messages, as AwsIotClient does in its socket callbacks. PINGREQ is sent
+ * every keep alive interval, also while messages wait for PUBACK.
+ */
+class SocketMqttClient final : public IMqttClient {
+  public:
+    /**
+     * @brief Broker address and TLS credentials.
+     */
+    struct Settings {
+        const char* host;
+        uint16_t port;
+        const char* caFile;   // Plain TCP if nullptr
+        const char* certFile; // Client certificate, may be nullptr
+        const char* keyFile;  // Key of the client certificate
+    };
+
+    /**
+     * @brief Handshake statistics of one handshake kind.
+     */
+    struct HandshakeStats {
+        uint32_t count;
+        common::Time totalMs;
+        uint32_t maxPeakHeap;
+    };
+
+    /**
+     * @brief Message and connection counters
+     */
+    struct Stats {
+        uint32_t published;     // Messages written to the socket
+        uint32_t acknowledged;  // QoS1 messages completed with PUBACK
+        uint32_t delivered;     // Messages passed to subscribers
+        uint32_t pings;         // PINGREQ sent
+        uint32_t pingsInFlight; // PINGREQ sent with messages in flight
+        uint32_t pingResponses; // PINGRESP received
+        HandshakeStats fullHandshakes;
+        HandshakeStats resumedHandshakes;
+    };
+
+    static constexpr size_t MAX_SUBSCRIPTIONS{8};
+
+    /**
+     * @brief Construct a new SocketMqttClient object.
+     *
+     * @param clientId The unique client ID for the MQTT connection.
+     * @param settings Broker address and TLS credentials.
+     */
+    SocketMqttClient(const std::string_view clientId, const Settings settings);
+
+    /**
+     * @brief Destroy the SocketMqttClient object, closes the connection.
+     */
+    ~SocketMqttClient();
+
+    /**
+     * @brief Loads the TLS credentials.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Credentials can't be loaded.
+     */
+    common::Error init();
+
+    /**
+     * @brief Gets message and connection counters.
+     * @note Safe to call from another thread.
+     *
+     * @return Counters since start.
+     */
+    Stats getStats() const;
+
+    void setDisconnectCallback(disconnectCallback cb,
+                               common::Argument arg) override;
+
+    /**
+     * @brief Subscribes to a topic, SUBSCRIBE is sent right away when
+     * connected and on every connect. Subscribing to a topic again only
+     * replaces its callback.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Invalid or too long topic filter.
+     *   - common::Error::NO_MEM: Subscription table is full.
+     *   - common::Error::FAIL: SUBSCRIBE not acknowledged.
+     */
+    common::Error subscribe(const std::string_view& topic, const Qos qos,
+                            subscribeCallback cb,
+                            common::Argument arg) override;
+
+    /**
+     * @brief Connects to the broker, subscribes to every topic in the table
+     * again and sends the in-flight messages again.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error connect() override;
+
+    common::Error disconnect() override;
+
+    /**
+     * @brief Publishes a message, QoS1 blocks until PUBACK.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Invalid payload.
+     *   - common::Error::INVALID_STATE: Not connected or asynchronous
+     * messages in flight.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error publish(const std::string_view& topic, char* payload,
+                          size_t payloadSize, const Qos qos) override;
+
+    common::Error publishAsync(const std::string_view& topic,
+                               const char* payload, size_t payloadSize,
+                               const Qos qos, publishCallback cb,
+                               common::Argument arg,
+                               uint16_t& packetId) override;
+
+    uint8_t getFreeInFlightSlots() const override;
+
+    /**
+     * @brief Reads what arrived, sends PINGREQ when the keep alive interval
+     * expired and handles PUBACK timeouts. A broken connection is closed and
+     * reported to the disconnect callback.
+     */
+    void yield() override;
+
+    int getSocket() override;
+
+    bool hasPendingData() override;
+
+    TlsStats getTlsStats() const override;
+
+    RttStats getRttStats() const override;
+
+    void resetRttStats() override;
+
+    sw::LatencyHistogram::Snapshot getPublishLatency() const override;
+
+    common::Error
+    registerMetrics(sw::metrics::Registry& registry) const override;
+
+  private:
+    template <typename T, void (*FREE)(T*)> struct Deleter {
+        void operator()(T* object) const { FREE(object); }
+    };
+    using TlsContext =
+        std::unique_ptr<SSL_CTX, Deleter<SSL_CTX, SSL_CTX_free>>;
+    using Tls = std::unique_ptr<SSL, Deleter<SSL, SSL_free>>;
+    using TlsSession =
+        std::unique_ptr<SSL_SESSION, Deleter<SSL_SESSION, SSL_SESSION_free>>;
+    using Subscriptions =
+        app::SubscriptionTable<subscribeCallback, MAX_SUBSCRIPTIONS,
+                               MAX_TOPIC_SIZE>;
+
+    /**
+     * @brief Acknowledgment a blocking call waits for.
+     */
+    struct ExpectedAck {
+        mqtt::PacketType type;
+        uint16_t packetId;
+        uint8_t returnCode;
+        bool isReceived;
+    };
+
+    static constexpr common::Time COMMAND_TIMEOUT_MS{5000};
+    // Largest packet from the broker, e.g. a shadow delta
+    static constexpr size_t RX_BUFFER_SIZE{2048};
+    static constexpr size_t PUBLISH_PACKET_SIZE{
+        InFlightWindow::PAYLOAD_SIZE + MAX_TOPIC_SIZE +
+        mqtt::MAX_FIXED_HEADER_SIZE + 2 * sizeof(uint16_t)};
+
+    /**
+     * @brief Opens the TCP connection and does the TLS handshake.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error open_();
+
+    /**
+     * @brief Does the TLS handshake, offers the cached session.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error handshake_();
+
+    /**
+     * @brief Closes the connection, the TLS session stays cached.
+     */
+    void close_();
+
+    /**
+     * @brief Closes the connection and calls the disconnect callback.
+     */
+    void drop_();
+
+    /**
+     * @brief Writes the whole buffer to the connection.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Connection error.
+     */
+    common::Error write_(const uint8_t* buffer, const size_t length);
+
+    /**
+     * @brief Reads what the connection has and handles complete packets.
+     *
+     * @return
+     *   - common::Error::OK: Success, also if nothing arrived.
+     *   - common::Error::FAIL: Connection closed or protocol error.
+     */
+    common::Error read_();
+
+    /**
+     * @brief Handles one packet from the broker.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Invalid packet.
+     */
+    common::Error handlePacket_(const uint8_t* packet, const size_t length);
+
+    /**
+     * @brief Reads until the expected acknowledgment arrives.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Not received in time or connection error.
+     */
+    common::Error waitForAck_(const mqtt::PacketType type,
+                              const uint16_t packetId);
+
+    /**
+     * @brief Sends SUBSCRIBE and waits for SUBACK.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail or refused.
+     */
+    common::Error sendSubscribe_(const Subscriptions::Entry& entry);
+
+    /**
+     * @brief Writes a QoS1 PUBLISH packet of an in-flight message.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::NO_MEM: Packet does not fit the buffer.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error sendPublish_(const InFlightWindow::Message& message,
+                               const bool isDuplicate);
+
+    /**
+     * @brief Sends PINGREQ when the keep alive interval expired.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Previous PINGREQ not answered or send fail.
+     */
+    common::Error keepAlive_();
+
+    /**
+     * @brief Gets the next packet ID not in flight, never 0.
+     */
+    uint16_t nextPacketId_();
+
+    /**
+     * @brief Handshake message callback, keeps the free heap watermark.
+     */
+    static void onHandshakeMessage_(int writeP, int version, int contentType,
+                                    const void* buffer, size_t length,
+                                    SSL* ssl, void* arg);
+
+    std::string_view clientId_;
+    Settings settings_;
+    Subscriptions subscriptions_{};
+    disconnectCallback disconnectCb_{nullptr};
+    common::Argument disconnectArg_{nullptr};
+    int socket_{-1};
+    bool isConnected_{false};
+    TlsContext tlsContext_{};
+    Tls tls_{};
+    TlsSession tlsSession_{};
+    uint32_t lowestFreeHeap_{0};
+    TlsStats tlsStats_{};
+    std::array<uint8_t, RX_BUFFER_SIZE> rxBuffer_{};
+    size_t rxLength_{0};
+    std::array<uint8_t, PUBLISH_PACKET_SIZE> txBuffer_{};
+    uint16_t packetId_{0};
+    ExpectedAck expectedAck_{};
+    common::Time lastPingMs_{0};
+    bool isPingOutstanding_{false};
+    InFlightWindow inFlight_;
+    std::atomic<uint32_t> published_{0};
+    std::atomic<uint32_t> acknowledged_{0};
+    std::atomic<uint32_t> delivered_{0};
+    std::atomic<uint32_t> pings_{0};
+    std::atomic<uint32_t> pingsInFlight_{0};
+    std::atomic<uint32_t> pingResponses_{0};
+    mutable std::mutex handshakeMutex_;
+    HandshakeStats fullHandshakes_{};
+    HandshakeStats resumedHandshakes_{};
+};
+} // namespace fake
+} // namespace net
@@ -0,0 +1,86 @@
+#include "fakegpio.hpp"
+
+namespace hw {
+namespace fake {
+Gpio::Gpio(const GpioNumber number) : number_{number} {}
+
+common::Error Gpio::setMode(const GpioMode mode) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  mode_ = mode;
+  return common::Error::OK;
+}
+
+common::Error Gpio::setLevel(const GpioLevel level) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (mode_ != GpioMode::OUTPUT) {
+    return common::Error::INVALID_STATE;
+  }
+
+  level_ = level;
+  return common::Error::OK;
+}
+
+common::Error Gpio::configurePullUpDown(const bool pullUpEnable,
+                                        const bool pullDownEnable) {
+  (void)pullUpEnable;
+  (void)pullDownEnable;
+  return common::Error::OK;
+}
+
+GpioLevel Gpio::getLevel() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return level_;
+}
+
+GpioNumber Gpio::getNumber() const { return number_; }
+
+common::Error Gpio::setInterrupt(const GpioInterruptType interruptType,
+                                 common::Callback interruptCallback,
+                                 common::Argument callbackData) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  interruptType_ = interruptType;
+  interruptCallback_ = interruptCallback;
+  callbackData_ = callbackData;
+  return common::Error::OK;
+}
+
+bool Gpio::isGpioAssigned() const { return true; }
+
+void Gpio::drive(const GpioLevel level) {
+  common::Callback callback{nullptr};
+  common::Argument callbackData{nullptr};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    const GpioLevel previous = level_;
+    level_ = level;
+    if (mode_ != GpioMode::INPUT || interruptCallback_ == nullptr ||
+        not isInterruptTriggered_(previous, level)) {
+      return;
+    }
+
+    callback = interruptCallback_;
+    callbackData = callbackData_;
+  }
+
+  callback(callbackData);
+}
+
+bool Gpio::isInterruptTriggered_(const GpioLevel previous,
+                                 const GpioLevel level) const {
+  switch (interruptType_) {
+  case GpioInterruptType::RISING_EDGE:
+    return previous == GpioLevel::LOW && level == GpioLevel::HIGH;
+  case GpioInterruptType::FALLING_EDGE:
+    return previous == GpioLevel::HIGH && level == GpioLevel::LOW;
+  case GpioInterruptType::RISING_AND_FALLING_EDGE:
+    return previous != level;
+  case GpioInterruptType::LOW_LEVEL:
+    return level == GpioLevel::LOW;
+  case GpioInterruptType::HIGH_LEVEL:
+    return level == GpioLevel::HIGH;
+  default:
+    return false;
+  }
+}
+} // namespace fake
+} // namespace hw
@@ -0,0 +1,324 @@
+#include "fakemqttclient.hpp"
+#include "esp_log.h"
+#include "uptime.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+static constexpr std::string_view TAG{"MQTT"};
+} // namespace
+
+namespace net {
+namespace fake {
+MqttClient::MqttClient(const common::Time ackDelayMs)
+    : ackDelayUs_{common::utils::msToUs<uint64_t, uint64_t>(ackDelayMs)} {}
+
+MqttClient::~MqttClient() {
+  if (timerFd_ >= 0) {
+    close(timerFd_);
+  }
+}
+
+common::Error MqttClient::init() {
+  if (timerFd_ >= 0) {
+    return common::Error::OK;
+  }
+
+  timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  return timerFd_ >= 0 ? common::Error::OK : common::Error::FAIL;
+}
+
+common::Error MqttClient::injectMessage(const std::string_view topic,
+                                        const std::string_view payload) {
+  if (topic.size() >= injected_.topic.size() ||
+      payload.size() > injected_.payload.size()) {
+    return common::Error::INVALID_ARG;
+  }
+
+  if (timerFd_ < 0) {
+    return common::Error::INVALID_STATE;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{injectedMutex_};
+    if (injected_.isPending) {
+      return common::Error::NO_MEM;
+    }
+
+    std::memcpy(injected_.topic.data(), topic.data(), topic.size());
+    injected_.topic[topic.size()] = '\0';
+    injected_.topicLength = topic.size();
+    std::memcpy(injected_.payload.data(), payload.data(), payload.size());
+    injected_.payloadLength = payload.size();
+    injected_.isPending = true;
+    wakeUp_();
+  }
+
+  return common::Error::OK;
+}
+
+MqttClient::Stats MqttClient::getStats() const {
+  return {published_.load(std::memory_order_relaxed),
+          acknowledged_.load(std::memory_order_relaxed),
+          delivered_.load(std::memory_order_relaxed)};
+}
+
+void MqttClient::setDisconnectCallback(disconnectCallback cb,
+                                       common::Argument arg) {
+  disconnectCb_ = std::move(cb);
+  disconnectArg_ = arg;
+}
+
+common::Error MqttClient::subscribe(const std::string_view& topic,
+                                    const Qos, subscribeCallback cb,
+                                    common::Argument arg) {
+  if (not Subscriptions::isValidFilter(topic) ||
+      topic.size() >= MAX_TOPIC_SIZE) {
+    return common::Error::INVALID_ARG;
+  }
+
+  if (subscriptions_.add(topic, std::move(cb), arg) == nullptr) {
+    return common::Error::NO_MEM;
+  }
+
+  ESP_LOGI(TAG.data(), "Subscribed to %.*s", static_cast<int>(topic.size()),
+           topic.data());
+  return common::Error::OK;
+}
+
+common::Error MqttClient::connect() {
+  if (timerFd_ < 0) {
+    return common::Error::INVALID_STATE;
+  }
+
+  isConnected_ = true;
+  ++connects_;
+  return common::Error::OK;
+}
+
+common::Error MqttClient::disconnect() {
+  isConnected_ = false;
+  for (InFlightMessage& message : inFlight_) {
+    if (message.isUsed) {
+      message.isUsed = false;
+      publishFails_.add();
+      if (message.cb) {
+        message.cb(message.packetId, common::Error::FAIL, message.arg);
+      }
+    }
+  }
+  arm_();
+  return common::Error::OK;
+}
+
+common::Error MqttClient::publish(const std::string_view& topic, char* payload,
+                                  size_t payloadSize, const Qos qos) {
+  if (payload == nullptr || payloadSize == 0) {
+    return common::Error::INVALID_ARG;
+  }
+
+  if (not isConnected_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  // Blocking QoS1 would wait for PUBACK, the stand-in acknowledges at once
+  log_(topic, payload, payloadSize, qos);
+  return common::Error::OK;
+}
+
+common::Error MqttClient::publishAsync(const std::string_view& topic,
+                                       const char* payload, size_t payloadSize,
+                                       const Qos qos, publishCallback cb,
+                                       common::Argument arg,
+                                       uint16_t& packetId) {
+  if (payload == nullptr || payloadSize == 0 ||
+      payloadSize > MAX_PAYLOAD_SIZE || topic.empty()) {
+    return common::Error::INVALID_ARG;
+  }
+
+  if (not isConnected_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  if (qos == Qos::_0) {
+    log_(topic, payload, payloadSize, qos);
+    packetId = 0;
+    if (cb) {
+      cb(packetId, common::Error::OK, arg);
+    }
+    return common::Error::OK;
+  }
+
+  auto slot = std::find_if(
+      inFlight_.begin(), inFlight_.end(),
+      [](const InFlightMessage& message) { return not message.isUsed; });
+  if (slot == inFlight_.end()) {
+    return common::Error::NO_MEM;
+  }
+
+  // Packet ID 0 is not valid for QoS1
+  packetId = nextPacketId_++;
+  if (nextPacketId_ == 0) {
+    nextPacketId_ = 1;
+  }
+
+  *slot = {true, packetId, sw::getUptimeUs(), std::move(cb), arg};
+  log_(topic, payload, payloadSize, qos);
+  arm_();
+  return common::Error::OK;
+}
+
+uint8_t MqttClient::getFreeInFlightSlots() const {
+  return static_cast<uint8_t>(
+      std::count_if(inFlight_.begin(), inFlight_.end(),
+                    [](const InFlightMessage& message) {
+                      return not message.isUsed;
+                    }));
+}
+
+void MqttClient::yield() {
+  uint64_t expirations{0};
+  if (timerFd_ < 0 ||
+      read(timerFd_, &expirations, sizeof(expirations)) < 0) {
+    // Nothing due, e.g. a yield for the keep alive
+    return;
+  }
+
+  completeDue_();
+  deliverInjected_();
+  arm_();
+}
+
+int MqttClient::getSocket() { return isConnected_ ? timerFd_ : -1; }
+
+bool MqttClient::hasPendingData() { return false; }
+
+IMqttClient::TlsStats MqttClient::getTlsStats() const {
+  // No TLS, every connect counts as a full handshake
+  return {connects_, 0, 0, 0};
+}
+
+IMqttClient::RttStats MqttClient::getRttStats() const { return rttStats_; }
+
+void MqttClient::resetRttStats() { rttStats_ = RttStats{}; }
+
+sw::LatencyHistogram::Snapshot MqttClient::getPublishLatency() const {
+  return publishLatency_.getSnapshot();
+}
+
+common::Error
+MqttClient::registerMetrics(sw::metrics::Registry& registry) const {
+  // Same metrics as the AWS IoT client
+  common::Error errorCode =
+      registry.add("mqtt.publishLatencyUs", publishLatency_);
+  if (errorCode == common::Error::OK) {
+    errorCode = registry.add("mqtt.retries", publishRetries_);
+  }
+  if (errorCode == common::Error::OK) {
+    errorCode = registry.add("mqtt.fails", publishFails_);
+  }
+  return errorCode;
+}
+
+void MqttClient::completeDue_() {
+  const uint64_t nowUs = sw::getUptimeUs();
+  for (InFlightMessage& message : inFlight_) {
+    if (not message.isUsed || nowUs < message.publishedUs + ackDelayUs_) {
+      continue;
+    }
+
+    message.isUsed = false;
+    const uint64_t latencyUs = nowUs - message.publishedUs;
+    const auto rttMs = static_cast<common::Time>(latencyUs / 1000);
+    if (rttStats_.count == 0 || rttMs < rttStats_.minMs) {
+      rttStats_.minMs = rttMs;
+    }
+    rttStats_.maxMs = std::max(rttStats_.maxMs, rttMs);
+    rttStats_.lastMs = rttMs;
+    rttStats_.totalMs += rttMs;
+    ++rttStats_.count;
+    publishLatency_.record(static_cast<uint32_t>(latencyUs));
+    acknowledged_.fetch_add(1, std::memory_order_relaxed);
+    if (message.cb) {
+      message.cb(message.packetId, common::Error::OK, message.arg);
+    }
+  }
+}
+
+void MqttClient::deliverInjected_() {
+  {
+    std::lock_guard<std::mutex> lock{injectedMutex_};
+    if (not injected_.isPending) {
+      return;
+    }
+    delivering_ = injected_;
+    injected_.isPending = false;
+  }
+
+  const std::string_view topic{delivering_.topic.data(),
+                               delivering_.topicLength};
+  const size_t matches = subscriptions_.forEachMatch(
+      topic, [this](Subscriptions::Entry& entry) {
+        if (entry.cb) {
+          entry.cb(delivering_.topic.data(),
+                   static_cast<uint16_t>(delivering_.topicLength),
+                   delivering_.payload.data(), delivering_.payloadLength,
+                   entry.arg);
+        }
+      });
+  if (matches == 0) {
+    ESP_LOGW(TAG.data(), "No subscription for %s", delivering_.topic.data());
+    return;
+  }
+  delivered_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MqttClient::arm_() {
+  constexpr uint64_t NS_PER_US{1000};
+  constexpr uint64_t NS_PER_S{1'000'000'000};
+  bool isAnyDue{false};
+  uint64_t dueUs{0};
+  for (const InFlightMessage& message : inFlight_) {
+    if (message.isUsed &&
+        (not isAnyDue || message.publishedUs + ackDelayUs_ < dueUs)) {
+      dueUs = message.publishedUs + ackDelayUs_;
+      isAnyDue = true;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock{injectedMutex_};
+  if (injected_.isPending) {
+    wakeUp_();
+    return;
+  }
+
+  // Zero disarms the timer, a message due already fires at once
+  itimerspec expiry{};
+  if (isAnyDue) {
+    const uint64_t nowUs = sw::getUptimeUs();
+    const uint64_t delayNs = dueUs > nowUs ? (dueUs - nowUs) * NS_PER_US : 1;
+    expiry.it_value.tv_sec = static_cast<time_t>(delayNs / NS_PER_S);
+    expiry.it_value.tv_nsec = static_cast<long>(delayNs % NS_PER_S);
+  }
+  timerfd_settime(timerFd_, 0, &expiry, nullptr);
+}
+
+void MqttClient::wakeUp_() {
+  // Zero disarms the timer, the shortest expiry fires at once
+  itimerspec expiry{};
+  expiry.it_value.tv_nsec = 1;
+  timerfd_settime(timerFd_, 0, &expiry, nullptr);
+}
+
+void MqttClient::log_(const std::string_view topic, const char* payload,
+                      const size_t payloadSize, const Qos qos) {
+  published_.fetch_add(1, std::memory_order_relaxed);
+  ESP_LOGI(TAG.data(), "%.*s QoS%u %.*s", static_cast<int>(topic.size()),
+           topic.data(), qos == Qos::_1 ? 1u : 0u,
+           static_cast<int>(payloadSize), payload);
+}
+} // namespace fake
+} // namespace net
@@ -0,0 +1,113 @@
+#include "fakesht40.hpp"
+#include "random.hpp"
+#include "sht40.hpp"
+#include "uptime.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace hw {
+namespace fake {
+Sht40::Sht40(const Settings settings) : settings_{settings} {}
+
+common::Error Sht40::write(const uint8_t deviceAddress,
+                           const uint8_t command) {
+  if (deviceAddress != ADDRESS) {
+    return common::Error::FAIL;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (command == RESET_COMMAND) {
+    isMeasured_ = false;
+    return common::Error::OK;
+  }
+
+  switch (static_cast<sensor::sht40::Precision>(command)) {
+  case sensor::sht40::Precision::HIGH:
+  case sensor::sht40::Precision::MEDIUM:
+  case sensor::sht40::Precision::LOW:
+    latchMeasurement_();
+    return common::Error::OK;
+  default:
+    return common::Error::FAIL;
+  }
+}
+
+common::Error Sht40::write(const uint8_t deviceAddress,
+                           const uint8_t registerAddress,
+                           const uint8_t* buffer, const size_t bufferLength) {
+  (void)deviceAddress;
+  (void)registerAddress;
+  (void)buffer;
+  (void)bufferLength;
+  return common::Error::FAIL;
+}
+
+common::Error Sht40::read(const uint8_t deviceAddress, uint8_t* buffer,
+                          const size_t bufferLength) {
+  if (deviceAddress != ADDRESS) {
+    return common::Error::FAIL;
+  }
+
+  if (buffer == nullptr || bufferLength > MEASUREMENT_SIZE) {
+    return common::Error::INVALID_ARG;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (not isMeasured_) {
+    // Sensor NACKs the read until a measurement is done
+    return common::Error::FAIL;
+  }
+
+  std::copy_n(measurement_.begin(), bufferLength, buffer);
+  isMeasured_ = false;
+  return common::Error::OK;
+}
+
+void Sht40::latchMeasurement_() {
+  constexpr float TWO_PI{6.2831853f};
+  constexpr float NOISE_STEP{0.01f};
+  constexpr uint32_t NOISE_STEPS{10};
+  constexpr float RAW_MAX{65535.0f};
+
+  const float phase =
+      TWO_PI *
+      static_cast<float>(sw::getUptimeMs() % settings_.periodMs) /
+      static_cast<float>(settings_.periodMs);
+  const auto noise = []() {
+    return NOISE_STEP *
+           (static_cast<float>(sw::random(0, 2 * NOISE_STEPS)) - NOISE_STEPS);
+  };
+  const float temperatureC =
+      settings_.temperatureC + settings_.swingC * std::sin(phase) + noise();
+  const float humidityRh =
+      settings_.humidityRh + settings_.swingRh * std::cos(phase) + noise();
+
+  // Inverse of the conversions in the datasheet
+  const float rawTemperature = (temperatureC + 45.0f) * RAW_MAX / 175.0f;
+  const float rawHumidity = (humidityRh + 6.0f) * RAW_MAX / 125.0f;
+  setWord_(0, static_cast<uint16_t>(std::clamp(rawTemperature, 0.0f, RAW_MAX)));
+  setWord_(3, static_cast<uint16_t>(std::clamp(rawHumidity, 0.0f, RAW_MAX)));
+  isMeasured_ = true;
+}
+
+void Sht40::setWord_(const size_t offset, const uint16_t word) {
+  measurement_[offset] = static_cast<uint8_t>(word >> 8);
+  measurement_[offset + 1] = static_cast<uint8_t>(word);
+  measurement_[offset + 2] = getCrc_(word);
+}
+
+uint8_t Sht40::getCrc_(const uint16_t word) {
+  constexpr uint8_t POLYNOMIAL{0x31};
+  uint8_t crc{0xFF};
+  for (const uint8_t byte :
+       {static_cast<uint8_t>(word >> 8), static_cast<uint8_t>(word)}) {
+    crc ^= byte;
+    for (uint8_t bit{0}; bit < 8; ++bit) {
+      crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ POLYNOMIAL)
+                         : static_cast<uint8_t>(crc << 1);
+    }
+  }
+  return crc;
+}
+} // namespace fake
+} // namespace hw
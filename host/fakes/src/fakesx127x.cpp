@@ -0,0 +1,414 @@
+#include "fakesx127x.hpp"
+#include "esp_log.h"
+#include "sx127xregisters.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+static constexpr std::string_view TAG{"FAKE_SX127X"};
+
+namespace mode {
+static constexpr uint8_t MASK{0b00000111};
+static constexpr uint8_t STANDBY{0b00000001};
+static constexpr uint8_t TX{0b00000011};
+static constexpr uint8_t RX_CONT{0b00000101};
+static constexpr uint8_t CAD{0b00000111};
+} // namespace mode
+
+namespace irq {
+static constexpr uint8_t RX_DONE{0b01000000};
+static constexpr uint8_t VALID_HEADER{0b00010000};
+static constexpr uint8_t TX_DONE{0b00001000};
+static constexpr uint8_t CAD_DONE{0b00000100};
+static constexpr uint8_t CAD_DETECTED{0b00000001};
+} // namespace irq
+
+namespace dio0 {
+static constexpr uint8_t SHIFT{6};
+static constexpr uint8_t RX_DONE{0b00};
+static constexpr uint8_t TX_DONE{0b01};
+static constexpr uint8_t CAD_DONE{0b10};
+} // namespace dio0
+
+// Reported for every received frame, a strong nearby signal
+static constexpr uint8_t PACKET_RSSI_VALUE{97}; // -60 dBm above 525 MHz
+static constexpr uint8_t PACKET_SNR_VALUE{38};  // 9.5 dB
+} // namespace
+
+namespace hw {
+namespace fake {
+namespace reg = sx127x::reg;
+
+Sx127x::Sx127x(Config config) : config_{config} {
+  // Reset values of the registers the drivers read back
+  registers_[reg::common::OP_MODE] = mode::STANDBY;
+  registers_[reg::common::FRF_MSB] = 0x6C;
+  registers_[reg::common::FRF_MID] = 0x80;
+  registers_[reg::common::VERSION] = 0x12;
+  registers_[reg::lora::MODEM_CONFIG_1] = 0x72;
+  registers_[reg::lora::MODEM_CONFIG_2] = 0x70;
+  registers_[reg::lora::PREAMBLE_LSB] = 0x08;
+  registers_[reg::lora::PAYLOAD_LENGTH] = 0x01;
+  registers_[reg::lora::SYNC_WORD] = 0x12;
+}
+
+Sx127x::~Sx127x() {
+  isRunning_ = false;
+  if (receiver_.joinable()) {
+    receiver_.join();
+  }
+
+  txTimer_.deinit();
+  rxTimer_.deinit();
+  if (socket_ >= 0) {
+    close(socket_);
+  }
+}
+
+common::Error Sx127x::init() {
+  if (config_.nodeId >= MAX_NODES) {
+    return common::Error::INVALID_ARG;
+  }
+
+  if (txTimer_.init() != common::Error::OK ||
+      rxTimer_.init() != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  txTimer_.setCallback(
+      [](common::Argument arg) { static_cast<Sx127x*>(arg)->finishTx_(); },
+      this);
+  rxTimer_.setCallback(
+      [](common::Argument arg) { static_cast<Sx127x*>(arg)->finishRx_(); },
+      this);
+
+  socket_ = socket(AF_INET, SOCK_DGRAM, 0);
+  if (socket_ < 0) {
+    return common::Error::FAIL;
+  }
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(config_.basePort + config_.nodeId);
+  if (bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+      0) {
+    ESP_LOGE(TAG.data(), "Port %u in use",
+             static_cast<unsigned>(config_.basePort + config_.nodeId));
+    return common::Error::FAIL;
+  }
+
+  isRunning_ = true;
+  receiver_ = std::thread{&Sx127x::receiveLoop_, this};
+  return common::Error::OK;
+}
+
+common::Error Sx127x::write(SpiDeviceHandle& deviceHandle,
+                            const uint8_t registerAddress,
+                            const uint8_t* buffer, const size_t bufferLength) {
+  (void)deviceHandle;
+  sw::trace::Scope trace{"spi write"};
+  const uint8_t address = registerAddress & 0x7F;
+  if (buffer == nullptr || (address != reg::common::FIFO &&
+                            address + bufferLength > REGISTER_COUNT)) {
+    return common::Error::INVALID_ARG;
+  }
+
+  uint32_t txTimeUs{0};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (size_t i = 0; i < bufferLength; ++i) {
+      if (address == reg::common::FIFO) {
+        fifo_[registers_[reg::lora::FIFO_ADDR_PTR]++] = buffer[i];
+        continue;
+      }
+
+      const bool isTxStarted = address + i == reg::common::OP_MODE &&
+                               (buffer[i] & mode::MASK) == mode::TX &&
+                               getMode_() != mode::TX;
+      writeRegister_(address + i, buffer[i]);
+      if (isTxStarted) {
+        txTimeUs = startTx_();
+      }
+    }
+    updateDio0_();
+  }
+
+  // Timer calls take the timer lock, which is held while callbacks run
+  if (txTimeUs != 0) {
+    txTimer_.startOnce(txTimeUs);
+  }
+  return common::Error::OK;
+}
+
+common::Error Sx127x::read(SpiDeviceHandle& deviceHandle,
+                           const uint8_t registerAddress, uint8_t* buffer,
+                           const size_t bufferLength) {
+  (void)deviceHandle;
+  sw::trace::Scope trace{"spi read"};
+  const uint8_t address = registerAddress & 0x7F;
+  if (buffer == nullptr || (address != reg::common::FIFO &&
+                            address + bufferLength > REGISTER_COUNT)) {
+    return common::Error::INVALID_ARG;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (size_t i = 0; i < bufferLength; ++i) {
+    buffer[i] = address == reg::common::FIFO
+                    ? fifo_[registers_[reg::lora::FIFO_ADDR_PTR]++]
+                    : readRegister_(address + i);
+  }
+  return common::Error::OK;
+}
+
+Sx127x::Stats Sx127x::getStats() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return stats_;
+}
+
+void Sx127x::receiveLoop_() {
+  AirFrame frame{};
+  while (isRunning_) {
+    pollfd descriptor{socket_, POLLIN, 0};
+    if (poll(&descriptor, 1, RECEIVE_POLL_MS) <= 0) {
+      continue;
+    }
+
+    const ssize_t length = recv(socket_, &frame, sizeof(frame), 0);
+    constexpr size_t HEADER_SIZE{offsetof(AirFrame, payload)};
+    if (length < static_cast<ssize_t>(HEADER_SIZE) ||
+        static_cast<size_t>(length) != HEADER_SIZE + frame.length) {
+      continue;
+    }
+
+    handleFrame_(frame);
+  }
+}
+
+void Sx127x::handleFrame_(const AirFrame& frame) {
+  const uint64_t endUs = frame.startUs + frame.timeOnAirUs;
+  uint64_t rxEndUs{0};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    const bool isOverlapping = channelBusyUntilUs_ > frame.startUs;
+    channelBusyUntilUs_ = std::max(channelBusyUntilUs_, endUs);
+
+    if (reception_.isPending) {
+      // Neither frame can be decoded
+      ++stats_.collisions;
+      reception_.isCollided = true;
+    } else if (getMode_() != mode::RX_CONT || not isMatch_(frame)) {
+      ++stats_.missed;
+    } else {
+      reception_ = {true, isOverlapping, frame};
+      rxEndUs = endUs;
+    }
+  }
+
+  if (rxEndUs != 0) {
+    const uint64_t nowUs = getMonotonicUs_();
+    rxTimer_.startOnce(
+        static_cast<common::Time>(rxEndUs > nowUs ? rxEndUs - nowUs : 1));
+  }
+}
+
+void Sx127x::finishRx_() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (not reception_.isPending) {
+    return;
+  }
+
+  if (reception_.isCollided) {
+    ++stats_.collisions;
+    reception_ = {};
+    return;
+  }
+
+  const AirFrame& frame = reception_.frame;
+  const uint8_t base = registers_[reg::lora::FIFO_RX_BASE_ADDR];
+  for (uint8_t i = 0; i < frame.length; ++i) {
+    fifo_[static_cast<uint8_t>(base + i)] = frame.payload[i];
+  }
+  registers_[reg::lora::FIFO_RX_CURRENT_ADDR] = base;
+  registers_[reg::lora::RX_NB_BYTES] = frame.length;
+  registers_[reg::lora::PKT_RSSI_VALUE] = PACKET_RSSI_VALUE;
+  registers_[reg::lora::PKT_SNR_VALUE] = PACKET_SNR_VALUE;
+  irqFlags_ |= irq::RX_DONE | irq::VALID_HEADER;
+  reception_ = {};
+  ++stats_.received;
+  updateDio0_();
+}
+
+void Sx127x::finishTx_() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (getMode_() != mode::TX) {
+    return;
+  }
+
+  // Modem returns to standby after the frame
+  registers_[reg::common::OP_MODE] =
+      (registers_[reg::common::OP_MODE] & ~mode::MASK) | mode::STANDBY;
+  irqFlags_ |= irq::TX_DONE;
+  updateDio0_();
+}
+
+void Sx127x::writeRegister_(const uint8_t address, const uint8_t value) {
+  switch (address) {
+  case reg::lora::IRQ_FLAGS:
+    // Flags are cleared by writing 1
+    irqFlags_ &= ~value;
+    break;
+  case reg::common::OP_MODE:
+    setMode_(value);
+    break;
+  default:
+    registers_[address] = value;
+    break;
+  }
+}
+
+uint8_t Sx127x::readRegister_(const uint8_t address) const {
+  return address == reg::lora::IRQ_FLAGS ? irqFlags_ : registers_[address];
+}
+
+void Sx127x::setMode_(const uint8_t value) {
+  registers_[reg::common::OP_MODE] = value;
+  const uint8_t newMode = value & mode::MASK;
+  if (newMode != mode::RX_CONT && reception_.isPending) {
+    // Receiver left RX before the frame was over
+    ++stats_.missed;
+    reception_ = {};
+  }
+
+  if (newMode == mode::CAD) {
+    const bool isActive = channelBusyUntilUs_ > getMonotonicUs_();
+    irqFlags_ |= irq::CAD_DONE | (isActive ? irq::CAD_DETECTED : 0);
+    registers_[reg::common::OP_MODE] = (value & ~mode::MASK) | mode::STANDBY;
+  }
+}
+
+uint32_t Sx127x::startTx_() {
+  AirFrame frame{};
+  frame.startUs = getMonotonicUs_();
+  frame.length = registers_[reg::lora::PAYLOAD_LENGTH];
+  frame.timeOnAirUs = getTimeOnAirUs_(frame.length);
+  std::copy_n(&registers_[reg::common::FRF_MSB], frame.frf.size(),
+              frame.frf.begin());
+  frame.modemConfig1 = registers_[reg::lora::MODEM_CONFIG_1];
+  frame.modemConfig2 = registers_[reg::lora::MODEM_CONFIG_2];
+  frame.syncWord = registers_[reg::lora::SYNC_WORD];
+  const uint8_t base = registers_[reg::lora::FIFO_TX_BASE_ADDR];
+  for (uint8_t i = 0; i < frame.length; ++i) {
+    frame.payload[i] = fifo_[static_cast<uint8_t>(base + i)];
+  }
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const size_t frameSize = offsetof(AirFrame, payload) + frame.length;
+  for (uint8_t node = 0; node < MAX_NODES; ++node) {
+    if (node == config_.nodeId) {
+      continue;
+    }
+
+    address.sin_port = htons(config_.basePort + node);
+    // Nodes which aren't running simply don't hear the frame
+    sendto(socket_, &frame, frameSize, 0,
+           reinterpret_cast<sockaddr*>(&address), sizeof(address));
+  }
+
+  ++stats_.sent;
+  ESP_LOGD(TAG.data(), "TX %u bytes, time on air: %lu [us]",
+           static_cast<unsigned>(frame.length),
+           static_cast<unsigned long>(frame.timeOnAirUs));
+  return frame.timeOnAirUs;
+}
+
+uint32_t Sx127x::getTimeOnAirUs_(const uint8_t payloadLength) const {
+  constexpr std::array<uint32_t, 10> BANDWIDTHS_HZ{
+      7'800, 10'400, 15'600, 20'800, 31'250,
+      41'700, 62'500, 125'000, 250'000, 500'000};
+  const uint8_t modemConfig1 = registers_[reg::lora::MODEM_CONFIG_1];
+  const uint8_t modemConfig2 = registers_[reg::lora::MODEM_CONFIG_2];
+  const uint8_t bandwidthIndex =
+      std::min<uint8_t>(modemConfig1 >> 4, BANDWIDTHS_HZ.size() - 1);
+  const int32_t spreadingFactor = modemConfig2 >> 4;
+  const int32_t codingRate = (modemConfig1 >> 1) & 0b111;
+  const int32_t implicitHeader = modemConfig1 & 0b1;
+  const int32_t crc = (modemConfig2 >> 2) & 0b1;
+  const int32_t lowDataRate =
+      (registers_[reg::lora::MODEM_CONFIG_3] >> 3) & 0b1;
+  const uint32_t preambleLength =
+      (static_cast<uint32_t>(registers_[reg::lora::PREAMBLE_MSB]) << 8) |
+      registers_[reg::lora::PREAMBLE_LSB];
+
+  // Semtech SX1276 datasheet, section 4.1.1.7
+  const int32_t numerator = 8 * payloadLength - 4 * spreadingFactor + 28 +
+                            16 * crc - 20 * implicitHeader;
+  const int32_t denominator = 4 * (spreadingFactor - 2 * lowDataRate);
+  int32_t payloadSymbols{8};
+  if (numerator > 0 && denominator > 0) {
+    payloadSymbols +=
+        ((numerator + denominator - 1) / denominator) * (codingRate + 4);
+  }
+
+  // Preamble has 4.25 symbols more than configured
+  const uint64_t quarterSymbols = 4 * (preambleLength + payloadSymbols) + 17;
+  return static_cast<uint32_t>((quarterSymbols << spreadingFactor) *
+                               1'000'000 /
+                               (4 * static_cast<uint64_t>(
+                                        BANDWIDTHS_HZ[bandwidthIndex])));
+}
+
+bool Sx127x::isMatch_(const AirFrame& frame) const {
+  constexpr uint8_t UPPER_NIBBLE{0xF0};
+  return std::equal(frame.frf.begin(), frame.frf.end(),
+                    &registers_[reg::common::FRF_MSB]) &&
+         ((frame.modemConfig1 ^ registers_[reg::lora::MODEM_CONFIG_1]) &
+          UPPER_NIBBLE) == 0 &&
+         ((frame.modemConfig2 ^ registers_[reg::lora::MODEM_CONFIG_2]) &
+          UPPER_NIBBLE) == 0 &&
+         frame.syncWord == registers_[reg::lora::SYNC_WORD];
+}
+
+void Sx127x::updateDio0_() {
+  bool isHigh{false};
+  switch (registers_[reg::common::DIO_MAPPING_1] >> dio0::SHIFT) {
+  case dio0::RX_DONE:
+    isHigh = irqFlags_ & irq::RX_DONE;
+    break;
+  case dio0::TX_DONE:
+    isHigh = irqFlags_ & irq::TX_DONE;
+    break;
+  case dio0::CAD_DONE:
+    isHigh = irqFlags_ & irq::CAD_DONE;
+    break;
+  default:
+    break;
+  }
+
+  // Held under the modem lock so levels are driven in order
+  config_.dio0.drive(isHigh ? GpioLevel::HIGH : GpioLevel::LOW);
+}
+
+uint8_t Sx127x::getMode_() const {
+  return registers_[reg::common::OP_MODE] & mode::MASK;
+}
+
+uint64_t Sx127x::getMonotonicUs_() {
+  timespec now{};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1'000'000 +
+         static_cast<uint64_t>(now.tv_nsec) / 1000;
+}
+} // namespace fake
+} // namespace hw
@@ -0,0 +1,162 @@
+#include "fileflash.hpp"
+#include <algorithm>
+#include <array>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr uint8_t ERASED_BYTE{0xFF};
+// Data is copied through the stack in chunks, the flash log writes from
+// paths which must not allocate
+constexpr size_t CHUNK_SIZE{256};
+
+/**
+ * @brief Fill a part of the file with erased flash.
+ *
+ * @return False if the file cannot be written.
+ */
+bool writeErased(const int fd, const size_t offset, const size_t length) {
+  std::array<uint8_t, CHUNK_SIZE> erased{};
+  erased.fill(ERASED_BYTE);
+  for (size_t done = 0; done < length;) {
+    const size_t chunk = std::min(CHUNK_SIZE, length - done);
+    if (pwrite(fd, erased.data(), chunk, static_cast<off_t>(offset + done)) !=
+        static_cast<ssize_t>(chunk)) {
+      return false;
+    }
+    done += chunk;
+  }
+  return true;
+}
+} // namespace
+
+namespace storage {
+namespace fake {
+FileFlash::FileFlash(const std::string_view path, const size_t size,
+                     const size_t sectorSize)
+    : path_{path}, size_{size}, sectorSize_{sectorSize} {}
+
+FileFlash::~FileFlash() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+common::Error FileFlash::init() {
+  if (sectorSize_ == 0 || size_ % sectorSize_ != 0) {
+    return common::Error::INVALID_ARG;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (fd_ >= 0) {
+    return common::Error::OK;
+  }
+
+  fd_ = open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    return common::Error::FAIL;
+  }
+
+  struct stat fileStat {};
+  if (fstat(fd_, &fileStat) != 0) {
+    return common::Error::FAIL;
+  }
+
+  // New or shorter file, the missing part is erased flash
+  const size_t currentSize = static_cast<size_t>(fileStat.st_size);
+  if (currentSize < size_ &&
+      not writeErased(fd_, currentSize, size_ - currentSize)) {
+    return common::Error::FAIL;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error FileFlash::read(const size_t offset, uint8_t* buffer,
+                              const size_t bufferLength) {
+  if (buffer == nullptr) {
+    return common::Error::INVALID_ARG;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  common::Error errorCode = checkRange_(offset, bufferLength);
+  if (errorCode != common::Error::OK) {
+    return errorCode;
+  }
+
+  return pread(fd_, buffer, bufferLength, static_cast<off_t>(offset)) ==
+                 static_cast<ssize_t>(bufferLength)
+             ? common::Error::OK
+             : common::Error::FAIL;
+}
+
+common::Error FileFlash::write(const size_t offset, const uint8_t* data,
+                               const size_t dataLength) {
+  if (data == nullptr) {
+    return common::Error::INVALID_ARG;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  common::Error errorCode = checkRange_(offset, dataLength);
+  if (errorCode != common::Error::OK) {
+    return errorCode;
+  }
+
+  std::array<uint8_t, CHUNK_SIZE> stored{};
+  for (size_t done = 0; done < dataLength;) {
+    const size_t chunk = std::min(CHUNK_SIZE, dataLength - done);
+    const auto chunkOffset = static_cast<off_t>(offset + done);
+    if (pread(fd_, stored.data(), chunk, chunkOffset) !=
+        static_cast<ssize_t>(chunk)) {
+      return common::Error::FAIL;
+    }
+
+    // Programming only clears bits
+    for (size_t i = 0; i < chunk; ++i) {
+      stored[i] &= data[done + i];
+    }
+
+    if (pwrite(fd_, stored.data(), chunk, chunkOffset) !=
+        static_cast<ssize_t>(chunk)) {
+      return common::Error::FAIL;
+    }
+    done += chunk;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error FileFlash::eraseSector(const size_t offset) {
+  if (offset % sectorSize_ != 0) {
+    return common::Error::INVALID_ARG;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  common::Error errorCode = checkRange_(offset, sectorSize_);
+  if (errorCode != common::Error::OK) {
+    return errorCode;
+  }
+
+  return writeErased(fd_, offset, sectorSize_) ? common::Error::OK
+                                               : common::Error::FAIL;
+}
+
+size_t FileFlash::getSize() const { return size_; }
+
+size_t FileFlash::getSectorSize() const { return sectorSize_; }
+
+common::Error FileFlash::checkRange_(const size_t offset,
+                                     const size_t length) const {
+  if (fd_ < 0) {
+    return common::Error::INVALID_STATE;
+  }
+
+  if (offset > size_ || length > size_ - offset) {
+    return common::Error::INVALID_ARG;
+  }
+
+  return common::Error::OK;
+}
+} // namespace fake
+} // namespace storage
@@ -0,0 +1,103 @@
+#include "ramstore.hpp"
+#include <cstring>
+
+namespace storage {
+namespace fake {
+common::Error RamStore::setItem(const std::string_view& key,
+                                const uint8_t& item) {
+  set_(key, Type::U8, &item, sizeof(item));
+  return common::Error::OK;
+}
+
+common::Error RamStore::getItem(const std::string_view& key, uint8_t& item) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  const Item* stored = find_(key, Type::U8);
+  if (stored == nullptr) {
+    return common::Error::NOT_FOUND;
+  }
+
+  item = stored->data.front();
+  return common::Error::OK;
+}
+
+common::Error RamStore::setItem(const std::string_view& key,
+                                const uint32_t& item) {
+  set_(key, Type::U32, &item, sizeof(item));
+  return common::Error::OK;
+}
+
+common::Error RamStore::getItem(const std::string_view& key, uint32_t& item) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  const Item* stored = find_(key, Type::U32);
+  if (stored == nullptr) {
+    return common::Error::NOT_FOUND;
+  }
+
+  std::memcpy(&item, stored->data.data(), sizeof(item));
+  return common::Error::OK;
+}
+
+common::Error RamStore::setString(const std::string_view& key,
+                                  const std::string& string) {
+  set_(key, Type::STRING, string.data(), string.size());
+  return common::Error::OK;
+}
+
+common::Error RamStore::getString(const std::string_view& key,
+                                  std::string& string) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  const Item* stored = find_(key, Type::STRING);
+  if (stored == nullptr) {
+    return common::Error::NOT_FOUND;
+  }
+
+  string.assign(stored->data.begin(), stored->data.end());
+  return common::Error::OK;
+}
+
+common::Error RamStore::setBlob(const std::string_view& key, const void* data,
+                                const size_t size) {
+  if (data == nullptr) {
+    return common::Error::INVALID_ARG;
+  }
+
+  set_(key, Type::BLOB, data, size);
+  return common::Error::OK;
+}
+
+common::Error RamStore::getBlob(const std::string_view& key, void* data,
+                                const size_t size) {
+  if (data == nullptr || size == 0) {
+    return common::Error::INVALID_ARG;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  const Item* stored = find_(key, Type::BLOB);
+  if (stored == nullptr || stored->data.size() != size) {
+    return common::Error::NOT_FOUND;
+  }
+
+  std::memcpy(data, stored->data.data(), size);
+  return common::Error::OK;
+}
+
+common::Error RamStore::save() { return common::Error::OK; }
+
+void RamStore::set_(const std::string_view& key, const Type type,
+                    const void* data, const size_t size) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  std::lock_guard<std::mutex> lock{mutex_};
+  items_.insert_or_assign(
+      std::string{key}, Item{type, std::vector<uint8_t>(bytes, bytes + size)});
+}
+
+const RamStore::Item* RamStore::find_(const std::string_view& key,
+                                      const Type type) const {
+  auto item = items_.find(key);
+  if (item == items_.end() || item->second.type != type) {
+    return nullptr;
+  }
+  return &item->second;
+}
+} // namespace fake
+} // namespace storage
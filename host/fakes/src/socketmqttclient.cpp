@@ -0,0 +1,711 @@
+#include "socketmqttclient.hpp"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "trace.hpp"
+#include "uptime.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/crypto.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+static constexpr std::string_view TAG{"MQTT"};
+
+int getRemainingMs(const common::Time startMs, const common::Time timeoutMs) {
+  const common::Time elapsedMs = sw::getUptimeMs() - startMs;
+  return elapsedMs < timeoutMs ? static_cast<int>(timeoutMs - elapsedMs) : 0;
+}
+} // namespace
+
+#if not defined(__SANITIZE_ADDRESS__) and not defined(__SANITIZE_THREAD__)
+// OpenSSL 3.0 allocates its packet writer state for every record, mbedTLS of
+// the hub writes records into its fixed buffer. TLS allocations go past the
+// malloc wrapper of sw::AllocationGuard, the heap size still counts them.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+}
+
+namespace {
+void* allocateTls(const size_t size, const char*, int) {
+  return __libc_malloc(size);
+}
+
+void* reallocateTls(void* ptr, const size_t size, const char*, int) {
+  return __libc_realloc(ptr, size);
+}
+
+void freeTls(void* ptr, const char*, int) { std::free(ptr); }
+
+bool setTlsAllocator() {
+  return CRYPTO_set_mem_functions(allocateTls, reallocateTls, freeTls) == 1;
+}
+} // namespace
+#else
+namespace {
+bool setTlsAllocator() { return true; }
+} // namespace
+#endif
+
+namespace net {
+namespace fake {
+SocketMqttClient::SocketMqttClient(const std::string_view clientId,
+                                   const Settings settings)
+    : clientId_{clientId}, settings_{settings},
+      inFlight_{[this](const InFlightWindow::Message& message,
+                       const bool isDuplicate) {
+        return sendPublish_(message, isDuplicate);
+      }} {}
+
+SocketMqttClient::~SocketMqttClient() { close_(); }
+
+common::Error SocketMqttClient::init() {
+  if (settings_.caFile == nullptr) {
+    return common::Error::OK;
+  }
+
+  // Only possible before OpenSSL allocated anything
+  if (not setTlsAllocator()) {
+    ESP_LOGW(TAG.data(), "TLS writes are counted as hot path allocations");
+  }
+
+  tlsContext_.reset(SSL_CTX_new(TLS_client_method()));
+  if (not tlsContext_) {
+    return common::Error::FAIL;
+  }
+
+  SSL_CTX* context = tlsContext_.get();
+  // mbedTLS of the hub negotiates TLS 1.2, resumption works the same there
+  if (SSL_CTX_set_max_proto_version(context, TLS1_2_VERSION) != 1 ||
+      SSL_CTX_load_verify_locations(context, settings_.caFile, nullptr) !=
+          1) {
+    ESP_LOGE(TAG.data(), "Failed to load %s", settings_.caFile);
+    tlsContext_.reset();
+    return common::Error::FAIL;
+  }
+  SSL_CTX_set_verify(context, SSL_VERIFY_PEER, nullptr);
+
+  if (settings_.certFile &&
+      (SSL_CTX_use_certificate_file(context, settings_.certFile,
+                                    SSL_FILETYPE_PEM) != 1 ||
+       SSL_CTX_use_PrivateKey_file(context, settings_.keyFile,
+                                   SSL_FILETYPE_PEM) != 1)) {
+    ESP_LOGE(TAG.data(), "Failed to load %s", settings_.certFile);
+    tlsContext_.reset();
+    return common::Error::FAIL;
+  }
+
+  return common::Error::OK;
+}
+
+SocketMqttClient::Stats SocketMqttClient::getStats() const {
+  std::lock_guard<std::mutex> lock{handshakeMutex_};
+  return {published_.load(std::memory_order_relaxed),
+          acknowledged_.load(std::memory_order_relaxed),
+          delivered_.load(std::memory_order_relaxed),
+          pings_.load(std::memory_order_relaxed),
+          pingsInFlight_.load(std::memory_order_relaxed),
+          pingResponses_.load(std::memory_order_relaxed),
+          fullHandshakes_,
+          resumedHandshakes_};
+}
+
+void SocketMqttClient::setDisconnectCallback(disconnectCallback cb,
+                                             common::Argument arg) {
+  disconnectCb_ = std::move(cb);
+  disconnectArg_ = arg;
+}
+
+common::Error SocketMqttClient::subscribe(const std::string_view& topic,
+                                          const Qos, subscribeCallback cb,
+                                          common::Argument arg) {
+  if (topic.size() >= MAX_TOPIC_SIZE ||
+      not Subscriptions::isValidFilter(topic)) {
+    return common::Error::INVALID_ARG;
+  }
+
+  const bool isSubscribed = subscriptions_.find(topic) != nullptr;
+  Subscriptions::Entry* entry = subscriptions_.add(topic, std::move(cb), arg);
+  if (entry == nullptr) {
+    return common::Error::NO_MEM;
+  }
+
+  // Not connected yet, connect() subscribes to the whole table
+  if (isSubscribed || not isConnected_) {
+    return common::Error::OK;
+  }
+
+  if (sendSubscribe_(*entry) != common::Error::OK) {
+    subscriptions_.remove(topic);
+    return common::Error::FAIL;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error SocketMqttClient::connect() {
+  close_();
+  if (open_() != common::Error::OK) {
+    close_();
+    return common::Error::FAIL;
+  }
+
+  // Subscriptions and in-flight messages are sent again below
+  const size_t length =
+      mqtt::serializeConnect(txBuffer_.data(), txBuffer_.size(), clientId_,
+                             MQTT_KEEP_ALIVE_INTERVAL_S, true);
+  if (length == 0 || write_(txBuffer_.data(), length) != common::Error::OK ||
+      waitForAck_(mqtt::PacketType::CONNACK, 0) != common::Error::OK ||
+      expectedAck_.returnCode != mqtt::CONNACK_ACCEPTED) {
+    ESP_LOGE(TAG.data(), "Broker refused the connection");
+    close_();
+    return common::Error::FAIL;
+  }
+
+  isConnected_ = true;
+  lastPingMs_ = sw::getUptimeMs();
+  isPingOutstanding_ = false;
+
+  common::Error errorCode{common::Error::OK};
+  subscriptions_.forEach([this, &errorCode](Subscriptions::Entry& entry) {
+    if (errorCode == common::Error::OK) {
+      errorCode = sendSubscribe_(entry);
+    }
+  });
+  if (errorCode != common::Error::OK) {
+    close_();
+    return common::Error::FAIL;
+  }
+
+  // A failed resend is retried on the PUBACK timeout
+  inFlight_.resend();
+  return common::Error::OK;
+}
+
+common::Error SocketMqttClient::disconnect() {
+  if (isConnected_) {
+    const size_t length = mqtt::serializeZero(
+        txBuffer_.data(), txBuffer_.size(), mqtt::PacketType::DISCONNECT);
+    write_(txBuffer_.data(), length);
+  }
+
+  close_();
+  return common::Error::OK;
+}
+
+common::Error SocketMqttClient::publish(const std::string_view& topic,
+                                        char* payload, size_t payloadSize,
+                                        const Qos qos) {
+  if (payload == nullptr || payloadSize == 0) {
+    return common::Error::INVALID_ARG;
+  }
+
+  // A blocking PUBACK wait would complete in-flight messages out of order
+  if (not isConnected_ || (qos == Qos::_1 && inFlight_.getCount() > 0)) {
+    return common::Error::INVALID_STATE;
+  }
+
+  sw::trace::Scope trace{"mqtt publish"};
+  const uint16_t packetId = qos == Qos::_1 ? nextPacketId_() : 0;
+  const size_t length = mqtt::serializePublish(
+      txBuffer_.data(), txBuffer_.size(),
+      {topic, reinterpret_cast<const uint8_t*>(payload), payloadSize,
+       packetId, static_cast<uint8_t>(qos), false});
+  if (length == 0 || write_(txBuffer_.data(), length) != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+  published_.fetch_add(1, std::memory_order_relaxed);
+
+  if (qos == Qos::_1) {
+    return waitForAck_(mqtt::PacketType::PUBACK, packetId);
+  }
+
+  return common::Error::OK;
+}
+
+common::Error SocketMqttClient::publishAsync(const std::string_view& topic,
+                                             const char* payload,
+                                             size_t payloadSize,
+                                             const Qos qos,
+                                             publishCallback cb,
+                                             common::Argument arg,
+                                             uint16_t& packetId) {
+  if (payload == nullptr || payloadSize == 0 ||
+      payloadSize > InFlightWindow::PAYLOAD_SIZE || topic.empty()) {
+    return common::Error::INVALID_ARG;
+  }
+
+  if (not isConnected_) {
+    return common::Error::INVALID_STATE;
+  }
+
+  if (qos == Qos::_0) {
+    common::Error errorCode = publish(topic, const_cast<char*>(payload),
+                                      payloadSize, Qos::_0);
+    packetId = 0;
+    if (errorCode == common::Error::OK && cb) {
+      cb(packetId, common::Error::OK, arg);
+    }
+    return errorCode;
+  }
+
+  if (inFlight_.getFreeSlots() == 0) {
+    return common::Error::NO_MEM;
+  }
+
+  packetId = nextPacketId_();
+  return inFlight_.publish(topic, payload, payloadSize, packetId,
+                           std::move(cb), arg);
+}
+
+uint8_t SocketMqttClient::getFreeInFlightSlots() const {
+  return inFlight_.getFreeSlots();
+}
+
+void SocketMqttClient::yield() {
+  if (not isConnected_) {
+    return;
+  }
+
+  if (read_() != common::Error::OK || keepAlive_() != common::Error::OK) {
+    drop_();
+    return;
+  }
+
+  inFlight_.checkTimeouts();
+}
+
+int SocketMqttClient::getSocket() { return isConnected_ ? socket_ : -1; }
+
+bool SocketMqttClient::hasPendingData() {
+  return tls_ && SSL_pending(tls_.get()) > 0;
+}
+
+IMqttClient::TlsStats SocketMqttClient::getTlsStats() const {
+  return tlsStats_;
+}
+
+IMqttClient::RttStats SocketMqttClient::getRttStats() const {
+  return inFlight_.getRttStats();
+}
+
+void SocketMqttClient::resetRttStats() { inFlight_.resetRttStats(); }
+
+sw::LatencyHistogram::Snapshot SocketMqttClient::getPublishLatency() const {
+  return inFlight_.getPublishLatency();
+}
+
+common::Error
+SocketMqttClient::registerMetrics(sw::metrics::Registry& registry) const {
+  return inFlight_.registerMetrics(registry);
+}
+
+common::Error SocketMqttClient::open_() {
+  std::array<char, 6> port{};
+  std::snprintf(port.data(), port.size(), "%u", settings_.port);
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses{nullptr};
+  if (getaddrinfo(settings_.host, port.data(), &hints, &addresses) != 0) {
+    ESP_LOGE(TAG.data(), "Failed to resolve %s", settings_.host);
+    return common::Error::FAIL;
+  }
+
+  for (addrinfo* address = addresses; address != nullptr;
+       address = address->ai_next) {
+    socket_ = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC,
+                     address->ai_protocol);
+    if (socket_ < 0) {
+      continue;
+    }
+    if (::connect(socket_, address->ai_addr, address->ai_addrlen) == 0) {
+      break;
+    }
+    ::close(socket_);
+    socket_ = -1;
+  }
+  freeaddrinfo(addresses);
+  if (socket_ < 0) {
+    ESP_LOGE(TAG.data(), "Failed to connect to %s:%u", settings_.host,
+             settings_.port);
+    return common::Error::FAIL;
+  }
+
+  // Pipelined publishes would wait for the ACK of the previous segment
+  const int isNoDelay{1};
+  setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, &isNoDelay, sizeof(isNoDelay));
+
+  if (tlsContext_ && handshake_() != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  // Reads in yield() take what arrived, writes wait in write_()
+  const int flags = fcntl(socket_, F_GETFL);
+  if (flags < 0 || fcntl(socket_, F_SETFL, flags | O_NONBLOCK) < 0) {
+    return common::Error::FAIL;
+  }
+
+  return common::Error::OK;
+}
+
+common::Error SocketMqttClient::handshake_() {
+  // Blocking handshake, a broker without TLS must not hang it
+  timeval timeout{static_cast<time_t>(COMMAND_TIMEOUT_MS / 1000), 0};
+  setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  tls_.reset(SSL_new(tlsContext_.get()));
+  SSL* tls = tls_.get();
+  if (tls == nullptr || SSL_set_fd(tls, socket_) != 1 ||
+      SSL_set1_host(tls, settings_.host) != 1) {
+    return common::Error::FAIL;
+  }
+  SSL_set_tlsext_host_name(tls, settings_.host);
+
+  if (tlsSession_ && SSL_set_session(tls, tlsSession_.get()) != 1) {
+    // Full handshake still works without it
+    tlsSession_.reset();
+  }
+
+  // Heap is sampled between handshake messages, allocations happen there
+  SSL_set_msg_callback(tls, onHandshakeMessage_);
+  SSL_set_msg_callback_arg(tls, this);
+  const uint32_t freeHeapBefore = esp_get_free_heap_size();
+  lowestFreeHeap_ = freeHeapBefore;
+  const common::Time startMs = sw::getUptimeMs();
+  if (SSL_connect(tls) != 1) {
+    ESP_LOGE(TAG.data(), "TLS handshake failed: %s",
+             SSL_get_verify_result(tls) != X509_V_OK
+                 ? X509_verify_cert_error_string(SSL_get_verify_result(tls))
+                 : "connection error");
+    // Broker may have rejected the session, don't offer it again
+    tlsSession_.reset();
+    return common::Error::FAIL;
+  }
+  SSL_set_msg_callback(tls, nullptr);
+
+  const common::Time durationMs = sw::getUptimeMs() - startMs;
+  const uint32_t lowestFreeHeap =
+      std::min(lowestFreeHeap_, esp_get_free_heap_size());
+  const uint32_t peakHeap = freeHeapBefore - lowestFreeHeap;
+  const bool isResumed = SSL_session_reused(tls) == 1;
+  tlsStats_ = {tlsStats_.handshakes + 1,
+               tlsStats_.resumedHandshakes + (isResumed ? 1 : 0), durationMs,
+               peakHeap};
+  {
+    std::lock_guard<std::mutex> lock{handshakeMutex_};
+    HandshakeStats& stats = isResumed ? resumedHandshakes_ : fullHandshakes_;
+    ++stats.count;
+    stats.totalMs += durationMs;
+    stats.maxPeakHeap = std::max(stats.maxPeakHeap, peakHeap);
+  }
+
+  tlsSession_.reset(SSL_get1_session(tls));
+  return common::Error::OK;
+}
+
+void SocketMqttClient::close_() {
+  isConnected_ = false;
+  rxLength_ = 0;
+  expectedAck_ = {};
+  if (tls_) {
+    SSL_shutdown(tls_.get());
+    tls_.reset();
+  }
+  if (socket_ >= 0) {
+    ::close(socket_);
+    socket_ = -1;
+  }
+}
+
+void SocketMqttClient::drop_() {
+  ESP_LOGW(TAG.data(), "Connection to %s:%u lost", settings_.host,
+           settings_.port);
+  close_();
+  if (disconnectCb_) {
+    disconnectCb_(disconnectArg_);
+  }
+}
+
+common::Error SocketMqttClient::write_(const uint8_t* buffer,
+                                       const size_t length) {
+  if (socket_ < 0) {
+    return common::Error::FAIL;
+  }
+
+  size_t written{0};
+  const common::Time startMs = sw::getUptimeMs();
+  while (written < length) {
+    ssize_t result{0};
+    bool isBlocked{false};
+    if (tls_) {
+      result = SSL_write(tls_.get(), &buffer[written],
+                         static_cast<int>(length - written));
+      if (result <= 0) {
+        const int error = SSL_get_error(tls_.get(), static_cast<int>(result));
+        isBlocked =
+            error == SSL_ERROR_WANT_WRITE || error == SSL_ERROR_WANT_READ;
+      }
+    } else {
+      result = send(socket_, &buffer[written], length - written, MSG_NOSIGNAL);
+      isBlocked = result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+
+    if (result > 0) {
+      written += static_cast<size_t>(result);
+      continue;
+    }
+
+    pollfd socket{socket_, POLLOUT, 0};
+    const int remainingMs = getRemainingMs(startMs, COMMAND_TIMEOUT_MS);
+    if (not isBlocked || remainingMs == 0 ||
+        poll(&socket, 1, remainingMs) <= 0) {
+      return common::Error::FAIL;
+    }
+  }
+
+  return common::Error::OK;
+}
+
+common::Error SocketMqttClient::read_() {
+  while (socket_ >= 0) {
+    if (rxLength_ == rxBuffer_.size()) {
+      ESP_LOGE(TAG.data(), "Packet does not fit %zu B", rxBuffer_.size());
+      return common::Error::FAIL;
+    }
+
+    uint8_t* end = &rxBuffer_[rxLength_];
+    const size_t space = rxBuffer_.size() - rxLength_;
+    ssize_t result{0};
+    if (tls_) {
+      result = SSL_read(tls_.get(), end, static_cast<int>(space));
+      if (result <= 0) {
+        const int error = SSL_get_error(tls_.get(), static_cast<int>(result));
+        return error == SSL_ERROR_WANT_READ ? common::Error::OK
+                                            : common::Error::FAIL;
+      }
+    } else {
+      result = recv(socket_, end, space, 0);
+      if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return common::Error::OK;
+      }
+      if (result <= 0) {
+        return common::Error::FAIL;
+      }
+    }
+    rxLength_ += static_cast<size_t>(result);
+
+    size_t offset{0};
+    while (offset < rxLength_) {
+      mqtt::PacketType type{};
+      size_t remainingLength{0};
+      const size_t headerSize = mqtt::parseFixedHeader(
+          &rxBuffer_[offset], rxLength_ - offset, type, remainingLength);
+      if (headerSize == 0) {
+        if (rxLength_ - offset >= mqtt::MAX_FIXED_HEADER_SIZE) {
+          return common::Error::FAIL;
+        }
+        break;
+      }
+
+      const size_t packetSize = headerSize + remainingLength;
+      if (packetSize > rxLength_ - offset) {
+        break;
+      }
+      if (handlePacket_(&rxBuffer_[offset], packetSize) !=
+          common::Error::OK) {
+        return common::Error::FAIL;
+      }
+      offset += packetSize;
+    }
+
+    // Keep the start of an incomplete packet
+    std::memmove(rxBuffer_.data(), &rxBuffer_[offset], rxLength_ - offset);
+    rxLength_ -= offset;
+  }
+
+  return common::Error::FAIL;
+}
+
+common::Error SocketMqttClient::handlePacket_(const uint8_t* packet,
+                                              const size_t length) {
+  const auto type = static_cast<mqtt::PacketType>(packet[0] >> 4);
+  uint16_t packetId{0};
+  uint8_t returnCode{0};
+  switch (type) {
+  case mqtt::PacketType::CONNACK:
+    if (not mqtt::deserializeConnack(packet, length, returnCode)) {
+      return common::Error::FAIL;
+    }
+    break;
+  case mqtt::PacketType::SUBACK:
+    if (not mqtt::deserializeSuback(packet, length, packetId, returnCode)) {
+      return common::Error::FAIL;
+    }
+    break;
+  case mqtt::PacketType::PUBACK:
+    if (not mqtt::deserializePuback(packet, length, packetId)) {
+      return common::Error::FAIL;
+    }
+    if (inFlight_.acknowledge(packetId)) {
+      acknowledged_.fetch_add(1, std::memory_order_relaxed);
+      return common::Error::OK;
+    }
+    break;
+  case mqtt::PacketType::PINGRESP:
+    isPingOutstanding_ = false;
+    pingResponses_.fetch_add(1, std::memory_order_relaxed);
+    return common::Error::OK;
+  case mqtt::PacketType::PUBLISH: {
+    mqtt::Publish publish{};
+    if (not mqtt::deserializePublish(packet, length, publish) ||
+        publish.topic.size() >= MAX_TOPIC_SIZE) {
+      return common::Error::FAIL;
+    }
+
+    // Callbacks get a null terminated topic like from the SDK
+    std::array<char, MAX_TOPIC_SIZE> topic{};
+    std::memcpy(topic.data(), publish.topic.data(), publish.topic.size());
+    subscriptions_.forEachMatch(
+        publish.topic, [&topic, &publish](Subscriptions::Entry& entry) {
+          if (entry.cb) {
+            entry.cb(topic.data(), static_cast<uint16_t>(publish.topic.size()),
+                     const_cast<uint8_t*>(publish.payload),
+                     publish.payloadSize, entry.arg);
+          }
+        });
+    delivered_.fetch_add(1, std::memory_order_relaxed);
+
+    if (publish.qos == 0) {
+      return common::Error::OK;
+    }
+    std::array<uint8_t, mqtt::MAX_FIXED_HEADER_SIZE + sizeof(uint16_t)>
+        puback{};
+    const size_t pubackLength =
+        mqtt::serializePuback(puback.data(), puback.size(), publish.packetId);
+    return write_(puback.data(), pubackLength);
+  }
+  default:
+    ESP_LOGE(TAG.data(), "Unexpected packet type %u",
+             static_cast<unsigned>(type));
+    return common::Error::FAIL;
+  }
+
+  if (expectedAck_.type == type && expectedAck_.packetId == packetId) {
+    expectedAck_.returnCode = returnCode;
+    expectedAck_.isReceived = true;
+  }
+  return common::Error::OK;
+}
+
+common::Error SocketMqttClient::waitForAck_(const mqtt::PacketType type,
+                                            const uint16_t packetId) {
+  expectedAck_ = {type, packetId, 0, false};
+  const common::Time startMs = sw::getUptimeMs();
+  while (not expectedAck_.isReceived) {
+    pollfd socket{socket_, POLLIN, 0};
+    const int remainingMs = getRemainingMs(startMs, COMMAND_TIMEOUT_MS);
+    if (remainingMs == 0 ||
+        (not hasPendingData() && poll(&socket, 1, remainingMs) <= 0) ||
+        read_() != common::Error::OK) {
+      expectedAck_ = {};
+      return common::Error::FAIL;
+    }
+  }
+
+  // Return code stays readable until the next wait
+  expectedAck_.type = {};
+  return common::Error::OK;
+}
+
+common::Error
+SocketMqttClient::sendSubscribe_(const Subscriptions::Entry& entry) {
+  const uint16_t packetId = nextPacketId_();
+  const size_t length = mqtt::serializeSubscribe(
+      txBuffer_.data(), txBuffer_.size(), packetId, entry.getTopic(), 1);
+  if (length == 0 || write_(txBuffer_.data(), length) != common::Error::OK ||
+      waitForAck_(mqtt::PacketType::SUBACK, packetId) != common::Error::OK ||
+      expectedAck_.returnCode == mqtt::SUBACK_FAILURE) {
+    ESP_LOGE(TAG.data(), "Failed to subscribe to %s", entry.topic.data());
+    return common::Error::FAIL;
+  }
+
+  ESP_LOGI(TAG.data(), "Subscribed to %s", entry.topic.data());
+  return common::Error::OK;
+}
+
+common::Error
+SocketMqttClient::sendPublish_(const InFlightWindow::Message& message,
+                               const bool isDuplicate) {
+  sw::trace::Scope trace{"mqtt publish"};
+  const size_t length = mqtt::serializePublish(
+      txBuffer_.data(), txBuffer_.size(),
+      {message.topic, reinterpret_cast<const uint8_t*>(message.payload.data()),
+       message.payloadSize, message.packetId, 1, isDuplicate});
+  if (length == 0) {
+    return common::Error::NO_MEM;
+  }
+
+  common::Error errorCode = write_(txBuffer_.data(), length);
+  if (errorCode == common::Error::OK) {
+    published_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return errorCode;
+}
+
+common::Error SocketMqttClient::keepAlive_() {
+  const common::Time nowMs = sw::getUptimeMs();
+  if (nowMs - lastPingMs_ <
+      static_cast<common::Time>(MQTT_KEEP_ALIVE_INTERVAL_S) * 1000) {
+    return common::Error::OK;
+  }
+
+  // No PINGRESP for a whole interval, the connection is gone
+  if (isPingOutstanding_) {
+    ESP_LOGW(TAG.data(), "No PINGRESP in %u s",
+             static_cast<unsigned>(MQTT_KEEP_ALIVE_INTERVAL_S));
+    return common::Error::FAIL;
+  }
+
+  std::array<uint8_t, mqtt::MAX_FIXED_HEADER_SIZE> pingreq{};
+  const size_t length = mqtt::serializeZero(pingreq.data(), pingreq.size(),
+                                            mqtt::PacketType::PINGREQ);
+  if (write_(pingreq.data(), length) != common::Error::OK) {
+    return common::Error::FAIL;
+  }
+
+  pings_.fetch_add(1, std::memory_order_relaxed);
+  if (inFlight_.getCount() > 0) {
+    pingsInFlight_.fetch_add(1, std::memory_order_relaxed);
+  }
+  isPingOutstanding_ = true;
+  lastPingMs_ = nowMs;
+  return common::Error::OK;
+}
+
+uint16_t SocketMqttClient::nextPacketId_() {
+  // Packet ID 0 is not valid, IDs still in flight after a wrap are skipped
+  do {
+    ++packetId_;
+  } while (packetId_ == 0 || inFlight_.isInFlight(packetId_));
+  return packetId_;
+}
+
+void SocketMqttClient::onHandshakeMessage_(int, int, int, const void*, size_t,
+                                           SSL*, void* arg) {
+  auto* client = static_cast<SocketMqttClient*>(arg);
+  client->lowestFreeHeap_ =
+      std::min(client->lowestFreeHeap_, esp_get_free_heap_size());
+}
+} // namespace fake
+} // namespace net
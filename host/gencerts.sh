@@ -0,0 +1,21 @@
+#!/bin/sh
+# Generates a test CA with broker and hub certificates for localhost.
+# Usage: gencerts.sh dir
+set -e
+
+DIR=${1:-tls}
+OPENSSL=${OPENSSL:-openssl}
+
+rm -rf "$DIR" && mkdir "$DIR"
+"$OPENSSL" req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 \
+  -nodes -days 1 -subj "/CN=Test CA" -keyout "$DIR/ca.key" \
+  -out "$DIR/ca.crt" 2>/dev/null
+for NAME in broker hub; do
+  "$OPENSSL" req -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 -nodes \
+    -subj "/CN=$NAME" -keyout "$DIR/$NAME.key" -out "$DIR/$NAME.csr" \
+    2>/dev/null
+  printf "subjectAltName=DNS:localhost,IP:127.0.0.1\n" > "$DIR/$NAME.ext"
+  "$OPENSSL" x509 -req -in "$DIR/$NAME.csr" -CA "$DIR/ca.crt" \
+    -CAkey "$DIR/ca.key" -CAcreateserial -days 1 -extfile "$DIR/$NAME.ext" \
+    -out "$DIR/$NAME.crt" 2>/dev/null
+done
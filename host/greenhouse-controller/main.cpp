@@ -0,0 +1,213 @@
+#include "configstore.hpp"
+#include "delay.hpp"
+#include "esp_log.h"
+#include "fakegpio.hpp"
+#include "fakesht40.hpp"
+#include "fakesx127x.hpp"
+#include "greenhousecontroller.hpp"
+#include "ramstore.hpp"
+#include "rfm95.hpp"
+#include "sht40.hpp"
+#include "timer.hpp"
+#include "trace.hpp"
+#include "types.hpp"
+#include "utils.hpp"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <unistd.h>
+
+// Controller of greenhouse-controller/main/main.cpp on the host.
+// app::GreenhouseController runs unchanged, the SHT40 and the radio are
+// simulated and the battery ADC is left out.
+
+namespace {
+static constexpr std::string_view TAG{"Controller"};
+// Greenhouse air, drifting over 10 minutes
+static constexpr hw::fake::Sht40::Settings AIR_SETTINGS{
+    22.0f, 60.0f, 3.0f, 10.0f,
+    common::utils::sToMs<common::Time, common::Time>(
+        common::utils::minToS<common::Time, common::Time>(10))};
+
+/**
+ * @brief Command line options
+ */
+struct Options {
+    uint8_t controllerId{1};
+    uint16_t basePort{hw::fake::Sx127x::DEFAULT_BASE_PORT};
+    common::DeviceConfig deviceConfig{};
+    const char* traceFile{nullptr}; // Chrome trace written on exit
+    bool isVerbose{false};
+};
+
+std::atomic<bool> isStopRequested{false};
+
+void printUsage(const char* name) {
+  std::printf("Usage: %s [-i controller_id] [-p base_port] "
+              "[-s spreading_factor] [-m measurement_period_s] [-t trace_file] "
+              "[-v]\n",
+              name);
+}
+
+/**
+ * @brief Parse command line options.
+ *
+ * @return False if an option is unknown or the ID is out of range.
+ */
+bool parseOptions(int argc, char** argv, Options& options) {
+  int option{0};
+  while ((option = getopt(argc, argv, "i:p:s:m:t:vh")) != -1) {
+    switch (option) {
+    case 'i':
+      options.controllerId = static_cast<uint8_t>(std::atoi(optarg));
+      break;
+    case 'p':
+      options.basePort = static_cast<uint16_t>(std::atoi(optarg));
+      break;
+    case 's':
+      options.deviceConfig.link.spreadingFactor =
+          static_cast<uint8_t>(std::atoi(optarg));
+      break;
+    case 'm':
+      options.deviceConfig.measurementPeriodS =
+          static_cast<uint32_t>(std::atoi(optarg));
+      break;
+    case 't':
+      options.traceFile = optarg;
+      break;
+    case 'v':
+      options.isVerbose = true;
+      break;
+    default:
+      return false;
+    }
+  }
+
+  // Node 0 is the hub
+  return options.controllerId > 0 &&
+         options.controllerId < hw::fake::Sx127x::MAX_NODES;
+}
+
+void logStats(const hw::fake::Sx127x& bus,
+              const app::GreenhouseController& controller) {
+  const hw::fake::Sx127x::Stats radioStats = bus.getStats();
+  ESP_LOGI(TAG.data(),
+           "Radio: sent %lu, received %lu, collisions %lu, missed %lu",
+           static_cast<unsigned long>(radioStats.sent),
+           static_cast<unsigned long>(radioStats.received),
+           static_cast<unsigned long>(radioStats.collisions),
+           static_cast<unsigned long>(radioStats.missed));
+
+  const radio::ListenBeforeTalk::Stats lbtStats =
+      controller.getListenBeforeTalk().getStats();
+  ESP_LOGI(TAG.data(), "LBT: deferrals %lu, busy drops %lu",
+           static_cast<unsigned long>(lbtStats.deferrals),
+           static_cast<unsigned long>(lbtStats.busyDrops));
+
+  const radio::DutyCycleLimiter::Stats dutyCycleStats =
+      controller.getDutyCycleLimiter().getStats();
+  ESP_LOGI(TAG.data(), "Duty cycle: deferrals %lu, airtime %llu [us]",
+           static_cast<unsigned long>(dutyCycleStats.deferrals),
+           static_cast<unsigned long long>(dutyCycleStats.airtimeUs));
+
+  const sw::LatencyMeter::Stats irqStats =
+      controller.getRadioThread().getIrqLatencyStats();
+  ESP_LOGI(TAG.data(), "IRQ latency: count %lu, mean %llu, max %lu [us]",
+           static_cast<unsigned long>(irqStats.count),
+           static_cast<unsigned long long>(
+               irqStats.count != 0 ? irqStats.totalUs / irqStats.count : 0),
+           static_cast<unsigned long>(irqStats.maxUs));
+}
+
+/**
+ * @brief Write recorded events as Chrome trace JSON to a file.
+ */
+void writeTrace(const char* path) {
+  std::FILE* file = std::fopen(path, "w");
+  if (file == nullptr) {
+    ESP_LOGE(TAG.data(), "Failed to open %s", path);
+    return;
+  }
+
+  const size_t count = sw::trace::dump(file);
+  std::fclose(file);
+  ESP_LOGI(TAG.data(), "Trace: %zu events in %s", count, path);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options{};
+  if (not parseOptions(argc, argv, options)) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  esp_log_level_set("*", options.isVerbose ? ESP_LOG_DEBUG : ESP_LOG_INFO);
+  std::signal(SIGINT, [](int) { isStopRequested = true; });
+  std::signal(SIGTERM, [](int) { isStopRequested = true; });
+  if (options.traceFile) {
+    sw::trace::enable();
+  }
+
+  common::Error errorCode{common::Error::OK};
+
+  // Configuration as if it was received from the hub before
+  storage::fake::RamStore storage;
+  errorCode = app::ConfigStore{{storage}}.save(options.deviceConfig);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "invalid config options");
+    return EXIT_FAILURE;
+  }
+
+  hw::fake::Sht40 i2c{AIR_SETTINGS};
+  sensor::Sht40 sht40{i2c};
+  errorCode = sht40.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "sht40 init fail");
+  }
+
+  hw::fake::Gpio rst{4};
+  hw::fake::Gpio dio0{17};
+  hw::fake::Sx127x bus{{dio0, options.controllerId, options.basePort}};
+  errorCode = bus.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "simulated radio init fail");
+    return EXIT_FAILURE;
+  }
+
+  hw::SpiDeviceHandle spiRfm95Handle{nullptr};
+  radio::Rfm95 rfm95{{rst, dio0, bus, spiRfm95Handle}};
+
+  // Software timer in place of the ESP high resolution timer
+  timer::sw::Timer measurementTimer;
+  errorCode = measurementTimer.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Measurement timer init fail");
+  }
+
+  app::GreenhouseController controller{{rfm95, sht40, sht40, measurementTimer,
+                                        storage, options.controllerId}};
+  errorCode = controller.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "controller init fail");
+  }
+
+  errorCode = controller.start();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "controller start fail");
+  }
+
+  while (not isStopRequested) {
+    controller.yield();
+    sw::delayMs(10);
+  }
+
+  logStats(bus, controller);
+  if (options.traceFile) {
+    writeTrace(options.traceFile);
+  }
+  // Threads run forever like on the target, don't unwind under them
+  std::fflush(stdout);
+  std::_Exit(EXIT_SUCCESS);
+}
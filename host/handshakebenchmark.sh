@@ -0,0 +1,61 @@
+#!/bin/sh
+# Reconnects the hub to the localhost TLS broker, which drops every
+# connection after a few seconds, with session resumption and without. Prints
+# full and resumed handshake time and peak heap as seen by the hub and the
+# broker. Fails if no handshake was resumed with resumption, one was resumed
+# without or the broker found a protocol error.
+# Usage: handshakebenchmark.sh hub_binary broker_binary duration_s
+set -e
+
+HUB=$1
+BROKER=$2
+DURATION_S=${3:-30}
+PORT=${PORT:-18884}
+DROP_AFTER_S=${DROP_AFTER_S:-3}
+
+"$(dirname "$0")/gencerts.sh" tls
+
+# run name broker_options...
+run() {
+  NAME=$1
+  shift
+  "$BROKER" -p "$PORT" -x "$DROP_AFTER_S" -c tls/broker.crt \
+    -k tls/broker.key -a tls/ca.crt "$@" > "broker-$NAME.log" &
+  BROKER_PID=$!
+  sleep 1
+  # Radio port must not clash with a running load test
+  "$HUB" -p 16000 -m "localhost:$PORT" -k tls > "hub-$NAME.log" &
+  HUB_PID=$!
+  sleep "$DURATION_S"
+  kill -INT "$HUB_PID" 2>/dev/null || true
+  wait "$HUB_PID" || true
+  kill -INT "$BROKER_PID" 2>/dev/null || true
+  wait "$BROKER_PID" || true
+
+  echo "$NAME:"
+  grep -E "TLS .* handshakes:" "hub-$NAME.log" || true
+  grep -E "handshakes [0-9]+, mean" "broker-$NAME.log" || true
+
+  if grep -q "Protocol error" "broker-$NAME.log"; then
+    echo "Broker found protocol errors, see broker-$NAME.log"
+    exit 1
+  fi
+  RESUMED=$(grep -o "TLS resumed handshakes: [0-9]*" "hub-$NAME.log" \
+    | awk '{print $4}')
+  if [ -z "$RESUMED" ]; then
+    echo "No handshake statistics, see hub-$NAME.log"
+    exit 1
+  fi
+}
+
+run resumption
+if [ "$RESUMED" -eq 0 ]; then
+  echo "No handshake resumed, see hub-resumption.log"
+  exit 1
+fi
+run no-resumption -n
+if [ "$RESUMED" -ne 0 ]; then
+  echo "Handshake resumed without resumption, see hub-no-resumption.log"
+  exit 1
+fi
+echo "Logs in $(pwd)"
@@ -0,0 +1,476 @@
+#include "allocationguard.hpp"
+#include "awspacket.hpp"
+#include "configstore.hpp"
+#include "defs.hpp"
+#include "delay.hpp"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "eventgroup.hpp"
+#include "fakegpio.hpp"
+#include "fakemqttclient.hpp"
+#include "fakesx127x.hpp"
+#include "fileflash.hpp"
+#include "flashlog.hpp"
+#include "hub.hpp"
+#include "ilinkpower.hpp"
+#include "queue.hpp"
+#include "ramstore.hpp"
+#include "rfm95.hpp"
+#include "socketmqttclient.hpp"
+#include "trace.hpp"
+#include "uptime.hpp"
+#include "utils.hpp"
+#include <array>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+// Hub of hub/main/main.cpp on the host. app::Hub runs unchanged on the
+// simulated modem. The AWS IoT SDK and Wi-Fi have no host backend, the MQTT
+// client is either a stand-in logging what would be published or, with -m,
+// a socket client talking to host/mqtt-broker, TLS with -k.
+
+namespace {
+static constexpr std::string_view TAG{"HUB"};
+static constexpr std::string_view THING_NAME{"hub"};
+static constexpr std::string_view TELEMETRY_LOG_PATH{"hub-telemetry.flash"};
+// Same size as the telemetry partition of the hub
+static constexpr size_t TELEMETRY_LOG_SIZE{0x40000};
+static constexpr std::string_view METRICS_TOPIC{"hub/metrics"};
+// Delta topic of THING_NAME, the cloud sends desired state changes on it
+static constexpr std::string_view DELTA_TOPIC{
+    "$aws/things/hub/shadow/update/delta"};
+
+/**
+ * @brief Desired shadow field set from the cloud while running
+ */
+struct ConfigChange {
+    std::array<char, 32> key;
+    double value;
+    uint32_t afterS; // Time from start
+};
+
+/**
+ * @brief Command line options
+ */
+struct Options {
+    uint16_t basePort{hw::fake::Sx127x::DEFAULT_BASE_PORT};
+    common::DeviceConfig deviceConfig{};
+    // Publish benchmark replaces the radio if its rate is set
+    app::Hub::Settings hubSettings{
+        {app::TelemetryAggregator::Mode::RAW, 0},
+        {0, common::utils::sToMs<common::Time, common::Time>(10)}};
+    ConfigChange configChange{};
+    bool hasConfigChange{false};
+    common::Time ackDelayMs{0}; // Broker round trip of the MQTT stand-in
+    const char* brokerHost{nullptr}; // Socket client instead of stand-in
+    uint16_t brokerPort{0};
+    const char* tlsDir{nullptr}; // ca.crt, hub.crt and hub.key, TLS if set
+    const char* traceFile{nullptr}; // Chrome trace written on exit
+    bool isVerbose{false};
+};
+
+/**
+ * @brief Link power without a radio, changes are only logged.
+ */
+class LinkPower final : public net::ILinkPower {
+  public:
+    common::Error setBusy(const bool isBusy) override {
+      ESP_LOGD(TAG.data(), "Link busy: %d", isBusy);
+      return common::Error::OK;
+    }
+};
+
+std::atomic<bool> isStopRequested{false};
+
+void printUsage(const char* name) {
+  std::printf("Usage: %s [-p base_port] [-s spreading_factor] "
+              "[-r request_period_s] [-a aggregation_window_s] "
+              "[-c shadow_key=value@after_s] [-b benchmark_rate_hz] "
+              "[-d benchmark_duration_s] [-l puback_latency_ms] "
+              "[-m broker_host:port [-k tls_dir]] [-t trace_file] [-v]\n",
+              name);
+}
+
+/**
+ * @brief Parse command line options.
+ *
+ * @return False if an option is unknown or not supported with -m.
+ */
+bool parseOptions(int argc, char** argv, Options& options) {
+  int option{0};
+  while ((option = getopt(argc, argv, "p:s:r:a:c:b:d:l:m:k:t:vh")) != -1) {
+    switch (option) {
+    case 'p':
+      options.basePort = static_cast<uint16_t>(std::atoi(optarg));
+      break;
+    case 's':
+      options.deviceConfig.link.spreadingFactor =
+          static_cast<uint8_t>(std::atoi(optarg));
+      break;
+    case 'r':
+      options.deviceConfig.requestPeriodS =
+          static_cast<uint32_t>(std::atoi(optarg));
+      break;
+    case 'a':
+      options.hubSettings.aggregator = {
+          app::TelemetryAggregator::Mode::AGGREGATED,
+          common::utils::sToMs<common::Time, common::Time>(
+              static_cast<common::Time>(std::atoi(optarg)))};
+      break;
+    case 'c':
+      options.hasConfigChange =
+          std::sscanf(optarg, "%31[^=]=%lf@%u",
+                      options.configChange.key.data(),
+                      &options.configChange.value,
+                      &options.configChange.afterS) == 3;
+      if (not options.hasConfigChange) {
+        return false;
+      }
+      break;
+    case 'b':
+      options.hubSettings.benchmark.rateHz =
+          static_cast<uint32_t>(std::atoi(optarg));
+      break;
+    case 'd':
+      options.hubSettings.benchmark.durationMs =
+          common::utils::sToMs<common::Time, common::Time>(
+              static_cast<common::Time>(std::atoi(optarg)));
+      break;
+    case 'l':
+      options.ackDelayMs = static_cast<common::Time>(std::atoi(optarg));
+      break;
+    case 'm': {
+      // Host part is terminated in place, optarg points into argv
+      char* separator = std::strrchr(optarg, ':');
+      if (separator == nullptr) {
+        return false;
+      }
+      *separator = '\0';
+      options.brokerHost = optarg;
+      options.brokerPort = static_cast<uint16_t>(std::atoi(separator + 1));
+      break;
+    }
+    case 'k':
+      options.tlsDir = optarg;
+      break;
+    case 't':
+      options.traceFile = optarg;
+      break;
+    case 'v':
+      options.isVerbose = true;
+      break;
+    default:
+      return false;
+    }
+  }
+  // Cloud and broker round trip are simulated by the stand-in only
+  return options.brokerHost == nullptr ||
+         (not options.hasConfigChange && options.ackDelayMs == 0);
+}
+
+/**
+ * @brief Send a shadow delta with the changed field as the cloud would.
+ *
+ * @return
+ *   - common::Error::OK: Success.
+ *   - common::Error::NO_MEM: Previous message not delivered yet.
+ *   - common::Error::FAIL: Delta does not fit.
+ */
+common::Error injectConfigChange(net::fake::MqttClient& mqttClient,
+                                 const ConfigChange& change) {
+  std::array<char, net::fake::MqttClient::MAX_PAYLOAD_SIZE> delta{};
+  const int length = std::snprintf(
+      delta.data(), delta.size(), R"({"version":1,"state":{"%s":%g}})",
+      change.key.data(), change.value);
+  if (length < 0 || static_cast<size_t>(length) >= delta.size()) {
+    return common::Error::FAIL;
+  }
+
+  ESP_LOGI(TAG.data(), "Cloud sets %s to %g", change.key.data(),
+           change.value);
+  return mqttClient.injectMessage(
+      DELTA_TOPIC, {delta.data(), static_cast<size_t>(length)});
+}
+
+void logStats(const hw::fake::Sx127x& bus, const app::Hub& hub) {
+  const hw::fake::Sx127x::Stats radioStats = bus.getStats();
+  ESP_LOGI(TAG.data(),
+           "Radio: sent %lu, received %lu, collisions %lu, missed %lu",
+           static_cast<unsigned long>(radioStats.sent),
+           static_cast<unsigned long>(radioStats.received),
+           static_cast<unsigned long>(radioStats.collisions),
+           static_cast<unsigned long>(radioStats.missed));
+
+  const radio::ListenBeforeTalk::Stats lbtStats =
+      hub.getListenBeforeTalk().getStats();
+  ESP_LOGI(TAG.data(), "LBT: deferrals %lu, busy drops %lu",
+           static_cast<unsigned long>(lbtStats.deferrals),
+           static_cast<unsigned long>(lbtStats.busyDrops));
+
+  const radio::DutyCycleLimiter::Stats dutyCycleStats =
+      hub.getDutyCycleLimiter().getStats();
+  ESP_LOGI(TAG.data(), "Duty cycle: deferrals %lu, airtime %llu [us]",
+           static_cast<unsigned long>(dutyCycleStats.deferrals),
+           static_cast<unsigned long long>(dutyCycleStats.airtimeUs));
+
+  const sw::LatencyMeter::Stats irqStats =
+      hub.getRadioThread().getIrqLatencyStats();
+  ESP_LOGI(TAG.data(), "IRQ latency: count %lu, mean %llu, max %lu [us]",
+           static_cast<unsigned long>(irqStats.count),
+           static_cast<unsigned long long>(
+               irqStats.count != 0 ? irqStats.totalUs / irqStats.count : 0),
+           static_cast<unsigned long>(irqStats.maxUs));
+}
+
+void logMqttStats(const app::Hub& hub, const uint32_t published,
+                  const uint32_t acknowledged, const uint32_t delivered) {
+  const app::Hub::TelemetryQueue::Stats queueStats =
+      hub.getTelemetryQueueStats();
+  ESP_LOGI(TAG.data(),
+           "MQTT: published %lu, acknowledged %lu, delivered %lu, queue high "
+           "water %lu, drops %lu",
+           static_cast<unsigned long>(published),
+           static_cast<unsigned long>(acknowledged),
+           static_cast<unsigned long>(delivered),
+           static_cast<unsigned long>(queueStats.highWaterMark),
+           static_cast<unsigned long>(queueStats.drops));
+}
+
+void logHandshakeStats(
+    const char* kind,
+    const net::fake::SocketMqttClient::HandshakeStats& handshakeStats) {
+  ESP_LOGI(TAG.data(), "TLS %s handshakes: %lu, mean %lu ms, peak heap %lu B",
+           kind, static_cast<unsigned long>(handshakeStats.count),
+           static_cast<unsigned long>(
+               handshakeStats.count != 0
+                   ? handshakeStats.totalMs / handshakeStats.count
+                   : 0),
+           static_cast<unsigned long>(handshakeStats.maxPeakHeap));
+}
+
+/**
+ * @brief Log keep alive and handshakes of the socket client, the broker
+ * logs what it received.
+ */
+void logSocketStats(const net::fake::SocketMqttClient& socketClient) {
+  const net::fake::SocketMqttClient::Stats socketStats =
+      socketClient.getStats();
+  ESP_LOGI(TAG.data(),
+           "Keep alive: PINGREQ %lu, with messages in flight %lu, PINGRESP "
+           "%lu",
+           static_cast<unsigned long>(socketStats.pings),
+           static_cast<unsigned long>(socketStats.pingsInFlight),
+           static_cast<unsigned long>(socketStats.pingResponses));
+  logHandshakeStats("full", socketStats.fullHandshakes);
+  logHandshakeStats("resumed", socketStats.resumedHandshakes);
+}
+
+void logAllocations() {
+  const char* lastScope = sw::AllocationGuard::getLastScope();
+  ESP_LOGI(TAG.data(), "Hot path allocations: %lu, %lu bytes%s%s",
+           static_cast<unsigned long>(
+               sw::AllocationGuard::getTotalAllocations()),
+           static_cast<unsigned long>(sw::AllocationGuard::getTotalBytes()),
+           lastScope ? ", last in " : "", lastScope ? lastScope : "");
+}
+
+/**
+ * @brief Log the final metrics snapshot, the cloud thread publishes them
+ * periodically while running.
+ */
+void logMetrics(const sw::metrics::Registry& metrics) {
+  constexpr uint64_t US_PER_S{1'000'000};
+  std::array<char, packet::aws::METRICS_BUFFER_SIZE> buffer{};
+  packet::aws::Metrics metricsPacket{
+      metrics, static_cast<uint32_t>(sw::getUptimeUs() / US_PER_S)};
+  if (metricsPacket.serializeToJson(buffer.data(), buffer.size()) !=
+      common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to parse metrics to JSON");
+    return;
+  }
+
+  ESP_LOGI(TAG.data(), "%s %s", METRICS_TOPIC.data(), buffer.data());
+}
+
+/**
+ * @brief Write recorded events as Chrome trace JSON to a file.
+ */
+void writeTrace(const char* path) {
+  std::FILE* file = std::fopen(path, "w");
+  if (file == nullptr) {
+    ESP_LOGE(TAG.data(), "Failed to open %s", path);
+    return;
+  }
+
+  const size_t count = sw::trace::dump(file);
+  std::fclose(file);
+  ESP_LOGI(TAG.data(), "Trace: %zu events in %s", count, path);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options{};
+  if (not parseOptions(argc, argv, options)) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  esp_log_level_set("*", options.isVerbose ? ESP_LOG_DEBUG : ESP_LOG_INFO);
+  std::signal(SIGINT, [](int) { isStopRequested = true; });
+  std::signal(SIGTERM, [](int) { isStopRequested = true; });
+  // A write to a socket the broker closed fails instead of killing the hub
+  std::signal(SIGPIPE, SIG_IGN);
+  if (options.traceFile) {
+    sw::trace::enable();
+  }
+
+  common::Error errorCode{common::Error::OK};
+
+  // Configuration as if it was set from the cloud before
+  storage::fake::RamStore storage;
+  errorCode = app::ConfigStore{{storage}}.save(options.deviceConfig);
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Invalid config options");
+    return EXIT_FAILURE;
+  }
+
+  hw::fake::Gpio rst{4};
+  hw::fake::Gpio dio0{17};
+  hw::fake::Sx127x bus{{dio0, 0, options.basePort}};
+  errorCode = bus.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init simulated radio");
+    return EXIT_FAILURE;
+  }
+
+  hw::SpiDeviceHandle spiRfm95Handle{nullptr};
+  radio::Rfm95 rfm95{{rst, dio0, bus, spiRfm95Handle}};
+
+  // No LED on the host, events are only logged
+  sw::Queue<def::ui::LedEvent> ledEventQueue{5};
+  errorCode = ledEventQueue.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to led event queue");
+  }
+  ledEventQueue.setCallback(
+      [](def::ui::LedEvent event, common::Argument) {
+        ESP_LOGD(TAG.data(), "LED event: %u", static_cast<unsigned>(event));
+      },
+      nullptr);
+
+  // Network is up from the start, there is no Wi-Fi to wait for
+  sw::EventGroup connectionEventGroup;
+  errorCode = connectionEventGroup.init();
+  if (errorCode == common::Error::OK) {
+    errorCode = connectionEventGroup.set(def::net::WIFI_CONNECTED_BIT);
+  }
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init connection event group");
+  }
+
+  net::fake::MqttClient mqttClient{options.ackDelayMs};
+  errorCode = mqttClient.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init MQTT stand-in");
+    return EXIT_FAILURE;
+  }
+
+  const std::string tlsDir{options.tlsDir ? options.tlsDir : ""};
+  const std::string caFile{tlsDir + "/ca.crt"};
+  const std::string certFile{tlsDir + "/hub.crt"};
+  const std::string keyFile{tlsDir + "/hub.key"};
+  std::unique_ptr<net::fake::SocketMqttClient> socketClient{};
+  if (options.brokerHost) {
+    socketClient = std::make_unique<net::fake::SocketMqttClient>(
+        THING_NAME,
+        net::fake::SocketMqttClient::Settings{
+            options.brokerHost, options.brokerPort,
+            options.tlsDir ? caFile.c_str() : nullptr,
+            options.tlsDir ? certFile.c_str() : nullptr,
+            options.tlsDir ? keyFile.c_str() : nullptr});
+    errorCode = socketClient->init();
+    if (errorCode != common::Error::OK) {
+      ESP_LOGE(TAG.data(), "Failed to load TLS credentials from %s",
+               tlsDir.c_str());
+      return EXIT_FAILURE;
+    }
+    // OpenSSL library and context take some 400 KB, mbedTLS far less
+    esp_host_set_heap_baseline();
+  }
+  net::IMqttClient& cloudClient =
+      socketClient ? static_cast<net::IMqttClient&>(*socketClient)
+                   : mqttClient;
+
+  LinkPower linkPower;
+
+  storage::fake::FileFlash telemetryFlash{TELEMETRY_LOG_PATH,
+                                          TELEMETRY_LOG_SIZE};
+  errorCode = telemetryFlash.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to open %s", TELEMETRY_LOG_PATH.data());
+  }
+
+  storage::FlashLog<common::TelemetrySummary> telemetryLog{telemetryFlash};
+  errorCode = telemetryLog.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init telemetry log");
+  }
+
+  app::Hub hub{{rfm95, storage, ledEventQueue, connectionEventGroup,
+                 cloudClient, linkPower, telemetryLog, THING_NAME},
+               options.hubSettings};
+  errorCode = hub.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init Hub");
+  }
+
+  errorCode = hub.start();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to start Hub");
+  }
+
+  const common::Time configChangeMs =
+      sw::getUptimeMs() + common::utils::sToMs<common::Time, common::Time>(
+                              options.configChange.afterS);
+  bool isConfigChangeDue{options.hasConfigChange};
+  while (not isStopRequested) {
+    // Retried until the stand-in takes it
+    if (isConfigChangeDue && sw::getUptimeMs() >= configChangeMs &&
+        injectConfigChange(mqttClient, options.configChange) !=
+            common::Error::NO_MEM) {
+      isConfigChangeDue = false;
+    }
+
+    while (ledEventQueue.yield()) {
+    }
+    hub.yield();
+    sw::delayMs(10);
+  }
+
+  logStats(bus, hub);
+  if (socketClient) {
+    const net::fake::SocketMqttClient::Stats socketStats =
+        socketClient->getStats();
+    logSocketStats(*socketClient);
+    logMqttStats(hub, socketStats.published, socketStats.acknowledged,
+                 socketStats.delivered);
+  } else {
+    const net::fake::MqttClient::Stats mqttStats = mqttClient.getStats();
+    logMqttStats(hub, mqttStats.published, mqttStats.acknowledged,
+                 mqttStats.delivered);
+  }
+  logAllocations();
+  logMetrics(hub.getMetrics());
+  if (options.traceFile) {
+    writeTrace(options.traceFile);
+  }
+  // Threads run forever like on the target, don't unwind under them
+  std::fflush(stdout);
+  std::_Exit(EXIT_SUCCESS);
+}
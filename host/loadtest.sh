@@ -0,0 +1,52 @@
+#!/bin/sh
+# Runs the hub and controllers on the simulated radio and prints their stats.
+# Usage: loadtest.sh hub_binary controller_binary controllers duration_s sf
+set -e
+
+HUB=$1
+CONTROLLER=$2
+CONTROLLERS=${3:-4}
+DURATION_S=${4:-60}
+SF=${5:-7}
+
+rm -f hub.log controller-*.log timeline.log *.trace.json *.flash
+PIDS=""
+# Measurement period is changed from the cloud a third into the run
+"$HUB" -s "$SF" -r 6 -c "measurementPeriodS=2@$((DURATION_S / 3))" \
+  -t hub.trace.json -v > hub.log &
+PIDS="$PIDS $!"
+for ID in $(seq 1 "$CONTROLLERS"); do
+  "$CONTROLLER" -i "$ID" -s "$SF" -m 1 -t "controller-$ID.trace.json" -v \
+    > "controller-$ID.log" &
+  PIDS="$PIDS $!"
+done
+
+sleep "$DURATION_S"
+kill -INT $PIDS 2>/dev/null || true
+wait || true
+
+# Log time is the shared monotonic clock, one timeline shows the whole path
+sort -s -t '(' -k 2 -n hub.log controller-*.log > timeline.log
+
+echo "Hub:"
+tail -n 8 hub.log
+for ID in $(seq 1 "$CONTROLLERS"); do
+  echo "Controller $ID:"
+  tail -n 5 "controller-$ID.log"
+done
+echo "Logs in $(pwd), merged in timeline.log, traces in *.trace.json"
+
+# Shadow delta must reach the radio thread, which delivers it to the
+# controllers on their next exchange
+if ! grep -q "Shadow field measurementPeriodS set to 2" hub.log; then
+  echo "Config change from the cloud not applied, see hub.log"
+  exit 1
+fi
+echo "Config change applied by $(grep -l "Config applied" controller-*.log \
+  | wc -l) of $CONTROLLERS controllers"
+
+# Radio, queue and AwsIotThread publish paths of the hub must not allocate
+if ! grep -q "Hot path allocations: 0," hub.log; then
+  echo "Heap allocations in hot paths, see hub.log"
+  exit 1
+fi
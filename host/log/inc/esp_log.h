@@ -0,0 +1,57 @@
+#pragma once
+
+// Host stand-in for the ESP-IDF logging macros. Lines keep the ESP-IDF
+// format "I (time) TAG: message", time is CLOCK_MONOTONIC in milliseconds so
+// logs of processes on one machine can be merged on it.
+
+#include <cstdint>
+
+typedef enum {
+  ESP_LOG_NONE,
+  ESP_LOG_ERROR,
+  ESP_LOG_WARN,
+  ESP_LOG_INFO,
+  ESP_LOG_DEBUG,
+  ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+/**
+ * @brief Set the highest level written, ESP_LOG_INFO by default.
+ *
+ * @param tag Only "*" is supported, the level applies to all tags.
+ * @param level Log level.
+ */
+void esp_log_level_set(const char* tag, esp_log_level_t level);
+
+/**
+ * @brief Get milliseconds of the monotonic clock.
+ *
+ * @return Time in milliseconds.
+ */
+uint32_t esp_log_timestamp();
+
+/**
+ * @brief Write a log line if its level is enabled.
+ *
+ * @param level Log level.
+ * @param tag Log tag.
+ * @param format printf format string.
+ */
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format,
+                   ...) __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOG_LEVEL(level, letter, tag, format, ...)                         \
+  esp_log_write(level, tag, letter " (%lu) %s: " format "\n",                  \
+                static_cast<unsigned long>(esp_log_timestamp()), tag,          \
+                ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...)                                             \
+  ESP_LOG_LEVEL(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)                                             \
+  ESP_LOG_LEVEL(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)                                             \
+  ESP_LOG_LEVEL(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)                                             \
+  ESP_LOG_LEVEL(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)                                             \
+  ESP_LOG_LEVEL(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
@@ -0,0 +1,29 @@
+#pragma once
+
+// Host stand-in for the ESP-IDF heap size queries. The host heap has no
+// fixed size, free heap is counted down from HOST_HEAP_SIZE by the bytes
+// malloc has handed out, so differences match the target.
+
+#include <cstdint>
+
+/**
+ * @brief Get the free heap size.
+ *
+ * @return HOST_HEAP_SIZE less the bytes in use above the baseline.
+ */
+uint32_t esp_get_free_heap_size();
+
+/**
+ * @brief Get the lowest free heap size seen by esp_get_free_heap_size().
+ * @note The target tracks every allocation, here only the calls are seen.
+ *
+ * @return Lowest free heap size in bytes.
+ */
+uint32_t esp_get_minimum_free_heap_size();
+
+/**
+ * @brief Host only, counts the bytes in use now as outside the heap, e.g.
+ * OpenSSL library state that the hub has no counterpart of.
+ * @note Call once at start, before threads measure the heap.
+ */
+void esp_host_set_heap_baseline();
@@ -0,0 +1,36 @@
+#include "esp_log.h"
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+std::atomic<esp_log_level_t> maxLevel{ESP_LOG_INFO};
+} // namespace
+
+void esp_log_level_set(const char* tag, esp_log_level_t level) {
+  (void)tag;
+  maxLevel = level;
+}
+
+uint32_t esp_log_timestamp() {
+  timespec now{};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint32_t>(static_cast<uint64_t>(now.tv_sec) * 1000 +
+                               static_cast<uint64_t>(now.tv_nsec) / 1'000'000);
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format,
+                   ...) {
+  (void)tag;
+  if (level > maxLevel) {
+    return;
+  }
+
+  va_list args;
+  va_start(args, format);
+  // A single call keeps lines of different threads apart
+  std::vfprintf(stdout, format, args);
+  va_end(args);
+  std::fflush(stdout);
+}
@@ -0,0 +1,36 @@
+#include "esp_system.h"
+#include <algorithm>
+#include <atomic>
+#include <malloc.h>
+
+namespace {
+// Free heap of the hub after start, before Wi-Fi and TLS
+constexpr uint64_t HOST_HEAP_SIZE{300 * 1024};
+std::atomic<uint32_t> minimumFreeHeap{UINT32_MAX};
+std::atomic<uint64_t> baselineUsed{0};
+} // namespace
+
+uint32_t esp_get_free_heap_size() {
+  const uint64_t inUse = mallinfo2().uordblks;
+  const uint64_t baseline = baselineUsed.load(std::memory_order_relaxed);
+  const uint64_t used = inUse > baseline ? inUse - baseline : 0;
+  const auto freeHeap =
+      static_cast<uint32_t>(used < HOST_HEAP_SIZE ? HOST_HEAP_SIZE - used : 0);
+
+  uint32_t minimum = minimumFreeHeap.load(std::memory_order_relaxed);
+  while (freeHeap < minimum && not minimumFreeHeap.compare_exchange_weak(
+                                   minimum, freeHeap,
+                                   std::memory_order_relaxed)) {
+  }
+  return freeHeap;
+}
+
+uint32_t esp_get_minimum_free_heap_size() {
+  return std::min(esp_get_free_heap_size(),
+                  minimumFreeHeap.load(std::memory_order_relaxed));
+}
+
+void esp_host_set_heap_baseline() {
+  baselineUsed.store(mallinfo2().uordblks, std::memory_order_relaxed);
+  minimumFreeHeap.store(UINT32_MAX, std::memory_order_relaxed);
+}
@@ -0,0 +1,689 @@
+#include "esp_log.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <poll.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+// Minimal MQTT 3.1.1 broker on localhost, optionally TLS, for the host hub.
+// It checks every packet of the client against the specification with its
+// own parser, acknowledges QoS1 PUBLISH after a set delay and answers
+// PINGREQ. Messages are not routed, subscriptions are only acknowledged. On
+// exit it prints what it has seen: handshakes, publishes, retries, PINGREQ
+// with messages unacknowledged and protocol errors.
+
+namespace {
+static constexpr std::string_view TAG{"BROKER"};
+static constexpr size_t MAX_CONNECTIONS{16};
+static constexpr size_t MAX_PACKET_SIZE{16 * 1024};
+static constexpr uint8_t MQTT_3_1_1_LEVEL{4};
+static constexpr uint32_t TLS_HANDSHAKE_TIMEOUT_S{5};
+static constexpr uint32_t IDLE_POLL_MS{1000};
+
+/**
+ * @brief Command line options
+ */
+struct Options {
+    uint16_t port{1883};
+    const char* certFile{nullptr}; // TLS if set
+    const char* keyFile{nullptr};
+    const char* caFile{nullptr}; // Client certificate required if set
+    uint32_t ackDelayMs{0};      // Time from PUBLISH to PUBACK
+    uint32_t dropAfterS{0};      // Connections are closed after, 0 never
+    bool isResumptionEnabled{true};
+    bool isVerbose{false};
+};
+
+/**
+ * @brief What the broker has seen since start
+ */
+struct Stats {
+    uint32_t connections;
+    uint32_t fullHandshakes;
+    uint32_t resumedHandshakes;
+    uint64_t fullHandshakeUs;
+    uint64_t resumedHandshakeUs;
+    uint32_t publishes;
+    uint32_t duplicates;   // PUBLISH sent again with DUP
+    uint32_t pings;        // PINGREQ
+    uint32_t pingsInFlight; // PINGREQ with a PUBACK outstanding
+    uint32_t drops;
+    uint32_t protocolErrors;
+};
+
+/**
+ * @brief PUBACK waiting for its delay
+ */
+struct PendingAck {
+    uint16_t packetId;
+    uint32_t dueMs;
+};
+
+/**
+ * @brief Client connection
+ */
+struct Connection {
+    int socket{-1};
+    SSL* tls{nullptr};
+    std::vector<uint8_t> rx{};
+    std::deque<PendingAck> pendingAcks{};
+    std::string clientId{};
+    bool isConnected{false}; // CONNECT received
+    uint16_t keepAliveS{0};
+    uint32_t openedMs{0};
+    uint32_t lastReceivedMs{0};
+};
+
+std::atomic<bool> isStopRequested{false};
+Options options{};
+Stats stats{};
+SSL_CTX* tlsContext{nullptr};
+std::vector<std::unique_ptr<Connection>> connections{};
+
+void printUsage(const char* name) {
+  std::printf("Usage: %s [-p port] [-c cert_file -k key_file [-a ca_file]] "
+              "[-l puback_latency_ms] [-x drop_after_s] [-n] [-v]\n",
+              name);
+}
+
+/**
+ * @brief Parse command line options.
+ *
+ * @return False if an option is unknown or TLS is incomplete.
+ */
+bool parseOptions(int argc, char** argv) {
+  int option{0};
+  while ((option = getopt(argc, argv, "p:c:k:a:l:x:nvh")) != -1) {
+    switch (option) {
+    case 'p':
+      options.port = static_cast<uint16_t>(std::atoi(optarg));
+      break;
+    case 'c':
+      options.certFile = optarg;
+      break;
+    case 'k':
+      options.keyFile = optarg;
+      break;
+    case 'a':
+      options.caFile = optarg;
+      break;
+    case 'l':
+      options.ackDelayMs = static_cast<uint32_t>(std::atoi(optarg));
+      break;
+    case 'x':
+      options.dropAfterS = static_cast<uint32_t>(std::atoi(optarg));
+      break;
+    case 'n':
+      options.isResumptionEnabled = false;
+      break;
+    case 'v':
+      options.isVerbose = true;
+      break;
+    default:
+      return false;
+    }
+  }
+  return (options.certFile == nullptr) == (options.keyFile == nullptr) &&
+         (options.caFile == nullptr || options.certFile != nullptr);
+}
+
+uint64_t getTimeUs() {
+  timespec now{};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1'000'000 +
+         static_cast<uint64_t>(now.tv_nsec) / 1000;
+}
+
+uint32_t getTimeMs() { return static_cast<uint32_t>(getTimeUs() / 1000); }
+
+/**
+ * @brief Set up the TLS server context.
+ *
+ * @return False if certificate or key can't be loaded.
+ */
+bool initTls() {
+  tlsContext = SSL_CTX_new(TLS_server_method());
+  if (tlsContext == nullptr ||
+      SSL_CTX_use_certificate_chain_file(tlsContext, options.certFile) != 1 ||
+      SSL_CTX_use_PrivateKey_file(tlsContext, options.keyFile,
+                                  SSL_FILETYPE_PEM) != 1) {
+    ERR_print_errors_fp(stderr);
+    return false;
+  }
+
+  if (options.caFile) {
+    if (SSL_CTX_load_verify_locations(tlsContext, options.caFile, nullptr) !=
+        1) {
+      ERR_print_errors_fp(stderr);
+      return false;
+    }
+    SSL_CTX_set_verify(tlsContext,
+                       SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT,
+                       nullptr);
+  }
+
+  if (options.isResumptionEnabled) {
+    // Sessions of verified clients are only resumed within this context
+    constexpr std::string_view SESSION_ID_CONTEXT{"mqtt-broker"};
+    SSL_CTX_set_session_id_context(
+        tlsContext,
+        reinterpret_cast<const unsigned char*>(SESSION_ID_CONTEXT.data()),
+        SESSION_ID_CONTEXT.size());
+  } else {
+    SSL_CTX_set_session_cache_mode(tlsContext, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_options(tlsContext, SSL_OP_NO_TICKET);
+  }
+  return true;
+}
+
+int openListener() {
+  const int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  const int isReused{1};
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &isReused, sizeof(isReused));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options.port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (listener < 0 ||
+      bind(listener, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(listener, static_cast<int>(MAX_CONNECTIONS)) != 0) {
+    ESP_LOGE(TAG.data(), "Failed to listen on port %u: %s", options.port,
+             std::strerror(errno));
+    return -1;
+  }
+  return listener;
+}
+
+void close(Connection& connection, const char* reason) {
+  ESP_LOGI(TAG.data(), "Closing %s: %s", connection.clientId.c_str(), reason);
+  if (connection.tls) {
+    SSL_shutdown(connection.tls);
+    SSL_free(connection.tls);
+    connection.tls = nullptr;
+  }
+  ::close(connection.socket);
+  connection.socket = -1;
+}
+
+void protocolError(Connection& connection, const char* error) {
+  ++stats.protocolErrors;
+  ESP_LOGE(TAG.data(), "Protocol error from %s: %s",
+           connection.clientId.c_str(), error);
+  close(connection, "protocol error");
+}
+
+/**
+ * @brief Write a whole packet, the socket is non-blocking.
+ *
+ * @return False on a connection error.
+ */
+bool write(Connection& connection, const uint8_t* data, const size_t length) {
+  size_t written{0};
+  while (written < length) {
+    ssize_t result{0};
+    bool isBlocked{false};
+    if (connection.tls) {
+      result = SSL_write(connection.tls, &data[written],
+                         static_cast<int>(length - written));
+      const int error = SSL_get_error(connection.tls, static_cast<int>(result));
+      isBlocked = result <= 0 && (error == SSL_ERROR_WANT_WRITE ||
+                                  error == SSL_ERROR_WANT_READ);
+    } else {
+      result = send(connection.socket, &data[written], length - written,
+                    MSG_NOSIGNAL);
+      isBlocked = result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+
+    if (result > 0) {
+      written += static_cast<size_t>(result);
+    } else if (isBlocked) {
+      pollfd socket{connection.socket, POLLOUT, 0};
+      poll(&socket, 1, static_cast<int>(IDLE_POLL_MS));
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint16_t readUint16(const uint8_t* data) {
+  return static_cast<uint16_t>(data[0] << 8 | data[1]);
+}
+
+/**
+ * @brief Read a length prefixed string of the variable header or payload.
+ *
+ * @return False if it does not fit the packet.
+ */
+bool readString(const uint8_t* data, const size_t length, size_t& offset,
+                std::string_view& value) {
+  if (offset + 2 > length) {
+    return false;
+  }
+  const size_t size = readUint16(&data[offset]);
+  offset += 2;
+  if (offset + size > length) {
+    return false;
+  }
+  value = {reinterpret_cast<const char*>(&data[offset]), size};
+  offset += size;
+  return true;
+}
+
+void handleConnect(Connection& connection, const uint8_t flags,
+                   const uint8_t* data, const size_t length) {
+  size_t offset{0};
+  std::string_view protocol{};
+  std::string_view clientId{};
+  if (flags != 0 || connection.isConnected ||
+      not readString(data, length, offset, protocol) || protocol != "MQTT" ||
+      offset + 4 > length || data[offset] != MQTT_3_1_1_LEVEL) {
+    protocolError(connection, "invalid CONNECT");
+    return;
+  }
+
+  const uint8_t connectFlags = data[offset + 1];
+  connection.keepAliveS = readUint16(&data[offset + 2]);
+  offset += 4;
+  // Reserved flag must be 0, will, user name and password are not expected
+  if ((connectFlags & 0xFD) != 0 ||
+      not readString(data, length, offset, clientId) || offset != length) {
+    protocolError(connection, "unsupported CONNECT flags or payload");
+    return;
+  }
+
+  connection.isConnected = true;
+  connection.clientId = std::string{clientId};
+  ++stats.connections;
+  ESP_LOGI(TAG.data(), "%s connected, keep alive %u s",
+           connection.clientId.c_str(), connection.keepAliveS);
+  const uint8_t connack[]{0x20, 0x02, 0x00, 0x00};
+  write(connection, connack, sizeof(connack));
+}
+
+void handlePublish(Connection& connection, const uint8_t flags,
+                   const uint8_t* data, const size_t length) {
+  const uint8_t qos = (flags >> 1) & 0x03;
+  const bool isDuplicate = (flags & 0x08) != 0;
+  size_t offset{0};
+  std::string_view topic{};
+  if (qos > 1 || (qos == 0 && isDuplicate) ||
+      not readString(data, length, offset, topic) || topic.empty() ||
+      topic.find_first_of("+#") != std::string_view::npos) {
+    protocolError(connection, "invalid PUBLISH header or topic");
+    return;
+  }
+
+  ++stats.publishes;
+  if (options.isVerbose) {
+    ESP_LOGI(TAG.data(), "PUBLISH QoS%u%s %.*s %.*s", qos,
+             isDuplicate ? " DUP" : "", static_cast<int>(topic.size()),
+             topic.data(), static_cast<int>(length - offset - (qos ? 2 : 0)),
+             reinterpret_cast<const char*>(&data[offset + (qos ? 2 : 0)]));
+  }
+  if (qos == 0) {
+    return;
+  }
+
+  if (offset + 2 > length) {
+    protocolError(connection, "PUBLISH without packet ID");
+    return;
+  }
+  const uint16_t packetId = readUint16(&data[offset]);
+  const bool isPending = std::any_of(
+      connection.pendingAcks.begin(), connection.pendingAcks.end(),
+      [packetId](const PendingAck& ack) { return ack.packetId == packetId; });
+  // A new message must not take an ID still waiting for its PUBACK
+  if (packetId == 0 || (isPending && not isDuplicate)) {
+    protocolError(connection, "packet ID 0 or in use");
+    return;
+  }
+
+  if (isDuplicate) {
+    ++stats.duplicates;
+  }
+  if (not isPending) {
+    connection.pendingAcks.push_back(
+        {packetId, getTimeMs() + options.ackDelayMs});
+  }
+}
+
+void handleSubscribe(Connection& connection, const uint8_t flags,
+                     const uint8_t* data, const size_t length) {
+  if (flags != 0x02 || length < 2) {
+    protocolError(connection, "invalid SUBSCRIBE header");
+    return;
+  }
+
+  const uint16_t packetId = readUint16(data);
+  std::vector<uint8_t> suback{0x90, 0x00, data[0], data[1]};
+  size_t offset{2};
+  std::string_view filter{};
+  while (offset < length) {
+    if (not readString(data, length, offset, filter) || filter.empty() ||
+        offset >= length || data[offset] > 2) {
+      protocolError(connection, "invalid SUBSCRIBE filter");
+      return;
+    }
+    ESP_LOGI(TAG.data(), "%s subscribed to %.*s", connection.clientId.c_str(),
+             static_cast<int>(filter.size()), filter.data());
+    suback.push_back(std::min<uint8_t>(data[offset], 1));
+    ++offset;
+  }
+
+  if (suback.size() == 4 || packetId == 0) {
+    protocolError(connection, "SUBSCRIBE without filter or packet ID");
+    return;
+  }
+  suback[1] = static_cast<uint8_t>(suback.size() - 2);
+  write(connection, suback.data(), suback.size());
+}
+
+void handlePacket(Connection& connection, const uint8_t header,
+                  const uint8_t* data, const size_t length) {
+  const uint8_t type = header >> 4;
+  const uint8_t flags = header & 0x0F;
+  if (not connection.isConnected && type != 1) {
+    protocolError(connection, "packet before CONNECT");
+    return;
+  }
+
+  switch (type) {
+  case 1:
+    handleConnect(connection, flags, data, length);
+    break;
+  case 3:
+    handlePublish(connection, flags, data, length);
+    break;
+  case 8:
+    handleSubscribe(connection, flags, data, length);
+    break;
+  case 12: {
+    if (flags != 0 || length != 0) {
+      protocolError(connection, "invalid PINGREQ");
+      return;
+    }
+    ++stats.pings;
+    if (not connection.pendingAcks.empty()) {
+      ++stats.pingsInFlight;
+    }
+    ESP_LOGI(TAG.data(), "PINGREQ from %s, %zu PUBLISH unacknowledged",
+             connection.clientId.c_str(), connection.pendingAcks.size());
+    const uint8_t pingresp[]{0xD0, 0x00};
+    write(connection, pingresp, sizeof(pingresp));
+    break;
+  }
+  case 14:
+    close(connection, "DISCONNECT");
+    break;
+  default:
+    protocolError(connection, "unexpected packet type");
+    break;
+  }
+}
+
+/**
+ * @brief Read what arrived and handle complete packets.
+ */
+void receive(Connection& connection) {
+  std::array<uint8_t, 4096> buffer{};
+  while (connection.socket >= 0) {
+    ssize_t result{0};
+    if (connection.tls) {
+      result = SSL_read(connection.tls, buffer.data(),
+                        static_cast<int>(buffer.size()));
+      if (result <= 0) {
+        const int error =
+            SSL_get_error(connection.tls, static_cast<int>(result));
+        if (error != SSL_ERROR_WANT_READ) {
+          close(connection, "connection closed");
+        }
+        break;
+      }
+    } else {
+      result = recv(connection.socket, buffer.data(), buffer.size(), 0);
+      if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      }
+      if (result <= 0) {
+        close(connection, "connection closed");
+        break;
+      }
+    }
+
+    connection.lastReceivedMs = getTimeMs();
+    connection.rx.insert(connection.rx.end(), buffer.begin(),
+                         buffer.begin() + result);
+  }
+
+  size_t offset{0};
+  while (connection.socket >= 0 && offset < connection.rx.size()) {
+    // Remaining length takes 1 to 4 bytes, 7 bits each
+    size_t remainingLength{0};
+    size_t index{offset + 1};
+    bool isComplete{false};
+    for (uint32_t shift = 0; index < connection.rx.size() && shift < 28;
+         shift += 7) {
+      const uint8_t byte = connection.rx[index++];
+      remainingLength |= static_cast<size_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        isComplete = true;
+        break;
+      }
+    }
+    if (not isComplete) {
+      if (index - offset > 4) {
+        protocolError(connection, "invalid remaining length");
+      }
+      break;
+    }
+    if (remainingLength > MAX_PACKET_SIZE) {
+      protocolError(connection, "packet too large");
+      break;
+    }
+    if (index + remainingLength > connection.rx.size()) {
+      break;
+    }
+
+    handlePacket(connection, connection.rx[offset], &connection.rx[index],
+                 remainingLength);
+    offset = index + remainingLength;
+  }
+
+  if (connection.socket >= 0) {
+    connection.rx.erase(connection.rx.begin(), connection.rx.begin() + offset);
+  }
+}
+
+/**
+ * @brief Send PUBACKs which are due, close expired connections.
+ *
+ * @return Time until the next PUBACK is due, IDLE_POLL_MS if none.
+ */
+uint32_t service(Connection& connection) {
+  const uint32_t nowMs = getTimeMs();
+  while (not connection.pendingAcks.empty() &&
+         static_cast<int32_t>(connection.pendingAcks.front().dueMs - nowMs) <=
+             0) {
+    const uint16_t packetId = connection.pendingAcks.front().packetId;
+    connection.pendingAcks.pop_front();
+    const uint8_t puback[]{0x40, 0x02, static_cast<uint8_t>(packetId >> 8),
+                           static_cast<uint8_t>(packetId & 0xFF)};
+    if (not write(connection, puback, sizeof(puback))) {
+      close(connection, "write failed");
+      return IDLE_POLL_MS;
+    }
+  }
+
+  // Client must send a packet within one and a half keep alive intervals
+  if (connection.keepAliveS > 0 &&
+      nowMs - connection.lastReceivedMs > connection.keepAliveS * 1500u) {
+    close(connection, "keep alive expired");
+    return IDLE_POLL_MS;
+  }
+
+  if (options.dropAfterS > 0 &&
+      nowMs - connection.openedMs >= options.dropAfterS * 1000u) {
+    ++stats.drops;
+    close(connection, "dropped as set by -x");
+    return IDLE_POLL_MS;
+  }
+
+  return connection.pendingAcks.empty()
+             ? IDLE_POLL_MS
+             : std::min(IDLE_POLL_MS,
+                        connection.pendingAcks.front().dueMs - nowMs);
+}
+
+void accept(const int listener) {
+  const int socket = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+  if (socket < 0) {
+    return;
+  }
+  if (connections.size() >= MAX_CONNECTIONS) {
+    ::close(socket);
+    return;
+  }
+
+  const int isNoDelay{1};
+  setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &isNoDelay, sizeof(isNoDelay));
+  auto connection = std::make_unique<Connection>();
+  connection->socket = socket;
+  connection->clientId = "client on fd " + std::to_string(socket);
+
+  if (tlsContext) {
+    // Blocking handshake, one hub connects at a time
+    timeval timeout{TLS_HANDSHAKE_TIMEOUT_S, 0};
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    connection->tls = SSL_new(tlsContext);
+    SSL_set_fd(connection->tls, socket);
+    const uint64_t startUs = getTimeUs();
+    if (SSL_accept(connection->tls) != 1) {
+      ESP_LOGE(TAG.data(), "TLS handshake failed");
+      ERR_print_errors_fp(stderr);
+      close(*connection, "TLS handshake failed");
+      return;
+    }
+
+    const uint64_t durationUs = getTimeUs() - startUs;
+    const bool isResumed = SSL_session_reused(connection->tls) == 1;
+    if (isResumed) {
+      ++stats.resumedHandshakes;
+      stats.resumedHandshakeUs += durationUs;
+    } else {
+      ++stats.fullHandshakes;
+      stats.fullHandshakeUs += durationUs;
+    }
+    ESP_LOGI(TAG.data(), "%s TLS handshake %s in %llu us",
+             SSL_get_version(connection->tls),
+             isResumed ? "resumed" : "full",
+             static_cast<unsigned long long>(durationUs));
+  }
+
+  fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+  connection->openedMs = getTimeMs();
+  connection->lastReceivedMs = connection->openedMs;
+  connections.push_back(std::move(connection));
+}
+
+void printStats() {
+  ESP_LOGI(TAG.data(),
+           "Connections %u, full handshakes %u, mean %llu us, resumed "
+           "handshakes %u, mean %llu us",
+           stats.connections, stats.fullHandshakes,
+           static_cast<unsigned long long>(
+               stats.fullHandshakes ? stats.fullHandshakeUs /
+                                          stats.fullHandshakes
+                                    : 0),
+           stats.resumedHandshakes,
+           static_cast<unsigned long long>(
+               stats.resumedHandshakes ? stats.resumedHandshakeUs /
+                                             stats.resumedHandshakes
+                                       : 0));
+  ESP_LOGI(TAG.data(),
+           "PUBLISH %u, DUP %u, PINGREQ %u, with PUBACK outstanding %u, "
+           "drops %u, protocol errors %u",
+           stats.publishes, stats.duplicates, stats.pings, stats.pingsInFlight,
+           stats.drops, stats.protocolErrors);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  if (not parseOptions(argc, argv)) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  std::signal(SIGINT, [](int) { isStopRequested = true; });
+  std::signal(SIGTERM, [](int) { isStopRequested = true; });
+  std::signal(SIGPIPE, SIG_IGN);
+
+  if (options.certFile && not initTls()) {
+    ESP_LOGE(TAG.data(), "Failed to load TLS credentials");
+    return EXIT_FAILURE;
+  }
+
+  const int listener = openListener();
+  if (listener < 0) {
+    return EXIT_FAILURE;
+  }
+  ESP_LOGI(TAG.data(), "Listening on 127.0.0.1:%u%s, PUBACK after %u ms",
+           options.port, tlsContext ? " with TLS" : "", options.ackDelayMs);
+
+  std::vector<pollfd> sockets{};
+  while (not isStopRequested) {
+    uint32_t timeoutMs{IDLE_POLL_MS};
+    for (auto& connection : connections) {
+      timeoutMs = std::min(timeoutMs, service(*connection));
+    }
+    connections.erase(
+        std::remove_if(connections.begin(), connections.end(),
+                       [](const std::unique_ptr<Connection>& connection) {
+                         return connection->socket < 0;
+                       }),
+        connections.end());
+
+    sockets.assign(1, {listener, POLLIN, 0});
+    bool hasPendingData{false};
+    for (auto& connection : connections) {
+      sockets.push_back({connection->socket, POLLIN, 0});
+      hasPendingData |= connection->tls && SSL_pending(connection->tls) > 0;
+    }
+    if (poll(sockets.data(), sockets.size(),
+             hasPendingData ? 0 : static_cast<int>(timeoutMs)) < 0) {
+      continue;
+    }
+
+    // Connections are only added after the loop, indexes stay aligned
+    for (size_t index = 0; index < connections.size(); ++index) {
+      Connection& connection = *connections[index];
+      if (sockets[index + 1].revents != 0 ||
+          (connection.tls && SSL_pending(connection.tls) > 0)) {
+        receive(connection);
+      }
+    }
+    if (sockets[0].revents & POLLIN) {
+      accept(listener);
+    }
+  }
+
+  printStats();
+  return EXIT_SUCCESS;
+}
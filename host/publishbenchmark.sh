@@ -0,0 +1,76 @@
+#!/bin/sh
+# Runs the hub publish benchmark against the localhost MQTT broker, over TLS
+# and over plain TCP, and prints msg/s, p50/p99 latency and heap per message.
+# Fails if a message is not acknowledged, the hot path allocates, no PINGREQ
+# was sent while messages were in flight or the broker found a protocol
+# error.
+# Usage: publishbenchmark.sh hub_binary broker_binary rate_hz duration_s
+set -e
+
+HUB=$1
+BROKER=$2
+RATE_HZ=${3:-200}
+DURATION_S=${4:-40}
+PORT=${PORT:-18883}
+# PUBACK delay keeps the window full, so PINGREQ goes out with messages in
+# flight
+ACK_DELAY_MS=${ACK_DELAY_MS:-20}
+
+# Test CA with a broker and a hub certificate, the hub verifies localhost
+"$(dirname "$0")/gencerts.sh" tls
+
+# run name broker_options...
+run() {
+  NAME=$1
+  shift
+  "$BROKER" -p "$PORT" -l "$ACK_DELAY_MS" "$@" > "broker-$NAME.log" &
+  BROKER_PID=$!
+  sleep 1
+  if [ "$NAME" = "tls" ]; then
+    TLS_OPTION="-k tls"
+  else
+    TLS_OPTION=""
+  fi
+  # Radio is replaced by the benchmark, its port must not clash with a
+  # running load test
+  # shellcheck disable=SC2086
+  "$HUB" -p 15000 -b "$RATE_HZ" -d "$DURATION_S" \
+    -m "localhost:$PORT" $TLS_OPTION > "hub-$NAME.log" &
+  HUB_PID=$!
+  sleep $((DURATION_S + 15))
+  kill -INT "$HUB_PID" 2>/dev/null || true
+  wait "$HUB_PID" || true
+  kill -INT "$BROKER_PID" 2>/dev/null || true
+  wait "$BROKER_PID" || true
+
+  echo "$NAME:"
+  grep "BENCHMARK.*msg/s" "hub-$NAME.log" || true
+  grep -E "Keep alive:|TLS .* handshakes:|Hot path" "hub-$NAME.log" || true
+  grep -E "PUBLISH [0-9]+, DUP|handshakes [0-9]+, mean" "broker-$NAME.log" \
+    || true
+
+  RESULT=$(grep -o "sent [0-9]* rejected [0-9]* acked [0-9]*" \
+    "hub-$NAME.log" || true)
+  SENT=$(echo "$RESULT" | awk '{print $2}')
+  ACKED=$(echo "$RESULT" | awk '{print $6}')
+  if [ -z "$SENT" ] || [ "$SENT" -eq 0 ] || [ "$SENT" != "$ACKED" ]; then
+    echo "Not every message acknowledged, see hub-$NAME.log"
+    exit 1
+  fi
+  if ! grep -q "Hot path allocations: 0," "hub-$NAME.log"; then
+    echo "Heap allocations in hot paths, see hub-$NAME.log"
+    exit 1
+  fi
+  if grep -q "Keep alive: .*with messages in flight 0," "hub-$NAME.log"; then
+    echo "No PINGREQ with messages in flight, see hub-$NAME.log"
+    exit 1
+  fi
+  if grep -q "Protocol error" "broker-$NAME.log"; then
+    echo "Broker found protocol errors, see broker-$NAME.log"
+    exit 1
+  fi
+}
+
+run tls -c tls/broker.crt -k tls/broker.key -a tls/ca.crt
+run tcp
+echo "Logs in $(pwd)"
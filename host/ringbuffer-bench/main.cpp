@@ -0,0 +1,153 @@
+#include "queue.hpp"
+#include "ringbuffer.hpp"
+#include "semaphore.hpp"
+#include "types.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Transfer cost of the telemetry queue types between a producer and a
+// consumer thread. The producer retries a full queue, so every item arrives
+// and throughput is limited by the queue. Latency is from send to receive.
+
+namespace {
+static constexpr uint32_t ITEMS{2'000'000};
+// Same depth as the hub telemetry queue
+static constexpr size_t CAPACITY{8};
+
+/**
+ * @brief Item with its send time, the size of a telemetry sample
+ */
+struct Sample {
+    uint64_t sentNs;
+    uint32_t sequence;
+    uint32_t payload;
+};
+
+uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief Send ITEMS samples, waiting while the queue is full.
+ */
+template <typename Buffer> void produce(Buffer& buffer) {
+  for (uint32_t i = 0; i < ITEMS; ++i) {
+    Sample sample{0, i, i * 3};
+    sample.sentNs = nowNs();
+    while (buffer.send(sample) != common::Error::OK) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+/**
+ * @brief Latencies of the received samples, checked for order.
+ */
+struct Consumer {
+    std::vector<uint32_t> latenciesNs;
+    uint32_t expected;
+    uint32_t outOfOrder;
+
+    Consumer() : latenciesNs(ITEMS), expected{0}, outOfOrder{0} {}
+
+    void take(const Sample& sample) {
+      latenciesNs[expected] = static_cast<uint32_t>(nowNs() - sample.sentNs);
+      if (sample.sequence != expected) {
+        ++outOfOrder;
+      }
+      ++expected;
+    }
+};
+
+/**
+ * @brief Run a producer and a consumer thread and print the results.
+ *
+ * @param receive Takes one sample into the consumer, false if none.
+ */
+template <typename Buffer, typename Receive>
+void run(const char* name, Buffer& buffer, Receive receive) {
+  Consumer consumer{};
+  const auto start = std::chrono::steady_clock::now();
+  std::thread producer{[&buffer] { produce(buffer); }};
+  while (consumer.expected < ITEMS) {
+    if (not receive(buffer, consumer)) {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  const auto end = std::chrono::steady_clock::now();
+
+  const double ns =
+      std::chrono::duration<double, std::nano>(end - start).count();
+  std::vector<uint32_t>& latencies = consumer.latenciesNs;
+  std::sort(latencies.begin(), latencies.end());
+  std::printf("%-28s %7.1f ns/item  %6.2f M items/s  latency p50 %6u ns  "
+              "p99 %8u ns  out of order %u\n",
+              name, ns / ITEMS, ITEMS * 1e3 / ns,
+              latencies[latencies.size() / 2],
+              latencies[latencies.size() * 99 / 100], consumer.outOfOrder);
+}
+} // namespace
+
+int main() {
+  using Ring = sw::RingBuffer<Sample, CAPACITY>;
+
+  {
+    Ring ring;
+    run("RingBuffer tryReceive", ring, [](Ring& ring, Consumer& consumer) {
+      Sample sample{};
+      if (ring.tryReceive(sample) != common::Error::OK) {
+        return false;
+      }
+      consumer.take(sample);
+      return true;
+    });
+  }
+
+  {
+    Ring ring;
+    if (ring.init() != common::Error::OK) {
+      std::printf("Failed to init ring buffer\n");
+      return EXIT_FAILURE;
+    }
+    run("RingBuffer receive (blocks)", ring,
+        [](Ring& ring, Consumer& consumer) {
+          Sample sample{};
+          if (ring.receive(sample, sw::Semaphore::WAIT_FOREVER) !=
+              common::Error::OK) {
+            return false;
+          }
+          consumer.take(sample);
+          return true;
+        });
+  }
+
+  {
+    using Mutex = sw::Queue<Sample>;
+    Mutex queue{CAPACITY};
+    if (queue.init() != common::Error::OK) {
+      std::printf("Failed to init queue\n");
+      return EXIT_FAILURE;
+    }
+    Consumer* target{nullptr};
+    queue.setCallback(
+        [](Sample sample, common::Argument arg) {
+          (*static_cast<Consumer**>(arg))->take(sample);
+        },
+        &target);
+    run("Queue yield (mutex)", queue,
+        [&target](Mutex& queue, Consumer& consumer) {
+          target = &consumer;
+          return queue.yield();
+        });
+  }
+
+  return EXIT_SUCCESS;
+}
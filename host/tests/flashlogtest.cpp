@@ -0,0 +1,203 @@
+#include "fileflash.hpp"
+#include "flashlog.hpp"
+#include <array>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+// Small sectors, so a few pages wrap the log around
+static constexpr size_t SECTOR_SIZE{512};
+static constexpr size_t SECTORS{4};
+static constexpr size_t FLASH_SIZE{SECTOR_SIZE * SECTORS};
+static constexpr size_t PAGE_SIZE{storage::FlashLog<uint32_t>::PAGE_SIZE};
+static constexpr size_t PAGES{FLASH_SIZE / PAGE_SIZE};
+static constexpr uint8_t FILL{0x5A};
+
+/**
+ * @brief Record with a payload, so a cleared byte changes its CRC
+ */
+struct Record {
+    uint32_t value;
+    std::array<uint8_t, 12> fill;
+};
+
+using Log = storage::FlashLog<Record>;
+
+Record makeRecord(const uint32_t value) {
+  Record record{value, {}};
+  record.fill.fill(FILL);
+  return record;
+}
+
+/**
+ * @brief Log on a flash file, reopened to simulate a reboot.
+ */
+class FlashLogTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      path_ = ::testing::TempDir() + "flashlog_" +
+              ::testing::UnitTest::GetInstance()->current_test_info()->name();
+      std::remove(path_.c_str());
+      reboot();
+    }
+
+    void TearDown() override {
+      log_.reset();
+      flash_.reset();
+      std::remove(path_.c_str());
+    }
+
+    /**
+     * @brief Drop RAM state and scan the flash again.
+     */
+    void reboot() {
+      log_.reset();
+      flash_ = std::make_unique<storage::fake::FileFlash>(path_, FLASH_SIZE,
+                                                          SECTOR_SIZE);
+      ASSERT_EQ(flash_->init(), common::Error::OK);
+      log_ = std::make_unique<Log>(*flash_);
+      ASSERT_EQ(log_->init(), common::Error::OK);
+    }
+
+    /**
+     * @brief Append records with increasing values until pages are written.
+     *
+     * @return Value of the next record.
+     */
+    uint32_t appendPages(const uint32_t pages, uint32_t value = 0) {
+      const uint32_t target = log_->getStats().pagesWritten + pages;
+      while (log_->getStats().pagesWritten < target) {
+        EXPECT_EQ(log_->append(makeRecord(value)), common::Error::OK);
+        ++value;
+      }
+      return value;
+    }
+
+    /**
+     * @brief Read all records.
+     *
+     * @return Values in read order.
+     */
+    std::vector<uint32_t> drain() {
+      std::vector<uint32_t> values;
+      Record record{};
+      while (log_->peek(record) == common::Error::OK) {
+        EXPECT_EQ(record.fill[0], FILL);
+        values.push_back(record.value);
+        EXPECT_EQ(log_->pop(), common::Error::OK);
+      }
+      return values;
+    }
+
+    std::string path_;
+    std::unique_ptr<storage::fake::FileFlash> flash_;
+    std::unique_ptr<Log> log_;
+};
+
+TEST_F(FlashLogTest, ReadsRecordsInAppendOrder) {
+  const uint32_t next = appendPages(2);
+  ASSERT_EQ(log_->append(makeRecord(next)), common::Error::OK);
+  ASSERT_EQ(log_->flush(), common::Error::OK);
+
+  const std::vector<uint32_t> values = drain();
+  ASSERT_EQ(values.size(), next + 1);
+  for (uint32_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(values[i], i);
+  }
+  EXPECT_TRUE(log_->isEmpty());
+}
+
+TEST_F(FlashLogTest, WrapAroundDropsOldestPages) {
+  // Twice the area, the write position passes every sector twice
+  const uint32_t next = appendPages(2 * PAGES);
+
+  const Log::Stats stats = log_->getStats();
+  EXPECT_GT(stats.pagesDropped, 0u);
+  const std::vector<uint32_t> values = drain();
+  ASSERT_FALSE(values.empty());
+  EXPECT_GT(values.front(), 0u);
+  EXPECT_EQ(values.back(), next - 1);
+  for (size_t i = 1; i < values.size(); ++i) {
+    EXPECT_EQ(values[i], values[i - 1] + 1);
+  }
+  // Erase-ahead keeps one sector free of unread data
+  EXPECT_LE(values.size() * sizeof(Record), FLASH_SIZE - SECTOR_SIZE);
+}
+
+TEST_F(FlashLogTest, SkipsPageWithWrongCrc) {
+  const uint32_t perPage = appendPages(1);
+  appendPages(2, perPage);
+
+  // Clear a payload byte of the first record on the second page
+  const uint8_t cleared{0};
+  ASSERT_EQ(flash_->write(PAGE_SIZE + PAGE_SIZE / 8, &cleared, 1),
+            common::Error::OK);
+
+  std::vector<uint32_t> values = drain();
+  EXPECT_EQ(log_->getStats().pagesCorrupted, 1u);
+  ASSERT_EQ(values.size(), 2 * perPage);
+  EXPECT_EQ(values.front(), 0u);
+  EXPECT_EQ(values[perPage], 2 * perPage);
+}
+
+TEST_F(FlashLogTest, CorruptedPageIsSkippedAfterReboot) {
+  const uint32_t perPage = appendPages(1);
+  appendPages(1, perPage);
+  const uint8_t cleared{0};
+  ASSERT_EQ(flash_->write(PAGE_SIZE / 8, &cleared, 1), common::Error::OK);
+
+  reboot();
+
+  const std::vector<uint32_t> values = drain();
+  EXPECT_EQ(log_->getStats().pagesCorrupted, 1u);
+  ASSERT_EQ(values.size(), perPage);
+  EXPECT_EQ(values.front(), perPage);
+}
+
+TEST_F(FlashLogTest, ContinuesAfterRebootFromFirstUnreadRecord) {
+  const uint32_t next = appendPages(3);
+  Record record{};
+  for (uint32_t i = 0; i < 5; ++i) {
+    ASSERT_EQ(log_->pop(), common::Error::OK);
+  }
+
+  reboot();
+
+  ASSERT_EQ(log_->peek(record), common::Error::OK);
+  EXPECT_EQ(record.value, 5u);
+
+  // New pages go after the ones written before the reboot
+  const uint32_t last = appendPages(1, next);
+  const std::vector<uint32_t> values = drain();
+  ASSERT_EQ(values.size(), last - 5);
+  EXPECT_EQ(values.back(), last - 1);
+}
+
+TEST_F(FlashLogTest, RecoversWriteAndReadPositionAfterWrapAndReboot) {
+  const uint32_t next = appendPages(PAGES + PAGES / 2);
+
+  reboot();
+
+  const uint32_t last = appendPages(1, next);
+  const std::vector<uint32_t> values = drain();
+  ASSERT_FALSE(values.empty());
+  EXPECT_EQ(values.back(), last - 1);
+  for (size_t i = 1; i < values.size(); ++i) {
+    EXPECT_EQ(values[i], values[i - 1] + 1);
+  }
+}
+
+TEST_F(FlashLogTest, RecordsNotWrittenAreLostOnReboot) {
+  const uint32_t next = appendPages(1);
+  ASSERT_EQ(log_->append(makeRecord(next)), common::Error::OK);
+
+  reboot();
+
+  const std::vector<uint32_t> values = drain();
+  ASSERT_EQ(values.size(), next);
+  EXPECT_EQ(values.back(), next - 1);
+}
+} // namespace
@@ -0,0 +1,128 @@
+#include "mqttpacket.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+using net::mqtt::PacketType;
+using net::mqtt::Publish;
+
+Publish createPublish(const std::string_view topic,
+                      const std::string_view payload, const uint16_t packetId) {
+  return {topic, reinterpret_cast<const uint8_t*>(payload.data()),
+          payload.size(), packetId, 1, false};
+}
+
+TEST(MqttPacketTest, PublishWritesQos1Packet) {
+  std::array<uint8_t, 32> buffer{};
+  const size_t length = net::mqtt::serializePublish(
+      buffer.data(), buffer.size(), createPublish("a/b", "hi", 0x1234));
+  const std::vector<uint8_t> expected{0x32, 0x09, 0x00, 0x03, 'a', '/',
+                                      'b',  0x12, 0x34, 'h',  'i'};
+  ASSERT_EQ(length, expected.size());
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), buffer.begin()));
+}
+
+TEST(MqttPacketTest, PublishSetsDuplicateFlag) {
+  std::array<uint8_t, 32> buffer{};
+  Publish publish = createPublish("a", "", 1);
+  publish.isDuplicate = true;
+  ASSERT_NE(
+      net::mqtt::serializePublish(buffer.data(), buffer.size(), publish), 0u);
+  EXPECT_EQ(buffer[0], 0x3A);
+}
+
+TEST(MqttPacketTest, PublishRoundTripsWithMultiByteRemainingLength) {
+  const std::string payload(200, 'x');
+  std::array<uint8_t, 256> buffer{};
+  const size_t length = net::mqtt::serializePublish(
+      buffer.data(), buffer.size(), createPublish("hub/telemetry", payload, 7));
+  ASSERT_NE(length, 0u);
+  // 2 + 13 + 2 + 200 = 217 takes two bytes, 0xD9 0x01
+  EXPECT_EQ(buffer[1], 0xD9);
+  EXPECT_EQ(buffer[2], 0x01);
+
+  PacketType type{};
+  size_t remainingLength{0};
+  EXPECT_EQ(net::mqtt::parseFixedHeader(buffer.data(), length, type,
+                                        remainingLength),
+            3u);
+  EXPECT_EQ(type, PacketType::PUBLISH);
+  EXPECT_EQ(remainingLength, 217u);
+
+  Publish publish{};
+  ASSERT_TRUE(net::mqtt::deserializePublish(buffer.data(), length, publish));
+  EXPECT_EQ(publish.topic, "hub/telemetry");
+  EXPECT_EQ(publish.packetId, 7);
+  EXPECT_EQ(publish.qos, 1);
+  ASSERT_EQ(publish.payloadSize, payload.size());
+  EXPECT_EQ(std::memcmp(publish.payload, payload.data(), payload.size()), 0);
+}
+
+TEST(MqttPacketTest, PublishRejectsSmallBuffer) {
+  std::array<uint8_t, 10> buffer{};
+  EXPECT_EQ(net::mqtt::serializePublish(buffer.data(), buffer.size(),
+                                        createPublish("a/b", "hi", 1)),
+            0u);
+}
+
+TEST(MqttPacketTest, FixedHeaderIncompleteOrInvalid) {
+  PacketType type{};
+  size_t remainingLength{0};
+  const std::array<uint8_t, 2> incomplete{0x30, 0x80};
+  EXPECT_EQ(net::mqtt::parseFixedHeader(incomplete.data(), incomplete.size(),
+                                        type, remainingLength),
+            0u);
+
+  const std::array<uint8_t, 6> tooLong{0x30, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+  EXPECT_EQ(net::mqtt::parseFixedHeader(tooLong.data(), tooLong.size(), type,
+                                        remainingLength),
+            0u);
+}
+
+TEST(MqttPacketTest, PubackRoundTrips) {
+  std::array<uint8_t, 4> buffer{};
+  ASSERT_EQ(
+      net::mqtt::serializePuback(buffer.data(), buffer.size(), 0xBEEF), 4u);
+  uint16_t packetId{0};
+  ASSERT_TRUE(
+      net::mqtt::deserializePuback(buffer.data(), buffer.size(), packetId));
+  EXPECT_EQ(packetId, 0xBEEF);
+
+  const std::array<uint8_t, 4> suback{0x90, 0x03, 0x00, 0x01};
+  EXPECT_FALSE(
+      net::mqtt::deserializePuback(suback.data(), suback.size(), packetId));
+}
+
+TEST(MqttPacketTest, SubackReadsReturnCode) {
+  const std::array<uint8_t, 5> refused{0x90, 0x03, 0x00, 0x05, 0x80};
+  uint16_t packetId{0};
+  uint8_t returnCode{0};
+  ASSERT_TRUE(net::mqtt::deserializeSuback(refused.data(), refused.size(),
+                                           packetId, returnCode));
+  EXPECT_EQ(packetId, 5);
+  EXPECT_EQ(returnCode, net::mqtt::SUBACK_FAILURE);
+}
+
+TEST(MqttPacketTest, ConnectAndSubscribeBytes) {
+  std::array<uint8_t, 32> buffer{};
+  size_t length = net::mqtt::serializeConnect(buffer.data(), buffer.size(),
+                                              "hub", 60, true);
+  const std::vector<uint8_t> connect{0x10, 0x0F, 0x00, 0x04, 'M', 'Q', 'T',
+                                     'T',  0x04, 0x02, 0x00, 0x3C, 0x00, 0x03,
+                                     'h',  'u',  'b'};
+  ASSERT_EQ(length, connect.size());
+  EXPECT_TRUE(std::equal(connect.begin(), connect.end(), buffer.begin()));
+
+  length = net::mqtt::serializeSubscribe(buffer.data(), buffer.size(), 2,
+                                         "a/#", 1);
+  const std::vector<uint8_t> subscribe{0x82, 0x08, 0x00, 0x02, 0x00, 0x03,
+                                       'a',  '/',  '#',  0x01};
+  ASSERT_EQ(length, subscribe.size());
+  EXPECT_TRUE(std::equal(subscribe.begin(), subscribe.end(), buffer.begin()));
+}
+} // namespace
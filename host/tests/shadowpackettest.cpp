@@ -0,0 +1,97 @@
+#include "awspacket.hpp"
+#include <array>
+#include <gtest/gtest.h>
+#include <string_view>
+
+namespace {
+using packet::aws::ShadowDelta;
+using packet::aws::ShadowReported;
+
+common::Error parse(ShadowDelta& delta, const std::string_view json,
+                    const bool isGetAccepted = false) {
+  return delta.parseFromJson(json.data(), json.size(), isGetAccepted);
+}
+
+TEST(ShadowPacketTest, ReportedWritesIntegersAndDecimals) {
+  ShadowReported reported{};
+  ASSERT_EQ(reported.add("requestPeriodS", 30.0), common::Error::OK);
+  ASSERT_EQ(reported.add("temperature", -1.25), common::Error::OK);
+  std::array<char, 128> buffer{};
+  ASSERT_EQ(reported.serializeToJson(buffer.data(), buffer.size()),
+            common::Error::OK);
+  EXPECT_STREQ(buffer.data(), "{\"state\":{\"reported\":{\"requestPeriodS\":30,"
+                              "\"temperature\":-1.25}}}");
+}
+
+TEST(ShadowPacketTest, ReportedRejectsEmptyKeyFullAndSmallBuffer) {
+  ShadowReported reported{};
+  EXPECT_EQ(reported.add("", 1.0), common::Error::INVALID_ARG);
+  for (size_t i = 0; i < ShadowReported::MAX_FIELDS; ++i) {
+    ASSERT_EQ(reported.add("key", 1.0), common::Error::OK);
+  }
+  EXPECT_EQ(reported.add("key", 1.0), common::Error::NO_MEM);
+
+  std::array<char, 16> buffer{};
+  EXPECT_EQ(reported.serializeToJson(buffer.data(), buffer.size()),
+            common::Error::FAIL);
+}
+
+TEST(ShadowPacketTest, DeltaReadsVersionAndFields) {
+  ShadowDelta delta{};
+  ASSERT_EQ(parse(delta, R"({"version":12,"timestamp":1700000000,
+      "state":{"requestPeriodS":60,"mode":"eco","limits":{"max":[1,2]},
+      "offset":-0.5},"metadata":{"requestPeriodS":{"timestamp":1}}})"),
+            common::Error::OK);
+  ASSERT_TRUE(delta.hasDelta());
+  EXPECT_EQ(delta.getVersion(), 12u);
+  ASSERT_EQ(delta.getFieldCount(), 4u);
+  EXPECT_EQ(delta.getField(0).key, "requestPeriodS");
+  EXPECT_TRUE(delta.getField(0).isNumber);
+  EXPECT_DOUBLE_EQ(delta.getField(0).value, 60.0);
+  EXPECT_EQ(delta.getField(1).key, "mode");
+  EXPECT_FALSE(delta.getField(1).isNumber);
+  EXPECT_FALSE(delta.getField(2).isNumber);
+  EXPECT_DOUBLE_EQ(delta.getField(3).value, -0.5);
+}
+
+TEST(ShadowPacketTest, GetAcceptedReadsOnlyDelta) {
+  ShadowDelta delta{};
+  ASSERT_EQ(parse(delta, R"({"state":{"desired":{"requestPeriodS":60},
+      "reported":{"requestPeriodS":30},"delta":{"requestPeriodS":60},
+      "extra":"a}\"b"},"version":7})",
+                  true),
+            common::Error::OK);
+  ASSERT_TRUE(delta.hasDelta());
+  EXPECT_EQ(delta.getVersion(), 7u);
+  ASSERT_EQ(delta.getFieldCount(), 1u);
+  EXPECT_EQ(delta.getField(0).key, "requestPeriodS");
+
+  // States in sync, no delta
+  ASSERT_EQ(parse(delta, R"({"state":{"desired":{"a":1},"reported":{"a":1}},
+      "version":8})",
+                  true),
+            common::Error::OK);
+  EXPECT_FALSE(delta.hasDelta());
+}
+
+TEST(ShadowPacketTest, DeltaCountsFieldsOverLimit) {
+  ShadowDelta delta{};
+  ASSERT_EQ(parse(delta, R"({"version":1,"state":{"a":1,"b":2,"c":3,"d":4,
+      "e":5,"f":6,"g":7,"h":8,"i":9,"j":10}})"),
+            common::Error::OK);
+  EXPECT_EQ(delta.getFieldCount(), ShadowDelta::MAX_FIELDS);
+  EXPECT_EQ(delta.getSkippedCount(), 2u);
+}
+
+TEST(ShadowPacketTest, DeltaRejectsInvalidJson) {
+  ShadowDelta delta{};
+  EXPECT_EQ(delta.parseFromJson(nullptr, 0, false),
+            common::Error::INVALID_ARG);
+  EXPECT_EQ(parse(delta, R"({"version":1,"state":{"a":1})"),
+            common::Error::FAIL);
+  EXPECT_EQ(parse(delta, R"({"version":1,"state":{"a":})"),
+            common::Error::FAIL);
+  EXPECT_EQ(parse(delta, R"({"version":1 "state":{}})"), common::Error::FAIL);
+  EXPECT_EQ(parse(delta, R"({"state":{"a":"x)"), common::Error::FAIL);
+}
+} // namespace
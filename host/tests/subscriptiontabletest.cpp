@@ -0,0 +1,143 @@
+#include "subscriptiontable.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+static constexpr size_t MAX_ENTRIES{4};
+static constexpr size_t TOPIC_SIZE{16};
+
+using Callback = void (*)(common::Argument);
+using Table = app::SubscriptionTable<Callback, MAX_ENTRIES, TOPIC_SIZE>;
+
+void countCall(common::Argument arg) { ++*static_cast<int*>(arg); }
+
+void otherCall(common::Argument arg) { *static_cast<int*>(arg) += 100; }
+
+TEST(SubscriptionTableTest, ExactFilterMatchesOnlyItsTopic) {
+  EXPECT_TRUE(Table::isMatch("a/b", "a/b"));
+  EXPECT_FALSE(Table::isMatch("a/b", "a/c"));
+  EXPECT_FALSE(Table::isMatch("a/b", "a/bc"));
+  EXPECT_FALSE(Table::isMatch("a/bc", "a/b"));
+}
+
+TEST(SubscriptionTableTest, PlusMatchesExactlyOneLevel) {
+  EXPECT_TRUE(Table::isMatch("a/+/c", "a/b/c"));
+  EXPECT_TRUE(Table::isMatch("+/b", "a/b"));
+  EXPECT_TRUE(Table::isMatch("a/+", "a/b"));
+  EXPECT_TRUE(Table::isMatch("+/+", "/b"));
+  // Empty level is a level too
+  EXPECT_TRUE(Table::isMatch("a/+", "a/"));
+  EXPECT_TRUE(Table::isMatch("a/+/c", "a//c"));
+  EXPECT_FALSE(Table::isMatch("a/+", "a"));
+  EXPECT_FALSE(Table::isMatch("a/+", "a/b/c"));
+  EXPECT_FALSE(Table::isMatch("a/+/c", "a/b/d"));
+}
+
+TEST(SubscriptionTableTest, HashMatchesParentAndAllChildLevels) {
+  EXPECT_TRUE(Table::isMatch("#", "a"));
+  EXPECT_TRUE(Table::isMatch("#", "a/b/c"));
+  EXPECT_TRUE(Table::isMatch("a/#", "a"));
+  EXPECT_TRUE(Table::isMatch("a/#", "a/b"));
+  EXPECT_TRUE(Table::isMatch("a/#", "a/b/c"));
+  EXPECT_TRUE(Table::isMatch("a/+/#", "a/b/c/d"));
+  EXPECT_FALSE(Table::isMatch("a/#", "b/c"));
+  EXPECT_FALSE(Table::isMatch("a/#", "ab"));
+}
+
+TEST(SubscriptionTableTest, TrailingLevelsDoNotMatch) {
+  EXPECT_FALSE(Table::isMatch("a/b", "a/b/c"));
+  EXPECT_FALSE(Table::isMatch("a/b", "a/b/"));
+  EXPECT_FALSE(Table::isMatch("a/b/c", "a/b"));
+  EXPECT_FALSE(Table::isMatch("a/b/", "a/b"));
+}
+
+TEST(SubscriptionTableTest, WildcardsDoNotMatchDollarTopics) {
+  EXPECT_FALSE(Table::isMatch("#", "$aws/things"));
+  EXPECT_FALSE(Table::isMatch("+/things", "$aws/things"));
+  EXPECT_TRUE(Table::isMatch("$aws/#", "$aws/things"));
+  EXPECT_TRUE(Table::isMatch("$aws/+", "$aws/things"));
+}
+
+TEST(SubscriptionTableTest, RejectsInvalidFilters) {
+  EXPECT_TRUE(Table::isValidFilter("a/+/#"));
+  EXPECT_TRUE(Table::isValidFilter("+"));
+  EXPECT_FALSE(Table::isValidFilter(""));
+  EXPECT_FALSE(Table::isValidFilter("a+"));
+  EXPECT_FALSE(Table::isValidFilter("a/+b"));
+  EXPECT_FALSE(Table::isValidFilter("a/#/b"));
+  EXPECT_FALSE(Table::isValidFilter("#a"));
+  EXPECT_FALSE(Table::isValidFilter("a#"));
+
+  Table table;
+  int calls{0};
+  EXPECT_EQ(table.add("a/#/b", countCall, &calls), nullptr);
+  EXPECT_EQ(table.size(), 0u);
+}
+
+TEST(SubscriptionTableTest, RejectsFilterWithoutRoomForTerminator) {
+  Table table;
+  int calls{0};
+  const std::string longest(TOPIC_SIZE - 1, 'a');
+  const std::string tooLong(TOPIC_SIZE, 'a');
+  Table::Entry* entry = table.add(longest, countCall, &calls);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->topic[longest.size()], '\0');
+  EXPECT_EQ(table.add(tooLong, countCall, &calls), nullptr);
+}
+
+TEST(SubscriptionTableTest, FullTableRejectsNewFilterOnly) {
+  Table table;
+  int calls{0};
+  const std::vector<std::string> filters{"a", "b/+", "c/#", "d"};
+  for (const std::string& filter : filters) {
+    ASSERT_NE(table.add(filter, countCall, &calls), nullptr);
+  }
+  ASSERT_EQ(table.size(), MAX_ENTRIES);
+
+  EXPECT_EQ(table.add("e", countCall, &calls), nullptr);
+
+  // Known filter only gets its callback replaced
+  Table::Entry* entry = table.find("b/+");
+  EXPECT_EQ(table.add("b/+", otherCall, &calls), entry);
+  EXPECT_EQ(table.size(), MAX_ENTRIES);
+
+  ASSERT_EQ(table.remove("a"), common::Error::OK);
+  EXPECT_EQ(table.remove("a"), common::Error::NOT_FOUND);
+  EXPECT_NE(table.add("e", countCall, &calls), nullptr);
+  EXPECT_EQ(table.size(), MAX_ENTRIES);
+}
+
+TEST(SubscriptionTableTest, EntriesStayInPlaceWhenOthersAreRemoved) {
+  Table table;
+  int calls{0};
+  Table::Entry* first = table.add("a", countCall, &calls);
+  Table::Entry* second = table.add("b", countCall, &calls);
+  ASSERT_EQ(table.remove("a"), common::Error::OK);
+  EXPECT_EQ(table.find("b"), second);
+  EXPECT_EQ(second->getTopic(), "b");
+  // Freed entry is reused
+  EXPECT_EQ(table.add("c", countCall, &calls), first);
+}
+
+TEST(SubscriptionTableTest, DispatchesToEveryMatchingFilter) {
+  Table table;
+  int calls{0};
+  ASSERT_NE(table.add("hub/+", countCall, &calls), nullptr);
+  ASSERT_NE(table.add("hub/#", countCall, &calls), nullptr);
+  ASSERT_NE(table.add("hub/metrics", otherCall, &calls), nullptr);
+  ASSERT_NE(table.add("controller/#", countCall, &calls), nullptr);
+
+  auto call = [](Table::Entry& entry) { entry.cb(entry.arg); };
+  EXPECT_EQ(table.forEachMatch("hub/metrics", call), 3u);
+  EXPECT_EQ(calls, 102);
+
+  calls = 0;
+  EXPECT_EQ(table.forEachMatch("hub", call), 1u);
+  EXPECT_EQ(calls, 1);
+
+  calls = 0;
+  EXPECT_EQ(table.forEachMatch("greenhouse/x", call), 0u);
+  EXPECT_EQ(calls, 0);
+}
+} // namespace
@@ -1,21 +1,25 @@
+#include "allocationguard.hpp"
 #include "awsiotclient.hpp"
-#include "awsiotthread.hpp"
 #include "button.hpp"
 #include "delay.hpp"
 #include "esp_log.h"
 #include "eventgroup.hpp"
+#include "flashlog.hpp"
+#include "flashpartition.hpp"
 #include "gpio.hpp"
+#include "hub.hpp"
 #include "nvsstore.hpp"
 #include "queue.hpp"
-#include "radiothreadhub.hpp"
 #include "rfm95.hpp"
 #include "spi.hpp"
 #include "timer.hpp"
+#include "trace.hpp"
 #include "uithread.hpp"
+#include "uptime.hpp"
 #include "utils.hpp"
 #include "wificontroller.hpp"
 #include "ws2812b.hpp"
-#include <cstring>
+#include <string>
 #include <string_view>
 
 namespace {
@@ -25,12 +29,70 @@ extern const uint8_t
     binaryCertificate[] asm("_binary_certificate_pem_crt_start");
 extern const uint8_t binaryPrivateKey[] asm("_binary_private_pem_key_start");
 static constexpr std::string_view TAG{"HUB"};
+#ifdef CONFIG_HUB_PUBLISH_BENCHMARK
+// Every synthetic sample must be published
+static constexpr app::Hub::Settings HUB_SETTINGS{
+    {app::TelemetryAggregator::Mode::RAW, 0},
+    {CONFIG_HUB_PUBLISH_BENCHMARK_RATE_HZ,
+     common::utils::sToMs<common::Time, common::Time>(
+         CONFIG_HUB_PUBLISH_BENCHMARK_DURATION_S)}};
+#else
+// One summary per controller every 5 minutes instead of every sample
+static constexpr app::Hub::Settings HUB_SETTINGS{
+    {app::TelemetryAggregator::Mode::AGGREGATED,
+     common::utils::sToMs<common::Time, common::Time>(
+         common::utils::minToS<common::Time, common::Time>(5))},
+    {0, 0}};
+#endif
+
+#ifdef CONFIG_HUB_BUS_STATS
+using Spi = hw::BasicSpi<hw::BusStats>;
+static constexpr common::Time BUS_STATS_PERIOD_MS{
+    common::utils::sToMs<common::Time, common::Time>(60)};
+
+/**
+ * @brief Log the transactions of each device on a bus and clear them.
+ *
+ * @param bus Bus name.
+ * @param busStats Statistics of the bus.
+ * @param periodMs Time since the last clear, for the bus time share.
+ */
+void logBusStats(const std::string_view bus, hw::BusStats& busStats,
+                 const common::Time periodMs) {
+  hw::BusStats::Stats stats{};
+  for (size_t i = 0; busStats.getStats(i, stats) == common::Error::OK; ++i) {
+    // Bus time share in hundredths of a percent
+    const uint64_t share = stats.busTimeUs * 10 / periodMs;
+    ESP_LOGI(TAG.data(),
+             "%.*s 0x%lx: %lu transactions, %lu bytes, %llu us "
+             "(%lu.%02lu%%), max %lu us",
+             static_cast<int>(bus.size()), bus.data(),
+             static_cast<unsigned long>(stats.device),
+             static_cast<unsigned long>(stats.transactions),
+             static_cast<unsigned long>(stats.bytes),
+             static_cast<unsigned long long>(stats.busTimeUs),
+             static_cast<unsigned long>(share / 100),
+             static_cast<unsigned long>(share % 100),
+             static_cast<unsigned long>(stats.maxLatencyUs));
+  }
+  busStats.reset();
+}
+#else
+using Spi = hw::Spi;
+#endif
 } // namespace
 
 extern "C" {
 void app_main(void) {
   common::Error errorCode{common::Error::OK};
 
+#ifdef CONFIG_HUB_TRACE
+  sw::trace::enable();
+#endif
+#ifdef CONFIG_HUB_ALLOCATION_GUARD_ABORT
+  sw::AllocationGuard::setAbortOnAllocation(true);
+#endif
+
   errorCode = storage::hw::NvsStore::init();
   if (errorCode != common::Error::OK) {
     ESP_LOGE(TAG.data(), "Failed to init nvs");
@@ -39,8 +101,8 @@ void app_main(void) {
   hw::Gpio mosi{23};
   hw::Gpio miso{19};
   hw::Gpio sck{18};
-  hw::Spi spi{{miso, mosi, sck, hw::Spi::Host::VSPI}};
-  errorCode = spi.init(hw::Spi::DmaChannel::CHANNEL_1);
+  Spi spi{{miso, mosi, sck, Spi::Host::VSPI}};
+  errorCode = spi.init(Spi::DmaChannel::CHANNEL_1);
   if (errorCode != common::Error::OK) {
     ESP_LOGE(TAG.data(), "Failed to init spi");
   }
@@ -55,26 +117,6 @@ void app_main(void) {
   hw::Gpio rst{4};
   hw::Gpio dio0{17};
   radio::Rfm95 rfm95{{rst, dio0, spi, spiRfm95Handle}};
-  errorCode = rfm95.init(radio::Rfm95::Modulation::LORA);
-  if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "Failed to init rfm95");
-  }
-
-  radio::Rfm95::ModemSettings settings{};
-  settings.frequencyHz = 868'000'000;
-  settings.lnaBoostHfEnable = true;
-  settings.gain = radio::Rfm95::Gain::G1;
-  settings.bandwidth = radio::Rfm95::Bandwidth::BW_125000;
-  settings.spreadingFactor = radio::Rfm95::SF::SF_12;
-  settings.syncWord = 18;
-  settings.preambleLength = 8;
-  settings.paPin = radio::Rfm95::PaPin::BOOST;
-  settings.power = 20;
-
-  errorCode = rfm95.setAllSettings(settings);
-  if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "Failed to set all rfm95 settings");
-  }
 
   storage::hw::NvsStore storage{"storage"};
 
@@ -84,18 +126,6 @@ void app_main(void) {
     ESP_LOGE(TAG.data(), "Failed to init wifi reconnect timer");
   }
 
-  timer::sw::Timer radiorequestTimer;
-  errorCode = radiorequestTimer.init();
-  if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "Failed to init radio request timer");
-  }
-
-  timer::sw::Timer radioTimeoutTimer;
-  errorCode = radioTimeoutTimer.init();
-  if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "Failed to init radio timeout timer");
-  }
-
   hw::Gpio redPin{12};
   hw::Gpio greenPin{27};
   hw::Gpio bluePin{26};
@@ -130,19 +160,6 @@ void app_main(void) {
     ESP_LOGE(TAG.data(), "Failed to start UiThread");
   }
 
-  sw::Queue<common::Telemetry> telemetryQueue{5};
-  errorCode = telemetryQueue.init();
-  if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "Failed to init telemetry queue");
-  }
-
-  app::RadioThreadHub radioThread{{rfm95, radiorequestTimer, radioTimeoutTimer,
-                                   ledEventQueue, telemetryQueue}};
-  errorCode = radioThread.start();
-  if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "Failed to start RadioThread");
-  }
-
   sw::EventGroup connectionEventGroup;
   errorCode = connectionEventGroup.init();
   if (errorCode != common::Error::OK) {
@@ -176,21 +193,48 @@ void app_main(void) {
     ESP_LOGE(TAG.data(), "Failed to init AwsIotClient");
   }
 
-  timer::sw::Timer awsiotReconnectTimer;
-  errorCode = awsiotReconnectTimer.init();
+  storage::hw::FlashPartition telemetryPartition{"telemetry"};
+  errorCode = telemetryPartition.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to find telemetry partition");
+  }
+
+  storage::FlashLog<common::TelemetrySummary> telemetryLog{telemetryPartition};
+  errorCode = telemetryLog.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init telemetry log");
+  }
+
+  app::Hub hub{{rfm95, storage, ledEventQueue, connectionEventGroup,
+                 awsIotClient, wifiController, telemetryLog, clientId},
+               HUB_SETTINGS};
+  errorCode = hub.init();
+  if (errorCode != common::Error::OK) {
+    ESP_LOGE(TAG.data(), "Failed to init Hub");
+  }
+
+  errorCode = wifiController.registerMetrics(hub.getMetrics());
   if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "Failed to aws iot reconnect timer");
+    ESP_LOGE(TAG.data(), "Failed to register metrics");
   }
 
-  app::AwsIotThread awsThread{{awsIotClient, connectionEventGroup,
-                               telemetryQueue, ledEventQueue,
-                               awsiotReconnectTimer}};
-  errorCode = awsThread.start();
+  errorCode = hub.start();
   if (errorCode != common::Error::OK) {
-    ESP_LOGE(TAG.data(), "Failed to start AwsIotThread");
+    ESP_LOGE(TAG.data(), "Failed to start Hub");
   }
 
+#ifdef CONFIG_HUB_BUS_STATS
+  common::Time busStatsMs = sw::getUptimeMs();
+#endif
   while (1) {
+#ifdef CONFIG_HUB_BUS_STATS
+    const common::Time nowMs = sw::getUptimeMs();
+    if (nowMs - busStatsMs >= BUS_STATS_PERIOD_MS) {
+      logBusStats("spi", spi.getBusStats(), nowMs - busStatsMs);
+      busStatsMs = nowMs;
+    }
+#endif
+    hub.yield();
     sw::delayMs(10);
   }
 }
@@ -1,11 +1,15 @@
 #pragma once
 
+#include "metrics.hpp"
 #include "types.hpp"
+#include <array>
 #include <cstddef>
+#include <string_view>
 
 namespace packet {
 namespace aws {
 constexpr size_t BUFFER_SIZE{256};
+constexpr size_t METRICS_BUFFER_SIZE{640};
 
 /**
  * @class Telemetry
@@ -36,5 +40,187 @@ class Telemetry {
     common::Telemetry telemetry_;
 };
 
+/**
+ * @class TelemetrySummary
+ * @brief A class for converting windowed telemetry statistics to JSON format.
+ */
+class TelemetrySummary {
+  public:
+    /**
+     * @brief Constructs a `TelemetrySummary` object with the given summary.
+     *
+     * @param summary The telemetry summary to be managed.
+     */
+    explicit TelemetrySummary(common::TelemetrySummary summary);
+
+    /**
+     * @brief Serializes the telemetry summary to JSON.
+     *
+     * @param buffer The buffer to store the JSON string.
+     * @param bufferLength The length of the provided buffer.
+     *
+     * @return common::Error Error code indicating success or failure.
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error serializeToJson(char* buffer, const size_t bufferLength);
+
+  private:
+    common::TelemetrySummary summary_;
+};
+
+/**
+ * @class Metrics
+ * @brief A class for converting a snapshot of runtime metrics to JSON format.
+ *
+ * Counters, gauges and readers are written as numbers. A latency histogram
+ * is written as count, p50, p99 and max, a linear histogram as count, p10,
+ * p50 and p90. Counters are totals since boot, uptime tells about a reboot.
+ */
+class Metrics {
+  public:
+    /**
+     * @brief Constructs a `Metrics` object with the given registry.
+     *
+     * @param registry Metrics to be serialized.
+     * @param uptimeS Time since boot in seconds.
+     */
+    Metrics(const sw::metrics::Registry& registry, uint32_t uptimeS);
+
+    /**
+     * @brief Serializes the current values of the metrics to JSON.
+     *
+     * @param buffer The buffer to store the JSON string.
+     * @param bufferLength The length of the provided buffer.
+     *
+     * @return common::Error Error code indicating success or failure.
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Buffer is null or empty.
+     *   - common::Error::FAIL: Fail, e.g. buffer too small.
+     */
+    common::Error serializeToJson(char* buffer, const size_t bufferLength);
+
+  private:
+    const sw::metrics::Registry& registry_;
+    uint32_t uptimeS_;
+};
+
+/**
+ * @class ShadowReported
+ * @brief A class for converting reported shadow fields to a shadow update
+ * document, {"state":{"reported":{...}}}.
+ *
+ * Integral values are written as integers, others with two decimals.
+ */
+class ShadowReported {
+  public:
+    static constexpr size_t MAX_FIELDS{8};
+
+    /**
+     * @brief Adds a reported field.
+     * @note Key is written as is, it must not need escaping and must stay
+     * valid until serialized.
+     *
+     * @param key Field key.
+     * @param value Field value.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Empty key.
+     *   - common::Error::NO_MEM: MAX_FIELDS fields already added.
+     */
+    common::Error add(const std::string_view key, const double value);
+
+    /**
+     * @brief Serializes the reported fields to JSON.
+     *
+     * @param buffer The buffer to store the JSON string.
+     * @param bufferLength The length of the provided buffer.
+     *
+     * @return common::Error Error code indicating success or failure.
+     *   - common::Error::OK: Success.
+     *   - common::Error::INVALID_ARG: Buffer is null or empty.
+     *   - common::Error::FAIL: Fail, e.g. buffer too small.
+     */
+    common::Error serializeToJson(char* buffer, const size_t bufferLength);
+
+  private:
+    struct Field {
+        std::string_view key;
+        double value;
+    };
+
+    std::array<Field, MAX_FIELDS> fields_{};
+    size_t count_{0};
+};
+
+/**
+ * @class ShadowDelta
+ * @brief A class for reading desired fields from a shadow document, no heap
+ * is used.
+ *
+ * Reads the delta document, {"version":n,"state":{...}}, or the get accepted
+ * document, where the fields are in state.delta. Keys point into the parsed
+ * payload, which must outlive the object. Fields after MAX_FIELDS are
+ * skipped.
+ */
+class ShadowDelta {
+  public:
+    static constexpr size_t MAX_FIELDS{8};
+
+    /**
+     * @brief Desired field
+     */
+    struct Field {
+        std::string_view key;
+        double value;
+        bool isNumber; // False for strings, objects and other values
+    };
+
+    /**
+     * @brief Parses a shadow document.
+     *
+     * @param json Document, not necessarily null terminated.
+     * @param length Document length.
+     * @param isGetAccepted True if json is a full shadow document.
+     *
+     * @return common::Error Error code indicating success or failure.
+     *   - common::Error::OK: Success, also without version or delta.
+     *   - common::Error::INVALID_ARG: Document is null.
+     *   - common::Error::FAIL: Document is not valid JSON.
+     */
+    common::Error parseFromJson(const char* json, const size_t length,
+                                const bool isGetAccepted);
+
+    /**
+     * @brief Checks if the document has a version and a delta object.
+     * Get accepted has no delta when desired and reported states match.
+     *
+     * @return True if fields can be applied.
+     */
+    bool hasDelta() const;
+
+    uint32_t getVersion() const;
+
+    size_t getFieldCount() const;
+
+    const Field& getField(const size_t index) const;
+
+    /**
+     * @brief Gets the number of fields skipped because of MAX_FIELDS.
+     *
+     * @return Number of skipped fields.
+     */
+    size_t getSkippedCount() const;
+
+  private:
+    std::array<Field, MAX_FIELDS> fields_{};
+    size_t count_{0};
+    size_t skippedCount_{0};
+    uint32_t version_{0};
+    bool hasVersion_{false};
+    bool hasState_{false};
+};
+
 } // namespace aws
 } // namespace packet
@@ -15,7 +15,8 @@ enum class Type : uint8_t {
   OK,                // Packet indicating OK status
   NOT_OK,            // Packet indicating NOT OK status
   TELEMETRY_REQUEST, // Packet requesting telemetry data
-  TELEMETRY          // Packet containing telemetry data
+  TELEMETRY,         // Packet containing telemetry data
+  CONFIG             // Packet containing device configuration
 };
 
 namespace utils {
@@ -76,5 +77,111 @@ class __attribute__((packed)) Telemetry {
     const Type type_{Type::TELEMETRY};
 };
 
+/**
+ * @class DeviceConfig
+ * @brief Class representing device configuration in a radio packet.
+ */
+class __attribute__((packed)) DeviceConfig {
+  public:
+    /**
+     * @brief Construct a new DeviceConfig object.
+     *
+     * @param config Device configuration.
+     */
+    explicit DeviceConfig(common::DeviceConfig config);
+
+    /**
+     * @brief Get the device configuration.
+     *
+     * @return Device configuration.
+     */
+    common::DeviceConfig getDeviceConfig() const;
+
+    /**
+     * @brief Parse device configuration to bytes.
+     *
+     * @param buffer Pointer to the buffer where the bytes will be written.
+     * @param bufferLength Length of the buffer.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error serialize(uint8_t* buffer, const size_t bufferLength);
+
+    /**
+     * @brief Parse device configuration from bytes.
+     *
+     * @param buffer Pointer to the buffer containing the bytes.
+     * @param bufferLength Length of the buffer.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error deserialize(const uint8_t* buffer, const size_t bufferLength);
+
+  private:
+    common::DeviceConfig config_;
+    const Type type_{Type::CONFIG};
+};
+
+/**
+ * @class Response
+ * @brief Class representing a controller response in a radio packet.
+ */
+class __attribute__((packed)) Response {
+  public:
+    /**
+     * @brief Construct a new Response object.
+     *
+     * @param type Response type, OK or NOT_OK.
+     * @param controllerId ID of the responding controller.
+     */
+    Response(const Type type, const uint8_t controllerId);
+
+    /**
+     * @brief Get the response type.
+     *
+     * @return OK or NOT_OK.
+     */
+    Type getType() const;
+
+    /**
+     * @brief Get the ID of the responding controller.
+     *
+     * @return Controller ID.
+     */
+    uint8_t getControllerId() const;
+
+    /**
+     * @brief Parse response to bytes.
+     *
+     * @param buffer Pointer to the buffer where the bytes will be written.
+     * @param bufferLength Length of the buffer.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail.
+     */
+    common::Error serialize(uint8_t* buffer, const size_t bufferLength);
+
+    /**
+     * @brief Parse response from bytes.
+     *
+     * @param buffer Pointer to the buffer containing the bytes.
+     * @param bufferLength Length of the buffer.
+     *
+     * @return
+     *   - common::Error::OK: Success.
+     *   - common::Error::FAIL: Fail, also if it is no response.
+     */
+    common::Error deserialize(const uint8_t* buffer, const size_t bufferLength);
+
+  private:
+    Type type_;
+    uint8_t controllerId_;
+};
+
 } // namespace radio
 } // namespace packet
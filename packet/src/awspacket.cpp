@@ -1,6 +1,327 @@
 #include "awspacket.hpp"
-#include "cJSON.h"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
+#include <string_view>
+
+namespace {
+/**
+ * @class JsonWriter
+ * @brief Writes a JSON object into a fixed buffer, no heap is used.
+ *
+ * Keys are written as given, they must not need escaping. The first error
+ * is kept, isOk() tells if the whole object fit.
+ */
+class JsonWriter {
+  public:
+    JsonWriter(char* buffer, const size_t bufferLength)
+        : end_{buffer + bufferLength - 1}, position_{buffer} {}
+
+    void beginObject(const std::string_view key = {}) {
+      addKey_(key);
+      append_("{");
+      isFirst_ = true;
+    }
+
+    void endObject() {
+      append_("}");
+      isFirst_ = false;
+    }
+
+    template <typename T>
+    void addInteger(const std::string_view key, const T value) {
+      addKey_(key);
+      appendInteger_(value);
+    }
+
+    /**
+     * @brief Add a number with two decimals, the resolution of the sensors.
+     * Floats are not printed, newlib keeps its float conversion buffers on
+     * the heap.
+     */
+    void addFloat(const std::string_view key, const float value) {
+      addFixed_(key, value);
+    }
+
+    /**
+     * @brief Add an integral number as integer, others with two decimals.
+     */
+    void addNumber(const std::string_view key, const double value) {
+      constexpr double INTEGER_LIMIT{9.0e15}; // Exact in a double
+      if (std::isfinite(value) && std::trunc(value) == value &&
+          std::fabs(value) < INTEGER_LIMIT) {
+        addInteger(key, static_cast<long long>(value));
+        return;
+      }
+      addFixed_(key, value);
+    }
+
+    /**
+     * @brief Terminate the string.
+     *
+     * @return True if the object fit into the buffer.
+     */
+    bool finish() {
+      *position_ = '\0';
+      return isOk_;
+    }
+
+  private:
+    void addFixed_(const std::string_view key, const double value) {
+      if (not std::isfinite(value)) {
+        addKey_(key);
+        append_("null");
+        return;
+      }
+
+      const long long hundredths = std::llround(value * 100.0);
+      const unsigned long long magnitude =
+          hundredths < 0 ? -static_cast<unsigned long long>(hundredths)
+                         : static_cast<unsigned long long>(hundredths);
+      addKey_(key);
+      if (hundredths < 0) {
+        append_("-");
+      }
+      appendInteger_(magnitude / 100);
+      const unsigned fraction = static_cast<unsigned>(magnitude % 100);
+      if (fraction != 0) {
+        const char digits[] = {'.', static_cast<char>('0' + fraction / 10),
+                               static_cast<char>('0' + fraction % 10)};
+        // 21.50 is written as 21.5
+        append_({digits, fraction % 10 == 0 ? 2u : 3u});
+      }
+    }
+
+    void addKey_(const std::string_view key) {
+      if (not isFirst_) {
+        append_(",");
+      }
+      isFirst_ = false;
+      if (key.empty()) {
+        return;
+      }
+      append_("\"");
+      append_(key);
+      append_("\":");
+    }
+
+    template <typename T> void appendInteger_(const T value) {
+      if (not isOk_) {
+        return;
+      }
+      const std::to_chars_result result = std::to_chars(position_, end_, value);
+      if (result.ec != std::errc{}) {
+        isOk_ = false;
+        return;
+      }
+      position_ = result.ptr;
+    }
+
+    void append_(const std::string_view text) {
+      if (not isOk_ or
+          text.size() > static_cast<size_t>(end_ - position_)) {
+        isOk_ = false;
+        return;
+      }
+      std::memcpy(position_, text.data(), text.size());
+      position_ += text.size();
+    }
+
+    char* end_; // Last byte, kept for the terminator
+    char* position_;
+    bool isFirst_{true};
+    bool isOk_{true};
+};
+
+/**
+ * @class JsonReader
+ * @brief Reads JSON from a buffer without copying, no heap is used.
+ *
+ * Strings are returned as views into the buffer with escapes left as they
+ * are. The first error is kept, isOk() tells if everything read was valid.
+ */
+class JsonReader {
+  public:
+    JsonReader(const char* json, const size_t length)
+        : position_{json}, end_{json + length} {}
+
+    /**
+     * @brief Start an object, or read the separator before its next member.
+     *
+     * @return True if there is a member to read, false at the object end.
+     */
+    bool nextMember(bool& isFirst) {
+      if (isFirst) {
+        isFirst = false;
+        expect_('{');
+        if (peek_() == '}') {
+          ++position_;
+          return false;
+        }
+        return isOk_;
+      }
+
+      const char c = peek_();
+      ++position_;
+      if (c == ',') {
+        return isOk_;
+      }
+      if (c != '}') {
+        isOk_ = false;
+      }
+      return false;
+    }
+
+    /**
+     * @brief Read a member key and the colon after it.
+     */
+    std::string_view readKey() {
+      const std::string_view key = readString_();
+      expect_(':');
+      return key;
+    }
+
+    bool isNumberNext() {
+      const char c = peek_();
+      return c == '-' || (c >= '0' && c <= '9');
+    }
+
+    bool isObjectNext() { return peek_() == '{'; }
+
+    double readNumber() {
+      double value{0.0};
+      peek_();
+      const std::from_chars_result result =
+          std::from_chars(position_, end_, value);
+      if (result.ec != std::errc{}) {
+        isOk_ = false;
+        return 0.0;
+      }
+      position_ = result.ptr;
+      return value;
+    }
+
+    /**
+     * @brief Skip a value of any type, nested ones included.
+     */
+    void skipValue() {
+      const char c = peek_();
+      if (c == '"') {
+        readString_();
+        return;
+      }
+      if (isNumberNext()) {
+        readNumber();
+        return;
+      }
+      if (c != '{' && c != '[') {
+        // true, false or null
+        while (position_ < end_ && *position_ >= 'a' && *position_ <= 'z') {
+          ++position_;
+        }
+        return;
+      }
+
+      size_t depth{0};
+      while (position_ < end_) {
+        const char next = *position_;
+        if (next == '"') {
+          readString_();
+          continue;
+        }
+        ++position_;
+        if (next == '{' || next == '[') {
+          ++depth;
+        } else if ((next == '}' || next == ']') && --depth == 0) {
+          return;
+        }
+      }
+      isOk_ = false;
+    }
+
+    bool isOk() const { return isOk_; }
+
+  private:
+    /**
+     * @brief Skip whitespace.
+     *
+     * @return Next character, 0 at the end.
+     */
+    char peek_() {
+      while (position_ < end_ && (*position_ == ' ' || *position_ == '\n' ||
+                                  *position_ == '\r' || *position_ == '\t')) {
+        ++position_;
+      }
+      if (position_ == end_) {
+        isOk_ = false;
+        return '\0';
+      }
+      return *position_;
+    }
+
+    void expect_(const char c) {
+      if (peek_() != c) {
+        isOk_ = false;
+        return;
+      }
+      ++position_;
+    }
+
+    std::string_view readString_() {
+      expect_('"');
+      const char* start = position_;
+      while (isOk_ && position_ < end_ && *position_ != '"') {
+        position_ += *position_ == '\\' ? 2 : 1;
+      }
+      if (not isOk_ || position_ >= end_) {
+        isOk_ = false;
+        return {};
+      }
+      const std::string_view text{start,
+                                  static_cast<size_t>(position_ - start)};
+      ++position_;
+      return text;
+    }
+
+    const char* position_;
+    const char* end_;
+    bool isOk_{true};
+};
+
+void addFieldSummary(JsonWriter& writer, const char* name,
+                     const common::FieldSummary& field) {
+  writer.beginObject(name);
+  writer.addFloat("min", field.min);
+  writer.addFloat("max", field.max);
+  writer.addFloat("mean", field.mean);
+  writer.addFloat("stddev", field.stddev);
+  writer.endObject();
+}
+
+void addLatency(JsonWriter& writer, const char* name,
+                const sw::LatencyHistogram& histogram) {
+  const sw::LatencyHistogram::Snapshot snapshot = histogram.getSnapshot();
+  writer.beginObject(name);
+  writer.addInteger("n", snapshot.count);
+  writer.addInteger("p50", snapshot.getPercentileUs(50));
+  writer.addInteger("p99", snapshot.getPercentileUs(99));
+  writer.addInteger("max", snapshot.maxUs);
+  writer.endObject();
+}
+
+void addLinear(JsonWriter& writer, const char* name,
+               const sw::metrics::LinearHistogram& histogram) {
+  const sw::metrics::LinearHistogram::Snapshot snapshot =
+      histogram.getSnapshot();
+  writer.beginObject(name);
+  writer.addInteger("n", snapshot.count);
+  writer.addInteger("p10", snapshot.getPercentile(10));
+  writer.addInteger("p50", snapshot.getPercentile(50));
+  writer.addInteger("p90", snapshot.getPercentile(90));
+  writer.endObject();
+}
+} // namespace
 
 namespace packet {
 namespace aws {
@@ -13,40 +334,191 @@ common::Error Telemetry::serializeToJson(char* buffer,
     return common::Error::INVALID_ARG;
   }
 
-  cJSON* root = cJSON_CreateObject();
-  if (root == nullptr) {
-    return common::Error::FAIL;
-  }
+  JsonWriter writer{buffer, bufferLength};
+  writer.beginObject();
+  writer.beginObject("telemetry");
+  writer.addInteger("controllerId", telemetry_.controllerId);
+  writer.addFloat("temperature", telemetry_.temperatureC);
+  writer.addFloat("humidity", telemetry_.humidityRh);
+  writer.endObject();
+  writer.endObject();
+  return writer.finish() ? common::Error::OK : common::Error::FAIL;
+}
+
+TelemetrySummary::TelemetrySummary(common::TelemetrySummary summary)
+    : summary_{summary} {}
 
-  cJSON* telemetry = cJSON_CreateObject();
-  if (root == nullptr) {
-    return common::Error::FAIL;
+common::Error TelemetrySummary::serializeToJson(char* buffer,
+                                                const size_t bufferLength) {
+  if (buffer == nullptr || bufferLength == 0) {
+    return common::Error::INVALID_ARG;
   }
 
-  cJSON_AddNumberToObject(telemetry, "temperature", telemetry_.temperatureC);
-  cJSON_AddNumberToObject(telemetry, "humidity", telemetry_.humidityRh);
-  cJSON_AddItemToObject(root, "telemetry", telemetry);
+  JsonWriter writer{buffer, bufferLength};
+  writer.beginObject();
+  writer.beginObject("summary");
+  writer.addInteger("controllerId", summary_.controllerId);
+  writer.addInteger("samples", summary_.sampleCount);
+  writer.addInteger("windowS", summary_.windowS);
+  addFieldSummary(writer, "temperature", summary_.temperatureC);
+  addFieldSummary(writer, "humidity", summary_.humidityRh);
+  writer.endObject();
+  writer.endObject();
+  return writer.finish() ? common::Error::OK : common::Error::FAIL;
+}
 
-  char* jsonStr = cJSON_PrintUnformatted(root);
-  if (jsonStr == nullptr) {
-    cJSON_Delete(root);
-    return common::Error::FAIL;
+Metrics::Metrics(const sw::metrics::Registry& registry, uint32_t uptimeS)
+    : registry_{registry}, uptimeS_{uptimeS} {}
+
+common::Error Metrics::serializeToJson(char* buffer,
+                                       const size_t bufferLength) {
+  if (buffer == nullptr || bufferLength == 0) {
+    return common::Error::INVALID_ARG;
   }
 
-  size_t jsonLength = std::strlen(jsonStr);
-  if (jsonLength + 1 > bufferLength) {
-    delete[] jsonStr;
-    cJSON_Delete(root);
-    return common::Error::FAIL;
+  JsonWriter writer{buffer, bufferLength};
+  writer.beginObject();
+  writer.addInteger("uptimeS", uptimeS_);
+  using Type = sw::metrics::Registry::Type;
+  for (const sw::metrics::Registry::Entry& entry : registry_) {
+    // Names are literals, terminated past the view
+    const char* name = entry.name.data();
+    switch (entry.type) {
+    case Type::COUNTER:
+      writer.addInteger(name, entry.counter->get());
+      break;
+    case Type::GAUGE:
+      writer.addInteger(name, entry.gauge->get());
+      break;
+    case Type::READER:
+      writer.addInteger(name, entry.reader(entry.readerArg));
+      break;
+    case Type::LATENCY:
+      addLatency(writer, name, *entry.latency);
+      break;
+    case Type::LINEAR:
+      addLinear(writer, name, *entry.linear);
+      break;
+    }
   }
+  writer.endObject();
+  return writer.finish() ? common::Error::OK : common::Error::FAIL;
+}
 
-  std::strncpy(buffer, jsonStr, bufferLength);
+common::Error ShadowReported::add(const std::string_view key,
+                                  const double value) {
+  if (key.empty()) {
+    return common::Error::INVALID_ARG;
+  }
 
-  delete[] jsonStr;
-  cJSON_Delete(root);
+  if (count_ == fields_.size()) {
+    return common::Error::NO_MEM;
+  }
 
+  fields_[count_++] = {key, value};
   return common::Error::OK;
 }
 
+common::Error ShadowReported::serializeToJson(char* buffer,
+                                              const size_t bufferLength) {
+  if (buffer == nullptr || bufferLength == 0) {
+    return common::Error::INVALID_ARG;
+  }
+
+  JsonWriter writer{buffer, bufferLength};
+  writer.beginObject();
+  writer.beginObject("state");
+  writer.beginObject("reported");
+  for (size_t i = 0; i < count_; ++i) {
+    writer.addNumber(fields_[i].key, fields_[i].value);
+  }
+  writer.endObject();
+  writer.endObject();
+  writer.endObject();
+  return writer.finish() ? common::Error::OK : common::Error::FAIL;
+}
+
+common::Error ShadowDelta::parseFromJson(const char* json,
+                                         const size_t length,
+                                         const bool isGetAccepted) {
+  if (json == nullptr) {
+    return common::Error::INVALID_ARG;
+  }
+
+  *this = ShadowDelta{};
+  JsonReader reader{json, length};
+  bool isFirst{true};
+  while (reader.nextMember(isFirst)) {
+    const std::string_view key = reader.readKey();
+    if (key == "version" && reader.isNumberNext()) {
+      const double version = reader.readNumber();
+      hasVersion_ = version >= 0 && version <= UINT32_MAX;
+      version_ = hasVersion_ ? static_cast<uint32_t>(version) : 0;
+      continue;
+    }
+
+    if (key != "state" || not reader.isObjectNext()) {
+      reader.skipValue();
+      continue;
+    }
+
+    // Full document keeps the delta next to desired and reported
+    bool isStateFirst{true};
+    if (isGetAccepted) {
+      bool isDeltaFound{false};
+      while (not isDeltaFound && reader.nextMember(isStateFirst)) {
+        if (reader.readKey() == "delta" && reader.isObjectNext()) {
+          isDeltaFound = true;
+        } else {
+          reader.skipValue();
+        }
+      }
+      if (not isDeltaFound) {
+        continue;
+      }
+    }
+
+    hasState_ = true;
+    bool isFieldFirst{true};
+    while (reader.nextMember(isFieldFirst)) {
+      const std::string_view fieldKey = reader.readKey();
+      Field field{fieldKey, 0.0, reader.isNumberNext()};
+      if (field.isNumber) {
+        field.value = reader.readNumber();
+      } else {
+        reader.skipValue();
+      }
+
+      if (count_ == fields_.size()) {
+        ++skippedCount_;
+      } else {
+        fields_[count_++] = field;
+      }
+    }
+
+    if (isGetAccepted) {
+      // Rest of the state object after the delta
+      while (reader.nextMember(isStateFirst)) {
+        reader.readKey();
+        reader.skipValue();
+      }
+    }
+  }
+
+  return reader.isOk() ? common::Error::OK : common::Error::FAIL;
+}
+
+bool ShadowDelta::hasDelta() const { return hasVersion_ && hasState_; }
+
+uint32_t ShadowDelta::getVersion() const { return version_; }
+
+size_t ShadowDelta::getFieldCount() const { return count_; }
+
+const ShadowDelta::Field& ShadowDelta::getField(const size_t index) const {
+  return fields_[index];
+}
+
+size_t ShadowDelta::getSkippedCount() const { return skippedCount_; }
+
 } // namespace aws
 } // namespace packet
@@ -65,5 +65,51 @@ common::Error Telemetry::deserialize(const uint8_t* buffer,
   return utils::deserialize(type_, telemetry_, buffer, bufferLength);
 }
 
+DeviceConfig::DeviceConfig(common::DeviceConfig config) : config_{config} {}
+
+common::DeviceConfig DeviceConfig::getDeviceConfig() const { return config_; }
+
+common::Error DeviceConfig::serialize(uint8_t* buffer,
+                                      const size_t bufferLength) {
+  return utils::serialize(type_, config_, buffer, bufferLength);
+}
+
+common::Error DeviceConfig::deserialize(const uint8_t* buffer,
+                                        const size_t bufferLength) {
+  return utils::deserialize(type_, config_, buffer, bufferLength);
+}
+
+Response::Response(const Type type, const uint8_t controllerId)
+    : type_{type}, controllerId_{controllerId} {}
+
+Type Response::getType() const { return type_; }
+
+uint8_t Response::getControllerId() const { return controllerId_; }
+
+common::Error Response::serialize(uint8_t* buffer, const size_t bufferLength) {
+  return utils::serialize(type_, controllerId_, buffer, bufferLength);
+}
+
+common::Error Response::deserialize(const uint8_t* buffer,
+                                    const size_t bufferLength) {
+  if (bufferLength < sizeof(Type)) {
+    return common::Error::FAIL;
+  }
+
+  const Type type = utils::getType(buffer);
+  if (type != Type::OK && type != Type::NOT_OK) {
+    return common::Error::FAIL;
+  }
+
+  common::Error errorCode =
+      utils::deserialize(type, controllerId_, buffer, bufferLength);
+  if (errorCode != common::Error::OK) {
+    return errorCode;
+  }
+
+  type_ = type;
+  return common::Error::OK;
+}
+
 } // namespace radio
 } // namespace packet